@@ -127,15 +127,15 @@ Audio::Update(Game &) {
  * @return The loaded buffer (empty if sound is not found). nullptr if Audio was not initialized.
  */
 Audio::Buffer *
-Audio::GetSoundBuffer(const std::string &name) {
+Audio::GetSoundBuffer(const Symbol &name) {
 #if HAVE_AUDIO
   if (!this->isInited) return nullptr;
 
   auto iter = this->buffers.find(name);
   if (iter == this->buffers.end()) {
-    this->buffers[name] = Audio::Buffer::LoadOgg(name);
+    iter = this->buffers.insert(std::make_pair(name, Audio::Buffer::LoadOgg(name.GetString()))).first;
   }
-  return this->buffers[name];
+  return iter->second;
 #else
   (void)name;
   return nullptr;
@@ -151,10 +151,10 @@ Audio::GetSoundBuffer(const std::string &name) {
   * @return The new source playing the requested sound.
   */
 std::shared_ptr<Audio::Source>
-Audio::PlaySound(const std::string &name, const Vector3 &pos, const Vector3 &velocity, bool loop, float volume, float pitch) {
+Audio::PlaySound(const Symbol &name, const Vector3 &pos, const Vector3 &velocity, bool loop, float volume, float pitch) {
 #if HAVE_AUDIO
   if (!this->isInited) return nullptr;
-  if (name == "") return nullptr;
+  if (name.IsEmpty()) return nullptr;
 
   //Log("trying to play sound %s\n", name.c_str());
   std::shared_ptr<Audio::Source> source(new Audio::Source(this->GetSoundBuffer(name), pos, velocity, loop, volume, pitch));
@@ -172,7 +172,7 @@ Audio::PlaySound(const std::string &name, const Vector3 &pos, const Vector3 &vel
 }
 
 std::shared_ptr<Audio::Source>
-Audio::PlaySound(const std::string &name, const Vector3 &pos) {
+Audio::PlaySound(const Symbol &name, const Vector3 &pos) {
   return PlaySound(name, pos, Vector3());
 }
 
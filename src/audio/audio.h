@@ -1,6 +1,8 @@
 #ifndef BARFOOS_AUDIO_H
 #define BARFOOS_AUDIO_H
 
+#include "common.h"
+
 #include <string>
 #include <memory>
 #include <vector>
@@ -65,8 +67,8 @@ public:
 
   void SetPlayer(const Mob *player) { this->player = player; }
 
-  std::shared_ptr<Source> PlaySound(const std::string &name, const Vector3 &pos);
-  std::shared_ptr<Source> PlaySound(const std::string &name, const Vector3 &pos, const Vector3 &velocity, bool loop = false, float volume = 1.0, float pitch = 1.0);
+  std::shared_ptr<Source> PlaySound(const Symbol &name, const Vector3 &pos);
+  std::shared_ptr<Source> PlaySound(const Symbol &name, const Vector3 &pos, const Vector3 &velocity, bool loop = false, float volume = 1.0, float pitch = 1.0);
 
 private:
 
@@ -83,12 +85,12 @@ private:
   const Mob *player;
 
   /** All loaded audio buffers. */
-  std::unordered_map<std::string, Buffer *> buffers;
+  std::unordered_map<Symbol, Buffer *> buffers;
 
   /** All currently playing audio sources. */
   std::vector<std::shared_ptr<Source>> sources;
 
-  Buffer *GetSoundBuffer(const std::string &name);
+  Buffer *GetSoundBuffer(const Symbol &name);
   void Deinit();
 };
 
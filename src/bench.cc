@@ -0,0 +1,149 @@
+#include "common.h"
+
+#include "game/game.h"
+#include "game/gamestates/running/runningstate.h"
+#include "util/pool.h"
+
+#include <google/protobuf/stubs/common.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/** Headless benchmark. Generates a level from a fixed seed, or loads the
+  * saved game, and runs a fixed number of game ticks without a window or
+  * sound, then prints how long the ticks took and what they spent their
+  * time on. It can also check that the saved level is built again from its
+  * seed to exactly the same cells.
+  */
+
+static void usage(const char *name) {
+  fprintf(stderr,
+    "usage: %s [-s seed] [-n ticks] [-t step] [-j threads] [-l] [-r]\n"
+    "  -s seed     seed of the generated level (default: bench)\n"
+    "  -l          load the saved game instead of generating a level\n"
+    "  -r          check that the saved level builds again from its seed\n"
+    "  -n ticks    number of ticks to run (default: 1000)\n"
+    "  -t step     length of a tick in seconds (default: 0.02)\n"
+    "  -j threads  threads used to build the level (default: one per core)\n",
+    name
+  );
+}
+
+static double seconds(const std::chrono::steady_clock::duration &d) {
+  return std::chrono::duration<double>(d).count();
+}
+
+int main(int argc, char **argv) {
+  GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+  std::string seed  = "bench";
+  size_t      ticks = 1000;
+  float       step  = 0.02;
+  bool        load  = false;
+  bool        rebuild = false;
+  size_t      threadCount = 0;
+
+  for (int i=1; i<argc; i++) {
+    if (i+1 < argc && !strcmp(argv[i], "-s")) {
+      seed = argv[++i];
+    } else if (i+1 < argc && !strcmp(argv[i], "-n")) {
+      ticks = strtoul(argv[++i], nullptr, 10);
+    } else if (i+1 < argc && !strcmp(argv[i], "-t")) {
+      step = strtof(argv[++i], nullptr);
+    } else if (i+1 < argc && !strcmp(argv[i], "-j")) {
+      threadCount = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "-l")) {
+      load = true;
+    } else if (!strcmp(argv[i], "-r")) {
+      rebuild = true;
+    } else {
+      usage(argv[0]);
+      return -1;
+    }
+  }
+
+  if (step <= 0.0) {
+    usage(argv[0]);
+    return -1;
+  }
+
+  Game *game = new Game();
+  game->SetFixedStep(step);
+  game->SetWorkerThreadCount(threadCount);
+  if (!game->Init()) {
+    Log("Could not initialize game object\n");
+    delete game;
+    return -1;
+  }
+
+  // the state is never made active, so nothing is saved
+  if (rebuild) {
+    RunningState *state = new RunningState(*game);
+    state->ContinueGame();
+    bool same = state->CheckLevelRebuild();
+    printf("rebuild    %s\n", same ? "same cells" : "different cells");
+
+    delete state;
+    delete game;
+    return same ? 0 : 1;
+  }
+
+  // generate or load level
+  auto genStart = std::chrono::steady_clock::now();
+  RunningState *state = new RunningState(*game);
+  if (load) {
+    state->ContinueGame();
+  } else {
+    state->NewGame(seed);
+  }
+  game->SetGameState(state);
+  auto genEnd = std::chrono::steady_clock::now();
+
+  // run ticks
+  std::vector<double> tickTimes;
+  tickTimes.reserve(ticks);
+
+  double thinkTime  = 0.0;
+  size_t thinkCount = 0;
+  size_t thinkMax   = 0;
+
+  for (size_t i=0; i<ticks; i++) {
+    auto tickStart = std::chrono::steady_clock::now();
+    bool running = game->Frame();
+    tickTimes.push_back(seconds(std::chrono::steady_clock::now() - tickStart));
+
+    const ThinkScheduler &scheduler = state->GetThinkScheduler();
+    thinkTime  += scheduler.GetThinkTime();
+    thinkCount += scheduler.GetThinkCount();
+    thinkMax    = std::max(thinkMax, scheduler.GetThinkCount());
+
+    if (!running) break;
+  }
+
+  double total = 0.0;
+  for (double t : tickTimes) total += t;
+
+  std::vector<double> sorted(tickTimes);
+  std::sort(sorted.begin(), sorted.end());
+
+  printf("seed       %s\n", seed.c_str());
+  printf("%-10s %10.3f ms\n", load ? "load" : "generate", seconds(genEnd - genStart) * 1000.0);
+  printf("ticks      %10u x %.3f s\n", (unsigned int)tickTimes.size(), step);
+  if (!sorted.empty()) {
+    printf("total      %10.3f ms\n", total * 1000.0);
+    printf("mean       %10.3f ms\n", total / sorted.size() * 1000.0);
+    printf("median     %10.3f ms\n", sorted[sorted.size()/2] * 1000.0);
+    printf("95%%        %10.3f ms\n", sorted[sorted.size()*95/100] * 1000.0);
+    printf("max        %10.3f ms\n", sorted.back() * 1000.0);
+    printf("think      %10.3f ms, %.1f entities per tick (max %u)\n",
+      thinkTime / sorted.size() * 1000.0, (double)thinkCount / sorted.size(), (unsigned int)thinkMax);
+  }
+  printf("\n%s\n", Profile::GetDump().c_str());
+  printf("%s\n", Pool::GetDump().c_str());
+
+  delete game;
+
+  return 0;
+}
@@ -32,7 +32,12 @@
 // useful if you need a reference to yourself
 #define self (*this)
 
-#if (HAVE_LIBOPENAL || HAVE_LIBOPENAL32) && HAVE_LIBOGG && HAVE_LIBVORBISFILE && HAVE_LIBVORBIS
+// headless builds have neither a window nor sound
+#if !HEADLESS
+#define HAVE_GFX 1
+#endif
+
+#if !HEADLESS && (HAVE_LIBOPENAL || HAVE_LIBOPENAL32) && HAVE_LIBOGG && HAVE_LIBVORBISFILE && HAVE_LIBVORBIS
 #define HAVE_AUDIO 1
 #endif
 
@@ -40,6 +45,7 @@
 
 #include "util/profile.h"
 #include "util/log.h"
+#include "util/symbol.h"
 
 enum        Axis          : int8_t;
 enum        Corner        : int8_t;
@@ -50,6 +56,8 @@ enum class  Element       : uint8_t;
 
 struct AABB;
 struct Animation;
+struct CellProperties;
+struct EntityProperties;
 struct FeatureInstance;
 struct IColor;
 struct IVector3;
@@ -59,7 +67,9 @@ struct Point;
 struct Rect;
 struct Sprite;
 struct Stats;
+struct SweepResult;
 struct Texture;
+struct Theme;
 struct Vector3;
 struct Vertex;
 
@@ -84,6 +94,7 @@ class RunningState;
 class Serializer;
 class Shader;
 class VertexBuffer;
+class WorkerPool;
 class World;
 
 namespace Const {
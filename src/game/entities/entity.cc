@@ -17,16 +17,17 @@
 #include "io/input.h"
 #include "math/random.h"
 
-static std::unordered_map<std::string, EntityProperties> allEntities;
+static std::unordered_map<Symbol, EntityProperties> allEntities;
 static std::unordered_map<std::string, std::vector<std::string>> allEntityGroups;
 static EntityProperties defaultEntity;
 
-const EntityProperties *getEntity(const std::string &name) {
-  if (allEntities.find(name) == allEntities.end()) {
+const EntityProperties *getEntity(const Symbol &name) {
+  auto iter = allEntities.find(name);
+  if (iter == allEntities.end()) {
     Log("Properties for entity of type '%s' not found\n", name.c_str());
     return &defaultEntity;
   }
-  return &allEntities[name];
+  return &iter->second;
 }
 
 void
@@ -78,6 +79,7 @@ EntityProperties::ParseProperty(const std::string &cmd) {
   else if (cmd == "learnevade")       this->learnEvade = true;
   else if (cmd == "randomangle")      this->randomAngle = true;
   else if (cmd == "quad")             this->isQuad = true;
+  else if (cmd == "particle")         this->isParticle = true;
 
   else if (cmd == "element")          Parse(this->element);
 
@@ -256,6 +258,26 @@ Entity *Entity::Create(const std::string &type) {
   }
   return entity;
 }
+
+/** Create an entity from a saved game, it has to be continued when added.
+  * @param proto The saved entity.
+  * @return The entity.
+  */
+Entity *Entity::Create(const Entity_Proto &proto) {
+  const EntityProperties &prop = allEntities[proto.type()];
+
+  Entity *entity;
+  switch(prop.klass) {
+    case SpawnClass::EntityClass:     entity = new Entity(proto); break;
+    case SpawnClass::MobClass:        entity = new Mob(proto);    break;
+    case SpawnClass::MonsterClass:    entity = new Monster(proto);    break;
+    case SpawnClass::ItemEntityClass: entity = new ItemEntity(proto); break;
+    case SpawnClass::PlayerClass:     entity = new Player(proto); break;
+    case SpawnClass::ProjectileClass: entity = new Projectile(proto); break;
+    default: entity = nullptr;
+  }
+  return entity;
+}
 /*
 Entity *Entity::Create(const std::string &type, Deserializer &deser) {
   //if (allEntities.find(type) == allEntities.end()) return nullptr;
@@ -274,13 +296,30 @@ Entity *Entity::Create(const std::string &type, Deserializer &deser) {
   return entity;
 }
 */
+Pool Entity::pool("Entity", true);
+
+/** Allocate an entity from the pool of the current level. */
+void *
+Entity::operator new(size_t size) {
+  return pool.Allocate(size);
+}
+
+void
+Entity::operator delete(void *ptr, size_t size) {
+  pool.Free(ptr, size);
+}
+
 Entity::Entity(const std::string &type) :
   removable(false),
   properties(getEntity(type)),
   regulars(),
   baseStats(),
+  statsGeneration(1),
+  effectiveStats(),
+  effectiveStatsGeneration(0),
+  effectiveInventoryGeneration(0),
   aabb(this->properties->extents),
-  lastCell(nullptr),
+  lastCell(),
   cellPos(),
   inventory(),
   sprite(this->properties->sprite),
@@ -303,8 +342,12 @@ Entity::Entity(const Entity_Proto &proto) :
   properties(getEntity(proto.type())),
   regulars(),
   baseStats(),
+  statsGeneration(1),
+  effectiveStats(),
+  effectiveStatsGeneration(0),
+  effectiveInventoryGeneration(0),
   aabb(this->properties->extents),
-  lastCell(nullptr),
+  lastCell(),
   cellPos(),
   inventory(),
   sprite(this->properties->sprite),
@@ -326,6 +369,12 @@ Entity::Start(RunningState &state, uint32_t id) {
   this->proto.set_next_think_time(game.GetTime());
   this->proto.set_start_time(game.GetTime());
 
+  if (this->properties->thinkInterval) {
+    // spread the first think over one interval so that entities spawned
+    // together don't all think in the same frame
+    state.ScheduleThink(*this, game.GetTime() + state.GetRandom().Float01() * this->properties->thinkInterval);
+  }
+
   if (this->properties->randomAngle) {
     this->SetRenderAngle(state.GetRandom().Float01() * 360.0);
   }
@@ -341,14 +390,14 @@ Entity::Start(RunningState &state, uint32_t id) {
   // fill inventory with random crap
   for (auto item : this->properties->items) {
     if (game.GetRandom().Chance(item.second)) {
-      Item *ii;
+      std::shared_ptr<Item> ii;
       if (item.first[0] == '$') {
         std::string itemName = getRandomItem(item.first.substr(1), state.GetLevel(), state.GetRandom());
-        ii = new Item(itemName);
+        ii = Item::Create(itemName);
       } else {
-        ii = new Item(item.first);
+        ii = Item::Create(item.first);
       }
-      this->GetInventory().AddToBackpack(std::shared_ptr<Item>(ii));
+      this->GetInventory().AddToBackpack(ii);
     }
   }
 
@@ -366,6 +415,7 @@ Entity::Start(RunningState &state, uint32_t id) {
   this->baseStats.SetMagicDefenseBonus(this->properties->mdef);
 
   this->baseStats.SetMaxHealthBonus(this->properties->maxHealth);
+  this->InvalidateStats();
 
   this->proto.set_health(this->GetEffectiveStats().GetMaxHealth());
 
@@ -409,9 +459,13 @@ Entity::Start(RunningState &state, uint32_t id) {
 }
 
 void
-Entity::Continue(RunningState &, uint32_t id) {
+Entity::Continue(RunningState &state, uint32_t id) {
   this->proto.set_id(id);
 
+  if (this->properties->thinkInterval) {
+    state.ScheduleThink(*this, this->GetNextThinkTime());
+  }
+
   this->aabb.center = Vector3(this->proto.position().x(), this->proto.position().y(), this->proto.position().z());
   this->aabb.extents = this->properties->extents;
 
@@ -421,10 +475,11 @@ Entity::Continue(RunningState &, uint32_t id) {
   }
 
   this->baseStats = Stats(this->proto.base_stats());
+  this->InvalidateStats();
 
   this->inventory.Clear();
   for (auto &i:this->proto.inventory()) {
-    this->inventory[InventorySlot(i.slot())] = std::shared_ptr<Item>(new Item(i.item()));
+    this->inventory[InventorySlot(i.slot())] = Item::Create(i.item());
   }
 }
 
@@ -462,12 +517,6 @@ Entity::Update(RunningState &state) {
   for (auto &r:this->regulars) r.second.Update(deltaT);
   this->sprite.Update(deltaT);
 
-  // think, mcfly, think
-  while(properties->thinkInterval && this->proto.next_think_time() < t) {
-    this->proto.set_next_think_time(this->proto.next_think_time() + properties->thinkInterval);
-    Think(state);
-  }
-
   this->inventory.Update(state, *this);
   this->smoothPosition.Update(deltaT);
 
@@ -483,11 +532,8 @@ Entity::Update(RunningState &state) {
       e.state += e.rate * deltaT;
 
       for (int n = 0; n<int(e.state); n++) {
-        Mob *particle = new Mob(e.name);
         Vector3 p = Vector3::Random(state.GetRandom()) * e.aabb.extents + e.aabb.center + this->aabb.center;
-        particle->SetPosition(p);
-        particle->AddVelocity(e.velocity);
-        state.AddEntity(particle);
+        state.SpawnParticle(e.name, p, e.velocity);
       }
 
       e.state -= int(e.state);
@@ -498,6 +544,7 @@ Entity::Update(RunningState &state) {
       if (t > it->GetEffect().duration + it->GetStartTime()) {
         state.GetGame().GetAudio().PlaySound(it->GetEffect().removeSound, this->GetPosition());
         it = this->activeBuffs.erase(it);
+        this->InvalidateStats();
       } else {
         it->GetEffect().Update(state, *this);
         if (this->IsDead()) return;
@@ -509,17 +556,17 @@ Entity::Update(RunningState &state) {
   this->cellPos = IVector3(aabb.center.x, aabb.center.y, aabb.center.z);
 
   World &world = state.GetWorld();
-  Cell &cell = world.GetCell(cellPos);
-  if (&cell != this->lastCell) {
-    if (this->lastCell && this->properties->cellLeave != "") {
-      world.SetCell(this->lastCell->GetPosition(), Cell(this->properties->cellLeave));
+  Cell cell = world.GetCell(cellPos);
+  if (cell != this->lastCell) {
+    if (this->lastCell.IsValid() && this->properties->cellLeave != "") {
+      world.SetCell(this->lastCell.GetPosition(), Cell(this->properties->cellLeave));
     }
-    if (this->properties->cellEnter != "") {
+    if (!this->properties->cellEnter.IsEmpty()) {
       world.SetCell(cellPos, Cell(this->properties->cellEnter));
     }
 
-    this->lastCell = &cell;
-  } else if (cell.GetInfo().type != this->properties->cellEnter && this->properties->cellLeave != "") {
+    this->lastCell = cell;
+  } else if (cell.GetInfo().type != this->properties->cellEnter && !this->properties->cellLeave.IsEmpty()) {
     world.SetCell(cellPos, Cell(this->properties->cellEnter));
   }
 
@@ -624,6 +671,7 @@ Entity::Die(RunningState &state, const HealthInfo &info) {
   this->PlaySound(state, "death");
 
   this->activeBuffs.clear();
+  this->InvalidateStats();
 
   if (info.dealerId != InvalidID && state.GetEntity(info.dealerId)) {
     state.GetPlayer().AddDeathMessage(*this, *state.GetEntity(info.dealerId), info);
@@ -631,8 +679,8 @@ Entity::Die(RunningState &state, const HealthInfo &info) {
     state.GetPlayer().AddDeathMessage(*this, info);
   }
 
-  if (this->lastCell && this->properties->cellLeave != "") {
-    state.GetWorld().SetCell(this->lastCell->GetPosition(), Cell(this->properties->cellLeave));
+  if (this->lastCell.IsValid() && this->properties->cellLeave != "") {
+    state.GetWorld().SetCell(this->lastCell.GetPosition(), Cell(this->properties->cellLeave));
   }
 
   if (this->properties->onDieExplodeRadius) {
@@ -661,8 +709,38 @@ Entity::Die(RunningState &state, const HealthInfo &info) {
   }
 }
 
-Stats
+/** Get the stats of the entity including items and buffs. The result is
+  * cached and only calculated again when the base stats, buffs or inventory
+  * have changed since the last call.
+  * @return Effective stats, valid until the next change.
+  */
+const Stats &
 Entity::GetEffectiveStats() const {
+  uint32_t inventoryGeneration = this->inventory.GetGeneration();
+
+  if (this->effectiveStatsGeneration != this->statsGeneration ||
+      this->effectiveInventoryGeneration != inventoryGeneration) {
+    this->effectiveStats = this->CalcEffectiveStats();
+    this->effectiveStatsGeneration = this->statsGeneration;
+    this->effectiveInventoryGeneration = inventoryGeneration;
+  }
+#ifdef CHECK_STATS_CACHE
+  else {
+    Stats stats = this->CalcEffectiveStats();
+    if (!(stats == this->effectiveStats)) {
+      Log("Stale effective stats for entity %u (generation %u)\n", this->GetId(), this->statsGeneration);
+    }
+  }
+#endif
+
+  return this->effectiveStats;
+}
+
+/** Calculate the stats of the entity including items and buffs.
+  * @return Effective stats.
+  */
+Stats
+Entity::CalcEffectiveStats() const {
   Stats stats = this->baseStats;
   this->inventory.ModifyStats(stats);
   for (auto &b : this->activeBuffs) {
@@ -673,7 +751,7 @@ Entity::GetEffectiveStats() const {
 
 void
 Entity::OnHealthDealt(RunningState &state, Entity &, const HealthInfo &info) {
-  if (this->baseStats.AddExperience(info.exp)) {
+  if (this->GetBaseStats().AddExperience(info.exp)) {
     this->proto.set_health(this->GetEffectiveStats().GetMaxHealth());
     this->OnLevelUp(state);
   }
@@ -699,6 +777,7 @@ Entity::AddBuff(RunningState &state, const std::string &name) {
   }
 
   this->activeBuffs.push_back(buff);
+  this->InvalidateStats();
   this->OnBuffAdded(state, buff.GetEffect());
 }
 
@@ -730,13 +809,14 @@ Entity::Teleport(RunningState &state, const Vector3 &target) {
 }
 
 void
-Entity::PlaySound(RunningState &state, const std::string &type) {
-  if (this->properties->sounds.find(type) == this->properties->sounds.end()) return;
-  state.GetGame().GetAudio().PlaySound(this->properties->sounds.at(type), GetSmoothPosition());
+Entity::PlaySound(RunningState &state, const Symbol &type) {
+  auto iter = this->properties->sounds.find(type);
+  if (iter == this->properties->sounds.end()) return;
+  state.GetGame().GetAudio().PlaySound(iter->second, GetSmoothPosition());
 }
 
 void
-Entity::PlaySound(const std::string &type) {
+Entity::PlaySound(const Symbol &type) {
   this->queuedSounds.push_back(type);
 }
 
@@ -769,7 +849,7 @@ Entity::GetProto() {
     }
   }
 
-  *this->proto.mutable_base_stats() = this->baseStats.proto;
+  *this->proto.mutable_base_stats() = this->baseStats.GetProto();
 
   return this->proto;
 }
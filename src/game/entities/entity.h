@@ -5,12 +5,14 @@
 #include "game/gameplay/stats.h"
 #include "game/gameplay/trigger.h"
 #include "game/items/inventory.h"
+#include "game/world/cells/cell.h"
 #include "gfx/sprite.h"
 #include "io/properties.h"
 #include "math/aabb.h"
 #include "math/ivector3.h"
 #include "math/vector3.h"
 #include "util/icolor.h"
+#include "util/pool.h"
 #include "util/smooth.h"
 #include "util/util.h"
 
@@ -34,7 +36,7 @@ struct EntityDrawBox {
 
 struct ParticleEmitter {
   AABB aabb;
-  std::string name;
+  Symbol name;
   Vector3 velocity;
   float rate;
   float state;
@@ -55,6 +57,7 @@ struct EntityProperties : public Properties {
   std::vector<EntityDrawBox> drawBoxes = std::vector<EntityDrawBox>(0);
   std::vector<ParticleEmitter> emitters = std::vector<ParticleEmitter>(0);
   bool    createBubbles     = false;
+  bool    isParticle        = false;  //< Spawn as a pooled particle instead of an entity.
 
   // movement
   float   stepHeight        = 0.5;    //< Allow entity to climb stairs.
@@ -118,7 +121,7 @@ struct EntityProperties : public Properties {
 
   uint32_t  onDieParticles    = 0;
   float   onDieParticleSpeed = 0.0;
-  std::string onDieParticleType = "";
+  Symbol onDieParticleType;
 
   // stats
   int     str               = 0;
@@ -137,10 +140,10 @@ struct EntityProperties : public Properties {
   std::vector<std::pair<std::string, float>> items = std::vector<std::pair<std::string, float>>(0);
 
   /** When entering a cell, replace it with a cell of this type. */
-  std::string cellEnter     = "";
+  Symbol cellEnter;
 
   /** When leaving a cell, replace it with a cell of this type. */
-  std::string cellLeave     = "";
+  Symbol cellLeave;
 
   /** Display name of entity. */
   std::string displayName   = "";
@@ -154,13 +157,13 @@ struct EntityProperties : public Properties {
   /** Replace entity if used with an item. itemname -> new entityname */
   std::unordered_map<std::string, std::string> onUseEntityReplace;
 
-  std::unordered_map<std::string, std::string> sounds;
+  std::unordered_map<Symbol, Symbol> sounds;
 
   virtual void ParseProperty(const std::string &name) override;
 };
 
 void LoadEntities();
-const EntityProperties *getEntity(const std::string &name);
+const EntityProperties *getEntity(const Symbol &name);
 const std::vector<std::string> &GetEntitiesInGroup(const std::string &group);
 float GetEntityProbability(const std::string &type, int level);
 
@@ -168,6 +171,7 @@ class Entity : public Triggerable {
 public:
 
   static Entity *Create(const std::string &type);
+  static Entity *Create(const Entity_Proto &proto);
   //static Entity *Create(const std::string &type, Deserializer &deser);
 
   Entity(const Entity &that) = delete;
@@ -175,6 +179,9 @@ public:
 
   Entity &operator=(const Entity &that) = delete;
 
+  static void *operator new(size_t size);
+  static void operator delete(void *ptr, size_t size);
+
   virtual void Start(RunningState &state, ID id);
   virtual void Continue(RunningState &state, ID id);
   virtual void Update(RunningState &state);
@@ -205,6 +212,9 @@ public:
   ID                        GetOwner()                        const { return this->proto.has_owner_id() ? this->proto.owner_id() : InvalidID; }
   void                      SetOwner(const Entity &owner)           { this->proto.set_owner_id(owner.GetId()); }
 
+  float                     GetNextThinkTime()                const { return this->proto.next_think_time(); }
+  void                      SetNextThinkTime(float t)               { this->proto.set_next_think_time(t); }
+
   // gameplay
 
   bool                      IsSolid()                         const { return properties->isSolid; }
@@ -222,6 +232,7 @@ public:
   void                      SetPosition(const Vector3  &pos)        { this->smoothPosition.SnapTo( this->aabb.center = pos ); }
   void                      SetPosition(const IVector3 &pos)        { this->SetPosition(Vector3(pos) + Vector3(0.5,0.5,0.5)); }
   const Vector3 &           GetPosition()                     const { return this->aabb.center; }
+  Vector3                   GetFeetPosition()                 const { return this->aabb.center - Vector3(0, this->aabb.extents.y, 0); }
 
   void                      SetForward(const Vector3  &p)           { this->proto.mutable_forward()->set_x(p.x); 
                                                                       this->proto.mutable_forward()->set_y(p.y); 
@@ -236,13 +247,14 @@ public:
   const Vector3             GetSmoothEyePosition()            const { return this->GetSmoothPosition() + Vector3(0,this->properties->eyeOffset,0); }
 
   void                      Teleport(RunningState &state, const Vector3 &target);
-  void                      PlaySound(RunningState &state, const std::string &sound);
-  void                      PlaySound(const std::string &sound);
+  void                      PlaySound(RunningState &state, const Symbol &sound);
+  void                      PlaySound(const Symbol &sound);
 
 
   const AABB &              GetAABB()                         const { return this->aabb; }
-  Stats                     GetEffectiveStats()               const;
-  Stats &                   GetBaseStats()                          { return this->baseStats; }
+  const Stats &             GetEffectiveStats()               const;
+  Stats &                   GetBaseStats()                          { this->InvalidateStats(); return this->baseStats; }
+  void                      InvalidateStats()                       { this->statsGeneration++; }
   float                     GetHealth()                       const { return this->proto.health(); }
 
   Element                   GetElement()                      const { return this->properties->element; }
@@ -282,6 +294,8 @@ protected:
   float                     GetDieTime()                      const { return this->proto.die_time(); }
   void                      SetDieTime(float t)                     { this->proto.set_die_time(t); }
 
+  Stats                     CalcEffectiveStats()              const;
+
   Entity_Proto proto;
 
   // management
@@ -289,16 +303,25 @@ protected:
   const EntityProperties *properties;
 
   std::unordered_map<std::string, Regular> regulars;
-  std::vector<std::string> queuedSounds;
+  std::vector<Symbol> queuedSounds;
 
   // gameplay
   Smooth<Vector3> smoothPosition = Smooth<Vector3>(30.0);
 
   Stats baseStats;
   std::vector<Buff> activeBuffs;
+
+  /** Incremented whenever base stats or buffs change. */
+  uint32_t statsGeneration;
+
+  /** Cached result of GetEffectiveStats() and the generations it was calculated for. */
+  mutable Stats effectiveStats;
+  mutable uint32_t effectiveStatsGeneration;
+  mutable uint32_t effectiveInventoryGeneration;
+
   AABB aabb;
 
-  Cell *lastCell;
+  Cell lastCell;
   IVector3 cellPos;
   Inventory inventory;
 
@@ -307,6 +330,10 @@ protected:
   bool drawAABB;
   IColor cellLight;
   std::vector<ParticleEmitter> emitters = std::vector<ParticleEmitter>(0);
+
+private:
+
+  static Pool pool;
 };
 
 #endif
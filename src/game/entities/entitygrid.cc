@@ -0,0 +1,133 @@
+#include "common.h"
+
+#include "game/entities/entity.h"
+#include "game/entities/entitygrid.h"
+
+constexpr int EntityGrid::bucketSize;
+
+/** C'tor. */
+EntityGrid::EntityGrid() :
+  buckets(),
+  keys(),
+  maxExtents()
+{
+}
+
+/** Add an entity at its current position.
+  * @param entity The entity.
+  */
+void
+EntityGrid::Add(Entity *entity) {
+  if (this->keys.find(entity) != this->keys.end()) return;
+
+  const AABB &aabb = entity->GetAABB();
+  this->maxExtents.x = std::max(this->maxExtents.x, aabb.extents.x);
+  this->maxExtents.y = std::max(this->maxExtents.y, aabb.extents.y);
+  this->maxExtents.z = std::max(this->maxExtents.z, aabb.extents.z);
+
+  uint64_t key = GetKey(aabb.center);
+  this->keys[entity] = key;
+  this->buckets[key].push_back(entity);
+}
+
+/** Remove an entity.
+  * @param entity The entity.
+  */
+void
+EntityGrid::Remove(Entity *entity) {
+  auto iter = this->keys.find(entity);
+  if (iter == this->keys.end()) return;
+
+  std::vector<Entity*> &bucket = this->buckets[iter->second];
+  auto bucketIter = std::find(bucket.begin(), bucket.end(), entity);
+  if (bucketIter != bucket.end()) {
+    *bucketIter = bucket.back();
+    bucket.pop_back();
+  }
+  if (bucket.empty()) this->buckets.erase(iter->second);
+
+  this->keys.erase(iter);
+}
+
+/** Move an entity to the bucket of its current position if it has changed.
+  * @param entity The entity.
+  */
+void
+EntityGrid::Move(Entity *entity) {
+  auto iter = this->keys.find(entity);
+  if (iter == this->keys.end()) return;
+  if (iter->second == GetKey(entity->GetAABB().center)) return;
+
+  this->Remove(entity);
+  this->Add(entity);
+}
+
+/** Remove all entities. */
+void
+EntityGrid::Clear() {
+  this->buckets.clear();
+  this->keys.clear();
+  this->maxExtents = Vector3();
+}
+
+/** Find all entities whose center is within a radius around a position.
+  * @param center Center of the sphere.
+  * @param radius Radius of the sphere.
+  * @param[out] entities The entities found are appended to this.
+  */
+void
+EntityGrid::FindInRadius(const Vector3 &center, float radius, std::vector<Entity*> &entities) const {
+  Vector3 r(radius, radius, radius);
+  this->ForEach(center - r, center + r, [&](Entity *entity) {
+    if ((entity->GetPosition() - center).GetMag() < radius) entities.push_back(entity);
+  });
+}
+
+/** Find all entities whose bounding box overlaps a box.
+  * @param aabb The box.
+  * @param[out] entities The entities found are appended to this.
+  */
+void
+EntityGrid::FindInAABB(const AABB &aabb, std::vector<Entity*> &entities) const {
+  this->ForEach(aabb.Min() - this->maxExtents, aabb.Max() + this->maxExtents, [&](Entity *entity) {
+    if (aabb.Overlap(entity->GetAABB())) entities.push_back(entity);
+  });
+}
+
+/** Find all pairs of entities whose bounding boxes overlap. Each pair is
+  * reported once, ordered by entity id so the result does not depend on
+  * where the entities live in memory.
+  * @param[out] pairs The pairs found are appended to this.
+  */
+void
+EntityGrid::FindPairs(std::vector<std::pair<Entity*, Entity*>> &pairs) const {
+  for (auto &bucket : this->buckets) {
+    for (Entity *e1 : bucket.second) {
+      const AABB &aabb = e1->GetAABB();
+      Vector3 reach = aabb.extents + this->maxExtents;
+
+      this->ForEach(aabb.center - reach, aabb.center + reach, [&](Entity *e2) {
+        if (e2->GetId() <= e1->GetId()) return;
+        if (aabb.Overlap(e2->GetAABB())) pairs.push_back(std::make_pair(e1, e2));
+      });
+    }
+  }
+}
+
+int
+EntityGrid::GetCoord(float v) {
+  // keep far away entities from overflowing the key
+  if (!(v > -1000000.0f)) v = -1000000.0f;
+  if (!(v <  1000000.0f)) v =  1000000.0f;
+  return (int)std::floor(v / bucketSize);
+}
+
+uint64_t
+EntityGrid::GetKey(int x, int y, int z) {
+  return ((uint64_t)(x & 0x1fffff) << 42) | ((uint64_t)(y & 0x1fffff) << 21) | (uint64_t)(z & 0x1fffff);
+}
+
+uint64_t
+EntityGrid::GetKey(const Vector3 &pos) {
+  return GetKey(GetCoord(pos.x), GetCoord(pos.y), GetCoord(pos.z));
+}
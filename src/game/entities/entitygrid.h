@@ -0,0 +1,76 @@
+#ifndef BARFOOS_ENTITYGRID_H
+#define BARFOOS_ENTITYGRID_H
+
+#include "common.h"
+
+#include "math/aabb.h"
+
+/** Uniform grid of entities for finding entities near a position.
+  * Entities are sorted into buckets by the cell coordinates of the center
+  * of their bounding box. Queries look at all buckets that may contain a
+  * matching entity, taking into account the largest extents of any entity
+  * in the grid.
+  */
+class EntityGrid final {
+public:
+
+                            EntityGrid          ();
+                            EntityGrid          (const EntityGrid &) = delete;
+
+  EntityGrid &              operator=           (const EntityGrid &) = delete;
+
+  void                      Add                 (Entity *entity);
+  void                      Remove              (Entity *entity);
+  void                      Move                (Entity *entity);
+  void                      Clear               ();
+
+  void                      FindInRadius        (const Vector3 &center, float radius, std::vector<Entity*> &entities) const;
+  void                      FindInAABB          (const AABB &aabb, std::vector<Entity*> &entities) const;
+  void                      FindPairs           (std::vector<std::pair<Entity*, Entity*>> &pairs) const;
+
+private:
+
+  /** Edge length of a bucket in cells. */
+  static constexpr int      bucketSize = 2;
+
+  std::unordered_map<uint64_t, std::vector<Entity*>> buckets;
+  std::unordered_map<const Entity *, uint64_t> keys;
+
+  /** Largest extents of any entity added to the grid. */
+  Vector3                   maxExtents;
+
+  static int                GetCoord            (float v);
+  static uint64_t           GetKey              (int x, int y, int z);
+  static uint64_t           GetKey              (const Vector3 &pos);
+
+  template<class F> void    ForEach             (const Vector3 &min, const Vector3 &max, F func) const;
+};
+
+/** Call a function for each entity whose center lies in a bucket touched
+  * by a box.
+  * @param min Minimum corner of the box.
+  * @param max Maximum corner of the box.
+  * @param func Function to call with each entity.
+  */
+template<class F> void
+EntityGrid::ForEach(const Vector3 &min, const Vector3 &max, F func) const {
+  int x0 = GetCoord(min.x), x1 = GetCoord(max.x);
+  int y0 = GetCoord(min.y), y1 = GetCoord(max.y);
+  int z0 = GetCoord(min.z), z1 = GetCoord(max.z);
+
+  for (int z=z0; z<=z1; z++) {
+    for (int y=y0; y<=y1; y++) {
+      for (int x=x0; x<=x1; x++) {
+        auto iter = this->buckets.find(GetKey(x, y, z));
+        if (iter == this->buckets.end()) continue;
+
+        for (Entity *entity : iter->second) {
+          func(entity);
+        }
+      }
+    }
+  }
+}
+
+#endif
+
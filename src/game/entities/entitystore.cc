@@ -0,0 +1,191 @@
+#include "common.h"
+
+#include "game/entities/entity.h"
+#include "game/entities/entitystore.h"
+
+constexpr size_t   EntityStore::indexBits;
+constexpr uint32_t EntityStore::indexMask;
+constexpr uint32_t EntityStore::maxGeneration;
+constexpr size_t   EntityStore::classCount;
+
+/** C'tor. */
+EntityStore::EntityStore() :
+  slots(),
+  freeSlots(),
+  dense(),
+  denseSlots()
+{
+}
+
+/** Add an entity. The store does not take ownership of the entity.
+  * @param entity The entity.
+  * @return Id of the entity, InvalidID if the store is full.
+  */
+ID
+EntityStore::Add(Entity *entity) {
+  if (!entity) return InvalidID;
+
+  uint32_t slotIndex;
+  if (!this->freeSlots.empty()) {
+    slotIndex = this->freeSlots.back();
+    this->freeSlots.pop_back();
+  } else {
+    if (this->slots.size() > indexMask) return InvalidID;
+    slotIndex = this->slots.size();
+    this->slots.push_back(Slot());
+  }
+
+  size_t k = GetClassIndex(entity->GetProperties()->klass);
+
+  Slot &slot = this->slots[slotIndex];
+  slot.klass      = k;
+  slot.used       = true;
+  slot.denseIndex = this->dense[k].size();
+
+  this->dense[k].push_back(entity);
+  this->denseSlots[k].push_back(slotIndex);
+
+  return (slot.generation << indexBits) | slotIndex;
+}
+
+/** Add an entity under a given id, e.g. the one it had in a saved game.
+  * The store does not take ownership of the entity.
+  * @param id Id of the entity.
+  * @param entity The entity.
+  * @return false if the id is invalid or already in use.
+  */
+bool
+EntityStore::Insert(ID id, Entity *entity) {
+  uint32_t slotIndex  = id & indexMask;
+  uint32_t generation = id >> indexBits;
+
+  if (!entity || generation == 0 || generation > maxGeneration) return false;
+
+  while(this->slots.size() <= slotIndex) {
+    this->freeSlots.push_back(this->slots.size());
+    this->slots.push_back(Slot());
+  }
+
+  Slot &slot = this->slots[slotIndex];
+  if (slot.used) return false;
+
+  this->freeSlots.erase(std::find(this->freeSlots.begin(), this->freeSlots.end(), slotIndex));
+
+  size_t k = GetClassIndex(entity->GetProperties()->klass);
+
+  slot.generation = generation;
+  slot.klass      = k;
+  slot.used       = true;
+  slot.denseIndex = this->dense[k].size();
+
+  this->dense[k].push_back(entity);
+  this->denseSlots[k].push_back(slotIndex);
+
+  return true;
+}
+
+/** Get an entity by its id.
+  * @param id Id of the entity.
+  * @return The entity or nullptr if there is no entity with that id.
+  */
+Entity *
+EntityStore::Get(ID id) const {
+  const Slot *slot = this->FindSlot(id);
+  if (!slot) return nullptr;
+  return this->dense[slot->klass][slot->denseIndex];
+}
+
+/** Remove an entity by its id. The store does not delete the entity.
+  * @param id Id of the entity.
+  * @return The removed entity or nullptr if there is no entity with that id.
+  */
+Entity *
+EntityStore::Remove(ID id) {
+  const Slot *slot = this->FindSlot(id);
+  if (!slot) return nullptr;
+
+  Entity *entity = this->dense[slot->klass][slot->denseIndex];
+  this->Erase(id & indexMask);
+  return entity;
+}
+
+/** Remove all entities without deleting them. Ids handed out before stay
+  * invalid.
+  */
+void
+EntityStore::Clear() {
+  this->freeSlots.clear();
+  for (uint32_t i=this->slots.size(); i>0; i--) {
+    if (this->slots[i-1].used) this->Erase(i-1);
+    else this->freeSlots.push_back(i-1);
+  }
+}
+
+/** Get the number of entities.
+  * @return Number of entities in the store.
+  */
+size_t
+EntityStore::GetCount() const {
+  size_t count = 0;
+  for (size_t k=0; k<classCount; k++) {
+    count += this->dense[k].size();
+  }
+  return count;
+}
+
+/** Get the number of entities of a spawn class.
+  * @param klass The spawn class.
+  * @return Number of entities of that class in the store.
+  */
+size_t
+EntityStore::GetCount(SpawnClass klass) const {
+  return this->dense[GetClassIndex(klass)].size();
+}
+
+const EntityStore::Slot *
+EntityStore::FindSlot(ID id) const {
+  uint32_t slotIndex  = id & indexMask;
+  uint32_t generation = id >> indexBits;
+
+  if (slotIndex >= this->slots.size()) return nullptr;
+
+  const Slot &slot = this->slots[slotIndex];
+  if (!slot.used || slot.generation != generation) return nullptr;
+  return &slot;
+}
+
+/** Free a used slot and fill the gap in the dense array of its class with
+  * the last entity of that class.
+  * @param slotIndex Index of the slot.
+  */
+void
+EntityStore::Erase(uint32_t slotIndex) {
+  Slot &slot = this->slots[slotIndex];
+  std::vector<Entity*>  &entities = this->dense[slot.klass];
+  std::vector<uint32_t> &owners   = this->denseSlots[slot.klass];
+
+  uint32_t last = owners.back();
+  entities[slot.denseIndex] = entities.back();
+  owners  [slot.denseIndex] = last;
+  this->slots[last].denseIndex = slot.denseIndex;
+
+  entities.pop_back();
+  owners.pop_back();
+
+  slot.used       = false;
+  slot.generation = slot.generation == maxGeneration ? 1 : slot.generation + 1;
+  this->freeSlots.push_back(slotIndex);
+}
+
+size_t
+EntityStore::GetClassIndex(SpawnClass klass) {
+  switch(klass) {
+    case SpawnClass::EntityClass:     return 0;
+    case SpawnClass::MobClass:        return 1;
+    case SpawnClass::MonsterClass:    return 2;
+    case SpawnClass::ItemEntityClass: return 3;
+    case SpawnClass::PlayerClass:     return 4;
+    case SpawnClass::ProjectileClass: return 5;
+  }
+  return 0;
+}
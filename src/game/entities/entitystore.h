@@ -0,0 +1,99 @@
+#ifndef BARFOOS_ENTITYSTORE_H
+#define BARFOOS_ENTITYSTORE_H
+
+#include "common.h"
+
+#include <vector>
+
+/** Generational slot map of all entities of a running game.
+  * An entity id consists of a slot index and the generation of that slot,
+  * so ids of removed entities are not mistaken for whatever later reuses
+  * their slot. The slots point into dense arrays that are kept separately
+  * for each spawn class and are iterated without gaps. Removing an entity
+  * moves the last entity of its class into its place.
+  */
+class EntityStore final {
+public:
+
+                            EntityStore         ();
+                            EntityStore         (const EntityStore &) = delete;
+
+  EntityStore &             operator=           (const EntityStore &) = delete;
+
+  ID                        Add                 (Entity *entity);
+  bool                      Insert              (ID id, Entity *entity);
+  Entity *                  Get                 (ID id)                                   const;
+  Entity *                  Remove              (ID id);
+  void                      Clear               ();
+
+  size_t                    GetCount            ()                                        const;
+  size_t                    GetCount            (SpawnClass klass)                        const;
+
+  template<class F> void    ForEach             (F func)                                  const;
+  template<class F> void    RemoveIf            (F func);
+
+private:
+
+  /** Number of bits of an id that hold the slot index. */
+  static constexpr size_t   indexBits           = 20;
+  static constexpr uint32_t indexMask           = (1<<indexBits)-1;
+
+  /** Largest generation of a slot, the next one wraps around to 1. */
+  static constexpr uint32_t maxGeneration       = 0xFFE;
+
+  /** Number of spawn classes. */
+  static constexpr size_t   classCount          = 6;
+
+  struct Slot {
+    uint32_t generation = 1;
+    uint8_t  klass      = 0;
+    bool     used       = false;
+    uint32_t denseIndex = 0;
+  };
+
+  std::vector<Slot>         slots;
+  std::vector<uint32_t>     freeSlots;
+
+  /** Entities and their slot indices, packed per spawn class. */
+  std::vector<Entity*>      dense[classCount];
+  std::vector<uint32_t>     denseSlots[classCount];
+
+  const Slot *              FindSlot            (ID id)                                   const;
+  void                      Erase               (uint32_t slotIndex);
+
+  static size_t             GetClassIndex       (SpawnClass klass);
+};
+
+/** Call a function for each entity. Entities added by the function are
+  * visited as well, removing entities from the store while iterating
+  * may skip an entity.
+  * @param func Function to call with each entity.
+  */
+template<class F> void
+EntityStore::ForEach(F func) const {
+  for (size_t k=0; k<classCount; k++) {
+    for (size_t i=0; i<this->dense[k].size(); i++) {
+      func(this->dense[k][i]);
+    }
+  }
+}
+
+/** Remove all entities for which a function returns true. The store does
+  * not delete the entities, the function has to take care of that.
+  * @param func Function to call with each entity.
+  */
+template<class F> void
+EntityStore::RemoveIf(F func) {
+  for (size_t k=0; k<classCount; k++) {
+    size_t i = 0;
+    while(i < this->dense[k].size()) {
+      if (func(this->dense[k][i])) {
+        this->Erase(this->denseSlots[k][i]);
+      } else {
+        i++;
+      }
+    }
+  }
+}
+
+#endif
@@ -8,15 +8,29 @@
 #include "game/world/world.h"
 #include "util/util.h"
 
+Pool Mob::pool("Mob", true);
+
+/** Allocate a mob from the pool of the current level. */
+void *
+Mob::operator new(size_t size) {
+  return pool.Allocate(size);
+}
+
+void
+Mob::operator delete(void *ptr, size_t size) {
+  pool.Free(ptr, size);
+}
+
 Mob::Mob(const std::string &propertyName) :
   Entity          (propertyName),
 
   move            (0, 0, 0),
   doesWantJump        (false),
 
-  headCell        (nullptr),
-  footCell        (nullptr),
-  groundCell      (nullptr)
+  headCell        (),
+  footCell        (),
+  groundCell      (),
+  cellSelections  ()
 {
   this->proto.set_spawn_class(uint32_t(SpawnClass::MobClass));
   this->proto.mutable_mob();
@@ -32,9 +46,10 @@ Mob::Mob(const Entity_Proto &proto) :
   move            (0, 0, 0),
   doesWantJump        (false),
 
-  headCell        (nullptr),
-  footCell        (nullptr),
-  groundCell      (nullptr)
+  headCell        (),
+  footCell        (),
+  groundCell      (),
+  cellSelections  ()
 {
 }
 
@@ -47,8 +62,8 @@ Mob::Start(RunningState &state, ID id) {
 
   if (this->properties->createBubbles) {
     this->regulars["bubble"] = Regular(0.2, [&]() {
-      if (this->footCell && this->footCell->IsLiquid())
-        state.SpawnInAABB("particle.bubble", this->footCell->GetAABB(), Vector3());
+      if (this->footCell.IsValid() && this->footCell.IsLiquid())
+        state.SpawnInAABB("particle.bubble", this->footCell.GetAABB(), Vector3());
     });
   }
 }
@@ -59,8 +74,8 @@ Mob::Continue(RunningState &state, ID id) {
 
   if (this->properties->createBubbles) {
     this->regulars["bubble"] = Regular(0.2, [&]() {
-      if (this->footCell && this->footCell->IsLiquid())
-        state.SpawnInAABB("particle.bubble", this->footCell->GetAABB(), Vector3());
+      if (this->footCell.IsValid() && this->footCell.IsLiquid())
+        state.SpawnInAABB("particle.bubble", this->footCell.GetAABB(), Vector3());
     });
   }
 }
@@ -84,8 +99,8 @@ Mob::Update(RunningState &state) {
   if (speed > maxSpeed) move = move * (maxSpeed/speed);
 
   float gravity = 3 * 9.81 * deltaT * this->properties->gravity;
-  float footFriction = 1.0 / (this->footCell ? this->footCell->GetInfo().speedModifier : 1.0);
-  float groundFriction = this->groundCell ? this->groundCell->GetInfo().friction : 0.1;
+  float footFriction = 1.0 / (this->footCell.IsValid() ? this->footCell.GetInfo().speedModifier : 1.0);
+  float groundFriction = this->groundCell.IsValid() ? this->groundCell.GetInfo().friction : 0.1;
   float friction = 1.0 / (1.0+deltaT * 10 * footFriction * groundFriction);
 
   Vector3 velocity = this->GetVelocity();
@@ -116,7 +131,8 @@ Mob::Update(RunningState &state) {
     if (doesWantJump && this->IsOnGround()) {
       if (game.GetTime() - this->GetLastJumpTime() > 0.5) {
         tvy = velocity.y = properties->jumpSpeed;
-        this->PlaySound(state, "jump");
+        static const Symbol jump("jump");
+        this->PlaySound(state, jump);
         this->SetLastJumpTime(game.GetTime());
       }
     }
@@ -137,49 +153,24 @@ Mob::Update(RunningState &state) {
   World &world = state.GetWorld();
   uint8_t axesTotal = 0;
   bool isMovingDown = velocity.y <= 0;
-  Cell *cell = nullptr;
+  Cell cell;
   Side side;
 
   if (this->IsNoclip()) {
     aabb.center = aabb.center + velocity * deltaT;
-  } else if (isMovingDown) {
-    Vector3 oldCenter = aabb.center;
-    Vector3 org = aabb.center + velocity.Horiz() * deltaT;
-    uint8_t axesForward = 0, axesDown = 0;
-
+  } else {
     // when moving down and pushing use step height
-    Vector3 step(0, (move.GetMag()!=0 && !this->IsSneaking()) ? this->properties->stepHeight : 0, 0);
-
-    // move up, forward, down
-    aabb.center = world.MoveAABB(aabb, aabb.center + step);
-    aabb.center = world.MoveAABB(aabb, aabb.center + velocity.Horiz()*deltaT, axesForward, &cell, &side, this->IsSneaking() && this->IsOnGround());
-    aabb.center = world.MoveAABB(aabb, aabb.center - step*1.25 + velocity.Vert()*deltaT, axesDown, cell ? nullptr : &cell, &side);
-
-    axesTotal |= axesForward | axesDown;
-
-    bool didHitFloor = axesDown & Axis::Y;
-
-    this->SetOnGround(didHitFloor);
+    float stepHeight = (isMovingDown && move.GetMag()!=0 && !this->IsSneaking()) ? this->properties->stepHeight : 0;
+    bool sneak = isMovingDown && this->IsSneaking() && this->IsOnGround();
 
-    org.y = aabb.center.y;
-    aabb.center = world.MoveAABB(aabb, org, axesDown, nullptr, nullptr, this->IsSneaking() && this->IsOnGround());
-    axesTotal |= axesDown;
+    SweepResult sweep;
+    aabb.center = state.SweepAABB(aabb, velocity * deltaT, sweep, stepHeight, sneak);
 
-    if (!didHitFloor) aabb.center = aabb.center + step*0.25;
+    axesTotal = sweep.axis;
+    cell      = sweep.cell;
+    side      = sweep.side;
 
-    // check collision with entities
-    Vector3 newCenter = aabb.center;
-    uint8_t axesEntities = 0;
-    aabb.center = oldCenter;
-    aabb.center = state.MoveAABB(aabb, newCenter, axesEntities);
-    axesTotal |= axesEntities;
-  } else {
-    // moving up
-    this->SetOnGround(false);
-    uint8_t axesWorld = 0, axesEntities = 0;
-    Vector3 newCenter = world.MoveAABB(aabb, aabb.center + velocity*deltaT, axesWorld, &cell, &side);
-    aabb.center = state.MoveAABB(aabb, newCenter, axesEntities);
-    axesTotal |= axesWorld | axesEntities;
+    this->SetOnGround(isMovingDown && (sweep.axis & Axis::Y));
   }
 
   bool didCollideHorizontal = axesTotal & Axis::Horizontal;
@@ -188,9 +179,9 @@ Mob::Update(RunningState &state) {
   // update new target position for smoothing
   this->smoothPosition = this->aabb.center;
 
-  if (cell && !this->properties->nocollideCell) {
+  if (cell.IsValid() && !this->properties->nocollideCell) {
     Entity *e = this; // WTF? GCC bug?
-    e->OnCollide(state, *cell, side);
+    e->OnCollide(state, cell, side);
   }
 
   // jump out of water
@@ -199,17 +190,18 @@ Mob::Update(RunningState &state) {
   }
 
   // open doors
-  if (didCollideHorizontal && cell && properties->onCollideUseCell) {
-    cell->OnUse(state, *this);
+  if (didCollideHorizontal && cell.IsValid() && properties->onCollideUseCell) {
+    cell.OnUse(state, *this);
   }
 
   // fall damage
   if (didCollideVertical) {
+    static const Symbol land("land"), landHard("land.hard");
     if (velocity.y < -6) {
-      this->PlaySound(state, "land");
+      this->PlaySound(state, land);
     }
     if (velocity.y < -15) {
-      this->PlaySound(state, "land.hard");
+      this->PlaySound(state, landHard);
       AddHealth(state, HealthInfo( (velocity.y+15)/5, HealthType::Falling));
     }
     velocity.y = 0;
@@ -221,27 +213,27 @@ Mob::Update(RunningState &state) {
   IVector3 footPos(aabb.center.x, aabb.center.y - aabb.extents.y, aabb.center.z);
   IVector3 headPos(aabb.center.x, aabb.center.y + aabb.extents.y, aabb.center.z);
 
-  footCell = &world.GetCell(footPos);
-  headCell = &world.GetCell(headPos);
+  footCell = world.GetCell(footPos);
+  headCell = world.GetCell(headPos);
 
-  Cell *newGroundCell = nullptr;
+  Cell newGroundCell;
   if (this->IsOnGround()) {
-    newGroundCell = &world.GetCell(footPos[Side::Down]);
+    newGroundCell = world.GetCell(footPos[Side::Down]);
   }
 
   if (newGroundCell != groundCell) {
-    if (groundCell && !properties->noStep) groundCell->OnStepOff(state, *this);
+    if (groundCell.IsValid() && !properties->noStep) groundCell.OnStepOff(state, *this);
     groundCell = newGroundCell;
-    if (groundCell && !properties->noStep) groundCell->OnStepOn(state, *this);
+    if (groundCell.IsValid() && !properties->noStep) groundCell.OnStepOn(state, *this);
   }
 
-  this->SetSubmerged(headCell->IsLiquid());
-  if (!this->IsNoclip()) this->SetInLiquid(footCell->GetInfo().flags & (CellFlags::Liquid | CellFlags::Ladder));
+  this->SetSubmerged(headCell.IsLiquid());
+  if (!this->IsNoclip()) this->SetInLiquid(footCell.GetInfo().flags & (CellFlags::Liquid | CellFlags::Ladder));
 
-  if (footCell->GetInfo().lavaDamage) {
-    this->AddHealth(state, HealthInfo( -footCell->GetInfo().lavaDamage * deltaT, HealthType::Lava));
-  } else if (headCell->GetInfo().lavaDamage) {
-    this->AddHealth(state, HealthInfo( -headCell->GetInfo().lavaDamage * deltaT, HealthType::Lava));
+  if (footCell.GetInfo().lavaDamage) {
+    this->AddHealth(state, HealthInfo( -footCell.GetInfo().lavaDamage * deltaT, HealthType::Lava));
+  } else if (headCell.GetInfo().lavaDamage) {
+    this->AddHealth(state, HealthInfo( -headCell.GetInfo().lavaDamage * deltaT, HealthType::Lava));
   }
 
   if (this->IsDead()) {
@@ -287,11 +279,11 @@ float
 Mob::GetMoveModifier() const {
   float mod = 1.0;
   if (this->IsSneaking()) mod *= 0.5;
-  if (this->footCell) mod *= this->footCell->GetInfo().speedModifier;
+  if (this->footCell.IsValid()) mod *= this->footCell.GetInfo().speedModifier;
   return mod * (1.0 + GetEffectiveStats().GetAgility() * Const::WalkSpeedFactorPerAGI);
 }
 
-Cell *
+Cell
 Mob::GetSelection(RunningState &state, float range, const std::shared_ptr<Item> &item, Side &selectedCellSide, ID &entityId) {
   Vector3 dir = this->GetForward();
   Vector3 pos = this->GetSmoothEyePosition();
@@ -323,13 +315,62 @@ Mob::GetSelection(RunningState &state, float range, const std::shared_ptr<Item>
   size_t flags = CellFlags::Pickable;
   if (item && item->GetProperties().pickLiquid) flags |= CellFlags::Liquid;
 
-  Cell &cell = state.GetWorld().CastRayCell(pos, dir, hitDist, selectedCellSide, flags);
-  if (hitDist < dist) {
+  const CellSelection &selection = this->GetCellSelection(state, pos, dir, flags);
+  selectedCellSide = selection.side;
+  if (selection.distance < dist) {
     entityId = InvalidID;
-    return &cell;
+    return selection.cell;
   } else {
-    return nullptr;
+    return Cell();
+  }
+}
+
+/** Get the first cell hit by a ray. The result is kept for the rest of the
+  * frame, so the player, spells and the inventory can all ask for the
+  * selection without casting the ray again as long as neither the ray nor
+  * the world have changed.
+  * @param state Running state.
+  * @param pos Ray origin.
+  * @param dir Ray direction.
+  * @param flags Flags a cell can have to be hit.
+  * @return The selection, distance is infinite if no cell was hit.
+  */
+const Mob::CellSelection &
+Mob::GetCellSelection(RunningState &state, const Vector3 &pos, const Vector3 &dir, size_t flags) {
+  float  t          = state.GetGame().GetTime();
+  size_t generation = state.GetWorld().GetCellGeneration();
+
+  CellSelection *selection = nullptr;
+  for (auto &s : this->cellSelections) {
+    if (s.flags == flags) {
+      selection = &s;
+      break;
+    }
   }
+
+  if (selection &&
+      selection->time == t &&
+      selection->worldGeneration == generation &&
+      selection->pos == pos &&
+      selection->dir == dir) {
+    return *selection;
+  }
+
+  if (!selection) {
+    this->cellSelections.push_back(CellSelection());
+    selection = &this->cellSelections.back();
+    selection->flags = flags;
+  }
+
+  selection->time            = t;
+  selection->pos             = pos;
+  selection->dir             = dir;
+  selection->worldGeneration = generation;
+  selection->distance        = INFINITY;
+  selection->side            = Side::Up;
+  selection->cell            = state.GetWorld().CastRayCell(pos, dir, selection->distance, selection->side, flags);
+
+  return *selection;
 }
 
 bool
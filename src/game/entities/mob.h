@@ -13,6 +13,9 @@ public:
 
   Mob &                     operator=   (const Mob &that) = delete;
 
+  static void *             operator new    (size_t size);
+  static void               operator delete (void *ptr, size_t size);
+
   virtual void              Start       (RunningState &state, ID id)                  override;
   virtual void              Continue    (RunningState &state, ID id)                  override;
   virtual void              Update      (RunningState &state)                         override;
@@ -42,7 +45,7 @@ public:
   bool                      IsInLiquid  ()                                            const           { return this->proto.mob().is_in_liquid(); }
   bool                      IsSubmerged ()                                            const           { return this->proto.mob().is_submerged(); }
 
-  Cell *                    GetSelection    (RunningState &state, float range, const std::shared_ptr<Item> &item, Side &selectedCellSide, ID &entityId);
+  Cell                      GetSelection    (RunningState &state, float range, const std::shared_ptr<Item> &item, Side &selectedCellSide, ID &entityId);
   bool                      HasLearntSpell  (const std::string &name) const;
   virtual void              LearnSpell      (const std::string &name);
 
@@ -51,14 +54,36 @@ protected:
   Vector3               move;
   bool                  doesWantJump;
 
-  Cell *                headCell;
-  Cell *                footCell;
-  Cell *                groundCell;
+  Cell                  headCell;
+  Cell                  footCell;
+  Cell                  groundCell;
 
   float                     GetLastJumpTime () const  { return this->proto.mob().last_jump_time(); }
   void                      SetLastJumpTime (float t) { this->proto.mutable_mob()->set_last_jump_time(t); }
 
   float                     GetMoveModifier () const;
+
+private:
+
+  /** Result of casting the look-at ray into the world. */
+  struct CellSelection {
+    float   time;
+    Vector3 pos;
+    Vector3 dir;
+    size_t  flags;
+    size_t  worldGeneration;
+
+    Cell    cell;
+    Side    side;
+    float   distance;
+  };
+
+  /** Cell selections of the current frame, one for each set of cell flags. */
+  std::vector<CellSelection> cellSelections;
+
+  const CellSelection &     GetCellSelection(RunningState &state, const Vector3 &pos, const Vector3 &dir, size_t flags);
+
+  static Pool               pool;
 };
 
 
@@ -5,9 +5,23 @@
 #include "game/gamestates/running/runningstate.h"
 #include "game/items/item.h"
 #include "game/world/cells/cell.h"
+#include "game/world/navfield.h"
 #include "game/world/world.h"
 #include "util/util.h"
 
+Pool Monster::pool("Monster", true);
+
+/** Allocate a monster from the pool of the current level. */
+void *
+Monster::operator new(size_t size) {
+  return pool.Allocate(size);
+}
+
+void
+Monster::operator delete(void *ptr, size_t size) {
+  pool.Free(ptr, size);
+}
+
 Monster::Monster(const std::string &propertyName) :
   Mob             (propertyName)
 {
@@ -30,7 +44,7 @@ Monster::Start(RunningState &state, ID id) {
   Mob::Start(state, id);
 
   if (properties->attackItem != "") {
-    this->attackItem = std::shared_ptr<Item>(new Item(properties->attackItem));
+    this->attackItem = Item::Create(properties->attackItem);
     this->attackItem->Update(state);
   }
 }
@@ -40,7 +54,7 @@ Monster::Continue(RunningState &state, ID id) {
   Mob::Continue(state, id);
 
   if (properties->attackItem != "") {
-    this->attackItem = std::shared_ptr<Item>(new Item(properties->attackItem));
+    this->attackItem = Item::Create(properties->attackItem);
     this->attackItem->Update(state);
   }
 }
@@ -76,9 +90,13 @@ Monster::Think(RunningState &state) {
         // out of range? -> unset attack target
         this->ClearAttackTarget();
       } else if (!CanSee(state, enemy->GetPosition())) {
-        // not visible? -> set move target to last known location, unset attack target
-        this->SetMoveTarget(enemy->GetPosition());
-        this->ClearAttackTarget();
+        // not visible? -> keep following the way to the player if it is short enough,
+        // otherwise set move target to last known location, unset attack target
+        uint16_t steps = state.GetWorld().GetNavField().GetDistance(this->GetFeetPosition());
+        if (!this->IsNavTarget(*enemy) || steps > this->properties->aggroRangeFar) {
+          this->SetMoveTarget(enemy->GetPosition());
+          this->ClearAttackTarget();
+        }
       } else if (dist < this->properties->meleeAttackRange &&
                  dist >= this->properties->keepDistance &&
                  state.GetGame().GetTime() > this->GetNextAttackTime()) {
@@ -139,11 +157,21 @@ Monster::Think(RunningState &state) {
       Vector3 fwd    = dir.Normalize();
       this->SetForward(fwd);
 
-      // dont get too close
-      dir = dir - fwd * this->properties->keepDistance;
+      Vector3 step;
+      if (this->IsNavTarget(*enemy) &&
+          dir.GetMag() > this->properties->meleeAttackRange + 1.0f &&
+          state.GetWorld().GetNavField().GetDirection(this->GetFeetPosition(), step)) {
+        // follow the way around obstacles
+        Vector3 shoriz = step.Horiz();
+        move = shoriz.GetMag() > 0.01f ? shoriz.Normalize() * this->properties->maxSpeed : Vector3();
+        if (step.y > 0.0f) this->doesWantJump = true;
+      } else {
+        // dont get too close
+        dir = dir - fwd * this->properties->keepDistance;
 
-      Vector3 dhoriz = dir.Horiz();
-      move = dhoriz.Normalize() * this->properties->maxSpeed;
+        Vector3 dhoriz = dir.Horiz();
+        move = dhoriz.Normalize() * this->properties->maxSpeed;
+      }
 
     } else {
       this->ClearAttackTarget();
@@ -169,6 +197,16 @@ Monster::Think(RunningState &state) {
   }
 }
 
+/** Check whether the way to an entity can be looked up in the navigation
+  * field of the world, which leads to the player.
+  * @param entity The entity.
+  * @return true if the entity is the player.
+  */
+bool
+Monster::IsNavTarget(const Entity &entity) const {
+  return entity.GetProperties()->name == "player";
+}
+
 void
 Monster::OnCollide(RunningState &state, Entity &other) {
   Mob::OnCollide(state, other);
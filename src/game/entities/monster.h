@@ -14,6 +14,9 @@ public:
 
   Monster &                 operator=   (const Monster &that) = delete;
 
+  static void *             operator new    (size_t size);
+  static void               operator delete (void *ptr, size_t size);
+
   virtual void              Start       (RunningState &state, ID id)                  override;
   virtual void              Continue    (RunningState &state, ID id)                  override;
   virtual void              Update      (RunningState &state)                         override;
@@ -44,9 +47,15 @@ protected:
   void                      SetAttackTarget(ID target)                                          { this->proto.mutable_monster()->set_attack_target(target); }
   ID                        GetAttackTarget()                                             const { return this->proto.monster().attack_target(); }
 
+  bool                      IsNavTarget(const Entity &entity)                             const;
+
 
   // from properties:
   std::shared_ptr<Item>     attackItem;
+
+private:
+
+  static Pool               pool;
 };
 
 
@@ -0,0 +1,241 @@
+#include "common.h"
+
+#include "game/entities/entity.h"
+#include "game/entities/particlepool.h"
+#include "game/game.h"
+#include "game/gamestates/running/runningstate.h"
+#include "game/world/world.h"
+#include "gfx/gfx.h"
+#include "gfx/gfxview.h"
+#include "gfx/texture.h"
+#include "math/random.h"
+#include "math/vector2.h"
+
+constexpr size_t ParticlePool::maxParticles;
+
+/** C'tor. */
+ParticlePool::ParticlePool() :
+  properties(),
+  positions(),
+  velocities(),
+  ages(),
+  lifetimes(),
+  sizes(),
+  lights(),
+  batchesNormal(),
+  batchesEmissive()
+{
+  this->properties.reserve(maxParticles);
+  this->positions .reserve(maxParticles);
+  this->velocities.reserve(maxParticles);
+  this->ages      .reserve(maxParticles);
+  this->lifetimes .reserve(maxParticles);
+  this->sizes     .reserve(maxParticles);
+  this->lights    .reserve(maxParticles);
+}
+
+/** Spawn a particle.
+  * @param state Running state.
+  * @param properties Entity type of the particle.
+  * @param pos Initial position.
+  * @param velocity Initial velocity.
+  * @return false if the pool is full.
+  */
+bool
+ParticlePool::Spawn(RunningState &state, const EntityProperties &properties, const Vector3 &pos, const Vector3 &velocity) {
+  if (this->positions.size() >= maxParticles) return false;
+
+  Random &random = state.GetRandom();
+
+  float lifetime = properties.lifetime + random.Float() * properties.lifetimeRand;
+  if (lifetime <= 0.0) lifetime = 1.0;
+
+  this->properties.push_back(&properties);
+  this->positions .push_back(pos);
+  this->velocities.push_back(velocity);
+  this->ages      .push_back(0.0);
+  this->lifetimes .push_back(lifetime);
+  this->sizes     .push_back(1.0 + random.Float() * properties.sizeRand);
+  this->lights    .push_back(state.GetWorld().GetLight(pos));
+  return true;
+}
+
+/** Move all particles and remove those that have reached the end of their
+  * lifetime.
+  * @param state Running state.
+  */
+void
+ParticlePool::Update(RunningState &state) {
+  PROFILE();
+
+  World &world = state.GetWorld();
+  float deltaT = state.GetGame().GetDeltaT();
+
+  size_t i = 0;
+  while(i < this->positions.size()) {
+    this->ages[i] += deltaT;
+    if (this->ages[i] > this->lifetimes[i]) {
+      this->Kill(i);
+      continue;
+    }
+
+    Vector3 &pos      = this->positions[i];
+    Vector3 &velocity = this->velocities[i];
+
+    velocity.y -= 3 * 9.81 * deltaT * this->properties[i]->gravity;
+
+    // move one axis at a time and stop at solid cells
+    Vector3 next = pos;
+
+    next.x += velocity.x * deltaT;
+    if (world.IsPointSolid(next)) { next.x = pos.x; velocity.x = 0; }
+
+    next.z += velocity.z * deltaT;
+    if (world.IsPointSolid(next)) { next.z = pos.z; velocity.z = 0; }
+
+    next.y += velocity.y * deltaT;
+    if (world.IsPointSolid(next)) {
+      next.y = pos.y;
+      velocity.y = 0;
+
+      // ground friction
+      velocity.x *= 0.5;
+      velocity.z *= 0.5;
+    }
+
+    pos = next;
+    this->lights[i] = world.GetLight(pos);
+    i++;
+  }
+}
+
+/** Draw all particles.
+  * @param gfx Graphics context.
+  */
+void
+ParticlePool::Draw(Gfx &gfx) const {
+  PROFILE();
+
+  for (auto &batch : this->batchesNormal)   batch.second.verts.Clear();
+  for (auto &batch : this->batchesEmissive) batch.second.verts.Clear();
+
+  const GfxView &view = gfx.GetView();
+  Vector3 right  = view.GetRight();
+  Vector3 up     = view.GetUp();
+  Vector3 normal = -view.GetForward();
+
+  for (size_t i=0; i<this->positions.size(); i++) {
+    const Sprite &sprite = this->properties[i]->sprite;
+
+    if (sprite.texture) {
+      this->AddQuad(this->batchesNormal[sprite.texture], i, right, up, normal, this->lights[i] + this->properties[i]->glow);
+    }
+    if (sprite.emissiveTexture) {
+      this->AddQuad(this->batchesEmissive[sprite.emissiveTexture], i, right, up, normal, IColor(255,255,255));
+    }
+  }
+
+  // vertex colors already contain the light
+  gfx.SetColor(IColor(255,255,255));
+  gfx.SetLight(IColor(0,0,0));
+  gfx.SetBackfaceCulling(false);
+
+  gfx.SetBlendNormal();
+  for (auto &batch : this->batchesNormal) {
+    if (batch.second.verts.GetCount() == 0) continue;
+    gfx.SetTextureFrame(batch.first);
+    gfx.DrawTriangles(batch.second.verts);
+  }
+
+  gfx.SetBlendAdd();
+  for (auto &batch : this->batchesEmissive) {
+    if (batch.second.verts.GetCount() == 0) continue;
+    gfx.SetTextureFrame(batch.first);
+    gfx.DrawTriangles(batch.second.verts);
+  }
+
+  gfx.SetBlendNormal();
+  gfx.SetBackfaceCulling(true);
+}
+
+/** Remove all particles, for example when changing levels. */
+void
+ParticlePool::Clear() {
+  this->properties.clear();
+  this->positions .clear();
+  this->velocities.clear();
+  this->ages      .clear();
+  this->lifetimes .clear();
+  this->sizes     .clear();
+  this->lights    .clear();
+}
+
+/** Remove a particle by moving the last one into its place.
+  * @param i Index of the particle.
+  */
+void
+ParticlePool::Kill(size_t i) {
+  size_t last = this->positions.size() - 1;
+
+  this->properties[i] = this->properties[last];
+  this->positions [i] = this->positions [last];
+  this->velocities[i] = this->velocities[last];
+  this->ages      [i] = this->ages      [last];
+  this->lifetimes [i] = this->lifetimes [last];
+  this->sizes     [i] = this->sizes     [last];
+  this->lights    [i] = this->lights    [last];
+
+  this->properties.pop_back();
+  this->positions .pop_back();
+  this->velocities.pop_back();
+  this->ages      .pop_back();
+  this->lifetimes .pop_back();
+  this->sizes     .pop_back();
+  this->lights    .pop_back();
+}
+
+/** Add the billboard of a particle to a batch.
+  * @param batch Batch to add to.
+  * @param i Index of the particle.
+  * @param right Right vector of the view.
+  * @param up Up vector of the view.
+  * @param normal Normal of the billboard.
+  * @param color Vertex color.
+  */
+void
+ParticlePool::AddQuad(Batch &batch, size_t i, const Vector3 &right, const Vector3 &up, const Vector3 &normal, const IColor &color) const {
+  const Sprite &sprite = this->properties[i]->sprite;
+
+  // current animation frame, particles only play their first animation
+  size_t frame = 0;
+  if (!sprite.animations.empty()) {
+    const Animation &anim = sprite.animations[0];
+    frame = anim.firstFrame;
+    if (anim.frameCount) frame += size_t(this->ages[i] * anim.fps) % anim.frameCount;
+  }
+
+  // same mapping as the texture matrix in Gfx::SetTextureFrame
+  Vector2 uv1(0,0), uv2(1,1);
+  if (sprite.totalFrames > 1) {
+    const Texture *texture = sprite.texture ? sprite.texture : sprite.emissiveTexture;
+    texture->GetFrameUV(frame, sprite.totalFrames, uv1, uv2);
+  }
+  float du = uv2.x - uv1.x;
+  float dv = uv2.y - uv1.y;
+
+  Vector3 center = this->positions[i] + right * sprite.offsetX + up * sprite.offsetY;
+  Vector3 x = right * (sprite.width  * this->sizes[i] * 0.5f);
+  Vector3 y = up    * (sprite.height * this->sizes[i] * 0.5f);
+
+  Vertex v0(center - x - y, color, uv1.x,      uv2.y,      normal);
+  Vertex v1(center + x - y, color, uv1.x + du, uv2.y,      normal);
+  Vertex v2(center + x + y, color, uv1.x + du, uv2.y + dv, normal);
+  Vertex v3(center - x + y, color, uv1.x,      uv2.y + dv, normal);
+
+  batch.verts.Add(v0);
+  batch.verts.Add(v1);
+  batch.verts.Add(v2);
+  batch.verts.Add(v0);
+  batch.verts.Add(v2);
+  batch.verts.Add(v3);
+}
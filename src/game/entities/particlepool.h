@@ -0,0 +1,59 @@
+#ifndef BARFOOS_PARTICLEPOOL_H
+#define BARFOOS_PARTICLEPOOL_H
+
+#include "common.h"
+
+#include "gfx/vertex.h"
+#include "gfx/vertexbuffer.h"
+#include "math/vector3.h"
+#include "util/icolor.h"
+
+/** Pool of short lived particles, for entity types marked with "particle".
+  * Particles are not entities, they only move, collide with solid cells and
+  * disappear after their lifetime. They are drawn as billboards with one
+  * draw call per texture.
+  */
+class ParticlePool final {
+public:
+
+                            ParticlePool        ();
+                            ParticlePool        (const ParticlePool &) = delete;
+
+  ParticlePool &            operator=           (const ParticlePool &) = delete;
+
+  bool                      Spawn               (RunningState &state, const EntityProperties &properties,
+                                                 const Vector3 &pos, const Vector3 &velocity);
+  void                      Update              (RunningState &state);
+  void                      Draw                (Gfx &gfx)                                const;
+  void                      Clear               ();
+
+  size_t                    GetCount            ()                                        const { return this->positions.size(); }
+
+private:
+
+  /** Maximum number of live particles, further spawns are dropped. */
+  static constexpr size_t   maxParticles = 16384;
+
+  /** Vertices of all particles sharing a texture. */
+  struct Batch {
+    VertexBuffer verts;
+  };
+
+  std::vector<const EntityProperties *> properties;
+  std::vector<Vector3>      positions;
+  std::vector<Vector3>      velocities;
+  std::vector<float>        ages;
+  std::vector<float>        lifetimes;
+  std::vector<float>        sizes;
+  std::vector<IColor>       lights;
+
+  mutable std::unordered_map<const Texture *, Batch> batchesNormal;
+  mutable std::unordered_map<const Texture *, Batch> batchesEmissive;
+
+  void                      Kill                (size_t i);
+  void                      AddQuad             (Batch &batch, size_t i, const Vector3 &right, const Vector3 &up,
+                                                 const Vector3 &normal, const IColor &color) const;
+};
+
+#endif
+
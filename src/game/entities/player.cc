@@ -16,12 +16,39 @@
 #include "gfx/vertex.h"
 #include "io/input.h"
 
+Pool Player::pool("Player");
+
+/** Allocate the player. Unlike other entities it keeps its pool across levels. */
+void *
+Player::operator new(size_t size) {
+  return pool.Allocate(size);
+}
+
+void
+Player::operator delete(void *ptr, size_t size) {
+  pool.Free(ptr, size);
+}
+
+/** Get the sprites of the element gems in the HUD. */
+static std::unordered_map<Element, Sprite>
+GetGemSprites() {
+  std::unordered_map<Element, Sprite> gemSprites;
+  gemSprites[Element::Physical] = Sprite("items/texture/gem.empty");
+  gemSprites[Element::Fire]     = Sprite("items/texture/gem.fire");
+  gemSprites[Element::Earth]    = Sprite("items/texture/gem.earth");
+  gemSprites[Element::Wind]      = Sprite("items/texture/gem.wind");
+  gemSprites[Element::Water]    = Sprite("items/texture/gem.water");
+  gemSprites[Element::Life]     = Sprite("items/texture/gem.life");
+  return gemSprites;
+}
+
 Player::Player() :
   Mob("player"),
 
   // rendering
   crosshairTex      (Texture::Get("gui/crosshair")),
   slotTex           (Texture::Get("gui/slot")),
+  gemSprites        (GetGemSprites()),
 
   // gameplay
   itemActiveLeft    (false),
@@ -39,8 +66,8 @@ Player::Player() :
 
   mapZoom           (-32.0f),
 
-  leftHand          (new Item("barehand.player")),
-  rightHand         (new Item("barehand.player")),
+  leftHand          (Item::Create("barehand.player")),
+  rightHand         (Item::Create("barehand.player")),
 
   blink(false)
 {
@@ -48,20 +75,14 @@ Player::Player() :
   this->proto.mutable_player();
 
   // TEST:
-  this->inventory.Equip(std::make_shared<Item>(Item("sword")), InventorySlot::RightHand);
-  this->inventory.Equip(std::make_shared<Item>(Item("torch")), InventorySlot::LeftHand);
-  this->inventory.AddToBackpack(std::make_shared<Item>(Item("torch")));
+  this->inventory.Equip(Item::Create("sword"), InventorySlot::RightHand);
+  this->inventory.Equip(Item::Create("torch"), InventorySlot::LeftHand);
+  this->inventory.AddToBackpack(Item::Create("torch"));
 
-  this->baseStats.UpgradeSkill("magic", 10);
+  this->GetBaseStats().UpgradeSkill(Skills::Magic, 10);
 
   //this->LearnSpell("spell.test");
 
-  gemSprites[Element::Physical] = Sprite("items/texture/gem.empty");
-  gemSprites[Element::Fire]     = Sprite("items/texture/gem.fire");
-  gemSprites[Element::Earth]    = Sprite("items/texture/gem.earth");
-  gemSprites[Element::Wind]      = Sprite("items/texture/gem.wind");
-  gemSprites[Element::Water]    = Sprite("items/texture/gem.water");
-  gemSprites[Element::Life]     = Sprite("items/texture/gem.life");
 }
 
 Player::Player(const Entity_Proto &proto) :
@@ -70,6 +91,7 @@ Player::Player(const Entity_Proto &proto) :
   // rendering
   crosshairTex      (Texture::Get("gui/crosshair")),
   slotTex           (Texture::Get("gui/slot")),
+  gemSprites        (GetGemSprites()),
 
   // gameplay
   itemActiveLeft    (false),
@@ -87,8 +109,8 @@ Player::Player(const Entity_Proto &proto) :
 
   mapZoom           (-32.0f),
 
-  leftHand          (new Item("barehand.player")),
-  rightHand         (new Item("barehand.player")),
+  leftHand          (Item::Create("barehand.player")),
+  rightHand         (Item::Create("barehand.player")),
 
   blink(false)
 {
@@ -166,7 +188,7 @@ Player::Update(RunningState &state) {
     this->SetBobPhase(this->GetBobPhase() - 1.0f);
 
     // TODO: get step sound from ground cell
-    if (this->groundCell) {
+    if (this->groundCell.IsValid()) {
       float pitch = 1.0 + state.GetRandom().Float()*0.05;
       std::string name = "step_a";
       switch(state.GetRandom().Integer(4)) {
@@ -179,7 +201,7 @@ Player::Update(RunningState &state) {
     }
   } else if (this->GetBobPhase() >= 0.5 && lastPhase < 0.5) {
     // TODO: get step sound from ground cell
-    if (this->groundCell) {
+    if (this->groundCell.IsValid()) {
       float pitch = 1.0 + state.GetRandom().Float()*0.05;
       std::string name = "step_a";
       switch(state.GetRandom().Integer(4)) {
@@ -207,10 +229,10 @@ Player::Update(RunningState &state) {
     if (useItem->NeedsChargeUp()) {
       useItem->SetCharging(true);
     } else {
-      std::string skill = useItem->GetProperties().useSkill;
+      SkillID skill = useItem->GetProperties().useSkill;
       bool result = this->UseItem(state, useItem);
-      if (result && skill != "") {
-        if (this->baseStats.UpgradeSkill(skill)) {
+      if (result && skill != Skills::None) {
+        if (this->GetBaseStats().UpgradeSkill(skill)) {
           // TODO: skill level up message
         }
       }
@@ -220,10 +242,10 @@ Player::Update(RunningState &state) {
     if (!useItem) useItem = this->rightHand;
 
     if (useItem->NeedsChargeUp() && lastItemActiveLeft) {
-      std::string skill = useItem->GetProperties().useSkill;
+      SkillID skill = useItem->GetProperties().useSkill;
       bool result = this->UseItem(state, useItem);
-      if (result && skill != "") {
-        if (this->baseStats.UpgradeSkill(skill)) {
+      if (result && skill != Skills::None) {
+        if (this->GetBaseStats().UpgradeSkill(skill)) {
           // TODO: skill level up message
         }
       }
@@ -237,10 +259,10 @@ Player::Update(RunningState &state) {
     if (useItem->NeedsChargeUp()) {
       useItem->SetCharging(true);
     } else {
-      std::string skill = useItem->GetProperties().useSkill;
+      SkillID skill = useItem->GetProperties().useSkill;
       bool result = this->UseItem(state, useItem);
-      if (result && skill != "") {
-        if (this->baseStats.UpgradeSkill(skill)) {
+      if (result && skill != Skills::None) {
+        if (this->GetBaseStats().UpgradeSkill(skill)) {
           // TODO: skill level up message
         }
       }
@@ -250,10 +272,10 @@ Player::Update(RunningState &state) {
     if (!useItem) useItem = this->leftHand;
 
     if (useItem->NeedsChargeUp() && lastItemActiveRight) {
-      std::string skill = useItem->GetProperties().useSkill;
+      SkillID skill = useItem->GetProperties().useSkill;
       bool result = this->UseItem(state, useItem);
-      if (result && skill != "") {
-        if (this->baseStats.UpgradeSkill(skill)) {
+      if (result && skill != Skills::None) {
+        if (this->GetBaseStats().UpgradeSkill(skill)) {
           // TODO: skill level up message
         }
       }
@@ -262,8 +284,8 @@ Player::Update(RunningState &state) {
   lastItemActiveRight = itemActiveRight;
 
   // update map
-  if (headCell) {
-    state.GetWorld().GetMap().AddFeatureSeen(headCell->GetFeatureID());
+  if (headCell.IsValid()) {
+    state.GetWorld().GetMap().AddFeatureSeen(headCell.GetFeatureID());
   }
 
   // update messages
@@ -384,7 +406,7 @@ Player::DrawGUI(Gfx &gfx) const {
     this->leftHand->DrawIcon(gfx, itemPos - Point(36, 0));
   }
 
-  size_t maxElements = GetEffectiveStats().GetSkill("magic");
+  size_t maxElements = GetEffectiveStats().GetSkill(Skills::Magic);
 
   for (size_t i=0; i<maxElements; i++) {
     if (i >= this->elements.size()) {
@@ -434,7 +456,7 @@ Player::DrawGUI(Gfx &gfx) const {
   gfx.SetColor(IColor(255, 255, 255));
 
   char tmp[1024];
-  Stats stats = this->GetEffectiveStats();
+  const Stats &stats = this->GetEffectiveStats();
   /*
   snprintf(tmp, sizeof(tmp), "STR: %3d DEX: %3d AGI: %3d DEF: %3d MATK: %3d MDEF: %3d MAX HP: %3d",
     stats.GetStrength(), 
@@ -530,7 +552,8 @@ Player::HandleEvent(const InputEvent &event) {
 void
 Player::SetUniforms(const std::shared_ptr<Shader> &shader) const {
   if (shader) {
-    shader->Uniform("u_fade", IColor(std::sqrt(this->GetPain())*255, 0, 0));
+    static const Symbol uFade("u_fade");
+    shader->Uniform(uFade, IColor(std::sqrt(this->GetPain())*255, 0, 0));
   }
 }
 
@@ -662,13 +685,13 @@ bool Player::UseItem(RunningState &state, const std::shared_ptr<Item> &item) {
   ID entityID;
   Side cellSide;
   // TODO: get default range
-  Cell *cell = this->GetSelection(state, item ? item->GetProperties().range : 5.0, item, cellSide, entityID);
+  Cell cell = this->GetSelection(state, item ? item->GetProperties().range : 5.0, item, cellSide, entityID);
 
   if (item) {
     if (entityID != InvalidID) {
       return item->UseOnEntity(state, *this, entityID);
-    } else if (cell) {
-      return item->UseOnCell(state, *this, cell, cellSide);
+    } else if (cell.IsValid()) {
+      return item->UseOnCell(state, *this, &cell, cellSide);
     } else {
       return item->UseOnNothing(state, *this);
     }
@@ -676,8 +699,8 @@ bool Player::UseItem(RunningState &state, const std::shared_ptr<Item> &item) {
     if (entityID != InvalidID) {
       Entity *entity = state.GetEntity(entityID);
       if (entity) entity->OnUse(state, *this);
-    } else if (cell) {
-      cell->OnUse(state, *this);
+    } else if (cell.IsValid()) {
+      cell.OnUse(state, *this);
     }
     return true;
   }
@@ -704,7 +727,7 @@ Player::OnCollide(RunningState &state, Entity &other) {
 
 void
 Player::QueueElement(Element element) {
-  size_t maxElements = GetEffectiveStats().GetSkill("magic");
+  size_t maxElements = GetEffectiveStats().GetSkill(Skills::Magic);
   size_t elemCount = 1;
   for (Element e:this->elements) if (e == element) elemCount++;
 
@@ -739,7 +762,7 @@ Player::CastSpell(RunningState &state) {
   if (spell.Cast(state, *this)) {
     if (this->GetCastStartTime() == 0.0) {
       AddMessage("You cast the spell "+spell.displayName);
-      this->baseStats.UpgradeSkill("magic");
+      this->GetBaseStats().UpgradeSkill(Skills::Magic);
       this->SetCastStartTime(t);
     }
     this->SetLastCastTime(t);
@@ -16,6 +16,9 @@ public:
 
   Player &operator=(const Player &) = delete;
 
+  static void *operator new(size_t size);
+  static void operator delete(void *ptr, size_t size);
+
   virtual void Start(RunningState &state, ID id) override;
   virtual void Update(RunningState &state) override;
   virtual void Draw(Gfx &gfx) const override;
@@ -129,6 +132,8 @@ private:
   void ClearElements();
   void CastSpell(RunningState &state);
   void StopCasting();
+
+  static Pool pool;
 };
 
 #endif
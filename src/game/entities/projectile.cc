@@ -1,12 +1,30 @@
 #include "game/entities/projectile.h"
 #include "game/gamestates/running/runningstate.h"
 
+Pool Projectile::pool("Projectile", true);
+
+/** Allocate a projectile from the pool of the current level. */
+void *
+Projectile::operator new(size_t size) {
+  return pool.Allocate(size);
+}
+
+void
+Projectile::operator delete(void *ptr, size_t size) {
+  pool.Free(ptr, size);
+}
+
 Projectile::Projectile(const std::string &type) :
   Mob(type)
 {
   this->proto.set_spawn_class(uint32_t(SpawnClass::ProjectileClass));
 }
 
+Projectile::Projectile(const Entity_Proto &proto) :
+  Mob(proto)
+{
+}
+
 void Projectile::Start(RunningState &state, uint32_t id) {
   //Log("Projectile::Start()\n");
   Mob::Start(state, id);
@@ -9,6 +9,10 @@ class Projectile : public Mob {
 public:
 
   Projectile(const std::string &type);
+  Projectile(const Entity_Proto &proto);
+
+  static void *operator new(size_t size);
+  static void operator delete(void *ptr, size_t size);
 
   virtual void Start(RunningState &state, uint32_t id) override;
 
@@ -16,6 +20,10 @@ public:
   virtual void OnCollide(RunningState &state, Entity &) override;
   
 protected:
+
+private:
+
+  static Pool pool;
 };
 
 #endif
@@ -0,0 +1,105 @@
+#include "common.h"
+
+#include "game/entities/entity.h"
+#include "game/entities/thinkscheduler.h"
+#include "game/game.h"
+#include "game/gamestates/running/runningstate.h"
+
+#include <chrono>
+
+constexpr size_t ThinkScheduler::maxThinksPerFrame;
+constexpr float  ThinkScheduler::slowDistance;
+constexpr float  ThinkScheduler::slowerDistance;
+
+/** C'tor. */
+ThinkScheduler::ThinkScheduler() :
+  queue(),
+  thinkCount(0),
+  thinkTime(0.0)
+{
+}
+
+/** Schedule the next think of an entity. An earlier schedule of the same
+  * entity is dropped.
+  * @param entity The entity.
+  * @param time Game time of the next think.
+  */
+void
+ThinkScheduler::Add(Entity &entity, float time) {
+  entity.SetNextThinkTime(time);
+  this->queue.push(Entry { time, entity.GetId() });
+}
+
+/** Let due entities think and schedule their next think.
+  * @param state Running state.
+  * @param focus Entity around which entities think at full rate, usually
+  *              the player, may be nullptr.
+  */
+void
+ThinkScheduler::Run(RunningState &state, const Entity *focus) {
+  PROFILE();
+
+  auto start = std::chrono::steady_clock::now();
+  float t    = state.GetGame().GetTime();
+
+  this->thinkCount = 0;
+
+  while(!this->queue.empty() && this->thinkCount < maxThinksPerFrame) {
+    Entry entry = this->queue.top();
+    if (entry.time > t) break;
+    this->queue.pop();
+
+    Entity *entity = state.GetEntity(entry.id);
+    if (!entity || entity->IsRemovable() || entity->GetNextThinkTime() != entry.time) continue;
+
+    entity->Think(state);
+    this->thinkCount++;
+
+    // thinking may have removed or rescheduled the entity
+    entity = state.GetEntity(entry.id);
+    if (!entity || entity->GetNextThinkTime() != entry.time) continue;
+
+    // keep the phase unless the entity fell behind by more than one interval
+    this->Add(*entity, std::max(entry.time + GetInterval(*entity, focus), t));
+  }
+
+  this->thinkTime = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+  PROFILE_COUNT("ThinkScheduler::Run / thinks", this->thinkCount);
+}
+
+/** Remove all entities. */
+void
+ThinkScheduler::Clear() {
+  this->queue = std::priority_queue<Entry, std::vector<Entry>, Later>();
+  this->thinkCount = 0;
+  this->thinkTime = 0.0;
+}
+
+/** Get the time until an entity thinks again.
+  * @param entity The entity.
+  * @param focus Entity around which entities think at full rate.
+  * @return Think interval of the entity, scaled by its distance to the focus.
+  */
+float
+ThinkScheduler::GetInterval(const Entity &entity, const Entity *focus) {
+  const EntityProperties *properties = entity.GetProperties();
+
+  float interval = properties->thinkInterval;
+  if (!focus || &entity == focus) return interval;
+
+  Vector3 dir  = entity.GetPosition() - focus->GetPosition();
+  float   dist = dir.GetMag() - std::max(properties->aggroRangeNear, properties->aggroRangeFar);
+
+  if (dist > slowerDistance) {
+    interval *= 4.0f;
+  } else if (dist > slowDistance) {
+    interval *= 2.0f;
+  }
+
+  // nothing the player will notice happens behind them
+  if (dist > 0.0f && dir.Dot(focus->GetForward()) < 0.0f) {
+    interval *= 2.0f;
+  }
+
+  return interval;
+}
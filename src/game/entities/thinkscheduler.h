@@ -0,0 +1,64 @@
+#ifndef BARFOOS_THINKSCHEDULER_H
+#define BARFOOS_THINKSCHEDULER_H
+
+#include "common.h"
+
+#include <queue>
+#include <vector>
+
+/** Decides which entities get to think in a frame.
+  * Entities are kept in a priority queue ordered by the time of their next
+  * think. Each frame at most a fixed number of due entities think, the
+  * rest stay in the queue and are the first to think in the next frame.
+  * Entities far away from the player or behind them think less often.
+  * Entries of removed entities or of entities that have been scheduled
+  * again are dropped when they come up.
+  */
+class ThinkScheduler final {
+public:
+
+                            ThinkScheduler      ();
+                            ThinkScheduler      (const ThinkScheduler &) = delete;
+
+  ThinkScheduler &          operator=           (const ThinkScheduler &) = delete;
+
+  void                      Add                 (Entity &entity, float time);
+  void                      Run                 (RunningState &state, const Entity *focus);
+  void                      Clear               ();
+
+  size_t                    GetQueueSize        ()                                        const { return this->queue.size(); }
+  size_t                    GetThinkCount       ()                                        const { return this->thinkCount; }
+  float                     GetThinkTime        ()                                        const { return this->thinkTime; }
+
+private:
+
+  /** Most entities that think in one frame. */
+  static constexpr size_t   maxThinksPerFrame   = 48;
+
+  /** Distance beyond the aggro range of an entity at which it thinks at
+    * half and at a quarter of its rate.
+    */
+  static constexpr float    slowDistance        = 16.0f;
+  static constexpr float    slowerDistance      = 48.0f;
+
+  struct Entry {
+    float time;
+    ID    id;
+  };
+
+  struct Later {
+    bool operator()(const Entry &a, const Entry &b) const {
+      return a.time > b.time || (a.time == b.time && a.id > b.id);
+    }
+  };
+
+  std::priority_queue<Entry, std::vector<Entry>, Later> queue;
+
+  /** Statistics of the last frame. */
+  size_t                    thinkCount;
+  float                     thinkTime;
+
+  static float              GetInterval         (const Entity &entity, const Entity *focus);
+};
+
+#endif
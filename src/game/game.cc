@@ -26,6 +26,8 @@ Game::Game(const Point &screenSize) :
   activeGui     (nullptr),
   startT        (0.0),
   deltaT        (0.0),
+  fixedStep     (0.0),
+  workerThreadCount(0),
   frame         (0),
   realFrame     (0),
   lastFPST      (0.0),
@@ -106,25 +108,29 @@ Game::Frame() {
     Log("changed gamestate\n");
   }
 
-//  float t = lastT + 1.0/25.0;
-
-  // update game (at most 0.1s at a time)
-  float t = this->gfx->GetTime() - this->startT;
-
-  // if too laggy, skip ahead
-  if (t - this->proto.last_time() > 0.5) {
-    float skip = t - this->proto.last_time() - 0.1;
-    Log("update is too slow, skipping %f seconds\n", skip);
-    this->startT += skip;
+  float t;
+  if (this->fixedStep > 0.0) {
+    // exactly one step per frame, no matter how long it takes
+    t = this->proto.last_time() + this->fixedStep;
+  } else {
+    // update game (at most 0.1s at a time)
     t = this->gfx->GetTime() - this->startT;
-  }
 
-  // while only a little laggy, catch up
-  while(t - this->proto.last_time() > 0.1) {
-    Log("update is slow, %fs (%f)\n", t - this->proto.last_time(), t);
-    this->proto.set_last_time(this->proto.last_time() + 0.1f);
-    this->Update(this->proto.last_time(), 0.1);
-    this->input->Update();
+    // if too laggy, skip ahead
+    if (t - this->proto.last_time() > 0.5) {
+      float skip = t - this->proto.last_time() - 0.1;
+      Log("update is too slow, skipping %f seconds\n", skip);
+      this->startT += skip;
+      t = this->gfx->GetTime() - this->startT;
+    }
+
+    // while only a little laggy, catch up
+    while(t - this->proto.last_time() > 0.1) {
+      Log("update is slow, %fs (%f)\n", t - this->proto.last_time(), t);
+      this->proto.set_last_time(this->proto.last_time() + 0.1f);
+      this->Update(this->proto.last_time(), 0.1);
+      this->input->Update();
+    }
   }
 
   this->Update(t, t - this->proto.last_time());
@@ -241,13 +247,8 @@ Game::SetGui(const std::shared_ptr<Gui> &gui) {
 }
 
 void
-Game::Serialize(std::ostream &out) {
-  this->proto.SerializeToOstream(&out);
-}
-
-void
-Game::Deserialize(std::istream &in) {
-  this->proto.ParseFromIstream(&in);
+Game::Deserialize(const Game_Proto &proto) {
+  this->proto = proto;
 
   this->startT = this->GetGfx().GetTime()-this->GetTime();
   this->random.Seed(this->proto.seed(), 0);
@@ -261,4 +262,5 @@ Game::Deserialize(std::istream &in) {
   LoadEntities();
   LoadEffects();
   LoadItems(*this);
+  LoadSpells();
 }
@@ -25,6 +25,10 @@ public:
   void NewGame(const std::string &seed);
   bool Frame();
 
+  void SetFixedStep(float step)             { this->fixedStep = step; }
+  void SetWorkerThreadCount(size_t count)   { this->workerThreadCount = count; }
+  void SetGameState(GameState *state)       { this->nextGameState = state; }
+
   Gfx    &GetGfx()    const { return *this->gfx;    }
   Audio  &GetAudio()  const { return *this->audio;  }
   Input  &GetInput()  const { return *this->input;  }
@@ -33,6 +37,7 @@ public:
   float   GetTime()   const { return this->proto.last_time();   }
   float   GetDeltaT() const { return this->deltaT;  }
   float   GetFPS()    const { return this->fps;     }
+  size_t  GetWorkerThreadCount() const { return this->workerThreadCount; }
 
   std::string GetScrollName();
   void SetIdentified(const std::string &name);
@@ -41,8 +46,8 @@ public:
   void HandleEvent(const InputEvent &event);
   void                  SetGui(const std::shared_ptr<Gui> &gui);
 
-  void Serialize(std::ostream &out);
-  void Deserialize(std::istream &in);
+  const Game_Proto &GetProto() const { return this->proto; }
+  void Deserialize(const Game_Proto &proto);
 
 private:
 
@@ -66,6 +71,12 @@ private:
   float   startT;
   float   deltaT;
 
+  /** If non-zero, advance the game by this much each frame instead of following the clock. */
+  float   fixedStep;
+
+  /** Threads a world uses to build and settle itself, 0 for one per core. */
+  size_t  workerThreadCount;
+
   size_t  frame, realFrame;
   float   lastFPST;
 
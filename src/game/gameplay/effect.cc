@@ -10,17 +10,18 @@
 
 #include <unordered_map>
 
-static std::unordered_map<std::string, EffectProperties> allEffects;
+static std::unordered_map<Symbol, EffectProperties> allEffects;
 static std::unordered_map<std::string, std::vector<std::string>> allEffectGroups;
 static EffectProperties defaultEffect;
 
-const EffectProperties &getEffect(const std::string &name) {
-  if (name == "") return defaultEffect;
-  if (allEffects.find(name) == allEffects.end()) {
+const EffectProperties &getEffect(const Symbol &name) {
+  if (name.IsEmpty()) return defaultEffect;
+  auto iter = allEffects.find(name);
+  if (iter == allEffects.end()) {
     Log("Properties for effect of type '%s' not found\n", name.c_str());
     return defaultEffect;
   }
-  return allEffects[name];
+  return iter->second;
 }
 
 const std::vector<std::string> &getEffectsInGroup(const std::string &group) {
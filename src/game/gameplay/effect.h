@@ -109,8 +109,8 @@ struct EffectProperties : public Properties {
 
   IColor light;
 
-  std::string addSound = "";
-  std::string removeSound = "";
+  Symbol addSound;
+  Symbol removeSound;
 
   virtual void ParseProperty(const std::string &name) override;
 
@@ -120,7 +120,7 @@ struct EffectProperties : public Properties {
 };
 
 void LoadEffects();
-const EffectProperties &getEffect(const std::string &name);
+const EffectProperties &getEffect(const Symbol &name);
 const std::vector<std::string> &getEffectsInGroup(const std::string &group);
 
 #endif
@@ -98,8 +98,8 @@ Spell::Cast(RunningState &state, Mob &user) const {
   // find target
   ID targetId;
   Side selectedCellSide;
-  Cell *cell = user.GetSelection(state, this->castRange, nullptr, selectedCellSide, targetId);
-  Entity *target = cell ? nullptr : state.GetEntity(targetId);
+  Cell cell = user.GetSelection(state, this->castRange, nullptr, selectedCellSide, targetId);
+  Entity *target = cell.IsValid() ? nullptr : state.GetEntity(targetId);
   
   if (!target && this->targetSelf) target = &user;
 
@@ -116,7 +116,7 @@ Spell::Cast(RunningState &state, Mob &user) const {
     }
 
     if (onCastDamageAOE) {
-      float damage = this->onCastDamageAOE * (stats.GetMagicAttack() + stats.GetSkill("magic"));
+      float damage = this->onCastDamageAOE * (stats.GetMagicAttack() + stats.GetSkill(Skills::Magic));
       for (ID e:entIDs) {
         Entity *ent = state.GetEntity(e);
         if (!ent) continue;
@@ -126,7 +126,7 @@ Spell::Cast(RunningState &state, Mob &user) const {
   }
 
   if (this->onCastDamageCaster) {
-    float damage = this->onCastDamageCaster * (stats.GetMagicAttack() + stats.GetSkill("magic"));
+    float damage = this->onCastDamageCaster * (stats.GetMagicAttack() + stats.GetSkill(Skills::Magic));
     user.AddHealth(state, Stats::MagicAttack(user.GetId(), user, damage, this->element));
   }
 
@@ -135,7 +135,7 @@ Spell::Cast(RunningState &state, Mob &user) const {
       target->AddBuff(state, this->onCastAddBuffTarget);
     }
     if (this->onCastDamageTarget) {
-      float damage = this->onCastDamageTarget * (stats.GetMagicAttack() + stats.GetSkill("magic"));
+      float damage = this->onCastDamageTarget * (stats.GetMagicAttack() + stats.GetSkill(Skills::Magic));
       target->AddHealth(state, Stats::MagicAttack(user.GetId(), *target, damage, this->element));
     }
   }
@@ -145,9 +145,8 @@ Spell::Cast(RunningState &state, Mob &user) const {
     entity->SetOwner(user);
     entity->SetForward(user.GetForward());
     entity->SetPosition(user.GetEyePosition() + user.GetForward());
-    state.AddEntity(entity);
     Projectile *proj = dynamic_cast<Projectile*>(entity);
-    if (proj) {
+    if (state.AddEntity(entity) != InvalidID && proj) {
       proj->SetVelocity(user.GetForward() * proj->GetProperties()->maxSpeed);
     }
   }
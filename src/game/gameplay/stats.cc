@@ -5,6 +5,73 @@
 #include "game/items/item.h"
 #include "math/random.h"
 
+static std::vector<std::string> skillNames { "magic", "evade" };
+static std::unordered_map<std::string, SkillID> skillIDs { { "magic", Skills::Magic }, { "evade", Skills::Evade } };
+
+/** Get the ID of a skill, interning the name if it has not been seen before.
+  * @param name Name of the skill.
+  * @return ID of the skill or Skills::None if the name is empty or there are
+  *         too many skills.
+  */
+SkillID getSkillID(const std::string &name) {
+  if (name == "") return Skills::None;
+
+  auto iter = skillIDs.find(name);
+  if (iter != skillIDs.end()) return iter->second;
+
+  if (skillNames.size() >= Skills::Max) {
+    Log("Too many skills, ignoring '%s'\n", name.c_str());
+    return Skills::None;
+  }
+
+  SkillID id = skillNames.size();
+  skillNames.push_back(name);
+  skillIDs[name] = id;
+  return id;
+}
+
+/** Get the name of a skill.
+  * @param id ID of the skill.
+  * @return Name of the skill or an empty string for an invalid ID.
+  */
+const std::string &getSkillName(SkillID id) {
+  static const std::string none = "";
+  if (id >= skillNames.size()) return none;
+  return skillNames[id];
+}
+
+/** Construct stats from a saved proto.
+  * @param proto The proto, skills are moved into the skill table.
+  */
+Stats::Stats(const Stats_Proto &proto) :
+  proto(proto),
+  skillExp(),
+  skillLevel()
+{
+  for (auto &s : this->proto.skills()) {
+    SkillID id = getSkillID(s.name());
+    if (id == Skills::None) continue;
+    this->skillExp[id]  += s.exp();
+    this->skillLevel[id] = Stats::GetLevelForSkillExp(this->skillExp[id]);
+  }
+  this->proto.clear_skills();
+}
+
+/** Get the stats as a proto for saving.
+  * @return The stats including skills.
+  */
+Stats_Proto
+Stats::GetProto() const {
+  Stats_Proto result = this->proto;
+  for (SkillID id = 0; id < Skills::Max; id++) {
+    if (!this->skillExp[id]) continue;
+    Skill_Proto *s = result.add_skills();
+    s->set_name(getSkillName(id));
+    s->set_exp(this->skillExp[id]);
+  }
+  return result;
+}
+
 /** Calculate the outcome of a melee attack with an item.
  * @param attacker Entity that attacks
  * @param victim Entity that defends
@@ -23,8 +90,8 @@ Stats::MeleeAttack(const Entity &attacker, const Entity &victim, const Item &ite
   float charge = item.NeedsChargeUp() ? item.GetCharge() : 1.0;
 
   // get stats
-  Stats atkStat = attacker.GetEffectiveStats();
-  Stats defStat = victim.GetEffectiveStats();
+  const Stats &atkStat = attacker.GetEffectiveStats();
+  const Stats &defStat = victim.GetEffectiveStats();
 
   uint32_t hitLevel  = atkStat.GetSkill(info.skill) + atkStat.GetHit();
   uint32_t fleeLevel = defStat.GetFlee();
@@ -75,7 +142,7 @@ Stats::MagicAttack(ID attackerID, const Entity &victim, float damage, Element el
   info.element = element;
 
   // get stats
-  Stats defStat = victim.GetEffectiveStats();
+  const Stats &defStat = victim.GetEffectiveStats();
 
   if (damage > 0.0) {
     info.amount = -(damage - defStat.GetMagicDefense());
@@ -107,7 +174,7 @@ Stats::ExplosionAttack(ID attackerID, const Entity &victim, float damage, Elemen
   info.element = element;
 
   // get stats
-  Stats defStat = victim.GetEffectiveStats();
+  const Stats &defStat = victim.GetEffectiveStats();
 
   if (damage > 0.0) {
     info.amount = -(damage - defStat.GetDefense());
@@ -138,7 +205,7 @@ Stats::ProjectileAttack(const Entity &projectile, const Entity &victim, float da
   info.element = projectile.GetElement();
 
   // get stats
-  Stats defStat = victim.GetEffectiveStats();
+  const Stats &defStat = victim.GetEffectiveStats();
 
   if (damage > 0.0) {
     info.amount = -(damage - defStat.GetDefense());
@@ -363,7 +430,7 @@ Stats::GetCrit()         const {
 
 uint32_t
 Stats::GetFlee()         const {
-  return GetFleeBonus() + GetSkill("evade") + GetLevel() + GetAgility() + GetLuck()/5;
+  return GetFleeBonus() + GetSkill(Skills::Evade) + GetLevel() + GetAgility() + GetLuck()/5;
 }
 
 uint32_t
@@ -385,39 +452,30 @@ bool Stats::operator==(const Stats &o) {
     this->GetMaxHealth()        == o.GetMaxHealth();
 }
 
-uint32_t 
-Stats::GetSkill(const std::string &name) const {
-  for (auto &s:this->proto.skills()) {
-    if (s.name() == name) {
-      return Stats::GetLevelForSkillExp(s.exp());
-    }
-  }
-  return 0;
-}
-
+/** Add experience to a skill.
+  * @param id ID of the skill.
+  * @param points Experience points to add.
+  * @return true if the skill level went up.
+  */
 bool
-Stats::UpgradeSkill(const std::string &name, uint32_t points) {
-  uint32_t oldLevel = this->GetSkill(name);
+Stats::UpgradeSkill(SkillID id, uint32_t points) {
+  if (id >= Skills::Max) return false;
 
-  for (auto &s:*this->proto.mutable_skills()) {
-    if (s.name() == name) {
-      s.set_exp(s.exp()+points);
-      return this->GetSkill(name) > oldLevel;
-    }
-  }
-
-  Skill_Proto *s = this->proto.add_skills();
-  s->set_name(name);
-  s->set_exp(points);
-  return this->GetSkill(name) > oldLevel;
+  uint32_t oldLevel = this->skillLevel[id];
+  this->skillExp[id]  += points;
+  this->skillLevel[id] = Stats::GetLevelForSkillExp(this->skillExp[id]);
+  return this->skillLevel[id] > oldLevel;
 }
 
+/** Get the experience points of all skills that have any.
+  * @return Map of skill names to experience points.
+  */
 std::unordered_map<std::string, uint32_t> 
-Stats::GetAllSkills() {
+Stats::GetAllSkills() const {
   std::unordered_map<std::string, uint32_t> skills;
 
-  for (auto &s:this->proto.skills()) {
-    skills[s.name()] = Stats::GetLevelForSkillExp(s.exp());
+  for (SkillID id = 0; id < Skills::Max; id++) {
+    if (this->skillExp[id]) skills[getSkillName(id)] = this->skillExp[id];
   }
   return skills;
 }
@@ -7,7 +7,7 @@
 #include "entity.pb.h"
 
 struct EffectProperties;
-const EffectProperties &getEffect(const std::string &name);
+const EffectProperties &getEffect(const Symbol &name);
 
 namespace Const {
   static constexpr float WalkSpeedFactorPerAGI   = 0.2f; // double walk speed every 5 agi points
@@ -17,6 +17,19 @@ namespace Const {
   static constexpr float ExpLevelSkill           = 3.0f; //
 };
 
+/** Small integer ID of an interned skill name. */
+typedef uint8_t SkillID;
+
+namespace Skills {
+  static constexpr SkillID None   = 0xff; // no skill
+  static constexpr SkillID Magic  = 0;    // always interned first
+  static constexpr SkillID Evade  = 1;
+  static constexpr size_t  Max    = 32;   // maximum number of distinct skills
+};
+
+SkillID getSkillID(const std::string &name);
+const std::string &getSkillName(SkillID id);
+
 enum class HitType : uint8_t {
   Miss = 0,
   Normal = 1,
@@ -64,7 +77,7 @@ struct HealthInfo {
   ID          dealerId;
   HitType     hitType;
   float       exp;
-  std::string skill;
+  SkillID     skill;
 
   HealthInfo() :
     amount    (0),
@@ -73,10 +86,10 @@ struct HealthInfo {
     dealerId  (InvalidID),
     hitType   (HitType::Normal),
     exp       (0.0),
-    skill     ("")
+    skill     (Skills::None)
   {}
 
-  HealthInfo(float amount, HealthType type = HealthType::Unspecified, Element element = Element::Physical, size_t dealerId = InvalidID, HitType hitType = HitType::Normal, float exp = 0.0, const std::string &skill = "") :
+  HealthInfo(float amount, HealthType type = HealthType::Unspecified, Element element = Element::Physical, size_t dealerId = InvalidID, HitType hitType = HitType::Normal, float exp = 0.0, SkillID skill = Skills::None) :
     amount    (amount),
     type      (type),
     element   (element),
@@ -89,27 +102,32 @@ struct HealthInfo {
 
 /** A buff/debuff. */
 struct Buff {
-  Buff(const std::string &type, float startT) {
+  Buff(const std::string &type, float startT) : effect(&getEffect(type)) {
     this->proto.set_effect(type);
     this->proto.set_start_time(startT);
   }
 
-  Buff(const Buff_Proto &proto) : proto(proto) {}
+  Buff(const Buff_Proto &proto) : proto(proto), effect(&getEffect(proto.effect())) {}
 
-  const EffectProperties &GetEffect()     const { return getEffect(this->proto.effect()); }
+  const EffectProperties &GetEffect()     const { return *this->effect; }
   float                   GetStartTime()  const { return this->proto.start_time(); }
 
   void                    Extend(float t)       { this->proto.set_start_time(this->proto.start_time() + t); }
   void                    Restart(float t)      { this->proto.set_start_time(t); }
 
   Buff_Proto proto;
+
+  /** Effect looked up once on construction. */
+  const EffectProperties *effect;
 };
 
-/** Entity stats. */
+/** Entity stats. Skills are kept in a flat table indexed by SkillID and
+  * are only converted to Skill_Proto by GetProto().
+  */
 struct Stats {
-  Stats() {
+  Stats() : skillExp(), skillLevel() {
   }
-  Stats(const Stats_Proto &proto) : proto(proto) {}
+  Stats(const Stats_Proto &proto);
 
   // primary stats
   uint32_t GetStrength()     const { return proto.str();     }
@@ -169,16 +187,22 @@ struct Stats {
   void  SetWalkSpeed(float f) { proto.set_walk_speed(f); }
   void  SetCoolDown(float f)  { proto.set_cool_down(f); }
 
-  uint32_t GetSkill(const std::string &name) const;
-  bool UpgradeSkill(const std::string &name, uint32_t points = 1);
-  std::unordered_map<std::string, uint32_t> GetAllSkills();
+  uint32_t GetSkill(SkillID id) const { return id < Skills::Max ? skillLevel[id] : 0; }
+  bool UpgradeSkill(SkillID id, uint32_t points = 1);
+  std::unordered_map<std::string, uint32_t> GetAllSkills() const;
 
   bool operator==(const Stats &o);
   bool AddExperience(float exp);
   std::string GetToolTip(bool absolute=false) const;
 
+  Stats_Proto GetProto() const;
+
+  /** Stats except skills. */
   Stats_Proto proto;
 
+  uint32_t skillExp[Skills::Max];
+  uint32_t skillLevel[Skills::Max];
+
   static HealthInfo MeleeAttack(const Entity &attacker, const Entity &victim, const Item &item, Random &random);
   static HealthInfo MagicAttack(ID attackerID, const Entity &victim, float damage, Element element);
   static HealthInfo ExplosionAttack(ID attackerID, const Entity &victim, float damage, Element element);
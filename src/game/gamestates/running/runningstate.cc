@@ -7,6 +7,7 @@
 #include "game/items/item.h"
 #include "game/items/itementity.h"
 #include "game/world/feature.h"
+#include "game/world/navfield.h"
 #include "game/world/world.h"
 #include "game/world/worldbuilder.h"
 #include "game/world/worldedit.h"
@@ -14,27 +15,37 @@
 #include "gfx/gfxview.h"
 #include "io/fileio.h"
 #include "io/input.h"
+#include "io/mappedfile.h"
+#include "io/protostream.h"
 #include "math/ivector3.h"
+#include "util/util.h"
 
 #include <sys/time.h>
+#include <chrono>
 #include <fstream>
 
 RunningState::RunningState(Game &game) :
   GameState(game),
   world(nullptr),
+  entities(),
   player(nullptr),
+  levelCellsSaved(false),
+  entityGrid(),
+  thinkScheduler(),
+  particles(),
   showInventory(false),
   lastSaveT(0.0),
-  saving(false)
+  saveWriter()
 {
   Log("+RunningState() %p %p %p %p\n", this, &GetRandom(), &game, &GetGame());
 }
 
+constexpr float RunningState::autosaveInterval;
+
 RunningState::~RunningState() {
-  for (auto entity : this->entities) {
-    delete entity.second;
-  }
-  this->entities.clear();
+  // gfx and audio may already be gone
+  this->player = nullptr;
+  this->ClearEntities();
 
   Log("-RunningState()\n");
 }
@@ -50,18 +61,22 @@ RunningState::Leave(GameState *) {
 
 void
 RunningState::NewGame() {
+  this->NewGame(ToString(time(nullptr)));
+}
+
+/**
+ * Start a new game with a level generated from a given seed.
+ * @param seed Seed of the random number generator.
+ */
+void
+RunningState::NewGame(const std::string &seed) {
   this->proto.set_level(0);
   this->proto.set_next_entity_id(1);
   this->proto.set_next_lock_id(1);
   this->proto.set_next_trigger_id(1);
 
-  std::string seed = ToString(time(nullptr));
   GetGame().NewGame(seed);
 
-  Log("allocating world...\n");
-  delete this->world;
-  this->world = new World(*this, IVector3(128, 64, 128));
-
   Random &random = GetRandom();
 
   Log("setting theme...\n");
@@ -80,10 +95,7 @@ RunningState::NewGame() {
   theme.itemCount = 100+random.Integer(120);
   theme.monsterCount = 50+random.Integer(100);
 
-  Log("building...\n");
-  
-  WorldBuilder builder(*this->world);
-  builder.Build(*this, theme);
+  this->BuildLevel(seed, theme);
 
   Log("adding player\n");
   Entity *player = Entity::Create("player");
@@ -99,9 +111,128 @@ RunningState::NewGame() {
   this->AddEntity(entity);
 }
 
+/**
+ * Build the current level from a seed and a theme. The same seed and theme
+ * always result in the same level, which is what saved levels rely on.
+ * @param seed Seed of the random number generator.
+ * @param theme Parameters of the world builder.
+ */
+void
+RunningState::BuildLevel(const std::string &seed, const Theme &theme) {
+  Level_Proto level;
+  level.set_seed(seed);
+  level.set_level(this->GetLevel());
+  *level.mutable_theme() = theme.GetProto();
+  level.set_first_lock_id(this->proto.next_lock_id());
+  level.set_first_trigger_id(this->proto.next_trigger_id());
+  this->StartLevel(level);
+
+  // start from a known state, whatever happened since the seed was set
+  GetRandom().Seed(seed, this->GetLevel());
+
+  Log("building...\n");
+  
+  WorldBuilder builder(*this->world);
+  builder.Build(*this, theme);
+
+  // the cell snapshot is taken from the baseline, it has to be complete
+  this->world->Settle();
+  this->world->SetBaseline();
+  this->level.set_cells_checksum(this->world->GetBaselineChecksum());
+  this->levelCellsSaved = false;
+}
+
+/**
+ * Replace the world by an empty one and remove everything of the old 
+ * level.
+ * @param level Parameters of the new level.
+ */
+void
+RunningState::StartLevel(const Level_Proto &level) {
+  Log("allocating world...\n");
+  delete this->world;
+  this->world = new World(*this, IVector3(128, 64, 128));
+  this->particles.Clear();
+  this->ClearEntities();
+
+  this->level = level;
+  this->level.clear_world();
+}
+
+/**
+ * Load the cells of a level as they were right after it was built from 
+ * its cell snapshot, which is a lot faster than building it again.
+ * @param level Parameters of the level.
+ * @return false if there is no snapshot of this level.
+ */
+bool
+RunningState::LoadLevelCells(const Level_Proto &level) {
+  PROFILE();
+
+  MappedFile file;
+  if (!file.Open("save.cells."+ToString(level.level()))) return false;
+
+  this->StartLevel(level);
+  if (!this->world->LoadCellSnapshot(file.GetData(), file.GetSize(), this->GetLevelKey())) return false;
+
+  this->world->SetBaseline();
+  this->levelCellsSaved = true;
+  return true;
+}
+
+/**
+ * Build a level again from its seed and theme, as it was built the first
+ * time.
+ * @param level Parameters of the level.
+ */
+void
+RunningState::RebuildLevel(const Level_Proto &level) {
+  // build with the ids of the first build, locks and triggers in the 
+  // cells depend on them
+  uint32_t nextLockId    = this->proto.next_lock_id();
+  uint32_t nextTriggerId = this->proto.next_trigger_id();
+  this->proto.set_next_lock_id(level.first_lock_id());
+  this->proto.set_next_trigger_id(level.first_trigger_id());
+
+  this->BuildLevel(level.seed(), Theme(level.theme()));
+
+  this->proto.set_next_lock_id(nextLockId);
+  this->proto.set_next_trigger_id(nextTriggerId);
+}
+
+/**
+ * Build the current level again from its seed, the way it is done when
+ * its cell snapshot is missing, and compare the result to the cells the
+ * level had right after it was built or loaded. The current level is
+ * replaced by the rebuilt one.
+ * @return true if the rebuilt level has the same cells.
+ */
+bool
+RunningState::CheckLevelRebuild() {
+  uint64_t checksum = this->world->GetBaselineChecksum();
+
+  Level_Proto level = this->level;
+  this->RebuildLevel(level);
+
+  return this->world->GetBaselineChecksum() == checksum;
+}
+
+/**
+ * Get a key that identifies the current level by the parameters it was 
+ * built with.
+ * @return The key.
+ */
+uint64_t
+RunningState::GetLevelKey() const {
+  std::string data = this->level.SerializePartialAsString();
+  return Checksum(data.data(), data.size());
+}
+
 void
 RunningState::ContinueGame() {
-  Load();
+  if (!this->Load()) {
+    this->NewGame();
+  }
 }
 
 void
@@ -136,11 +267,12 @@ RunningState::Render(Gfx &gfx) const {
   // draw all entities
   {
     PROFILE_NAMED("Draw Entities");
-    for (auto entity : this->entities) {
-      if (entity.second) entity.second->Draw(gfx);
-    }
+    this->entities.ForEach([&](Entity *entity) { entity->Draw(gfx); });
   }
 
+  // draw all particles
+  this->particles.Draw(gfx);
+
   {
     PROFILE_NAMED("Draw Weapons");
     gfx.ClearDepth(1.0);
@@ -170,15 +302,12 @@ RunningState::Update() {
   // remove removable entities
   {
     PROFILE_NAMED("Remove Entities");
-    auto entityIter = this->entities.begin();
-    while(entityIter != this->entities.end()) {
-      if (!entityIter->second || entityIter->second->IsRemovable()) {
-        delete entityIter->second;
-        entityIter = this->entities.erase(entityIter);
-      } else {
-        entityIter++;
-      }
-    }
+    this->entities.RemoveIf([&](Entity *entity) {
+      if (!entity->IsRemovable()) return false;
+      this->entityGrid.Remove(entity);
+      delete entity;
+      return true;
+    });
   }
 
   // show or hide inventory
@@ -195,7 +324,7 @@ RunningState::Update() {
         GetGame().SetGui(std::shared_ptr<Gui>(new InventoryGui(*this, *player)));
         this->showInventory = true;
       } else {
-        if (entities[entityID]->GetLockedID()) {
+        if (entity->GetLockedID()) {
           this->player->AddMessage("The "+entity->GetName()+" is locked.");
         } else {
           GetGame().SetGui(std::shared_ptr<Gui>(new InventoryGui(*this, *player, *entity)));
@@ -213,43 +342,53 @@ RunningState::Update() {
   // update world
   this->world->Update(*this);
 
+  // find the ways to the player
+  if (this->player) {
+    this->world->GetNavField().Update(std::vector<IVector3> { IVector3(this->player->GetFeetPosition()) });
+  }
+
   // handle collision between entities
   {
     PROFILE_NAMED("Entity Collision");
-    std::vector<Entity*> collideEntities;
-    for (auto entity : this->entities) {
-      if (!entity.second) continue;
-      if (entity.second->GetProperties()->nocollideEntity) continue;
-      if (entity.second->IsDead()) continue;
-      collideEntities.push_back(entity.second);
-    }
-    for (size_t i=0; i<collideEntities.size(); i++) {
-      Entity *e1 = collideEntities[i];
-      for (size_t j=i+1; j<collideEntities.size(); j++) {
-        Entity *e2 = collideEntities[j];
-
-        // don't collide with owners if not wanted
-        if (e1->GetOwner() == e2->GetId() && e1->GetProperties()->nocollideOwner) continue;
-        if (e2->GetOwner() == e1->GetId() && e2->GetProperties()->nocollideOwner) continue;
-
-        if (e1->GetAABB().Overlap(e2->GetAABB())) {
-          e1->OnCollide(*this, *e2);
-          e2->OnCollide(*this, *e1);
-        }
+    std::vector<std::pair<Entity*, Entity*>> pairs;
+    this->entityGrid.FindPairs(pairs);
+
+    for (auto &pair : pairs) {
+      Entity *e1 = pair.first;
+      Entity *e2 = pair.second;
+
+      if (e1->GetProperties()->nocollideEntity || e1->IsDead()) continue;
+      if (e2->GetProperties()->nocollideEntity || e2->IsDead()) continue;
+
+      // don't collide with owners if not wanted
+      if (e1->GetOwner() == e2->GetId() && e1->GetProperties()->nocollideOwner) continue;
+      if (e2->GetOwner() == e1->GetId() && e2->GetProperties()->nocollideOwner) continue;
+
+      // an earlier collision may have moved one of them
+      if (e1->GetAABB().Overlap(e2->GetAABB())) {
+        e1->OnCollide(*this, *e2);
+        e2->OnCollide(*this, *e1);
       }
     }
   }
 
+  // let entities think
+  this->thinkScheduler.Run(*this, this->player);
+
   // update all entities
   {
     PROFILE_NAMED("Entity Update");
-    for (auto &entity : this->entities) {
-      if (entity.second) {
-        entity.second->Update(*this);
-      } else {
-        Log("Entity %u is null!\n", entity.first);
-      }
-    }
+    this->entities.ForEach([&](Entity *entity) {
+      entity->Update(*this);
+      this->entityGrid.Move(entity);
+    });
+  }
+
+  this->particles.Update(*this);
+
+  // save now and then, skip it while the last save is still being written
+  if (this->player && GetGame().GetTime() - this->lastSaveT > autosaveInterval && !this->saveWriter.IsBusy()) {
+    this->Save();
   }
 
   return this;
@@ -264,26 +403,63 @@ void RunningState::HandleEvent(const InputEvent &event) {
 }
 
 /**
- * Add an entity to this game.
+ * Add an entity to this game. The game takes ownership of the entity, if
+ * it can't be added it is deleted right away.
  * @param entity Entity to add
+ * @return Id of the entity, InvalidID if it could not be added.
  */
 ID
 RunningState::AddEntity(Entity *entity) {
-  ID entityId = GetNextEntityId();
-  this->entities[entityId] = entity;
+  ID entityId = this->entities.Add(entity);
+  if (entityId == InvalidID) {
+    Log("Too many entities, could not add %s\n", entity->GetProperties()->name.c_str());
+    delete entity;
+    return InvalidID;
+  }
+
   entity->Start(*this, entityId);
+  this->entityGrid.Add(entity);
+
+  if (dynamic_cast<Player*>(entity)) {
+    this->SetPlayer(dynamic_cast<Player*>(entity));
+  }
+  return entityId;
+}
+
+/**
+ * Add a saved entity to this game under its old id.
+ * @param entityProto The saved entity.
+ * @return Id of the entity, InvalidID if it could not be added.
+ */
+ID
+RunningState::ContinueEntity(const Entity_Proto &entityProto) {
+  Entity *entity = Entity::Create(entityProto);
+  if (!entity) return InvalidID;
 
-  if (entity->IsSolid()) this->solidEntities.push_back(entity);
+  ID entityId = entityProto.id();
+  if (!this->entities.Insert(entityId, entity)) {
+    Log("Could not continue %s with id %08x\n", entityProto.type().c_str(), entityId);
+    delete entity;
+    return InvalidID;
+  }
+
+  entity->Continue(*this, entityId);
+  this->entityGrid.Add(entity);
 
   if (dynamic_cast<Player*>(entity)) {
-    this->player = dynamic_cast<Player*>(entity);
-    GetGame().GetGfx().SetPlayer(player);
-    GetGame().GetAudio().SetPlayer(player);
-    this->proto.set_player_id(entityId);
+    this->SetPlayer(dynamic_cast<Player*>(entity));
   }
   return entityId;
 }
 
+void
+RunningState::SetPlayer(Player *player) {
+  this->player = player;
+  GetGame().GetGfx().SetPlayer(player);
+  GetGame().GetAudio().SetPlayer(player);
+  this->proto.set_player_id(player->GetId());
+}
+
 /**
  * Remove an entity from this world.
  * If the entity is the player entity, the player reference will be unset.
@@ -291,37 +467,52 @@ RunningState::AddEntity(Entity *entity) {
  */
 void
 RunningState::RemoveEntity(ID entityId) {
-  auto iter = this->entities.find(entityId);
-  if (iter == this->entities.end()) {
+  Entity *entity = this->entities.Remove(entityId);
+  if (!entity) {
     return;
   }
 
-  if (this->player == iter->second) {
+  if (this->player == entity) {
     this->player = nullptr;
     GetGame().GetGfx().SetPlayer(nullptr);
     GetGame().GetAudio().SetPlayer(nullptr);
     this->proto.set_player_id(0);
   }
 
-  auto solidIter = std::find(this->solidEntities.begin(), this->solidEntities.end(), iter->second);
-  if (solidIter != this->solidEntities.end()) {
-    this->solidEntities.erase(solidIter);
+  this->entityGrid.Remove(entity);
+  delete entity;
+}
+
+/**
+ * Delete all entities, e.g. when leaving a level, and give the memory of
+ * the level entity pools back in one go.
+ */
+void
+RunningState::ClearEntities() {
+  if (this->player) {
+    this->player = nullptr;
+    GetGame().GetGfx().SetPlayer(nullptr);
+    GetGame().GetAudio().SetPlayer(nullptr);
+    this->proto.set_player_id(0);
   }
 
-  delete iter->second;
-  this->entities.erase(iter);
+  this->entityGrid.Clear();
+  this->thinkScheduler.Clear();
+  this->entities.ForEach([](Entity *entity) { delete entity; });
+  this->entities.Clear();
+
+  Pool::ReleaseLevel();
 }
 
 std::vector<ID>
 RunningState::FindEntities(const Vector3 &center, float radius) const {
-  std::vector<ID> entities;
+  std::vector<Entity*> found;
+  this->entityGrid.FindInRadius(center, radius, found);
 
-  for (auto entity : this->entities) {
-    if (!entity.second || entity.second->IsDead()) continue;
-    float d = (center - entity.second->GetPosition()).GetMag();
-    if (d < radius) {
-      entities.push_back(entity.first);
-    }
+  std::vector<ID> entities;
+  for (Entity *entity : found) {
+    if (entity->IsDead()) continue;
+    entities.push_back(entity->GetId());
   }
 
   return entities;
@@ -329,12 +520,12 @@ RunningState::FindEntities(const Vector3 &center, float radius) const {
 
 std::vector<ID>
 RunningState::FindSolidEntities(const AABB &aabb) const {
-  std::vector<ID> entities;
+  std::vector<Entity*> found;
+  this->entityGrid.FindInAABB(aabb, found);
 
-  for (auto ent : this->solidEntities) {
-    if (aabb.Overlap(ent->GetAABB())) {
-      entities.push_back(ent->GetId());
-    }
+  std::vector<ID> entities;
+  for (Entity *entity : found) {
+    if (entity->IsSolid()) entities.push_back(entity->GetId());
   }
 
   return entities;
@@ -342,12 +533,12 @@ RunningState::FindSolidEntities(const AABB &aabb) const {
 
 std::vector<const Entity*>
 RunningState::FindLightEntities(const Vector3 &pos, float radius) const {
-  std::vector<const Entity*> entities;
+  std::vector<Entity*> found;
+  this->entityGrid.FindInRadius(pos, radius, found);
 
-  for (auto &entity : this->entities) {
-    if (entity.second && !entity.second->GetLight().IsBlack() && (entity.second->GetPosition()-pos).GetMag() < radius) {
-      entities.push_back(entity.second);
-    }
+  std::vector<const Entity*> entities;
+  for (Entity *entity : found) {
+    if (!entity->GetLight().IsBlack()) entities.push_back(entity);
   }
 
   std::sort(entities.begin(), entities.end(), [&](const Entity *a, const Entity *b) -> bool {
@@ -371,18 +562,14 @@ RunningState::CheckEntities(const IVector3 &pos) {
   aabb.extents = Vector3(0.5, 0.5, 0.5);
   aabb.center = Vector3(pos) + aabb.extents;
 
-  for (auto entity : this->entities) {
-    if (aabb.Overlap(entity.second->GetAABB())) return false;
-  }
-
-  return true;
+  std::vector<Entity*> found;
+  this->entityGrid.FindInAABB(aabb, found);
+  return found.empty();
 }
 
 Entity *
 RunningState::GetEntity(ID entityId) {
-  auto iter = this->entities.find(entityId);
-  if (iter == this->entities.end()) return nullptr;
-  return iter->second;
+  return this->entities.Get(entityId);
 }
 
 Vector3 RunningState::MoveAABB(
@@ -489,6 +676,24 @@ Vector3 RunningState::MoveAABB(
   return center;
 }
 
+/** Sweep a AABB through the world and then against the solid entities.
+  * @param aabb The AABB to move.
+  * @param delta Movement of the AABB.
+  * @param[out] result Contacts during the movement, see World::SweepAABB.
+  * @param stepHeight Height of obstacles in the world to step onto.
+  * @param sneak If true, prevent falling from ledges.
+  * @return The final center position of the AABB.
+  */
+Vector3
+RunningState::SweepAABB(const AABB &aabb, const Vector3 &delta, SweepResult &result, float stepHeight, bool sneak) {
+  Vector3 center = this->world->SweepAABB(aabb, delta, result, stepHeight, sneak);
+
+  uint8_t axis = 0;
+  center = this->MoveAABB(aabb, center, axis);
+  result.axis |= axis;
+  return center;
+}
+
 void
 RunningState::Explosion(Entity &entity, const Vector3 &pos, size_t radius, float strength, float damage, Element element, bool magical) {
   ID ownerID = entity.GetOwner();
@@ -498,13 +703,13 @@ RunningState::Explosion(Entity &entity, const Vector3 &pos, size_t radius, float
   float damageFactor = 1.0;
 
   if (owner) {
-    Stats stats = owner->GetEffectiveStats();
-    damageFactor += 0.2 * (stats.GetMagicAttack() + stats.GetSkill("magic")); //Stats::GetLevelForSkillExp(stats.skills["magic"]));
+    const Stats &stats = owner->GetEffectiveStats();
+    damageFactor += 0.2 * (stats.GetMagicAttack() + stats.GetSkill(Skills::Magic)); //Stats::GetLevelForSkillExp(stats.skills["magic"]));
   }
 
   std::vector<ID> entIDs = this->FindEntities(pos, radius);
   for (ID entID : entIDs) {
-    Entity &ent  = *this->entities[entID];
+    Entity &ent  = *this->GetEntity(entID);
     Vector3 d = ent.GetPosition() - pos;
     float dmg = damage / (1.0 + d.GetSquareMag());
 
@@ -535,11 +740,19 @@ RunningState::Explosion(Entity &entity, const Vector3 &pos, size_t radius, float
 
 ID
 RunningState::SpawnInAABB(
-  const std::string &type,
+  const Symbol &type,
   const AABB &aabb,
   const Vector3 &velocity
 ) {
-  Entity *entity = Entity::Create(type);
+  const EntityProperties *properties = getEntity(type);
+  if (properties->isParticle) {
+    Vector3 s = aabb.extents - properties->extents;
+    Vector3 p = Vector3::Random(GetRandom()) * s + aabb.center;
+    this->particles.Spawn(*this, *properties, p, velocity);
+    return InvalidID;
+  }
+
+  Entity *entity = Entity::Create(type.GetString());
   if (!entity) return InvalidID;
 
   Vector3 s = aabb.extents - entity->GetAABB().extents;
@@ -552,6 +765,32 @@ RunningState::SpawnInAABB(
   return AddEntity(entity);
 }
 
+/**
+ * Spawn a particle. Types marked as particles go to the particle pool,
+ * others are spawned as a Mob.
+ * @param type Entity type of the particle.
+ * @param pos Initial position.
+ * @param velocity Initial velocity.
+ * @return Id of the spawned entity, InvalidID for pooled particles.
+ */
+ID
+RunningState::SpawnParticle(
+  const Symbol &type,
+  const Vector3 &pos,
+  const Vector3 &velocity
+) {
+  const EntityProperties *properties = getEntity(type);
+  if (properties->isParticle) {
+    this->particles.Spawn(*this, *properties, pos, velocity);
+    return InvalidID;
+  }
+
+  Mob *particle = new Mob(type.GetString());
+  particle->SetPosition(pos);
+  particle->AddVelocity(velocity);
+  return AddEntity(particle);
+}
+
 void RunningState::LockCell(Cell &cell) {
   if (cell.GetLockID()) return;
 
@@ -565,7 +804,7 @@ void RunningState::LockCell(Cell &cell) {
     //  keyPos = this->GetWorld().GetRandomTeleportTarget(this->GetRandom())[Side::Up];
     //}
 
-    std::shared_ptr<Item> keyItem(new Item("key"));
+    std::shared_ptr<Item> keyItem = Item::Create("key");
     keyItem->SetUnlockID(id);
 
     ItemEntity *entity = new ItemEntity(keyItem);
@@ -589,7 +828,7 @@ void RunningState::LockEntity(Entity &ent) {
     //  keyPos = this->GetWorld().GetRandomTeleportTarget(this->GetRandom())[Side::Up];
     //}
 
-    std::shared_ptr<Item> keyItem(new Item("key"));
+    std::shared_ptr<Item> keyItem = Item::Create("key");
     keyItem->SetUnlockID(id);
 
     ItemEntity *entity = new ItemEntity(keyItem);
@@ -601,16 +840,16 @@ void RunningState::LockEntity(Entity &ent) {
 }
 
 void RunningState::TriggerOn(ID id) {
-  for (auto &entity : this->entities) {
-    if (entity.second && entity.second->GetTriggerId() == id) entity.second->TriggerOn();
-  }
+  this->entities.ForEach([&](Entity *entity) {
+    if (entity->GetTriggerId() == id) entity->TriggerOn();
+  });
   this->GetWorld().TriggerOn(id);
 }
 
 void RunningState::TriggerOff(ID id) {
-  for (auto &entity : this->entities) {
-    if (entity.second && entity.second->GetTriggerId() == id) entity.second->TriggerOff();
-  }
+  this->entities.ForEach([&](Entity *entity) {
+    if (entity->GetTriggerId() == id) entity->TriggerOff();
+  });
   this->GetWorld().TriggerOff(id);
 }
 
@@ -621,114 +860,151 @@ RunningState::GetNextTriggerId() {
   return id;
 }
 
-ID
-RunningState::GetNextEntityId() { 
-  ID id = this->proto.next_entity_id();
-  this->proto.set_next_entity_id(id + 1); 
-  return id;
-}
-
+/**
+ * Save the game. The state is copied into a snapshot here, serializing
+ * and writing it to disk happens on the save writer thread.
+ */
 void
 RunningState::Save() {
   PROFILE();
-  Log("Saving...\n");
-  this->saving = true;
-
-  std::fstream out;
-  if (createUserStream("save.game", out)) {
-    this->GetGame().Serialize(out);
-    this->proto.SerializeToOstream(&out);
-  } else {
-    Log("could not open save.game file\n");
-  }
 
-  SaveLevel();
+  auto start = std::chrono::steady_clock::now();
 
-  this->saving = false;
-}
+  SaveWriter::Snapshot snapshot;
+  snapshot.push_back(SaveWriter::File { "save.game", {}, nullptr, nullptr });
+  snapshot.back().messages.emplace_back(new Game_Proto(this->GetGame().GetProto()));
+  snapshot.back().messages.emplace_back(new RunningState_Proto(this->proto));
 
-void
-RunningState::SaveLevel() {
-  std::fstream out;
-  if (createUserStream("save.level."+ToString(this->GetLevel()), out)) {
-    ::EntityList_Proto entityList;
-    for (auto &e:this->entities) {
-      if (e.second) *entityList.mutable_entities()->Add() = e.second->GetProto();
-    }
-    entityList.SerializeToOstream(&out);
-  } else {
-    Log("could not open level save file\n");
-  }
+  this->SaveLevel(snapshot);
 
-  world->GetProto().SerializeToOstream(&out);
+  this->saveWriter.Post(std::move(snapshot));
+  this->lastSaveT = this->GetGame().GetTime();
 
-  // TODO: serialize nondefault cells
+  float time = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+  Log("Saving... snapshot took %.1f ms\n", time * 1000.0f);
+}
 
-  /*
-  for (size_t i=0; i<world->GetCellCount(); i++) {
-    Cell_Proto cellProto;
-    world->GetCell(i).Serialize(cellProto);
-    cellProto.SerializeToOstream(&out);
+/**
+ * Add the current level to a save snapshot. A level file starts with the 
+ * seed and theme the level was built from, followed by the entities and 
+ * finally by the cells that differ from a freshly built level. The first
+ * save of a level also writes a cell snapshot of the freshly built level.
+ * @param snapshot The snapshot.
+ */
+void
+RunningState::SaveLevel(SaveWriter::Snapshot &snapshot) {
+  // the cells of the freshly built level never change, write them once
+  if (!this->levelCellsSaved) {
+    snapshot.push_back(SaveWriter::File { "save.cells."+ToString(this->GetLevel()), {}, nullptr, this->world->GetCellSnapshot(this->GetLevelKey()) });
+    this->levelCellsSaved = true;
   }
-  */
 
-  /*
-  Serializer ser("LEVL");
-  ser << *world;
-  ser << (uint32_t)this->player->GetId();
-  ser << this->entities;
+  snapshot.push_back(SaveWriter::File { "save.level."+ToString(this->GetLevel()), {}, nullptr, nullptr });
+  SaveWriter::File &file = snapshot.back();
 
-  FILE *f = createUserFile("level." + ToString(this->proto.level()));
+  Level_Proto *level = new Level_Proto();
+  file.messages.emplace_back(level);
+  *level = this->level;
+  auto saveDelta = this->world->GetSnapshot(*level->mutable_world());
 
-  //std::thread([=](){
-    if (f) {
-  //    ser.WriteToFile(f);
-      fclose(f);
+  ::EntityList_Proto *entityList = new ::EntityList_Proto();
+  file.messages.emplace_back(entityList);
+  this->entities.ForEach([&](Entity *entity) {
+    *entityList->mutable_entities()->Add() = entity->GetProto();
+  });
+
+  file.prepare = [saveDelta](SaveWriter::MessageList &messages) {
+    std::vector<std::unique_ptr<CellDelta_Proto>> deltas;
+    saveDelta(deltas);
+    for (auto &delta : deltas) {
+      messages.emplace_back(delta.release());
     }
-  //}).detach();
-  */
+  };
 }
 
-void
+/**
+ * Load the current level. The cells of the freshly built level are taken
+ * from its cell snapshot, or if there is none the level is built again
+ * from its seed and theme. Then its entities are replaced by the saved 
+ * ones and the changed cells are read one delta at a time. The deltas are
+ * skipped if the level built again is not the one they were saved for.
+ * @return false if the level could not be loaded.
+ */
+bool
 RunningState::LoadLevel() {
-  /*
-  FILE *f = openUserFile("level." + ToString(this->proto.level()));
+  PROFILE();
+
+  std::fstream in;
+  if (!openUserStream("save.level."+ToString(this->GetLevel()), in)) {
+    Log("could not open level save file\n");
+    return false;
+  }
+
+  ProtoReader reader(in);
 
-  Deserializer deser;
-  deser.LoadFromFile(f, "LEVL");
-  fclose(f);
+  Level_Proto level;
+  ::EntityList_Proto entityList;
+  if (!reader.Read(level) || !reader.Read(entityList)) {
+    Log("could not read level save file\n");
+    return false;
+  }
 
-  delete world;
-  world = new World(*this, deser);
+  bool cellsMatch = true;
+  if (!this->LoadLevelCells(level)) {
+    this->RebuildLevel(level);
 
-  ID playerId;
-  deser >> playerId;
-  deser >> this->entities;
+    if (level.has_cells_checksum() && level.cells_checksum() != this->level.cells_checksum()) {
+      Log("level %d was built differently than before, ignoring its cell deltas\n", this->GetLevel());
+      cellsMatch = false;
+    }
+  }
+  this->world->LoadSnapshot(level.world());
 
-  this->player = dynamic_cast<Player*>(this->entities[playerId]);
-  GetGame().GetGfx().SetPlayer(this->player);
+  this->ClearEntities();
+  for (auto &entityProto : entityList.entities()) {
+    this->ContinueEntity(entityProto);
+  }
 
-  for (auto &e:this->entities) {
-    e.second->Continue(*this, e.first);
-  }*/
+  CellDelta_Proto delta;
+  size_t deltaCount = 0;
+  while(cellsMatch && reader.Read(delta)) {
+    if (!this->world->LoadDelta(level.world(), delta)) {
+      Log("broken cell delta in level save file\n");
+    }
+    deltaCount++;
+  }
+
+  Log("loaded level %d with %u entities and %u cell deltas\n", this->GetLevel(), (unsigned int)this->entities.GetCount(), (unsigned int)deltaCount);
+  return true;
 }
 
-void
+/**
+ * Load the game saved by Save().
+ * @return false if there is no saved game.
+ */
+bool
 RunningState::Load() {
   PROFILE();
-  /*
   Log("Loading...\n");
 
-  Deserializer deser;
-  FILE *f = openUserFile("game");
-  deser.LoadFromFile(f, "GAME");
+  std::fstream in;
+  if (!openUserStream("save.game", in)) {
+    Log("could not open save.game file\n");
+    return false;
+  }
 
-  Log("game %08x\n", deser.GetPos());
-  //deser >> GetGame();
+  ProtoReader reader(in);
 
-  Log("runningstate %08x\n", deser.GetPos());
-  //deser >> self;
+  Game_Proto gameProto;
+  RunningState_Proto proto;
+  if (!reader.Read(gameProto) || !reader.Read(proto)) {
+    Log("could not read save.game file\n");
+    return false;
+  }
+  in.close();
 
-  LoadLevel();
-  */
+  this->GetGame().Deserialize(gameProto);
+  this->proto = proto;
+
+  return this->LoadLevel();
 }
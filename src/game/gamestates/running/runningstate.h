@@ -1,12 +1,18 @@
 #ifndef BARFOOS_RUNNINGSTATE_H
 #define BARFOOS_RUNNINGSTATE_H
 
+#include "game/entities/entitygrid.h"
+#include "game/entities/entitystore.h"
+#include "game/entities/particlepool.h"
+#include "game/entities/thinkscheduler.h"
 #include "game/gamestates/gamestate.h"
+#include "io/savewriter.h"
 
+#include "entity.pb.h"
 #include "runningstate.pb.h"
+#include "world.pb.h"
 
 #include <vector>
-#include <unordered_map>
 
 class RunningState : public GameState {
 public:
@@ -21,7 +27,9 @@ public:
   virtual void          HandleEvent(const InputEvent &evt) override;
 
   void                  NewGame();
+  void                  NewGame(const std::string &seed);
   void                  ContinueGame();
+  bool                  CheckLevelRebuild();
 
   World  &              GetWorld()                  const { return *this->world;  }
   int                   GetLevel()                  const { return this->proto.level();   }
@@ -39,11 +47,16 @@ public:
   std::vector<ID>       FindEntities(const Vector3 &center, float radius)      const;
   std::vector<ID>       FindSolidEntities(const AABB &aabb) const;
 
+  void                  ScheduleThink(Entity &entity, float time) { this->thinkScheduler.Add(entity, time); }
+  const ThinkScheduler &GetThinkScheduler()         const { return this->thinkScheduler; }
+
   // misc.
   Vector3               MoveAABB(const AABB &aabb, const Vector3 &dir, uint8_t &axis);
+  Vector3               SweepAABB(const AABB &aabb, const Vector3 &delta, SweepResult &result, float stepHeight = 0.0f, bool sneak = false);
 
   void                  Explosion(Entity &entity, const Vector3 &pos, size_t radius, float strength, float damage, Element element, bool magical = false);
-  ID                    SpawnInAABB(const std::string &type, const AABB &aabb, const Vector3 &velocity);
+  ID                    SpawnInAABB(const Symbol &type, const AABB &aabb, const Vector3 &velocity);
+  ID                    SpawnParticle(const Symbol &type, const Vector3 &pos, const Vector3 &velocity);
   void                  LockCell(Cell &cell);
   void                  LockEntity(Entity &entity);
 
@@ -51,8 +64,8 @@ public:
   void                  TriggerOff(ID id);
   ID                    GetNextTriggerId();
 
-  void                  SaveLevel();
-  void                  LoadLevel();
+  void                  SaveLevel(SaveWriter::Snapshot &snapshot);
+  bool                  LoadLevel();
 
 private:
 
@@ -60,23 +73,43 @@ private:
 
   World *world;
 
-  ID GetNextEntityId();
+  EntityStore entities;
+  ID ContinueEntity(const Entity_Proto &entityProto);
+  void ClearEntities();
 
-  std::unordered_map<ID, Entity*> entities;
   Player *player;
+  void SetPlayer(Player *player);
+
+  /** Parameters the current level was built with, without the world. */
+  Level_Proto level;
+
+  /** Whether the cells of the freshly built level have been saved, see
+    * World::GetCellSnapshot. */
+  bool levelCellsSaved;
 
-  std::vector<Entity*> solidEntities;
+  void StartLevel(const Level_Proto &level);
+  void BuildLevel(const std::string &seed, const Theme &theme);
+  void RebuildLevel(const Level_Proto &level);
+  bool LoadLevelCells(const Level_Proto &level);
+  uint64_t GetLevelKey() const;
+
+  EntityGrid entityGrid;
+  ThinkScheduler thinkScheduler;
+  ParticlePool particles;
 
   bool showInventory;
 
+  /** Game time between automatic saves. */
+  static constexpr float autosaveInterval = 300.0f;
+
   float lastSaveT;
 
  std::vector<const Entity*> FindLightEntities(const Vector3 &pos, float radius) const;
   void BuildWorld();
 
-  volatile bool saving;
+  SaveWriter saveWriter;
   void Save();
-  void Load();
+  bool Load();
 
   friend Serializer &operator << (Serializer &ser, const RunningState &state);
   friend Deserializer &operator >> (Deserializer &deser, RunningState &state);
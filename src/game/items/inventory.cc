@@ -105,7 +105,7 @@ Inventory::AddToInventory(const std::shared_ptr<Item> &item, InventorySlot slot)
   } else if (item->GetAmount() > 1) {
     //Log("Cannot Stack!\n");
     // can't be stacked, put all but one from stack into backpack
-    std::shared_ptr<Item> rest(new Item(item->GetProperties().name));
+    std::shared_ptr<Item> rest = Item::Create(item->GetProperties().name);
     rest->SetAmount(item->GetAmount()-1);
     item->SetAmount(1);
 
@@ -233,7 +233,7 @@ Inventory::DropItem(RunningState &state, Entity &owner, const std::shared_ptr<It
   if (!item || item->IsRemovable()) return;
 
   while(item->GetAmount() > 1) {
-    DropItem(state, owner, std::shared_ptr<Item>(new Item(item->GetProperties().name)));
+    DropItem(state, owner, Item::Create(item->GetProperties().name));
     item->DecAmount();
   }
 
@@ -276,6 +276,21 @@ Inventory::ModifyStats(Stats &stats) const {
   }
 }
 
+/** Get a value that changes whenever an item is added to or removed from
+  * the inventory or an item in it changes in a way that affects stats.
+  * @return Combined generation of all items.
+  */
+uint32_t
+Inventory::GetGeneration() const {
+  uint32_t generation = 0;
+  for (auto &item : this->inventory) {
+    if (!item.second) continue;
+    generation = generation * 31 + (uint32_t)item.first;
+    generation = generation * 31 + item.second->GetGeneration();
+  }
+  return generation;
+}
+
 uint32_t
 Inventory::GetGold() const {
   if (!self[InventorySlot::Purse]) return 0;
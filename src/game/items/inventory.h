@@ -82,6 +82,7 @@ public:
   void                      RemoveGem(Element e);
 
   void ModifyStats(Stats &stats) const;
+  uint32_t                  GetGeneration()                   const;
 
   void Clear() { this->inventory.clear(); }
 
@@ -270,7 +270,7 @@ void InventorySlotGui::HandleEvent(const InputEvent &event) {
         std::shared_ptr<Item> combineItem = parent->dragItem;
         bool isStack = parent->dragItem->GetAmount() > 1;
         if (isStack) {
-          combineItem = std::shared_ptr<Item>(new Item(parent->dragItem->GetProperties().name));
+          combineItem = Item::Create(parent->dragItem->GetProperties().name);
           parent->dragItem->DecAmount();
         } else {
           parent->dragItem = nullptr;
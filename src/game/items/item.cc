@@ -15,13 +15,18 @@
 #include "gfx/text.h"
 #include "gfx/texture.h"
 
+uint32_t Item::lastGeneration = 0;
+
+Pool Item::pool("Item");
+
 Item::Item(const std::string &type) :
   properties(&getItem(type)),
   effect(nullptr),
   durabilityTex(Texture::Get("gui/durability")),
   isRemovable(false),
   sprite(this->properties->sprite),
-  typeIdentified(false)
+  typeIdentified(false),
+  generation(++lastGeneration)
 {
   if (!this->sprite.animations.empty()) this->sprite.StartAnim(0);
 
@@ -36,7 +41,8 @@ Item::Item(const Item_Proto &proto) :
   durabilityTex(Texture::Get("gui/durability")),
   isRemovable(false),
   sprite(this->properties->sprite),
-  typeIdentified(proto.is_item_identified())
+  typeIdentified(proto.is_item_identified()),
+  generation(++lastGeneration)
 {
 }
 
@@ -62,6 +68,7 @@ void Item::ReplaceWith(const std::string &type) {
   this->proto.clear_unlock_id();
 
   if (!this->sprite.animations.empty()) this->sprite.StartAnim(0);
+  this->Modified();
 }
 
 bool Item::CanUse(RunningState &state) const {
@@ -75,7 +82,7 @@ void Item::StartCooldown(RunningState &state, Entity &user, bool damage) {
     this->proto.set_durability(this->GetDurability() - this->properties->useDurability * this->effect->useDurability);
   }
 
-  Stats stats = user.GetEffectiveStats();
+  const Stats &stats = user.GetEffectiveStats();
   float cooldown = this->GetCooldown() / (1.0 + Const::AttackSpeedFactorPerAGI*stats.GetAgility());
   cooldown *= stats.GetCoolDown();
   this->proto.set_next_use_time(state.GetGame().GetTime() + cooldown);
@@ -120,6 +127,7 @@ void Item::Update(RunningState &state) {
     this->effect = &getEffect(effectName);
     this->proto.set_effect(effectName);
     this->proto.set_durability(this->proto.durability() * this->effect->durability);
+    this->Modified();
   }
 
   if (!this->typeIdentified && this->proto.is_item_identified()) {
@@ -211,7 +219,7 @@ bool Item::UseOnEntity(RunningState &state, Mob &user, uint32_t id) {
       HealthInfo healthInfo(Stats::MeleeAttack(user, *entity, *this, state.GetRandom()));
 
       if (entity->GetProperties()->learnEvade && healthInfo.hitType == HitType::Miss) {
-        entity->GetBaseStats().UpgradeSkill("evade");
+        entity->GetBaseStats().UpgradeSkill(Skills::Evade);
         // TODO: play item "miss.entity" sound
       } else {
         // TODO: play item "hit.entity" sound
@@ -296,9 +304,10 @@ bool Item::UseOnNothing(RunningState &state, Mob &user) {
     proj->SetOwner(user);
     proj->SetForward(user.GetForward());
     proj->SetPosition(user.GetPosition() + Vector3(0,user.GetProperties()->eyeOffset,0));
-    state.AddEntity(proj);
-    proj->SetVelocity(proj->GetVelocity() * charge);
-    proj->AddVelocity(user.GetVelocity());
+    if (state.AddEntity(proj) != InvalidID) {
+      proj->SetVelocity(proj->GetVelocity() * charge);
+      proj->AddVelocity(user.GetVelocity());
+    }
     this->StartCooldown(state, user);
     return true;
   } else {
@@ -459,6 +468,7 @@ Item::Combine(const std::shared_ptr<Item> &other) {
     if (effect.onCombineIdentify) {
       other->proto.set_is_item_identified(true);
     }
+    other->Modified();
     this->proto.set_is_item_identified(true);
     if (this->properties->durability != 0.0) {
       this->proto.set_durability(this->GetDurability() - this->properties->combineDurability);
@@ -505,7 +515,7 @@ Item::Consume(RunningState &state, Entity &user) {
   this->isRemovable = true;
 
   if (this->properties->onConsumeResult != "") {
-    return std::shared_ptr<Item>(new Item(this->properties->onConsumeResult));
+    return Item::Create(this->properties->onConsumeResult);
   }
   return nullptr;
 }
@@ -513,6 +523,7 @@ Item::Consume(RunningState &state, Entity &user) {
 void
 Item::SetEquipped(bool equipped) {
   this->proto.set_is_equipped(equipped);
+  this->Modified();
   if (!equipped) {
     this->proto.set_is_charging(false);
   }
@@ -1,6 +1,7 @@
 #ifndef BARFOOS_ITEM_H
 #define BARFOOS_ITEM_H
 
+#include "util/pool.h"
 #include "util/weighted_map.h"
 #include "game/items/itemproperties.h"
 
@@ -24,6 +25,8 @@ public:
 
   Item &operator=(const Item &) = default;
 
+  template<class... Args> static std::shared_ptr<Item> Create(Args&&... args);
+
   void Update(RunningState &state);
 
   void Draw(Gfx &gfx, bool left);
@@ -88,6 +91,10 @@ public:
 
   const Item_Proto &GetProto() const { return this->proto; }
 
+  /** Changes whenever something about the item changes that affects the
+    * stats of its owner. Unique across all items. */
+  uint32_t GetGeneration()              const { return this->generation; }
+
 protected:
 
   Item_Proto proto;
@@ -104,11 +111,30 @@ protected:
 
   // gameplay
   bool typeIdentified;
+  uint32_t generation;
+
+  static uint32_t lastGeneration;
+
+  void Modified() { this->generation = ++lastGeneration; }
 
   friend Serializer   &operator << (Serializer &ser, const Item &item);
   friend Deserializer &operator >> (Deserializer &ser, Item *&item);
   friend Deserializer &operator >> (Deserializer &ser, Inventory &inventory);
+
+private:
+
+  static Pool pool;
 };
 
+/** Create an item. The item and its reference count share one block from
+  * the item pool.
+  * @param args Arguments to the item c'tor.
+  * @return The new item.
+  */
+template<class... Args> std::shared_ptr<Item>
+Item::Create(Args&&... args) {
+  return std::allocate_shared<Item>(PoolAllocator<Item>(pool), std::forward<Args>(args)...);
+}
+
 #endif
 
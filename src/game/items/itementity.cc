@@ -5,9 +5,22 @@
 #include "game/world/world.h"
 #include "gfx/gfx.h"
 
+Pool ItemEntity::pool("ItemEntity", true);
+
+/** Allocate an item entity from the pool of the current level. */
+void *
+ItemEntity::operator new(size_t size) {
+  return pool.Allocate(size);
+}
+
+void
+ItemEntity::operator delete(void *ptr, size_t size) {
+  pool.Free(ptr, size);
+}
+
 ItemEntity::ItemEntity(const std::string &itemName) : 
   Mob("item"),
-  item(new Item(itemName)),
+  item(Item::Create(itemName)),
   yoffset(0.5)  {
   this->proto.set_spawn_class(uint32_t(SpawnClass::ItemEntityClass));
   this->proto.mutable_item();
@@ -24,7 +37,7 @@ ItemEntity::ItemEntity(const std::shared_ptr<Item> &item) :
 ItemEntity::ItemEntity(const Entity_Proto &proto) : 
   Mob(proto),
   yoffset(0.5) {
-  this->item = std::shared_ptr<Item>(new Item(proto.item()));
+  this->item = Item::Create(proto.item());
 }
 
 ItemEntity::~ItemEntity() {
@@ -37,7 +50,7 @@ void ItemEntity::Start(RunningState &state, uint32_t id) {
 
 void ItemEntity::Continue(RunningState &state, uint32_t id) {
   Mob::Continue(state, id);
-  this->item = std::shared_ptr<Item>(new Item(this->proto.item()));
+  this->item = Item::Create(this->proto.item());
 }
 
 void ItemEntity::Update(RunningState &state) {
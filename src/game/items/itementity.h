@@ -15,6 +15,9 @@ public:
   ItemEntity(const Entity_Proto &proto);
   virtual ~ItemEntity();
 
+  static void *operator new(size_t size);
+  static void operator delete(void *ptr, size_t size);
+
   virtual void Draw(Gfx &gfx) const override;
   virtual void Start(RunningState &state, uint32_t id) override;
   virtual void Continue(RunningState &state, uint32_t id) override;
@@ -30,6 +33,10 @@ protected:
 
   std::shared_ptr<Item> item;
   float yoffset;
+
+private:
+
+  static Pool pool;
 };
 
 #endif
@@ -9,17 +9,19 @@
 
 #include <unordered_map>
 
-static std::unordered_map<std::string, ItemProperties> allItems;
+static std::unordered_map<Symbol, ItemProperties> allItems;
 static std::unordered_map<std::string, std::vector<std::string>> allItemGroups;
 ItemProperties defaultItem;
 
-const ItemProperties &getItem(const std::string &name) {
-  if (name == "default") return defaultItem;
-  if (allItems.find(name) == allItems.end()) {
+const ItemProperties &getItem(const Symbol &name) {
+  static const Symbol defaultName("default");
+  if (name == defaultName) return defaultItem;
+  auto iter = allItems.find(name);
+  if (iter == allItems.end()) {
     Log("Properties for entity of type '%s' not found\n", name.c_str());
     return defaultItem;
   }
-  return allItems[name];
+  return iter->second;
 }
 
 std::string getRandomItem(const std::string &group, int level, Random &random) {
@@ -41,9 +43,11 @@ static void shuffleItems(Game &game, std::function<bool(ItemProperties&)> doShuf
   std::vector<std::string> items;
   for (auto &i : allItems) {
     if (doShuffleFn(i.second)) {
-      items.push_back(i.first);
+      items.push_back(i.first.GetString());
     }
   }
+  // symbols hash by address, sort so the shuffle only depends on the seed
+  std::sort(items.begin(), items.end());
 
   for (size_t i = 0; i < items.size(); i++) {
     // swap appearances and descriptions
@@ -150,7 +154,7 @@ ItemProperties::ParseProperty(const std::string &cmd) {
   else if (cmd == "boots")          this->equippable |= (1<<(size_t)InventorySlot::Boots);
 
   else if (cmd == "stack")          this->stackable = true;
-  else if (cmd == "useskill")    Parse(this->useSkill);
+  else if (cmd == "useskill")       { std::string skill; Parse(skill); this->useSkill = getSkillID(skill); }
 
   else if (cmd == "durability")       Parse(this->durability);
   else if (cmd == "usedurability")    Parse(this->useDurability);
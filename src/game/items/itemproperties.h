@@ -79,7 +79,7 @@ struct ItemProperties : public Properties {
 
   int uneqAddHP  = 0;
 
-  std::string useSkill = "";
+  SkillID useSkill = Skills::None;
 
   uint32_t equippable = 0;
   bool twoHanded = false;
@@ -129,7 +129,7 @@ struct ItemProperties : public Properties {
 };
 
 void LoadItems(Game &game);
-const ItemProperties &getItem(const std::string &name);
+const ItemProperties &getItem(const Symbol &name);
 std::string getRandomItem(const std::string &group, int level, Random &random);
 float GetItemProbability(const std::string &type, int level);
 
@@ -13,55 +13,85 @@
 // -------------------------------------------------------------------------
 
 /** C'tor.
-  * @param type Cell type.
+  * Creates a reference to no cell.
   */
-CellBase::CellBase(const std::string &type) :
+CellBase::CellBase() :
   Triggerable(),
-  info(&GetCellProperties(type)),
+  store(nullptr),
   world(nullptr),
+  index(0),
   pos(0,0,0),
-  tickInterval( info->flags & CellFlags::Viscous ? 32 : 5 ),
-  proto()
+  owned()
 {
-  for (size_t i=0; i<6; i++)
-    this->neighbours[i] = nullptr;
-
-  this->vertsDirty = true;
-  this->colorDirty = true;
+}
 
-  this->proto.set_type(type);
-  if (this->IsLiquid()) this->SetLiquidAmount(15);
-  this->SetScale( this->info->scale );
+/** C'tor.
+  * Creates a cell that is not part of a world.
+  * @param type Cell type.
+  */
+CellBase::CellBase(const Symbol &type) :
+  Triggerable(),
+  store(nullptr),
+  world(nullptr),
+  index(0),
+  pos(0,0,0),
+  owned(new CellStore(1))
+{
+  this->store = this->owned.get();
+  this->store->Reset(0, type);
 }
  
+/** Copy c'tor.
+  * References the same cell as that, unless that cell is not part of a 
+  * world, in which case the data is copied.
+  * @param that Cell from which to copy.
+  */
 CellBase::CellBase(const CellBase &that) :
   Triggerable(that),
-  info(that.info),
+  store(that.store),
   world(that.world),
+  index(that.index),
   pos(that.pos),
-  tickInterval( info->flags & CellFlags::Viscous ? 32 : 5 ),
-  proto(that.proto)
+  owned()
 {
-  for (size_t i=0; i<6; i++)
-    this->neighbours[i] = nullptr;
-
-  this->vertsDirty = true;
-  this->colorDirty = true;
+  if (that.owned) {
+    this->owned.reset(new CellStore(*that.owned));
+    this->store = this->owned.get();
+  }
 }
 
-CellBase::CellBase(const Cell_Proto &proto) :
+/** C'tor.
+  * @param store Store that holds the cell data.
+  * @param world World of which the cell is part.
+  * @param index Index of the cell in the store.
+  * @param pos Position of the cell in the world.
+  */
+CellBase::CellBase(CellStore *store, World *world, size_t index, const IVector3 &pos) :
   Triggerable(),
-  info(&GetCellProperties(proto.type())),
-  world(nullptr),
-  pos(0,0,0),
-  tickInterval( info->flags & CellFlags::Viscous ? 32 : 5 ),
-  proto(proto)
+  store(store),
+  world(world),
+  index(index),
+  pos(pos),
+  owned()
 {
-  for (size_t i=0; i<6; i++)
-    this->neighbours[i] = nullptr;
+}
+
+CellBase &
+CellBase::operator=(const CellBase &that) {
+  if (this == &that) return *this;
 
-  this->vertsDirty = false;
-  this->colorDirty = false;
+  this->world = that.world;
+  this->index = that.index;
+  this->pos   = that.pos;
+
+  if (that.owned) {
+    this->owned.reset(new CellStore(*that.owned));
+    this->store = this->owned.get();
+  } else {
+    this->owned.reset();
+    this->store = that.store;
+  }
+  return *this;
 }
 
 /** Lock a cell (for use with a key).
@@ -73,9 +103,11 @@ CellBase::Lock(uint32_t id) {
 
   this->SetLockID(id);
 
+  const CellProperties &info = this->GetInfo();
   for (int i=0; i<6; i++) {
-    if (info->onUseCascade & (1<<i) && this->neighbours[i]->info == info)
-      this->neighbours[i]->Lock(id);
+    Cell cell = self[(Side)i];
+    if (info.onUseCascade & (1<<i) && cell.GetInfo() == info)
+      cell.Lock(id);
   }
 }
 
@@ -88,12 +120,44 @@ CellBase::Unlock() {
 
   this->ClearLockID();
 
+  const CellProperties &info = this->GetInfo();
   for (int i=0; i<6; i++) {
-    if (info->onUseCascade & (1<<i) && this->neighbours[i]->info == info)
-      this->neighbours[i]->Unlock();
+    Cell cell = self[(Side)i];
+    if (info.onUseCascade & (1<<i) && cell.GetInfo() == info)
+      cell.Unlock();
   }
 }
 
+/** Get a neighbouring cell.
+  * Cells outside of a world or a copied region only have themselves as 
+  * neighbours.
+  * @param side Side of the neighbour.
+  * @return The neighbour.
+  */
+Cell
+CellBase::operator[](Side side) const {
+  if (this->world) return this->world->GetCell(this->pos[side]);
+
+  if (this->store->IsRegion()) {
+    IVector3 p = this->pos[side];
+    return Cell(this->store, nullptr, this->store->GetRegionIndex(p), p);
+  }
+  return Cell(this->store, nullptr, this->index, this->pos);
+}
+
+/** Get the light level at a position, including ambient light.
+  * @param pos World position of a cell.
+  * @return Light level.
+  */
+IColor
+CellBase::GetLightAt(const IVector3 &pos) const {
+  if (this->world) return this->world->GetLight(pos);
+  if (!this->store->IsRegion()) return IColor();
+
+  size_t i = this->store->GetRegionIndex(pos);
+  return IColor(this->store->lightR[i], this->store->lightG[i], this->store->lightB[i]) + World::GetAmbientLight();
+}
+
 
 /** Check whether the player has seen this cell yet.
   * Compares the cell's feature id with the list of all seen features.
@@ -110,10 +174,17 @@ CellBase::IsSeen(size_t) const {
 
 void
 CellBase::SetReversed(bool top, bool bottom) { 
-  this->proto.set_is_top_reversed(top); 
-  this->proto.set_is_bottom_reversed(bottom); 
+  this->SetBit(CellStore::TopReversed,    top);
+  this->SetBit(CellStore::BottomReversed, bottom);
   if (this->world && !this->IsDynamic()) 
-    this->world->MarkForUpdateNeighbours(&this->world->GetCell(this->GetPosition()));
+    this->world->MarkForUpdateNeighbours(this);
+}
+
+/** Drop the shape of the cell if it became a plain unscaled cube again. */
+void
+CellBase::CompactShape() {
+  if (this->IsTopFlat() && this->IsBottomFlat() && this->GetScale() == this->GetInfo().scale)
+    this->store->ClearShape(this->index);
 }
 
 /** Set top corner heights.
@@ -136,6 +207,7 @@ CellBase::SetTopHeights(float a, float b, float c, float d) {
   this->SetTopHeight(1, b);
   this->SetTopHeight(2, c);
   this->SetTopHeight(3, d);
+  this->CompactShape();
 
   if (world && !IsDynamic()) 
     world->MarkForUpdateNeighbours(this);
@@ -161,6 +233,7 @@ CellBase::SetBottomHeights(float a, float b, float c, float d) {
   this->SetBottomHeight(1, b);
   this->SetBottomHeight(2, c);
   this->SetBottomHeight(3, d);
+  this->CompactShape();
 
   if (world && !IsDynamic()) 
     world->MarkForUpdateNeighbours(this);
@@ -168,12 +241,19 @@ CellBase::SetBottomHeights(float a, float b, float c, float d) {
 
 // -------------------------------------------------------------------------
 
+/** C'tor.
+  * Creates a reference to no cell.
+  */
+Cell::Cell() :
+  CellRender()
+{
+}
+
 /** C'tor.
   * @param type Cell type.
   */
-Cell::Cell(const std::string &type) :
-  CellRender(type),
-  tickPhase(0)
+Cell::Cell(const Symbol &type) :
+  CellRender(type)
 {
 }
 
@@ -181,22 +261,31 @@ Cell::Cell(const std::string &type) :
   * @param that Cell from which to copy.
   */
 Cell::Cell(const Cell &that) :
-  CellRender(that),
-  tickPhase(0)
+  CellRender(that)
 {
 }
 
-Cell::Cell(const Cell_Proto &proto) :
-  CellRender(proto),
-  tickPhase(0)
+/** C'tor.
+  * @param store Store that holds the cell data.
+  * @param world World of which the cell is part.
+  * @param index Index of the cell in the store.
+  * @param pos Position of the cell in the world.
+  */
+Cell::Cell(CellStore *store, World *world, size_t index, const IVector3 &pos) :
+  CellRender(store, world, index, pos)
 {
-  Log("%s\n", __PRETTY_FUNCTION__);
 }
 
 /** D'tor. */
 Cell::~Cell() {
 }
 
+Cell &
+Cell::operator=(const Cell &that) {
+  CellBase::operator=(that);
+  return *this;
+}
+
 /** Update this cell.
   * @param state The running game state.
   */
@@ -208,8 +297,6 @@ Cell::Update(
 
   float t = state.GetGame().GetTime();
 
-  this->uvTime = t;
-
   // Spawn entities if activated
   if (this->HasSpawnOnActive() && this->IsTriggered() && t > this->GetNextActivationTime()) {
     // spawn in adjacent cell
@@ -232,18 +319,20 @@ Cell::Update(
   if (this->IsLiquid()) {
     if (this->GetLiquidAmount() == 0) {
       // this cell lost all its liquid, replace by air
-      this->world->SetCell(this->pos, Cell("air"));
+      static const Symbol air("air");
+      this->world->SetCell(this->pos, Cell(air));
 
       // "this" is now the new air cell
     } else {
       // update heights
       float h = this->GetLiquidAmount()/16.0;
+      const CellProperties &info = this->GetInfo();
 
-      if (self[Side::Up].info == info && self[Side::Down].info == info) {
+      if (self[Side::Up].GetInfo() == info && self[Side::Down].GetInfo() == info) {
         // liquid and top and bottom cells are the same as this one
         this->SetTopHeights(1,1,1,1);
         this->SetBottomHeights(0,0,0,0);
-      } else if (self[Side::Up].info == info && self[Side::Down].info != info) {
+      } else if (self[Side::Up].GetInfo() == info && self[Side::Down].GetInfo() != info) {
         // liquid and liquid above and nothing liquid below
         this->SetTopHeights(1,1,1,1);
         this->SetBottomHeights(1-h,1-h,1-h,1-h);
@@ -263,12 +352,14 @@ Cell::Update(
   */
 void
 Cell::OnUse(RunningState &state, Mob &user, bool force) {
+  const CellProperties &info = this->GetInfo();
+
   // enforce delay
-  if (state.GetGame().GetTime() - this->GetLastUseTime() < this->info->useDelay) 
+  if (state.GetGame().GetTime() - this->GetLastUseTime() < info.useDelay) 
     return;
 
   // enforce chance
-  if (!force && !state.GetRandom().Chance(this->info->useChance)) 
+  if (!force && !state.GetRandom().Chance(info.useChance)) 
     return;
 
   // update use time
@@ -282,18 +373,18 @@ Cell::OnUse(RunningState &state, Mob &user, bool force) {
   }
 
   // replace cell if wanted
-  const CellProperties *info = this->info;
-  if (info->flags & CellFlags::OnUseReplace) {
-    Log("replacing with %s %d %d %d\n", info->replace.c_str(), pos.x, pos.y, pos.z);
-    this->world->SetCell(GetPosition(), Cell(info->replace)).SetLastUseTime(state.GetGame().GetTime());
+  if (info.flags & CellFlags::OnUseReplace) {
+    Log("replacing with %s %d %d %d\n", info.replace.c_str(), pos.x, pos.y, pos.z);
+    this->world->SetCell(GetPosition(), Cell(info.replace)).SetLastUseTime(state.GetGame().GetTime());
   }
 
   // cascade through neighbours
-  Log("cascading %04x\n", info->onUseCascade);
+  Log("cascading %04x\n", info.onUseCascade);
   for (int i=0; i<6; i++) {
-    Log("%d %d %p %p %s %d %d %d\n", i, info->onUseCascade & (1<<i), this->info, this->neighbours[i]->info, this->neighbours[i]->GetType().c_str(), pos.x, pos.y, pos.z);
-    if (info->onUseCascade & (1<<i) && this->neighbours[i]->info == info)
-      this->neighbours[i]->OnUse(state, user, true);
+    Cell cell = self[(Side)i];
+    Log("%d %d %p %p %s %d %d %d\n", i, info.onUseCascade & (1<<i), &info, &cell.GetInfo(), cell.GetType().c_str(), pos.x, pos.y, pos.z);
+    if (info.onUseCascade & (1<<i) && cell.GetInfo() == info)
+      cell.OnUse(state, user, true);
   }
 
   if (!force) PlaySound(state, "use");
@@ -302,50 +393,67 @@ Cell::OnUse(RunningState &state, Mob &user, bool force) {
 /** Let a cell tick.
   * Updates tick phase. Let's liquid cells flow.
   * @param state Running state.
+  * @return true if the cell or its neighbours changed or may still change
+  *         without further outside changes.
   */
-void 
+bool 
 Cell::Tick(RunningState &state) {
-  this->tickPhase = (this->tickPhase + 1) % this->tickInterval;
-  if (this->tickPhase) return;
+  if (!this->world) return false;
+
+  const CellProperties &info = this->GetInfo();
+  uint8_t tickInterval = info.flags & CellFlags::Viscous ? 32 : 5;
+
+  uint8_t &tickPhase = this->store->tickPhases[this->index];
+  tickPhase = (tickPhase + 1) % tickInterval;
+  if (tickPhase) return false;
 
-  if (this->neighbours[0] == nullptr) return;
+  bool changed = false;
 
-  if ((this->info->flags & CellFlags::Liquid) && this->GetLiquidAmount() > 0) {
-    if (self[Side::Up].info == self.info && this->GetLiquidAmount() < 16) return;
+  if ((info.flags & CellFlags::Liquid) && this->GetLiquidAmount() > 0) {
+    if (self[Side::Up].GetInfo() == info && this->GetLiquidAmount() < 16) return false;
 
     // if we can't flow down and have more than 1 unit of liquid
-    if (!this->Flow(Side::Down) && this->GetLiquidAmount() > 1) {
+    changed = this->Flow(Side::Down);
+    if (!changed && this->GetLiquidAmount() > 1) {
       // try flowing to one random side
       Side sides[4] = { Side::Left, Side::Right, Side::Forward, Side::Backward };
       int n = state.GetRandom().Integer(4);
       for (int i=0; i<4; i++) {
         if (this->Flow(sides[(n+i)%4])) {
+          changed = true;
           break;
         }
       }
 
       // if we have too much liquid, even allow flowing up
-      if (this->GetLiquidAmount() > 16) this->Flow(Side::Up);
+      if (this->GetLiquidAmount() > 16) changed |= this->Flow(Side::Up);
     }
+
+    // flowing onto another liquid may have replaced this cell
+    if (this->GetInfo() != info) return true;
   }
 
   // if this cell wants to be replaced if detail falls below a certain level
-  if (info->detailBelowReplace && this->GetLiquidAmount() < this->info->detailBelowReplace && this->info->replace != "") {
+  if (info.detailBelowReplace && this->GetLiquidAmount() < info.detailBelowReplace && !info.replace.IsEmpty()) {
     // check if we are connected to liquid neighbours
     bool liquidNeighbours = false;
-    liquidNeighbours |= this->neighbours[(int)Side::Left]->info == this->info     && this->neighbours[(int)Side::Left]->GetLiquidAmount() > info->detailBelowReplace;
-    liquidNeighbours |= this->neighbours[(int)Side::Right]->info == this->info    && this->neighbours[(int)Side::Right]->GetLiquidAmount() > info->detailBelowReplace;
-    liquidNeighbours |= this->neighbours[(int)Side::Forward]->info == this->info  && this->neighbours[(int)Side::Forward]->GetLiquidAmount() > info->detailBelowReplace;
-    liquidNeighbours |= this->neighbours[(int)Side::Backward]->info == this->info && this->neighbours[(int)Side::Backward]->GetLiquidAmount() > info->detailBelowReplace;
-    liquidNeighbours |= this->neighbours[(int)Side::Down]->info == this->info     && this->neighbours[(int)Side::Down]->GetLiquidAmount() > info->detailBelowReplace;
-
-    // if not connected, take a chance and replace
-    if (!liquidNeighbours && state.GetRandom().Chance(this->info->replaceChance)) {
-      this->world->SetCell(GetPosition(), Cell(info->replace));
-      // this is no longer valid
-      return;
+    Side sides[5] = { Side::Left, Side::Right, Side::Forward, Side::Backward, Side::Down };
+    for (Side side : sides) {
+      Cell cell = self[side];
+      liquidNeighbours |= cell.GetInfo() == info && cell.GetLiquidAmount() > info.detailBelowReplace;
+    }
+
+    if (!liquidNeighbours) {
+      // if not connected, take a chance and replace
+      if (state.GetRandom().Chance(info.replaceChance)) {
+        this->world->SetCell(GetPosition(), Cell(info.replace));
+        // this is no longer valid
+      }
+      return true;
     }
   }
+
+  return changed;
 }
 
 /** Try to flow a cell's content to one of its sides.
@@ -354,139 +462,127 @@ Cell::Tick(RunningState &state) {
   */
 bool
 Cell::Flow(Side side) {
-  if ((this->info->flags & CellFlags::Liquid) == 0) return false;
+  const CellProperties &info = this->GetInfo();
+  if ((info.flags & CellFlags::Liquid) == 0) return false;
 
-  Cell *cell = this->neighbours[(int)side];
+  Cell cell = self[side];
 
-  if (cell->IsSolid()) return false;
+  if (cell.IsSolid()) return false;
 
-  if (cell->info->flags & CellFlags::Liquid) {
+  const CellProperties &cellInfo = cell.GetInfo();
+  if (cellInfo.flags & CellFlags::Liquid) {
     // combine lava and water to rock
-    if (this->info->onFlowOntoReplaceTarget.find(cell->info->type) != this->info->onFlowOntoReplaceTarget.end()) {
-      this->world->SetCell(this->pos[side], this->info->onFlowOntoReplaceSelf.at(cell->info->type));
-      this->world->SetCell(this->pos,       this->info->onFlowOntoReplaceTarget.at(cell->info->type));
+    if (info.onFlowOntoReplaceTarget.find(cellInfo.type) != info.onFlowOntoReplaceTarget.end()) {
+      Symbol replaceSelf   = info.onFlowOntoReplaceSelf.at(cellInfo.type);
+      Symbol replaceTarget = info.onFlowOntoReplaceTarget.at(cellInfo.type);
+      this->world->SetCell(this->pos[side], Cell(replaceSelf));
+      this->world->SetCell(this->pos,       Cell(replaceTarget));
       return true;
     }
 
     // check if cell is full
-    if ((cell->GetLiquidAmount() >= this->GetLiquidAmount() && side != Side::Down) || cell->GetLiquidAmount() >= 16) return false;
+    if ((cell.GetLiquidAmount() >= this->GetLiquidAmount() && side != Side::Down) || cell.GetLiquidAmount() >= 16) return false;
   }
 
   this->SetLiquidAmount(this->GetLiquidAmount() - 1);
 
-  if (cell->info != this->info) {
+  if (cellInfo != info) {
     // replace target cell if not already of this type
-    this->world->SetCell(this->pos[side], Cell(info->type));
-    cell->SetLiquidAmount(1);
+    this->world->SetCell(this->pos[side], Cell(info.type));
+    cell.SetLiquidAmount(1);
   } else {
     // otherwise just increase liquid
-    cell->SetLiquidAmount(cell->GetLiquidAmount() + 1);
+    cell.SetLiquidAmount(cell.GetLiquidAmount() + 1);
   }
 
+  // only the liquid amounts changed, the static geometry stays the same
   world->MarkForUpdateNeighbours(this);
-  world->MarkForUpdateNeighbours(cell);
+  world->MarkForUpdateNeighbours(&cell);
+  world->MarkForUpdateLiquid(this);
+  world->MarkForUpdateLiquid(&cell);
   return true;
 }
 
 /** Update this cell because one or more of its neighbours has changed.
+  * Only the cell itself is written, so cells can be updated in parallel.
+  * @return true if the light of the cell doesn't fit its neighbours and
+  *         has to be fixed by the light engine.
   */
-void
+bool
 Cell::UpdateNeighbours(
   size_t
 ) {
-  if (this->world == nullptr) return;
+  if (this->world == nullptr) return false;
 
-  size_t oldvis = this->visibility;
-  this->visibility = 0;
+  const CellProperties &info = this->GetInfo();
+
+  uint8_t visibility = 0;
 
   // TODO: if liquid check sides for non liquid or different liquid amount
 
   // check if vertically out of box
   bool oversize = !this->IsTopFlat() || !this->IsBottomFlat();
 
+  Cell neighbours[6];
+  for (size_t i=0; i<6; i++) {
+    neighbours[i] = self[(Side)i];
+  }
+
   // check for transparent neighbours
   for (size_t i =0; i<6; i++) {
     // all sides visible if oversize
     if (oversize) {
-      this->visibility |= 1<<i;
+      visibility |= 1<<i;
       continue;
     }
 
-    Cell &cell = *this->neighbours[i];
+    const Cell &cell = neighbours[i];
 
     // show sides to transparent cells
-    if (cell.IsTransparent() || cell.info->scale != Vector3(1,1,1)) {
-      this->visibility |= 1<<i;
+    if (cell.IsTransparent() || cell.GetInfo().scale != Vector3(1,1,1)) {
+      visibility |= 1<<i;
     }
 
     // make interliquid sides transparent
-    if (this->info == cell.info && this->info->flags & CellFlags::Liquid) {
-      this->visibility &= ~(1<<i);
+    if (info == cell.GetInfo() && info.flags & CellFlags::Liquid) {
+      visibility &= ~(1<<i);
     }
 
     // TODO: instead hide sides with equals heights
   }
 
   // if scaled, assume transparent
-  if (info->scale.x != 1.0) this->visibility |= (1<<Side::Left)    | (1<<Side::Right);
-  if (info->scale.y != 1.0) this->visibility |= (1<<Side::Up)      | (1<<Side::Down);
-  if (info->scale.z != 1.0) this->visibility |= (1<<Side::Forward) | (1<<Side::Backward);
+  if (info.scale.x != 1.0) visibility |= (1<<Side::Left)    | (1<<Side::Right);
+  if (info.scale.y != 1.0) visibility |= (1<<Side::Up)      | (1<<Side::Down);
+  if (info.scale.z != 1.0) visibility |= (1<<Side::Forward) | (1<<Side::Backward);
 
   // check nonflat top and bottom
-  if (!this->IsTopFlat())    this->visibility |= 1<<Side::Up;
-  if (!this->IsBottomFlat()) this->visibility |= 1<<Side::Down;
+  if (!this->IsTopFlat())    visibility |= 1<<Side::Up;
+  if (!this->IsBottomFlat()) visibility |= 1<<Side::Down;
 
   // override
-  this->visibility |= this->info->showSides;
-  this->visibility &= ~(this->info->hideSides);
+  visibility |= info.showSides;
+  visibility &= ~(info.hideSides);
+
+  this->SetVisibility(visibility);
 
   // only transparent cells can be lit
   IColor color;
   if (this->IsTransparent()) {
     // collect max light from neighbours
     for (size_t i=0; i<6; i++) {
-      Cell &cell = *this->neighbours[i];
-      color = color.Max(cell.GetLightLevel());
+      color = color.Max(neighbours[i].GetLightLevel());
     }
 
     // propagate light
-    color = (color * this->info->lightFactor) - this->info->lightFade;
+    color = (color * info.lightFactor) - info.lightFade;
 
     // emit light
-    color = color.Max(this->info->light);
+    color = color.Max(info.light);
   }
 
-
-  // update this cell and neighbours recursively until nothing changes anymore
-  bool lightChanged = this->SetLightLevel(color);
-  bool visChanged = this->visibility != oldvis;
-  bool updated = lightChanged || visChanged;
-  if (updated) {
-    updated = true;
-    if (visChanged) {
-      this->vertsDirty = true;
-    }
-    this->colorDirty |= lightChanged;
-  }
-
-  if (lightChanged) {
-    for (size_t i=0; i<6; i++) {
-      world->MarkForUpdateNeighbours(this->neighbours[i]);
-    }
-
-    // update corner cells as well
-    this->world->GetCell(this->pos + IVector3( 1,  1,  1)).colorDirty = true;
-    this->world->GetCell(this->pos + IVector3(-1,  1,  1)).colorDirty = true;
-    this->world->GetCell(this->pos + IVector3( 1, -1,  1)).colorDirty = true;
-    this->world->GetCell(this->pos + IVector3(-1, -1,  1)).colorDirty = true;
-    this->world->GetCell(this->pos + IVector3( 1,  1, -1)).colorDirty = true;
-    this->world->GetCell(this->pos + IVector3(-1,  1, -1)).colorDirty = true;
-    this->world->GetCell(this->pos + IVector3( 1, -1, -1)).colorDirty = true;
-    this->world->GetCell(this->pos + IVector3(-1, -1, -1)).colorDirty = true;
-    for (size_t i=0; i<6; i++) {
-      this->neighbours[i]->colorDirty = true;
-    }
-  }
+  // the light engine has to fix the light if it doesn't fit the neighbours
+  return color.Saturate() != this->GetLightLevel();
 }
 
 /** Get the light color of a cell for a given side and corner.
@@ -497,7 +593,7 @@ Cell::UpdateNeighbours(
 IColor
 CellRender::SideCornerColor(Side side, size_t corner) const {
   // not initialized yet?
-  if (!world) return IColor();
+  if (!this->HasNeighbours()) return IColor();
 
   // is cell emitting light?
   if (!GetInfo().light.IsBlack()) {
@@ -522,10 +618,10 @@ CellRender::SideCornerColor(Side side, size_t corner) const {
   if (side == Side::Down) vb = -vb;
 
   IColor l0, l1, l2, l3;
-  l0 = this->world->GetLight(p0);
-  l1 = this->world->GetLight(p0+va);
-  l2 = this->world->GetLight(p0+vb);
-  l3 = this->world->GetLight(p0+va+vb);
+  l0 = this->GetLightAt(p0);
+  l1 = this->GetLightAt(p0+va);
+  l2 = this->GetLightAt(p0+vb);
+  l3 = this->GetLightAt(p0+va+vb);
 
   return (l0+l1+l2+l3)/4;
 }
@@ -552,10 +648,10 @@ Cell::CheckSideSolid(Side side, const Vector3 &org, bool sneak) const {
   }
 
   // check for clipping movement into cell from opposite side
-  bool clipIn  = (cell.info->clipSidesIn  & (1 <<(-side)));
+  bool clipIn  = (cell.GetInfo().clipSidesIn  & (1 <<(-side)));
 
   // check for clipping movement out the cell
-  bool clipOut = (this->info->clipSidesOut & (1 <<  side ));
+  bool clipOut = (this->GetInfo().clipSidesOut & (1 <<  side ));
 
   if (side == Side::Up || side == Side::Down) {
     return (clipIn || clipOut);
@@ -568,39 +664,25 @@ Cell::CheckSideSolid(Side side, const Vector3 &org, bool sneak) const {
   return (clipIn && heightCheck) || clipOut;
 }
 
-/** Set world and position.
+/** Initialize a cell after it was put into the world.
   * This is comparable to Entity::Start. Selects a random texture.
-  * Gets neighbour cells from world. Marks cell for update.
-  * @param world World of which the cell is part.
-  * @param pos Position of cell in world.
+  * Marks cell and neighbours for update.
   */
 void
-Cell::SetWorld(World *world, const IVector3 &pos) {
-  this->pos = pos;
-  this->world = world;
+Cell::Start() {
+  if (!this->world) return;
 
-  if (this->GetType() == "door.right.closed"||this->GetType() == "door.right.open") {
-    Log("setworld %d %d %d\n", pos.x, pos.y, pos.z);
-  }
+  const CellProperties &info = this->GetInfo();
 
-  if (info->textures.empty()) {
-    this->SetTexture(0, info->flags & MultiSided);
+  if (info.textures.empty()) {
+    this->store->variants[this->index] = 0;
   } else {
-    size_t idx = world->GetState().GetRandom().Integer(info->textures.size());
-    this->SetTexture(info->textures[idx], info->flags & MultiSided);
-    if (idx < info->emissiveTextures.size())
-      this->SetEmissiveTexture(info->emissiveTextures[idx]);
-  }
-
-  if (this->info->activeTexture != "") this->activeTexture = Texture::Get("cells/texture/"+this->info->activeTexture);
-  if (this->info->emissiveActiveTexture != "") this->emissiveActiveTexture = Texture::Get("cells/texture/"+this->info->emissiveActiveTexture);
-
-  for (size_t i=0; i<6; i++) {
-    this->neighbours[i] = &this->world->GetCell(pos[(Side)i]);
+    this->store->variants[this->index] = this->world->GetState().GetRandom().Integer(info.textures.size());
   }
 
   for (size_t i=0; i<6; i++) {
-    world->MarkForUpdateNeighbours(this->neighbours[i]);
+    Cell cell = self[(Side)i];
+    world->MarkForUpdateNeighbours(&cell);
   }
 
   world->MarkForUpdateNeighbours(this);
@@ -617,7 +699,7 @@ Cell::GetAABB() const {
   return aabb;
 }
 
-/** Cast a ray against the triangles of the cell.
+/** Cast a ray against the shape of the cell.
   * @param start Ray start point.
   * @param dir   Ray direction vector.
   * @param[out] t Time of hit if hit.
@@ -626,31 +708,12 @@ Cell::GetAABB() const {
   */
 bool
 Cell::Ray(const Vector3 &start, const Vector3 &dir, float &t, Vector3 &p) const {
-  bool hit = false;
-  float tt = INFINITY;
-
-  for (size_t i=0; i<verts.size(); i+=3) {
-    Vector3 tri[3] = {
-      Vector3(this->verts[i+0].xyz[0], this->verts[i+0].xyz[1], this->verts[i+0].xyz[2]),
-      Vector3(this->verts[i+1].xyz[0], this->verts[i+1].xyz[1], this->verts[i+1].xyz[2]),
-      Vector3(this->verts[i+2].xyz[0], this->verts[i+2].xyz[1], this->verts[i+2].xyz[2])
-    };
-
-    float ttt;
-    Vector3 pp;
-
-    if (Vector3::TriangleRay(tri, start, dir, ttt, pp)) {
-      hit = true;
-      if (ttt < tt) tt = ttt;
-    }
-  }
-
-  if (hit) {
-    t = tt;
-    p = start + dir * t;
-  }
+  float tt;
+  if (!this->GetPickShape().Ray(start - Vector3(this->pos), dir, tt)) return false;
 
-  return hit;
+  t = tt;
+  p = start + dir * t;
+  return true;
 }
 
 /** Handle a mob stepping on the cell.
@@ -662,7 +725,7 @@ void
 Cell::OnStepOn(RunningState &state, Mob &mob) {
   if (this->IsTeleport() && state.GetGame().GetTime() > this->GetNextActivationTime()) {
     IVector3 target(this->world->GetCellPos(this->GetTeleportTarget()));
-    Cell &targetCell = state.GetWorld().GetCell(target);
+    Cell targetCell = state.GetWorld().GetCell(target);
 
     this->SetNextActivationTime(state.GetGame().GetTime() + 2);
     targetCell.SetNextActivationTime(state.GetGame().GetTime() + 2);
@@ -700,23 +763,25 @@ Cell::OnStepOff(RunningState &state, Mob &) {
 void
 Cell::OnUseItem(RunningState &, Mob &, Item &item) {
   std::string itemType = item.GetType();
+  const CellProperties &info = this->GetInfo();
 
-  auto iter1 = this->info->onUseItemReplaceItem.find(itemType);
-  if (iter1 != this->info->onUseItemReplaceItem.end()) {
+  auto iter1 = info.onUseItemReplaceItem.find(itemType);
+  if (iter1 != info.onUseItemReplaceItem.end()) {
     item.ReplaceWith(iter1->second);
   }
 
-  auto iter2 = this->info->onUseItemAddDetail.find(itemType);
-  if (iter2 != this->info->onUseItemAddDetail.end()) {
+  auto iter2 = info.onUseItemAddDetail.find(itemType);
+  if (iter2 != info.onUseItemAddDetail.end()) {
     if (iter2->second < 0 && (int)(this->GetLiquidAmount()) < -iter2->second) {
       this->SetLiquidAmount(0);
     } else {
       this->SetLiquidAmount(this->GetLiquidAmount() + iter2->second);
     }
+    this->world->MarkForUpdateLiquid(this);
   }
 
-  auto iter3 = this->info->onUseItemReplace.find(itemType);
-  if (iter3 != this->info->onUseItemReplace.end()) {
+  auto iter3 = info.onUseItemReplace.find(itemType);
+  if (iter3 != info.onUseItemReplace.end()) {
     this->world->SetCell(this->GetPosition(), Cell(iter3->second));
   }
 }
@@ -741,6 +806,8 @@ Cell::Rotate() {
   this->SetBottomHeight(3, tmp);
 
   this->SetScale(this->GetScale().ZYX());
+  this->CompactShape();
+
   this->SetSideReversed(!this->IsSideReversed());
   this->SetReversed(!this->IsTopReversed(), !this->IsBottomReversed());
 }
@@ -750,7 +817,9 @@ Cell::Rotate() {
   * @param type Type of sound to play.
   */
 void
-Cell::PlaySound(RunningState &state, const std::string &type) {
-  if (this->info->sounds.find(type) == this->info->sounds.end()) return;
-  state.GetGame().GetAudio().PlaySound(this->info->sounds.at(type), GetAABB().center);
+Cell::PlaySound(RunningState &state, const Symbol &type) {
+  const CellProperties &info = this->GetInfo();
+  auto iter = info.sounds.find(type);
+  if (iter == info.sounds.end()) return;
+  state.GetGame().GetAudio().PlaySound(iter->second, GetAABB().center);
 }
@@ -2,29 +2,36 @@
 #define BARFOOS_CELL_H
 
 #include "game/world/cells/cellrender.h"
-#include "world.pb.h"
 
-/** A cell in the world. */
+/** A cell in the world. 
+  * This is a lightweight reference to the cell data in the CellStore of a 
+  * World. Cells created from a type name are not part of a world and keep
+  * their data in a private store, they can be put into a world with 
+  * World::SetCell.
+  */
 class Cell final : public CellRender {
 public:
 
-                            Cell(const std::string &type = "default");
+                            Cell();
+                            Cell(const Symbol &type);
                             Cell(const Cell &that);
-                            Cell(const Cell_Proto &proto);
+                            Cell(CellStore *store, World *world, size_t index, const IVector3 &pos);
                             ~Cell();
 
-  void                      SetWorld(World *world, const IVector3 &pos);
+  Cell &                    operator=(const Cell &that);
+
+  void                      Start();
   void                      Update(RunningState &state);
 
-  void                      UpdateNeighbours(size_t depth = 16);
+  bool                      UpdateNeighbours(size_t depth = 16);
 
-  void                      PlaySound(RunningState &state, const std::string &sound);
+  void                      PlaySound(RunningState &state, const Symbol &sound);
 
   AABB                      GetAABB() const;
   bool                      CheckSideSolid(Side side, const Vector3 &org, bool sneak = false) const;
   bool                      Ray(const Vector3 &start, const Vector3 &dir, float &t, Vector3 &p) const;
 
-  void                      Tick(RunningState &state);
+  bool                      Tick(RunningState &state);
   bool                      Flow(Side side);
 
   void                      OnUse(RunningState &state, Mob &user, bool force = false);
@@ -33,11 +40,6 @@ public:
   void                      OnStepOff(RunningState &state, Mob &mob);
 
   void                      Rotate();
-
-protected:
-
-  /** Current tick phase from 0 to tickInterval. Tick()s on 0. */
-  uint8_t                   tickPhase;
 };
 
 #endif
@@ -1,137 +1,133 @@
 #ifndef BARFOOS_CELLBASE_H
 #define BARFOOS_CELLBASE_H
 
-#include "game/world/cells/cellproperties.h"
+#include "game/world/cells/cellstore.h"
 #include "game/gameplay/trigger.h"
 
-#include "world.pb.h"
-
 class CellBase : public Triggerable {
 public:
 
-  const std::string &       GetType() const { return this->proto.type(); }
-  const CellProperties &    GetInfo() const { return *this->info; }
+  const Symbol &            GetType() const { return this->GetInfo().type; }
+  const CellProperties &    GetInfo() const { return GetCellProperties(this->store->types[this->index]); }
   World *                   GetWorld() const { return this->world; }
   const IVector3 &          GetPosition() const { return this->pos; }
+  size_t                    GetIndex() const { return this->index; }
+
+  /** Check whether this refers to a cell at all. */
+  bool                      IsValid() const { return this->store != nullptr; }
+
+  bool                      operator==(const CellBase &that) const { return this->store == that.store && this->index == that.index; }
+  bool                      operator!=(const CellBase &that) const { return !(self == that); }
 
   bool                      IsSeen(size_t checkNeighbours = 0) const;
 
-  void                      SetLockID(ID id) { this->proto.set_lock_id(id); }
-  void                      ClearLockID() { this->proto.clear_lock_id(); }
-  ID                        GetLockID() const { return this->proto.lock_id(); }
-  bool                      IsLocked() const { return this->proto.has_lock_id(); }
+  void                      SetLockID(ID id) { this->GetExtra().lockId = id; }
+  void                      ClearLockID() { if (this->FindExtra()) this->GetExtra().lockId = InvalidID; }
+  ID                        GetLockID() const { return this->FindExtra() ? this->FindExtra()->lockId : InvalidID; }
+  bool                      IsLocked() const { return this->GetLockID() != InvalidID; }
 
-  float                     GetNextActivationTime() const { return this->proto.next_activation_time(); }
-  void                      SetNextActivationTime(float f) { this->proto.set_next_activation_time(f); }
+  float                     GetNextActivationTime() const { return this->FindExtra() ? this->FindExtra()->nextActivationTime : 0.0f; }
+  void                      SetNextActivationTime(float f) { this->GetExtra().nextActivationTime = f; }
 
-  void                      SetTeleportTarget(uint32_t index) { this->proto.set_teleport_target(index); }
-  uint32_t                  GetTeleportTarget() const { return this->proto.teleport_target(); }
-  bool                      IsTeleport() const { return this->proto.has_teleport_target(); }
+  void                      SetTeleportTarget(uint32_t index) { this->GetExtra().teleportTarget = index; }
+  uint32_t                  GetTeleportTarget() const { return this->FindExtra() ? this->FindExtra()->teleportTarget : InvalidID; }
+  bool                      IsTeleport() const { return this->GetTeleportTarget() != InvalidID; }
 
-  void                      SetTriggerTarget(uint32_t triggerTargetId) { this->proto.set_trigger_target_id(triggerTargetId); }
-  ID                        GetTriggerTarget() const { return this->IsTrigger() ? this->proto.trigger_target_id() : InvalidID; }
-  bool                      IsTrigger() const { return this->proto.has_trigger_target_id(); }
+  void                      SetTriggerTarget(uint32_t triggerTargetId) { this->GetExtra().triggerTargetId = triggerTargetId; }
+  ID                        GetTriggerTarget() const { return this->FindExtra() ? this->FindExtra()->triggerTargetId : InvalidID; }
+  bool                      IsTrigger() const { return this->GetTriggerTarget() != InvalidID; }
 
-  void                      SetProtected(bool locked) { this->proto.set_is_protected(locked); }
-  bool                      IsProtected() const { return this->proto.is_protected(); }
+  void                      SetProtected(bool locked) { this->SetBit(CellStore::Protected, locked); }
+  bool                      IsProtected() const { return this->HasBit(CellStore::Protected); }
 
-  void                      SetIgnoringProtection(bool ignore) { this->proto.set_is_ignoring_protection(ignore); }
-  bool                      IsIgnoringProtection() const { return this->proto.is_ignoring_protection(); }
+  void                      SetIgnoringProtection(bool ignore) { this->SetBit(CellStore::IgnoringProtection, ignore); }
+  bool                      IsIgnoringProtection() const { return this->HasBit(CellStore::IgnoringProtection); }
 
-  void                      SetIgnoringWrite(bool ignore) { this->proto.set_is_ignoring_write(ignore); }
-  bool                      IsIgnoringWrite() const { return this->proto.is_ignoring_write(); }
+  void                      SetIgnoringWrite(bool ignore) { this->SetBit(CellStore::IgnoringWrite, ignore); }
+  bool                      IsIgnoringWrite() const { return this->HasBit(CellStore::IgnoringWrite); }
 
-  void                      SetFeatureID(ID id) { this->proto.set_feature_id(id); }
-  ID                        GetFeatureID() const { return this->proto.has_feature_id() ? this->proto.feature_id() : InvalidID; }
+  void                      SetFeatureID(ID id) { this->store->features[this->index] = id < CellStore::InvalidFeature ? id : CellStore::InvalidFeature; }
+  ID                        GetFeatureID() const { uint16_t id = this->store->features[this->index]; return id != CellStore::InvalidFeature ? id : InvalidID; }
 
-  bool                      IsTopReversed() const { return this->proto.is_top_reversed(); }
-  bool                      IsBottomReversed() const { return this->proto.is_bottom_reversed(); }
+  bool                      IsTopReversed() const { return this->HasBit(CellStore::TopReversed); }
+  bool                      IsBottomReversed() const { return this->HasBit(CellStore::BottomReversed); }
   void                      SetReversed(bool top, bool bottom);
 
-  void                      SetSideReversed     (bool rev)                                      { this->proto.set_is_side_reversed(rev); }
-  bool                      IsSideReversed      ()                                        const { return this->proto.is_side_reversed(); }
+  void                      SetSideReversed     (bool rev)                                      { this->SetBit(CellStore::SideReversed, rev); }
+  bool                      IsSideReversed      ()                                        const { return this->HasBit(CellStore::SideReversed); }
 
-  bool                      HasSpawnOnActive() const { return this->proto.has_spawn_on_active(); }
+  bool                      HasSpawnOnActive() const { return this->FindExtra() && this->FindExtra()->spawnMobType != ""; }
   void                      SetSpawnOnActive(const std::string &mob, Side side, float rate) {
-                              this->proto.mutable_spawn_on_active()->set_mob_type(mob);
-                              this->proto.mutable_spawn_on_active()->set_side(uint32_t(side));
-                              this->proto.mutable_spawn_on_active()->set_rate(rate);
+                              CellExtra &extra = this->GetExtra();
+                              extra.spawnMobType = mob;
+                              extra.spawnSide    = side;
+                              extra.spawnRate    = rate;
                             }
 
-  const std::string &       GetSpawnOnActiveMobType() const { return this->proto.spawn_on_active().mob_type(); }
-  Side                      GetSpawnOnActiveSide() const { return Side(this->proto.spawn_on_active().side()); }
-  float                     GetSpawnOnActiveRate() const { return this->proto.spawn_on_active().rate(); }
+  const std::string &       GetSpawnOnActiveMobType() const { return this->FindExtra()->spawnMobType; }
+  Side                      GetSpawnOnActiveSide() const { return this->FindExtra()->spawnSide; }
+  float                     GetSpawnOnActiveRate() const { return this->FindExtra()->spawnRate; }
 
-  uint32_t                  GetLiquidAmount() const { return this->proto.liquid_amount(); }
-  void                      SetLiquidAmount(uint32_t amt) { this->proto.set_liquid_amount(amt); }
+  uint32_t                  GetLiquidAmount() const { return this->store->liquid[this->index]; }
+  void                      SetLiquidAmount(uint32_t amt) { this->store->liquid[this->index] = amt < 255 ? amt : 255; }
 
   void                      SetTopHeight(size_t n, float f) { 
-                              switch(n) {
-                                case 0:  this->proto.mutable_top_heights()->set_a(f); break;
-                                case 1:  this->proto.mutable_top_heights()->set_b(f); break;
-                                case 2:  this->proto.mutable_top_heights()->set_c(f); break;
-                                case 3:  this->proto.mutable_top_heights()->set_d(f); break;
-                              }
+                              if (n < 4) this->GetShape().top[n] = f;
                             }
                             
   float                     GetTopHeight(size_t n) const { 
-                              switch(n) {
-                                case 0:  return this->proto.top_heights().a();
-                                case 1:  return this->proto.top_heights().b();
-                                case 2:  return this->proto.top_heights().c();
-                                case 3:  return this->proto.top_heights().d();
-                                default: return 1.0f;
-                              }
+                              if (n >= 4) return 1.0f;
+                              const CellShape *shape = this->FindShape();
+                              return shape ? shape->top[n] : 1.0f;
                             }
 
   void                      SetTopHeights(float a, float b, float c, float d);
   void                      SetBottomHeights(float a, float b, float c, float d);
 
-  bool                      IsTopFlat() const { return !this->proto.has_top_heights(); }
+  bool                      IsTopFlat() const { 
+                              const CellShape *shape = this->FindShape();
+                              return !shape || (shape->top[0] == 1.0f && shape->top[1] == 1.0f && shape->top[2] == 1.0f && shape->top[3] == 1.0f);
+                            }
 
   void                      SetBottomHeight(size_t n, float f) { 
-                              switch(n) {
-                                case 0:  this->proto.mutable_bottom_heights()->set_a(f); break;
-                                case 1:  this->proto.mutable_bottom_heights()->set_b(f); break;
-                                case 2:  this->proto.mutable_bottom_heights()->set_c(f); break;
-                                case 3:  this->proto.mutable_bottom_heights()->set_d(f); break;
-                              }
+                              if (n < 4) this->GetShape().bottom[n] = f;
                             }
                             
   float                     GetBottomHeight(size_t n) const { 
-                              switch(n) {
-                                case 0:  return this->proto.bottom_heights().a();
-                                case 1:  return this->proto.bottom_heights().b();
-                                case 2:  return this->proto.bottom_heights().c();
-                                case 3:  return this->proto.bottom_heights().d();
-                                default: return 1.0f;
-                              }
+                              if (n >= 4) return 1.0f;
+                              const CellShape *shape = this->FindShape();
+                              return shape ? shape->bottom[n] : 0.0f;
                             }
 
-  bool                      IsBottomFlat() const { return !this->proto.has_top_heights(); }
+  bool                      IsBottomFlat() const {
+                              const CellShape *shape = this->FindShape();
+                              return !shape || (shape->bottom[0] == 0.0f && shape->bottom[1] == 0.0f && shape->bottom[2] == 0.0f && shape->bottom[3] == 0.0f);
+                            }
 
-  void                      SetScale(const Vector3 &scale) { this->proto.set_scale_x(scale.x); this->proto.set_scale_y(scale.y); this->proto.set_scale_z(scale.z); }
-  Vector3                   GetScale() const { return Vector3( this->proto.scale_x(), this->proto.scale_y(), this->proto.scale_z() ); }
+  void                      SetScale(const Vector3 &scale) { if (this->FindShape() || scale != this->GetInfo().scale) this->GetShape().scale = scale; }
+  Vector3                   GetScale() const { return this->FindShape() ? this->FindShape()->scale : this->GetInfo().scale; }
 
-  void                      SetLastUseTime(float f) { this->proto.set_last_use_time(f); }
-  float                     GetLastUseTime() const { return this->proto.last_use_time(); }
+  void                      SetLastUseTime(float f) { this->GetExtra().lastUseTime = f; }
+  float                     GetLastUseTime() const { return this->FindExtra() ? this->FindExtra()->lastUseTime : 0.0f; }
 
-  IColor                    GetLightLevel() const { return IColor(this->proto.light_r(), this->proto.light_g(), this->proto.light_b()); }
+  IColor                    GetLightLevel() const { return IColor(this->store->lightR[this->index], this->store->lightG[this->index], this->store->lightB[this->index]); }
   bool                      SetLightLevel(const IColor &level, bool force = false) {
+                              IColor c = level.Saturate();
+
                               // only update when changing
-                              if (!force && level == this->GetLightLevel()) return false;
-                              this->proto.set_light_r(level.r);
-                              this->proto.set_light_g(level.g);
-                              this->proto.set_light_b(level.b);
+                              if (!force && c == this->GetLightLevel()) return false;
+                              this->store->lightR[this->index] = c.r;
+                              this->store->lightG[this->index] = c.g;
+                              this->store->lightB[this->index] = c.b;
                               return true;
                             }
 
-  virtual void              SetTrigger(uint32_t id, bool toggle = false) override { this->proto.set_trigger_id(id); this->proto.set_is_trigger_toggle(toggle); }
-  virtual uint32_t          GetTriggerId() const override { return this->proto.has_trigger_id() ? this->proto.trigger_id() : InvalidID; }
-  virtual bool              IsTriggerToggle() const override { return this->proto.is_trigger_toggle(); }
+  virtual void              SetTrigger(uint32_t id, bool toggle = false) override { CellExtra &extra = this->GetExtra(); extra.triggerId = id; extra.isTriggerToggle = toggle; }
+  virtual uint32_t          GetTriggerId() const override { return this->FindExtra() ? this->FindExtra()->triggerId : InvalidID; }
+  virtual bool              IsTriggerToggle() const override { return this->FindExtra() && this->FindExtra()->isTriggerToggle; }
 
-  virtual void              SetTriggered(bool triggered) override { this->proto.set_is_triggered(triggered); }
-  virtual bool              IsTriggered() const override{ return this->proto.is_triggered(); }
+  virtual void              SetTriggered(bool triggered) override { this->SetBit(CellStore::Triggered, triggered); }
+  virtual bool              IsTriggered() const override{ return this->HasBit(CellStore::Triggered); }
 
   // -------------------------------------------------------------
 
@@ -143,30 +139,61 @@ public:
   float                     GetHeightClamp(float x, float z) const;
   float                     GetHeightBottomClamp(float x, float z) const;
 
+  /** Get the collision shape of the cell in cell local coordinates. */
+  CellCollision             GetCollision() const { return this->store->GetCollision(this->index); }
+
+  /** Get the shape of the cell as it is rendered, in cell local coordinates. */
+  CellCollision             GetPickShape() const { return this->store->GetPickShape(this->index); }
+
   bool                      IsDynamic() const;
   bool                      IsLiquid() const;
   bool                      IsSolid() const;
   bool                      IsTransparent() const;
 
-  Cell &                    operator[](Side side);
-  const Cell &              operator[](Side side) const;
+  Cell                      operator[](Side side) const;
 
 protected:
+  friend class World;
 
-                            CellBase(const std::string &type);
+                            CellBase();
+                            CellBase(const Symbol &type);
                             CellBase(const CellBase &that);
-                            CellBase(const Cell_Proto &proto);
+                            CellBase(CellStore *store, World *world, size_t index, const IVector3 &pos);
+
+  CellBase &                operator=(const CellBase &that);
 
-  const CellProperties *    info;
+  /** Store that holds the data of the cell. */
+  CellStore *               store;
+
+  /** World of which the cell is part, nullptr for cells not in a world. */
   World *                   world;
+
+  /** Index of the cell in the store. */
+  size_t                    index;
+
+  /** Position of the cell in the world. */
   IVector3                  pos;
-  Cell *                    neighbours[6] = {};
 
-  uint8_t                   tickInterval;
+  /** Private single cell store for cells that are not part of a world. */
+  std::unique_ptr<CellStore> owned;
+
+  bool                      HasBit              (uint16_t bit)                            const { return this->store->bits[this->index] & bit; }
+  void                      SetBit              (uint16_t bit, bool on)                         {
+                              if (on) this->store->bits[this->index] |=  bit;
+                              else    this->store->bits[this->index] &= ~bit;
+                            }
 
-  Cell_Proto proto;
+  const CellShape *         FindShape           ()                                        const { return this->store->FindShape(this->index); }
+  CellShape &               GetShape            ()                                              { return this->store->GetShape(this->index); }
+  void                      CompactShape        ();
 
-  bool vertsDirty, colorDirty;
+  const CellExtra *         FindExtra           ()                                        const { return this->store->FindExtra(this->index); }
+  CellExtra &               GetExtra            ()                                              { return this->store->GetExtra(this->index); }
+
+  /** Check whether neighbouring cells are available, either from the world
+    * or from a copied region. */
+  bool                      HasNeighbours       ()                                        const { return this->world || this->store->IsRegion(); }
+  IColor                    GetLightAt          (const IVector3 &pos)                     const;
 };
 
 inline float
@@ -186,50 +213,7 @@ CellBase::GetHeightClamp(
   float z
 ) const {
   if (this->IsTopFlat()) return GetTopHeight(0);
-
-  if (x > 1.0) x = 1.0;
-  if (x < 0.0) x = 0.0;
-  if (z > 1.0) z = 1.0;
-  if (z < 0.0) z = 0.0;
-
-  float slopeX;
-  float slopeZ;
-
-  if (this->IsTopReversed()) {
-    // Z ^
-    //   | 1---2
-    //   | | \ |
-    //   | 0---3
-    //   +------> X
-
-    if (x < z) {
-      // lower left triangle
-      slopeX = GetTopHeight(3) - GetTopHeight(0);
-      slopeZ = GetTopHeight(1) - GetTopHeight(0);
-    } else {
-      // upper right triangle
-      slopeX = GetTopHeight(2) - GetTopHeight(1);
-      slopeZ = GetTopHeight(2) - GetTopHeight(3);
-    }
-  } else {
-    // Z ^
-    //   | 1---2
-    //   | | / |
-    //   | 0---3
-    //   +------> X
-
-    if (x < z) {
-      // upper left triangle
-      slopeX = GetTopHeight(2) - GetTopHeight(1);
-      slopeZ = GetTopHeight(1) - GetTopHeight(0);
-    } else {
-      // lower right triangle
-      slopeX = GetTopHeight(3) - GetTopHeight(0);
-      slopeZ = GetTopHeight(2) - GetTopHeight(3);
-    }
-  }
-
-  return GetTopHeight(0) + slopeX * x + slopeZ * z;
+  return this->GetCollision().GetTop(x, z);
 }
 
 inline float
@@ -249,85 +233,36 @@ CellBase::GetHeightBottomClamp(
   float z
 ) const {
   if (this->IsBottomFlat()) return GetBottomHeight(0);
-
-  if (x > 1.0) x = 1.0;
-  if (x < 0.0) x = 0.0;
-  if (z > 1.0) z = 1.0;
-  if (z < 0.0) z = 0.0;
-
-  float slopeX;
-  float slopeZ;
-
-  if (this->IsBottomReversed()) {
-    // Z ^
-    //   | 1---2
-    //   | | \ |
-    //   | 0---3
-    //   +------> X
-
-    if (x < z) {
-      // lower left triangle
-      slopeX = GetBottomHeight(3) - GetBottomHeight(0);
-      slopeZ = GetBottomHeight(1) - GetBottomHeight(0);
-    } else {
-      // upper right triangle
-      slopeX = GetBottomHeight(2) - GetBottomHeight(1);
-      slopeZ = GetBottomHeight(2) - GetBottomHeight(3);
-    }
-  } else {
-    // Z ^
-    //   | 1---2
-    //   | | / |
-    //   | 0---3
-    //   +------> X
-
-    if (x < z) {
-      // upper left triangle
-      slopeX = GetBottomHeight(2) - GetBottomHeight(1);
-      slopeZ = GetBottomHeight(1) - GetBottomHeight(0);
-    } else {
-      // lower right triangle
-      slopeX = GetBottomHeight(3) - GetBottomHeight(0);
-      slopeZ = GetBottomHeight(2) - GetBottomHeight(3);
-    }
-  }
-
-  return GetBottomHeight(0) + slopeX * x + slopeZ * z;
+  return this->GetCollision().GetBottom(x, z);
 }
 
 inline bool CellBase::IsTransparent() const {
-  return
-    this->GetInfo().flags & CellFlags::Transparent ||
-    this->GetInfo().flags & CellFlags::DoNotRender ||
-    GetBottomHeight(0) != 0.0 || 
-    GetBottomHeight(1) != 0.0 || 
-    GetBottomHeight(2) != 0.0 || 
-    GetBottomHeight(3) != 0.0 || 
-    GetTopHeight(0) != 1.0 ||
-    GetTopHeight(1) != 1.0 ||
-    GetTopHeight(2) != 1.0 ||
-    GetTopHeight(3) != 1.0 
+  if (this->GetInfo().flags & (CellFlags::Transparent | CellFlags::DoNotRender)) return true;
+
+  const CellShape *shape = this->FindShape();
+  return 
+    shape && (
+    shape->bottom[0] != 0.0 || 
+    shape->bottom[1] != 0.0 || 
+    shape->bottom[2] != 0.0 || 
+    shape->bottom[3] != 0.0 || 
+    shape->top[0] != 1.0 ||
+    shape->top[1] != 1.0 ||
+    shape->top[2] != 1.0 ||
+    shape->top[3] != 1.0 )
     ;
 }
 
 inline bool CellBase::IsSolid() const {
-  return this->info->flags & CellFlags::Solid;
+  return this->GetInfo().flags & CellFlags::Solid;
 }
 
 inline bool CellBase::IsLiquid() const {
-  return this->info->flags & CellFlags::Liquid;
+  return this->GetInfo().flags & CellFlags::Liquid;
 }
 
 inline bool CellBase::IsDynamic() const {
-  return this->info->flags & CellFlags::Dynamic || this->GetTriggerId() != InvalidID || this->IsTrigger();
-}
-
-inline Cell &CellBase::operator[](Side side) {
-  return *this->neighbours[(int)side];
-}
-
-inline const Cell &CellBase::operator[](Side side) const {
-  return *this->neighbours[(int)side];
+  return this->GetInfo().flags & CellFlags::Dynamic || (this->FindExtra() && (this->GetTriggerId() != InvalidID || this->IsTrigger()));
 }
 
 #endif
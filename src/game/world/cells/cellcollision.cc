@@ -0,0 +1,233 @@
+#include "common.h"
+
+#include "game/world/cells/cellcollision.h"
+
+/** Restrict a ray interval to one slab of a box.
+  * @param s Start coordinate of the ray.
+  * @param d Direction coordinate of the ray.
+  * @param lo Lower bound of the slab.
+  * @param hi Upper bound of the slab.
+  * @param[in,out] t0 Start of the interval.
+  * @param[in,out] t1 End of the interval.
+  * @return false if the interval became empty.
+  */
+static bool
+ClipSlab(float s, float d, float lo, float hi, float &t0, float &t1) {
+  if (d == 0.0f) return s >= lo && s <= hi;
+
+  float ta = (lo - s) / d;
+  float tb = (hi - s) / d;
+  if (ta > tb) std::swap(ta, tb);
+
+  if (ta > t0) t0 = ta;
+  if (tb < t1) t1 = tb;
+  return t0 <= t1;
+}
+
+/** Restrict an interval to where a linear function is not negative.
+  * @param fa Value of the function at @a a.
+  * @param fb Value of the function at @a b.
+  * @param a Start of the interval the function is linear on.
+  * @param b End of the interval the function is linear on.
+  * @param[in,out] lo Start of the restricted interval.
+  * @param[in,out] hi End of the restricted interval.
+  * @return false if the function is negative on the whole interval.
+  */
+static bool
+ClipLinear(float fa, float fb, float a, float b, float &lo, float &hi) {
+  if (fa <  0.0f && fb <  0.0f) return false;
+  if (fa >= 0.0f && fb >= 0.0f) return true;
+
+  float tc = a + (b - a) * fa / (fa - fb);
+  if (fa < 0.0f) lo = std::max(lo, tc);
+  else           hi = std::min(hi, tc);
+  return true;
+}
+
+/** C'tor. Creates a box the size of a unit cube scaled around its center.
+  * @param scale Scale of the box.
+  */
+CellCollision::CellCollision(const Vector3 &scale) :
+  min(Vector3(0.5f, 0.5f, 0.5f) - scale * 0.5f),
+  max(Vector3(0.5f, 0.5f, 0.5f) + scale * 0.5f),
+  top(),
+  bottom(),
+  topReversed(false),
+  bottomReversed(false),
+  box(true)
+{
+  for (size_t i=0; i<4; i++) {
+    this->top[i]    = this->max.y;
+    this->bottom[i] = this->min.y;
+  }
+}
+
+/** C'tor. Creates the shape of a cell from its corner heights.
+  * @param top Top corner heights.
+  * @param bottom Bottom corner heights.
+  * @param scale Scale of the shape around the cell center.
+  * @param topReversed Whether the top surface is split along the 1-3 diagonal.
+  * @param bottomReversed Whether the bottom surface is split along the 1-3 diagonal.
+  */
+CellCollision::CellCollision(
+  const float *top,
+  const float *bottom,
+  const Vector3 &scale,
+  bool topReversed,
+  bool bottomReversed
+) :
+  min(0.5f - 0.5f * scale.x, 0.0f, 0.5f - 0.5f * scale.z),
+  max(0.5f + 0.5f * scale.x, 0.0f, 0.5f + 0.5f * scale.z),
+  top(),
+  bottom(),
+  topReversed(topReversed),
+  bottomReversed(bottomReversed),
+  box(true)
+{
+  for (size_t i=0; i<4; i++) {
+    this->top[i]    = 0.5f + (top[i]    - 0.5f) * scale.y;
+    this->bottom[i] = 0.5f + (bottom[i] - 0.5f) * scale.y;
+
+    if (this->top[i] != this->top[0] || this->bottom[i] != this->bottom[0]) this->box = false;
+  }
+
+  this->min.y = std::min(std::min(this->bottom[0], this->bottom[1]), std::min(this->bottom[2], this->bottom[3]));
+  this->max.y = std::max(std::max(this->top[0],    this->top[1]),    std::max(this->top[2],    this->top[3]));
+}
+
+/** Get the highest point of the top and the lowest point of the bottom
+  * surface over a rectangle.
+  * @param minX Minimum local x coordinate, clamped to the footprint.
+  * @param minZ Minimum local z coordinate, clamped to the footprint.
+  * @param maxX Maximum local x coordinate, clamped to the footprint.
+  * @param maxZ Maximum local z coordinate, clamped to the footprint.
+  * @param[out] highestTop Highest point of the top surface.
+  * @param[out] lowestBottom Lowest point of the bottom surface.
+  */
+void
+CellCollision::GetRange(float minX, float minZ, float maxX, float maxZ, float &highestTop, float &lowestBottom) const {
+  if (this->box) {
+    highestTop   = this->max.y;
+    lowestBottom = this->min.y;
+    return;
+  }
+
+  float u0 = this->GetU(minX), u1 = this->GetU(maxX);
+  float v0 = this->GetV(minZ), v1 = this->GetV(maxZ);
+
+  // the surfaces are linear on each triangle, so their extremes lie on the
+  // corners of the footprint or where the diagonals cross its edges
+  float us[12] = { u0, u1, u0, u1 };
+  float vs[12] = { v0, v0, v1, v1 };
+  size_t count = 4;
+
+  for (bool reversed : { this->topReversed, this->bottomReversed }) {
+    float a = reversed ? 1.0f - u0 : u0;
+    float b = reversed ? 1.0f - u1 : u1;
+    if (a >= v0 && a <= v1) { us[count] = u0; vs[count] = a; count++; }
+    if (b >= v0 && b <= v1) { us[count] = u1; vs[count] = b; count++; }
+
+    float c = reversed ? 1.0f - v0 : v0;
+    float d = reversed ? 1.0f - v1 : v1;
+    if (c >= u0 && c <= u1) { us[count] = c; vs[count] = v0; count++; }
+    if (d >= u0 && d <= u1) { us[count] = d; vs[count] = v1; count++; }
+  }
+
+  highestTop   = -INFINITY;
+  lowestBottom =  INFINITY;
+  for (size_t i=0; i<count; i++) {
+    highestTop   = std::max(highestTop,   Interpolate(this->top,    this->topReversed,    us[i], vs[i]));
+    lowestBottom = std::min(lowestBottom, Interpolate(this->bottom, this->bottomReversed, us[i], vs[i]));
+  }
+}
+
+/** Check whether a box overlaps the shape. For sloped surfaces this compares
+  * the box with the highest point of the top and the lowest point of the
+  * bottom surface above the box footprint, so it may report an overlap for
+  * boxes that only touch the bounds of a very oddly shaped cell.
+  * @param min Minimum corner of the box in local coordinates.
+  * @param max Maximum corner of the box in local coordinates.
+  * @return true if the box overlaps the shape.
+  */
+bool
+CellCollision::IsAABBOverlapping(const Vector3 &min, const Vector3 &max) const {
+  if (max.x < this->min.x || min.x > this->max.x) return false;
+  if (max.z < this->min.z || min.z > this->max.z) return false;
+  if (max.y < this->min.y || min.y > this->max.y) return false;
+  if (this->box) return true;
+
+  float highest, lowest;
+  this->GetRange(min.x, min.z, max.x, max.z, highest, lowest);
+  return highest >= min.y && lowest <= max.y;
+}
+
+/** Cast a ray against the shape. Like a ray against the outside faces of
+  * the cell, a ray starting inside the shape only hits where it enters the
+  * shape again.
+  * @param start Ray start point in local coordinates.
+  * @param dir Ray direction vector.
+  * @param[out] t Time of hit if hit.
+  * @return true if the ray hit the shape.
+  */
+bool
+CellCollision::Ray(const Vector3 &start, const Vector3 &dir, float &t) const {
+  float t0 = 0.0f;
+  float t1 = INFINITY;
+
+  if (!ClipSlab(start.x, dir.x, this->min.x, this->max.x, t0, t1)) return false;
+  if (!ClipSlab(start.z, dir.z, this->min.z, this->max.z, t0, t1)) return false;
+  if (!ClipSlab(start.y, dir.y, this->min.y, this->max.y, t0, t1)) return false;
+
+  if (this->box) {
+    if (t0 < 0.00001f) return false;
+    t = t0;
+    return true;
+  }
+
+  // split the interval where the ray crosses the diagonal of a surface, in
+  // between both surfaces are linear along the ray
+  float splits[4] = { t0, t1, t1, t1 };
+  size_t splitCount = 1;
+
+  float wx = this->max.x - this->min.x;
+  float wz = this->max.z - this->min.z;
+  float u  = wx > 0.0f ? (start.x - this->min.x) / wx : 0.0f;
+  float v  = wz > 0.0f ? (start.z - this->min.z) / wz : 0.0f;
+  float du = wx > 0.0f ? dir.x / wx : 0.0f;
+  float dv = wz > 0.0f ? dir.z / wz : 0.0f;
+
+  for (bool reversed : { this->topReversed, this->bottomReversed }) {
+    float d0 = GetDiagonal(reversed, u, v);
+    float dd = GetDiagonal(reversed, u + du, v + dv) - d0;
+    if (dd == 0.0f) continue;
+
+    float tc = -d0 / dd;
+    if (tc > t0 && tc < t1) splits[splitCount++] = tc;
+  }
+  splits[splitCount++] = t1;
+  std::sort(splits, splits + splitCount);
+
+  float lastEnd = -INFINITY;
+  for (size_t i=0; i+1<splitCount; i++) {
+    float a = splits[i];
+    float b = splits[i+1];
+
+    Vector3 pa = start + dir * a;
+    Vector3 pb = start + dir * b;
+
+    float lo = a;
+    float hi = b;
+    if (!ClipLinear(this->GetTop(pa.x, pa.z) - pa.y,    this->GetTop(pb.x, pb.z) - pb.y,    a, b, lo, hi)) continue;
+    if (!ClipLinear(pa.y - this->GetBottom(pa.x, pa.z), pb.y - this->GetBottom(pb.x, pb.z), a, b, lo, hi)) continue;
+    if (lo > hi) continue;
+
+    // entering the shape, not just continuing from the previous piece
+    if (lo > lastEnd + 0.00001f && lo >= 0.00001f) {
+      t = lo;
+      return true;
+    }
+    lastEnd = hi;
+  }
+
+  return false;
+}
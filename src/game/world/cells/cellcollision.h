@@ -0,0 +1,157 @@
+#ifndef BARFOOS_CELLCOLLISION_H
+#define BARFOOS_CELLCOLLISION_H
+
+#include "common.h"
+
+#include "math/vector3.h"
+
+/** Analytic collision shape of a cell in cell local coordinates.
+  * The shape is the volume between a bottom and a top surface over a
+  * rectangular footprint. Each surface is given by its four corner heights
+  * and split into two triangles along the same diagonal the renderer uses.
+  * When both surfaces are flat the shape is a plain box.
+  *
+  * Corners are numbered like this:
+  *
+  *    Z ^
+  *      | 1---2
+  *      | |   |
+  *      | 0---3
+  *      +------> X
+  */
+class CellCollision final {
+public:
+
+                            CellCollision       ();
+  explicit                  CellCollision       (const Vector3 &scale);
+                            CellCollision       (const float *top, const float *bottom, const Vector3 &scale,
+                                                 bool topReversed, bool bottomReversed);
+
+  bool                      IsBox               ()                                        const { return this->box; }
+  const Vector3 &           GetMin              ()                                        const { return this->min; }
+  const Vector3 &           GetMax              ()                                        const { return this->max; }
+
+  float                     GetTop              (float x, float z)                        const;
+  float                     GetBottom           (float x, float z)                        const;
+  void                      GetRange            (float minX, float minZ, float maxX, float maxZ,
+                                                 float &highestTop, float &lowestBottom)  const;
+
+  bool                      IsPointInside       (const Vector3 &p)                        const;
+  bool                      IsAABBOverlapping   (const Vector3 &min, const Vector3 &max)  const;
+  bool                      Ray                 (const Vector3 &start, const Vector3 &dir, float &t) const;
+
+private:
+
+  /** Bounds of the shape. */
+  Vector3                   min, max;
+
+  /** Corner heights of the top and bottom surfaces. */
+  float                     top[4];
+  float                     bottom[4];
+
+  /** Whether a surface is split along the 1-3 instead of the 0-2 diagonal. */
+  bool                      topReversed;
+  bool                      bottomReversed;
+
+  /** Whether both surfaces are flat. */
+  bool                      box;
+
+  float                     GetU                (float x)                                 const;
+  float                     GetV                (float z)                                 const;
+  static float              GetDiagonal         (bool reversed, float u, float v);
+  static float              Interpolate         (const float *h, bool reversed, float u, float v);
+};
+
+/** C'tor. Creates a solid unit cube. */
+inline
+CellCollision::CellCollision() :
+  min(0,0,0),
+  max(1,1,1),
+  top    { 1,1,1,1 },
+  bottom { 0,0,0,0 },
+  topReversed(false),
+  bottomReversed(false),
+  box(true)
+{
+}
+
+/** Get the height of the top surface.
+  * @param x Local x coordinate, clamped to the footprint.
+  * @param z Local z coordinate, clamped to the footprint.
+  * @return Local y coordinate of the top surface.
+  */
+inline float
+CellCollision::GetTop(float x, float z) const {
+  if (this->box) return this->max.y;
+  return Interpolate(this->top, this->topReversed, this->GetU(x), this->GetV(z));
+}
+
+/** Get the height of the bottom surface.
+  * @param x Local x coordinate, clamped to the footprint.
+  * @param z Local z coordinate, clamped to the footprint.
+  * @return Local y coordinate of the bottom surface.
+  */
+inline float
+CellCollision::GetBottom(float x, float z) const {
+  if (this->box) return this->min.y;
+  return Interpolate(this->bottom, this->bottomReversed, this->GetU(x), this->GetV(z));
+}
+
+/** Check whether a point is within the shape. Points on the surface count
+  * as inside.
+  * @param p Point in local coordinates.
+  * @return true if the point is inside.
+  */
+inline bool
+CellCollision::IsPointInside(const Vector3 &p) const {
+  if (p.x < this->min.x || p.x > this->max.x) return false;
+  if (p.z < this->min.z || p.z > this->max.z) return false;
+  if (p.y < this->min.y || p.y > this->max.y) return false;
+  if (this->box) return true;
+  return p.y <= this->GetTop(p.x, p.z) && p.y >= this->GetBottom(p.x, p.z);
+}
+
+inline float
+CellCollision::GetU(float x) const {
+  float w = this->max.x - this->min.x;
+  if (w <= 0.0f) return 0.0f;
+  return std::min(std::max((x - this->min.x) / w, 0.0f), 1.0f);
+}
+
+inline float
+CellCollision::GetV(float z) const {
+  float w = this->max.z - this->min.z;
+  if (w <= 0.0f) return 0.0f;
+  return std::min(std::max((z - this->min.z) / w, 0.0f), 1.0f);
+}
+
+/** Signed distance of a footprint position from the diagonal that splits
+  * a surface. Negative values are on the side of triangle 0-1-2 (or 0-1-3
+  * when reversed).
+  */
+inline float
+CellCollision::GetDiagonal(bool reversed, float u, float v) {
+  return reversed ? u + v - 1.0f : u - v;
+}
+
+inline float
+CellCollision::Interpolate(const float *h, bool reversed, float u, float v) {
+  if (reversed) {
+    if (u + v < 1.0f) {
+      // triangle 0-1-3
+      return h[0] + (h[3] - h[0]) * u + (h[1] - h[0]) * v;
+    }
+    // triangle 1-2-3
+    return h[1] + h[3] - h[2] + (h[2] - h[1]) * u + (h[2] - h[3]) * v;
+  }
+
+  if (u < v) {
+    // triangle 0-1-2
+    return h[0] + (h[2] - h[1]) * u + (h[1] - h[0]) * v;
+  }
+  // triangle 0-2-3
+  return h[0] + (h[3] - h[0]) * u + (h[2] - h[3]) * v;
+}
+
+#endif
+
@@ -5,22 +5,25 @@
 #include "gfx/texture.h"
 #include "io/fileio.h"
 
-static std::unordered_map<std::string, CellProperties> cellProperties;
+static std::unordered_map<Symbol, CellProperties> cellProperties;
+static std::vector<const CellProperties *> cellPropertiesTable;
 
 CellProperties::CellProperties() :
   type("default"),
+  index(0),
   textures(0),
   emissiveTextures(0),
-  activeTexture(""),
-  emissiveActiveTexture(""),
+  activeTexture(nullptr),
+  emissiveActiveTexture(nullptr),
   light(0,0,0),
   flags(0),
   lightFactor(0.85),
   lightFade(0),
-  replace(""),
+  replace(),
   replaceChance(0.0),
   detailBelowReplace(0),
   scale(1.0, 1.0, 1.0),
+  pickShape(),
   speedModifier(1.0),
   friction(1.0),
   showSides(0),
@@ -39,8 +42,8 @@ CellProperties::CellProperties() :
 void CellProperties::ParseProperty(const std::string &cmd) {
   if (cmd == "tex")               Parse("cells/texture/", this->textures);
   else if (cmd == "emissivetex")  Parse("cells/texture/", this->emissiveTextures);
-  else if (cmd == "activetex")    Parse(this->activeTexture);
-  else if (cmd == "emissiveactivetex")    Parse(this->emissiveActiveTexture);
+  else if (cmd == "activetex")    Parse("cells/texture/", this->activeTexture);
+  else if (cmd == "emissiveactivetex")    Parse("cells/texture/", this->emissiveActiveTexture);
 
   else if (cmd == "light")        Parse(this->light);
   else if (cmd == "lightscale")   { float f; Parse(f); this->light = this->light * f; }
@@ -104,7 +107,7 @@ void CellProperties::ParseProperty(const std::string &cmd) {
   else if (cmd == "detailbelowreplace") Parse(this->detailBelowReplace);
   else if (cmd == "replacechance") Parse(this->replaceChance);
   else if (cmd == "onflowontoreplacetarget") {
-    std::string from, to, own;
+    Symbol from, to, own;
     Parse(from);
     Parse(to);
     Parse(own);
@@ -115,20 +118,53 @@ void CellProperties::ParseProperty(const std::string &cmd) {
   else SetError("Ignoring '" + cmd + "'\n");
 }
 
+/** Get the properties of a cell type, adding it to the cell type table
+  * if it is not known yet.
+  * @param type Name of the cell type.
+  * @return The cell properties.
+  */
+static CellProperties &GetOrAddCellProperties(const Symbol &type) {
+  auto iter = cellProperties.find(type);
+  if (iter != cellProperties.end()) return iter->second;
+
+  CellProperties &info = cellProperties[type];
+  info.type  = type;
+  info.index = cellPropertiesTable.size();
+  cellPropertiesTable.push_back(&info);
+  return info;
+}
+
 void LoadCells() {
   std::vector<std::string> assets = findAssets("cells");
   for (const std::string &name : assets) {
     FILE *f = openAsset("cells/"+name);
     if (f) {
       Log("Loading cell properties for type '%s'\n", name.c_str());
-      cellProperties[name].ParseFile(f);
-      cellProperties[name].type = name;
+      CellProperties &info = GetOrAddCellProperties(name);
+      info.ParseFile(f);
+      info.type = name;
+      info.pickShape = CellCollision(info.scale);
       fclose(f);
     }
   }
 }
 
-const CellProperties &GetCellProperties(const std::string &type) {
-  return cellProperties[type];
+const CellProperties &GetCellProperties(const Symbol &type) {
+  return GetOrAddCellProperties(type);
+}
+
+/** Get the properties of a cell type by its index in the cell type table.
+  * @param index Cell type index.
+  * @return The cell properties.
+  */
+const CellProperties &GetCellProperties(uint16_t index) {
+  return *cellPropertiesTable[index];
+}
+
+/** Get the number of entries in the cell type table.
+  * @return Number of known cell types.
+  */
+size_t GetCellTypeCount() {
+  return cellPropertiesTable.size();
 }
 
@@ -1,6 +1,7 @@
 #ifndef BARFOOS_CELLPROPERTIES_H
 #define BARFOOS_CELLPROPERTIES_H
 
+#include "game/world/cells/cellcollision.h"
 #include "io/properties.h"
 
 #include <unordered_map>
@@ -53,7 +54,10 @@ enum CellFlags {
 /** Information about a cell shared by cells of same type. */
 struct CellProperties : public Properties {
   /** Name of cell type. */
-  std::string type;
+  Symbol type;
+
+  /** Index of this cell type in the cell type table. */
+  uint16_t index;
 
   /** An array of textures to randomly choose from when cell is added to world. */
   std::vector<const Texture *> textures;
@@ -62,10 +66,10 @@ struct CellProperties : public Properties {
   std::vector<const Texture *> emissiveTextures;
 
   /** Texture to use when cell is "active". */
-  std::string activeTexture;
+  const Texture *activeTexture;
 
   /** Emissive texture to use when cell is "active". */
-  std::string emissiveActiveTexture;
+  const Texture *emissiveActiveTexture;
 
   /** Light emission from this kind of cell.
     * Default: Black, no light is emitted.
@@ -92,7 +96,7 @@ struct CellProperties : public Properties {
   /** Name of cell type with which to replace this cell under certain conditions.
     * Default: "", don't replace.
     */
-  std::string replace;
+  Symbol replace;
 
   /** If nonzero, the chance per tick to replace this cell.
     * Default: 0.0, don't replace.
@@ -118,6 +122,10 @@ struct CellProperties : public Properties {
     */
   Vector3 scale;
 
+  /** Shape of the cell with its rendering scale applied, for picking cells
+    * that have no corner heights of their own. */
+  CellCollision pickShape;
+
   /** Movement speed factor. */
   float speedModifier;
 
@@ -152,19 +160,19 @@ struct CellProperties : public Properties {
   float useChance;
 
   /** Particle entity to use when cell breaks. */
-  std::string breakParticle;
+  Symbol breakParticle;
 
   /** Replace when flowing onto something: targetcelltype -> newtargetcelltype. */
-  std::unordered_map<std::string, std::string> onFlowOntoReplaceTarget;
+  std::unordered_map<Symbol, Symbol> onFlowOntoReplaceTarget;
 
   /** Replace when flowing onto something: targetcelltype -> newowncelltype. */
-  std::unordered_map<std::string, std::string> onFlowOntoReplaceSelf;
+  std::unordered_map<Symbol, Symbol> onFlowOntoReplaceSelf;
 
   /** Chance of this cell to be initially locked. (Cascades into onUseCascade neighbours.) */
   float lockedChance;
 
   /** A list of sounds: soundType -> soundfile. */
-  std::unordered_map<std::string, std::string> sounds;
+  std::unordered_map<Symbol, Symbol> sounds;
 
   CellProperties();
 
@@ -172,7 +180,9 @@ struct CellProperties : public Properties {
 };
 
 void LoadCells();
-const CellProperties &GetCellProperties(const std::string &type);
+const CellProperties &GetCellProperties(const Symbol &type);
+const CellProperties &GetCellProperties(uint16_t index);
+size_t GetCellTypeCount();
 
 #endif
 
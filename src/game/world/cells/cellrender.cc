@@ -1,11 +1,12 @@
 #include "common.h"
 
+#include "game/game.h"
+#include "game/gamestates/running/runningstate.h"
 #include "game/world/cells/cell.h"
 #include "game/world/world.h"
+#include "gfx/texture.h"
 #include "util/util.h"
 
-static bool sidesDatasInited = false;
-
 struct SideData {
   int idx[4];
   int tile;
@@ -44,57 +45,87 @@ static void InitSideData(Side side) {
   sideData[(int)side].vvec = vvec;
 }
 
-static void InitSideData() {
+static bool InitSideData() {
   for (size_t s = 0; s<6; s++) {
     InitSideData((Side)s);
   }
-  sidesDatasInited = true;
+  return true;
 }
 
 static const SideData &GetSideData(Side s) {
-  if (!sidesDatasInited) InitSideData();
+  // initialized once, even when called from several mesh builder threads
+  static const bool sideDataInited = InitSideData();
+  (void)sideDataInited;
   return sideData[(int)s];
 }
 
 /** C'tor.
-  * @param type Cell type.
+  * Creates a reference to no cell.
   */
-CellRender::CellRender(const std::string &type) :
-  CellBase(type),
-  visibility(0),
-  verts(),
-  texture(nullptr),
-  emissiveTexture(nullptr),
-  activeTexture(nullptr),
-  emissiveActiveTexture(nullptr),
-  uscale(1.0)
+CellRender::CellRender() :
+  CellBase()
 {
 }
 
-CellRender::CellRender(const Cell_Proto &proto) :
-  CellBase(proto),
-  visibility(0),
-  verts(),
-  texture(nullptr),
-  emissiveTexture(nullptr),
-  activeTexture(nullptr),
-  emissiveActiveTexture(nullptr),
-  uscale(1.0)
+/** C'tor.
+  * @param type Cell type.
+  */
+CellRender::CellRender(const Symbol &type) :
+  CellBase(type)
 {
 }
 
 CellRender::CellRender(const CellRender &that) :
-  CellBase(that),
-  visibility(0),
-  verts(),
-  texture(that.texture),
-  emissiveTexture(that.emissiveTexture),
-  activeTexture(that.activeTexture),
-  emissiveActiveTexture(that.emissiveActiveTexture),
-  uscale(that.uscale)
+  CellBase(that)
 {
 }
 
+CellRender::CellRender(CellStore *store, World *world, size_t index, const IVector3 &pos) :
+  CellBase(store, world, index, pos)
+{
+}
+
+/** Get the time used for texture animation.
+  * @return Current game time, the time a region was copied or 0 if not in
+  *         a world.
+  */
+float
+CellRender::GetUVTime() const {
+  if (!this->world) return this->store->regionTime;
+  return this->world->GetState().GetGame().GetTime();
+}
+
+/** Get current texture.
+  * @return Normal texture for this cell, or active. 
+  */
+const Texture *
+CellRender::GetTexture() const {
+  const CellProperties &info = this->GetInfo();
+
+  if (info.activeTexture && this->GetUVTime() < this->GetNextActivationTime()) {
+    return info.activeTexture;
+  }
+
+  if (info.textures.empty()) return nullptr;
+  return info.textures[this->store->variants[this->index] % info.textures.size()];
+}
+
+/** Get current emissive texture.
+  * @return Normal texture for this cell, or active. 
+  */
+const Texture *
+CellRender::GetEmissiveTexture() const {
+  const CellProperties &info = this->GetInfo();
+
+  if (info.emissiveActiveTexture && this->GetUVTime() < this->GetNextActivationTime()) {
+    return info.emissiveActiveTexture;
+  }
+
+  size_t idx = this->store->variants[this->index];
+  if (idx >= info.emissiveTextures.size()) return nullptr;
+  return info.emissiveTextures[idx];
+}
+
 /** Get all 4 corner colors for a given side.
   * @param side Side to use.
   * @param[out] colors Where to store the colors.
@@ -107,30 +138,8 @@ CellRender::SideColors(Side side, IColor *colors) const {
   colors[3] = this->SideCornerColor(side, 3);
 }
 
-/** Set normal texture.
-  * @param tex Texture to use.
-  * @param multi If true, texture contains multiple sides.
-  */
 void
-CellRender::SetTexture(const Texture *tex, bool multi) {
-  if (multi) {
-    this->uscale = 1.0/8.0;
-  } else {
-    this->uscale = 1.0;
-  }
-  this->texture = tex; 
-}
-
-/** Set emissive normal texture.
-  * @param tex Texture to use.
-  */
-void
-CellRender::SetEmissiveTexture(const Texture *tex) {
-  this->emissiveTexture = tex; 
-}
-
-void
-CellRender::SideVerts(Side side, std::vector<Vertex> &verts, bool reverse) const {
+CellRender::SideVerts(Side side, const Vector3 *corners, std::vector<Vertex> &verts, bool reverse) const {
   bool drawA = true, drawB = true;
 
   const SideData &data = GetSideData(side);
@@ -150,23 +159,26 @@ CellRender::SideVerts(Side side, std::vector<Vertex> &verts, bool reverse) const
 
   if (!drawA && !drawB) return;
 
+  const CellProperties &info = this->GetInfo();
+  float uscale = (info.flags & CellFlags::MultiSided) ? 1.0/8.0 : 1.0;
+
   float u[4] = { 
-    this->u[0] + (pos[0].Dot(data.uvec) + data.tile) * this->uscale, 
-    this->u[1] + (pos[1].Dot(data.uvec) + data.tile) * this->uscale, 
-    this->u[2] + (pos[2].Dot(data.uvec) + data.tile) * this->uscale, 
-    this->u[3] + (pos[3].Dot(data.uvec) + data.tile) * this->uscale 
+    (pos[0].Dot(data.uvec) + data.tile) * uscale, 
+    (pos[1].Dot(data.uvec) + data.tile) * uscale, 
+    (pos[2].Dot(data.uvec) + data.tile) * uscale, 
+    (pos[3].Dot(data.uvec) + data.tile) * uscale 
   };
   
   float v[4] = { 
-    pos[0].Dot(data.vvec) + this->v[0], 
-    pos[1].Dot(data.vvec) + this->v[1],
-    pos[2].Dot(data.vvec) + this->v[2],
-    pos[3].Dot(data.vvec) + this->v[3] 
+    pos[0].Dot(data.vvec), 
+    pos[1].Dot(data.vvec),
+    pos[2].Dot(data.vvec),
+    pos[3].Dot(data.vvec)
   };
 
-  if (GetInfo().flags & CellFlags::UVTurb) {
-    float t = this->uvTime;
-    if (GetInfo().flags & CellFlags::Viscous) {
+  if (info.flags & CellFlags::UVTurb) {
+    float t = this->GetUVTime();
+    if (info.flags & CellFlags::Viscous) {
       t *= 0.05;
     }
     for (int i=0; i<4; i++) {
@@ -184,7 +196,7 @@ CellRender::SideVerts(Side side, std::vector<Vertex> &verts, bool reverse) const
     this->world->GetLight(pos[3]+this->pos)
   };*/
   SideColors(side, colors);
-  bool doubleSided = info->flags & CellFlags::DoubleSided;
+  bool doubleSided = info.flags & CellFlags::DoubleSided;
 
   if (reverse) {
     if (drawA) {
@@ -241,91 +253,15 @@ CellRender::SideVerts(Side side, std::vector<Vertex> &verts, bool reverse) const
   }
 }
 
+/** Create the vertices of all visible sides of the cell.
+  * @param[out] verts Vertices in world space are appended here.
+  */
 void
-CellRender::SideColors(Side side, std::vector<IColor> &outcolors, bool reverse) const {
-  bool drawA = true, drawB = true;
+CellRender::GetVertices(std::vector<Vertex> &verts) const {
+  uint8_t visibility = this->GetVisibility();
+  const CellProperties &info = this->GetInfo();
 
-  const SideData &data = GetSideData(side);
-
-  Vector3 pos[4] = { corners[data.idx[0]],    corners[data.idx[1]],    corners[data.idx[2]],    corners[data.idx[3]] };
-
-  // avoid coplanar faces
-  if (side == Side::Up   &&  reverse && pos[0].y == 0.0 && pos[1].y == 0.0 && pos[3].y == 0.0) drawA = false;
-  if (side == Side::Up   &&  reverse && pos[1].y == 0.0 && pos[2].y == 0.0 && pos[3].y == 0.0) drawB = false;
-  if (side == Side::Up   && !reverse && pos[0].y == 0.0 && pos[1].y == 0.0 && pos[2].y == 0.0) drawA = false;
-  if (side == Side::Up   && !reverse && pos[0].y == 0.0 && pos[2].y == 0.0 && pos[3].y == 0.0) drawB = false;
-
-  if (side == Side::Down &&  reverse && pos[0].y == 1.0 && pos[1].y == 1.0 && pos[3].y == 1.0) drawA = false;
-  if (side == Side::Down &&  reverse && pos[1].y == 1.0 && pos[2].y == 1.0 && pos[3].y == 1.0) drawB = false;
-  if (side == Side::Down && !reverse && pos[0].y == 1.0 && pos[1].y == 1.0 && pos[2].y == 1.0) drawA = false;
-  if (side == Side::Down && !reverse && pos[0].y == 1.0 && pos[2].y == 1.0 && pos[3].y == 1.0) drawB = false;
-
-  if (!drawA && !drawB) return;
-
-  IColor colors[4];
-  SideColors(side, colors);
-  bool doubleSided = info->flags & CellFlags::DoubleSided;
-
-  if (reverse) {
-    if (drawA) {
-      outcolors.push_back(colors[0]);
-      outcolors.push_back(colors[1]);
-      outcolors.push_back(colors[3]);
-      
-      if (doubleSided) {
-        outcolors.push_back(colors[3]);
-        outcolors.push_back(colors[1]);
-        outcolors.push_back(colors[0]);
-      }
-    }
-
-    if (drawB) {
-      outcolors.push_back(colors[1]);
-      outcolors.push_back(colors[2]);
-      outcolors.push_back(colors[3]);
-      
-      if (doubleSided) {
-        outcolors.push_back(colors[3]);
-        outcolors.push_back(colors[2]);
-        outcolors.push_back(colors[1]);
-      }
-    }
-  } else {
-    if (drawA) {
-      outcolors.push_back(colors[0]);
-      outcolors.push_back(colors[1]);
-      outcolors.push_back(colors[2]);
-      
-      if (doubleSided) {
-        outcolors.push_back(colors[2]);
-        outcolors.push_back(colors[1]);
-        outcolors.push_back(colors[0]);
-      }
-    }
-
-    if (drawB) {
-      outcolors.push_back(colors[0]);
-      outcolors.push_back(colors[2]);
-      outcolors.push_back(colors[3]);
-      
-      if (doubleSided) {
-        outcolors.push_back(colors[3]);
-        outcolors.push_back(colors[2]);
-        outcolors.push_back(colors[0]);
-      }
-    }
-  }
-}
-
-bool
-CellRender::UpdateVertices() {
-  if (!visibility || (this->info->flags & CellFlags::DoNotRender)) return false;
-  
-  if (!this->vertsDirty) {
-    this->UpdateColors();
-    return false;
-  }
-  if ((this->info->flags & CellFlags::Dynamic) == 0) this->vertsDirty = false;
+  if (!visibility || (info.flags & CellFlags::DoNotRender)) return;
 
   float h[4];
   h[0] = GetTopHeight(0);
@@ -333,37 +269,34 @@ CellRender::UpdateVertices() {
   h[2] = GetTopHeight(2);
   h[3] = GetTopHeight(3);
   
-  if (info->flags & CellFlags::Liquid && (neighbours[(int)Side::Up]->info != this->info)) {
+  if (info.flags & CellFlags::Liquid && this->HasNeighbours() && self[Side::Up].GetInfo() != info) {
     // snap vertices of neighbouring liquid cells together to make a nice connected surface
-    Cell *l = neighbours[(int)Side::Left];
-    Cell *r = neighbours[(int)Side::Right];
-    Cell *f = neighbours[(int)Side::Forward];
-    Cell *b = neighbours[(int)Side::Backward];
-    Cell *rf = nullptr;
-    Cell *lf = nullptr;
-    Cell *rb = nullptr;
-    Cell *lb = nullptr;
+    Cell l = self[Side::Left];
+    Cell r = self[Side::Right];
+    Cell f = self[Side::Forward];
+    Cell b = self[Side::Backward];
+    Cell rf, lf, rb, lb;
     
-    if (l->info != this->info) l = nullptr;
-    if (r->info != this->info) r = nullptr;
-    if (f->info != this->info) f = nullptr;
-    if (b->info != this->info) b = nullptr;
+    if (l.GetInfo() != info) l = Cell();
+    if (r.GetInfo() != info) r = Cell();
+    if (f.GetInfo() != info) f = Cell();
+    if (b.GetInfo() != info) b = Cell();
     
-    if (r) rf = r->neighbours[(int)Side::Forward];
-    if (f) rf = f->neighbours[(int)Side::Right];
-    if (rf && rf->info != this->info) rf = nullptr;
+    if (r.IsValid()) rf = r[Side::Forward];
+    if (f.IsValid()) rf = f[Side::Right];
+    if (rf.IsValid() && rf.GetInfo() != info) rf = Cell();
 
-    if (l) lf = l->neighbours[(int)Side::Forward];
-    if (f) lf = f->neighbours[(int)Side::Left];
-    if (lf && lf->info != this->info) lf = nullptr;
+    if (l.IsValid()) lf = l[Side::Forward];
+    if (f.IsValid()) lf = f[Side::Left];
+    if (lf.IsValid() && lf.GetInfo() != info) lf = Cell();
 
-    if (l) lb = l->neighbours[(int)Side::Backward];
-    if (b) lb = b->neighbours[(int)Side::Left];
-    if (lb && lb->info != this->info) lb = nullptr;
+    if (l.IsValid()) lb = l[Side::Backward];
+    if (b.IsValid()) lb = b[Side::Left];
+    if (lb.IsValid() && lb.GetInfo() != info) lb = Cell();
     
-    if (r) rb = r->neighbours[(int)Side::Backward];
-    if (b) rb = b->neighbours[(int)Side::Right];
-    if (rb && rb->info != this->info) rb = nullptr;
+    if (r.IsValid()) rb = r[Side::Backward];
+    if (b.IsValid()) rb = b[Side::Right];
+    if (rb.IsValid() && rb.GetInfo() != info) rb = Cell();
 
 
     // Z ^
@@ -375,37 +308,37 @@ CellRender::UpdateVertices() {
     float w[4] = {1,1,1,1};
     
     // 0
-    if (lb) { h[0] += lb->GetTopHeight(2); w[0]++; };
-    if (b)  { h[0] += b ->GetTopHeight(1); w[0]++; };
-    if (l)  { h[0] += l ->GetTopHeight(3); w[0]++; };
+    if (lb.IsValid()) { h[0] += lb.GetTopHeight(2); w[0]++; };
+    if (b.IsValid())  { h[0] += b .GetTopHeight(1); w[0]++; };
+    if (l.IsValid())  { h[0] += l .GetTopHeight(3); w[0]++; };
     
     // 1
-    if (lf) { h[1] += lf->GetTopHeight(3); w[1]++; };
-    if (f)  { h[1] += f ->GetTopHeight(0); w[1]++; };
-    if (l)  { h[1] += l ->GetTopHeight(2); w[1]++; };
+    if (lf.IsValid()) { h[1] += lf.GetTopHeight(3); w[1]++; };
+    if (f.IsValid())  { h[1] += f .GetTopHeight(0); w[1]++; };
+    if (l.IsValid())  { h[1] += l .GetTopHeight(2); w[1]++; };
 
     // 2
-    if (rf) { h[2] += rf->GetTopHeight(0); w[2]++; };
-    if (f)  { h[2] += f ->GetTopHeight(3); w[2]++; };
-    if (r)  { h[2] += r ->GetTopHeight(1); w[2]++; };
+    if (rf.IsValid()) { h[2] += rf.GetTopHeight(0); w[2]++; };
+    if (f.IsValid())  { h[2] += f .GetTopHeight(3); w[2]++; };
+    if (r.IsValid())  { h[2] += r .GetTopHeight(1); w[2]++; };
     
     // 3
-    if (rb) { h[3] += rb->GetTopHeight(1); w[3]++; };
-    if (b)  { h[3] += b ->GetTopHeight(2); w[3]++; };
-    if (r)  { h[3] += r ->GetTopHeight(0); w[3]++; };
+    if (rb.IsValid()) { h[3] += rb.GetTopHeight(1); w[3]++; };
+    if (b.IsValid())  { h[3] += b .GetTopHeight(2); w[3]++; };
+    if (r.IsValid())  { h[3] += r .GetTopHeight(0); w[3]++; };
         
     h[0] /= w[0]; h[1] /= w[1]; h[2] /= w[2]; h[3] /= w[3];
   }  
   
-  if (GetInfo().flags & CellFlags::Waving) {
+  if (info.flags & CellFlags::Waving) {
     // Z ^
     //   | 1---2
     //   | | / |
     //   | 0---3
     //   +------> X
 
-    float t = this->uvTime;
-    if (GetInfo().flags & CellFlags::Viscous) {
+    float t = this->GetUVTime();
+    if (info.flags & CellFlags::Viscous) {
       t *= 0.25;
     }
     h[0] += Wave(this->pos.x,   this->pos.z,   t, 0.1);
@@ -414,10 +347,12 @@ CellRender::UpdateVertices() {
     h[3] += Wave(this->pos.x+1, this->pos.z,   t, 0.1);
   }
   
-  const float &scaleX = this->proto.scale_x();
-  const float &scaleY = this->proto.scale_y();
-  const float &scaleZ = this->proto.scale_z();
+  Vector3 scale = this->GetScale();
+  const float &scaleX = scale.x;
+  const float &scaleY = scale.y;
+  const float &scaleZ = scale.z;
   
+  Vector3 corners[8];
   corners[0] = Vector3(0.5-0.5*scaleX, 0.5+(GetBottomHeight(0)-0.5)*scaleY, 0.5-0.5*scaleZ); 
   corners[1] = Vector3(0.5+0.5*scaleX, 0.5+(GetBottomHeight(3)-0.5)*scaleY, 0.5-0.5*scaleZ); 
   corners[2] = Vector3(0.5-0.5*scaleX, 0.5+(h[0]    -0.5)*scaleY, 0.5-0.5*scaleZ); 
@@ -428,39 +363,10 @@ CellRender::UpdateVertices() {
   corners[6] = Vector3(0.5-0.5*scaleX, 0.5+(h[1]    -0.5)*scaleY, 0.5+0.5*scaleZ);
   corners[7] = Vector3(0.5+0.5*scaleX, 0.5+(h[2]    -0.5)*scaleY, 0.5+0.5*scaleZ);
 
-  verts.clear();
-  
-  if (visibility & (1<<Side::Right))    SideVerts(Side::Right,    verts, this->IsSideReversed());
-  if (visibility & (1<<Side::Left))     SideVerts(Side::Left,     verts, this->IsSideReversed());
-  if (visibility & (1<<Side::Up))       SideVerts(Side::Up,       verts, this->IsTopReversed());
-  if (visibility & (1<<Side::Down))     SideVerts(Side::Down,     verts, this->IsBottomReversed());
-  if (visibility & (1<<Side::Forward))  SideVerts(Side::Forward,  verts, this->IsSideReversed());
-  if (visibility & (1<<Side::Backward)) SideVerts(Side::Backward, verts, this->IsSideReversed());
-  
-  return true;
-}
-
-void
-CellRender::UpdateColors() {
-  if (!visibility || (this->info->flags & CellFlags::DoNotRender)) return;
-  //if (!this->colorDirty) return;
-  if ((this->info->flags & CellFlags::Dynamic) == 0) this->colorDirty = false;
-  
-  std::vector<IColor> colors;
-  
-  if (visibility & (1<<Side::Right))    SideColors(Side::Right,    colors, this->IsSideReversed());
-  if (visibility & (1<<Side::Left))     SideColors(Side::Left,     colors, this->IsSideReversed());
-  if (visibility & (1<<Side::Up))       SideColors(Side::Up,       colors, this->IsTopReversed());
-  if (visibility & (1<<Side::Down))     SideColors(Side::Down,     colors, this->IsBottomReversed());
-  if (visibility & (1<<Side::Forward))  SideColors(Side::Forward,  colors, this->IsSideReversed());
-  if (visibility & (1<<Side::Backward)) SideColors(Side::Backward, colors, this->IsSideReversed());
-  
-  if (colors.size() != verts.size()) {
-    Log("color count %u doesn't match vertex count %u! %u\n", colors.size(), verts.size(), info->flags & CellFlags::DoubleSided);
-    return;
-  }
-  
-  for (size_t i=0; i<verts.size(); i++) {
-    verts[i].SetColor(colors[i]);
-  }
+  if (visibility & (1<<Side::Right))    SideVerts(Side::Right,    corners, verts, this->IsSideReversed());
+  if (visibility & (1<<Side::Left))     SideVerts(Side::Left,     corners, verts, this->IsSideReversed());
+  if (visibility & (1<<Side::Up))       SideVerts(Side::Up,       corners, verts, this->IsTopReversed());
+  if (visibility & (1<<Side::Down))     SideVerts(Side::Down,     corners, verts, this->IsBottomReversed());
+  if (visibility & (1<<Side::Forward))  SideVerts(Side::Forward,  corners, verts, this->IsSideReversed());
+  if (visibility & (1<<Side::Backward)) SideVerts(Side::Backward, corners, verts, this->IsSideReversed());
 }
@@ -0,0 +1,218 @@
+#include "common.h"
+
+#include "game/world/cells/cellstore.h"
+
+constexpr uint16_t CellStore::Protected;
+constexpr uint16_t CellStore::IgnoringProtection;
+constexpr uint16_t CellStore::IgnoringWrite;
+constexpr uint16_t CellStore::TopReversed;
+constexpr uint16_t CellStore::BottomReversed;
+constexpr uint16_t CellStore::SideReversed;
+constexpr uint16_t CellStore::Triggered;
+constexpr uint16_t CellStore::Default;
+constexpr uint16_t CellStore::HasShape;
+constexpr uint16_t CellStore::HasExtra;
+constexpr uint16_t CellStore::ContentBits;
+constexpr uint16_t CellStore::InvalidFeature;
+
+/** C'tor.
+  * @param count Number of cells, all initialized to the "default" type.
+  */
+CellStore::CellStore(size_t count) :
+  types(),
+  bits(),
+  features(),
+  liquid(),
+  lightR(),
+  lightG(),
+  lightB(),
+  visibility(),
+  variants(),
+  tickPhases(),
+  shapes(),
+  extras()
+{
+  this->Resize(count);
+}
+
+/** Change the number of cells. New cells are of the "default" type.
+  * @param count New number of cells.
+  */
+void
+CellStore::Resize(size_t count) {
+  uint16_t defaultType = GetCellProperties("default").index;
+
+  this->types     .resize(count, defaultType);
+  this->bits      .resize(count, Default);
+  this->features  .resize(count, InvalidFeature);
+  this->liquid    .resize(count, 0);
+  this->lightR    .resize(count, 0);
+  this->lightG    .resize(count, 0);
+  this->lightB    .resize(count, 0);
+  this->visibility.resize(count, 0);
+  this->variants  .resize(count, 0);
+  this->tickPhases.resize(count, 0);
+}
+
+/** Get an estimate of the memory used by the cells.
+  * @return Memory usage in bytes.
+  */
+size_t
+CellStore::GetMemoryUsage() const {
+  size_t perCell = sizeof(uint16_t) * 3 + sizeof(uint8_t) * 7;
+  return this->GetCount() * perCell +
+         this->shapes.size() * (sizeof(CellShape) + sizeof(size_t)) +
+         this->extras.size() * (sizeof(CellExtra) + sizeof(size_t));
+}
+
+/** Reset a cell to a freshly created cell of a given type.
+  * @param i Index of the cell.
+  * @param type Cell type.
+  */
+void
+CellStore::Reset(size_t i, const Symbol &type) {
+  const CellProperties &info = GetCellProperties(type);
+
+  this->shapes.erase(i);
+  this->extras.erase(i);
+
+  this->types[i]      = info.index;
+  this->bits[i]       = 0;
+  this->features[i]   = InvalidFeature;
+  this->liquid[i]     = (info.flags & CellFlags::Liquid) ? 15 : 0;
+  this->lightR[i]     = 0;
+  this->lightG[i]     = 0;
+  this->lightB[i]     = 0;
+  this->visibility[i] = 0;
+  this->variants[i]   = 0;
+  this->tickPhases[i] = 0;
+}
+
+/** Copy the content of a cell from another store.
+  * Feature id, default flag, visibility and texture variant are left alone,
+  * they depend on the position of the cell in the world.
+  * @param i Index of the cell to overwrite.
+  * @param from Store from which to copy.
+  * @param j Index of the cell in the other store.
+  */
+void
+CellStore::CopyCell(size_t i, const CellStore &from, size_t j) {
+  if (&from == this && i == j) return;
+
+  this->types[i]      = from.types[j];
+  this->liquid[i]     = from.liquid[j];
+  this->lightR[i]     = from.lightR[j];
+  this->lightG[i]     = from.lightG[j];
+  this->lightB[i]     = from.lightB[j];
+  this->tickPhases[i] = 0;
+  this->bits[i]       = (this->bits[i] & ~(ContentBits | HasShape | HasExtra)) | (from.bits[j] & ContentBits);
+
+  const CellShape *shape = from.FindShape(j);
+  if (shape) {
+    CellShape copy(*shape);
+    this->GetShape(i) = copy;
+  } else {
+    this->shapes.erase(i);
+  }
+
+  const CellExtra *extra = from.FindExtra(j);
+  if (extra) {
+    CellExtra copy(*extra);
+    this->GetExtra(i) = copy;
+  } else {
+    this->extras.erase(i);
+  }
+}
+
+/** Make this a copy of a box shaped part of a world store.
+  * The last cell of both stores is the default cell, which is also used for
+  * positions outside of the world.
+  * @param from Cells of the world.
+  * @param fromSize Size of the world.
+  * @param origin World position of the first cell to copy.
+  * @param size Size of the box to copy.
+  */
+void
+CellStore::CopyRegion(const CellStore &from, const IVector3 &fromSize, const IVector3 &origin, const IVector3 &size) {
+  size_t count = size.x * size.y * size.z;
+
+  this->shapes.clear();
+  this->extras.clear();
+  this->Resize(count + 1);
+
+  this->regionOrigin = origin;
+  this->regionSize   = size;
+
+  for (size_t i=0; i<=count; i++) {
+    size_t j = from.GetCount() - 1;
+
+    if (i < count) {
+      IVector3 pos(
+        origin.x + i % size.x,
+        origin.y + (i / size.x) % size.y,
+        origin.z + i / (size.x * size.y)
+      );
+
+      if (pos.x < fromSize.x && pos.y < fromSize.y && pos.z < fromSize.z) {
+        j = pos.x + fromSize.x * (pos.y + fromSize.y * pos.z);
+      }
+    }
+
+    this->types[i]      = from.types[j];
+    this->bits[i]       = from.bits[j];
+    this->features[i]   = from.features[j];
+    this->liquid[i]     = from.liquid[j];
+    this->lightR[i]     = from.lightR[j];
+    this->lightG[i]     = from.lightG[j];
+    this->lightB[i]     = from.lightB[j];
+    this->visibility[i] = from.visibility[j];
+    this->variants[i]   = from.variants[j];
+    this->tickPhases[i] = from.tickPhases[j];
+
+    if (from.bits[j] & HasShape) this->shapes[i] = from.shapes.at(j);
+    if (from.bits[j] & HasExtra) this->extras[i] = from.extras.at(j);
+  }
+}
+
+/** Get the shape of a cell, creating it if the cell is a plain cube.
+  * @param i Index of the cell.
+  * @return The shape.
+  */
+CellShape &
+CellStore::GetShape(size_t i) {
+  if (this->bits[i] & HasShape) return this->shapes[i];
+
+  this->bits[i] |= HasShape;
+  CellShape &shape = this->shapes[i];
+  shape = CellShape();
+  shape.scale = GetCellProperties(this->types[i]).scale;
+  return shape;
+}
+
+/** Turn a cell back into a plain cube.
+  * @param i Index of the cell.
+  */
+void
+CellStore::ClearShape(size_t i) {
+  this->bits[i] &= ~HasShape;
+  this->shapes.erase(i);
+}
+
+/** Get the extra data of a cell, creating it if necessary.
+  * @param i Index of the cell.
+  * @return The extra data.
+  */
+CellExtra &
+CellStore::GetExtra(size_t i) {
+  this->bits[i] |= HasExtra;
+  return this->extras[i];
+}
+
+/** Remove the extra data of a cell.
+  * @param i Index of the cell.
+  */
+void
+CellStore::ClearExtra(size_t i) {
+  this->bits[i] &= ~HasExtra;
+  this->extras.erase(i);
+}
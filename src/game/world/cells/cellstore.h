@@ -0,0 +1,172 @@
+#ifndef BARFOOS_CELLSTORE_H
+#define BARFOOS_CELLSTORE_H
+
+#include "game/world/cells/cellproperties.h"
+
+#include <unordered_map>
+
+/** Corner heights and scale of a cell that is not a plain unit cube. */
+struct CellShape {
+  float   top[4]    = {1,1,1,1};
+  float   bottom[4] = {0,0,0,0};
+  Vector3 scale     = Vector3(1,1,1);
+};
+
+/** Rarely used cell data: locks, teleports, triggers and spawners. */
+struct CellExtra {
+  ID          lockId              = InvalidID;
+  uint32_t    teleportTarget      = InvalidID;
+  ID          triggerTargetId     = InvalidID;
+  ID          triggerId           = InvalidID;
+  bool        isTriggerToggle     = false;
+
+  std::string spawnMobType        = "";
+  Side        spawnSide           = Side::InvalidSide;
+  float       spawnRate           = 0.0f;
+
+  float       nextActivationTime  = 0.0f;
+  float       lastUseTime         = 0.0f;
+};
+
+/** Packed struct-of-arrays storage for a block of cells.
+  * Everything a cell needs every frame is kept in dense per-cell planes,
+  * the rest lives in sparse side tables indexed by cell index.
+  */
+struct CellStore final {
+
+  // per cell state bits
+  static constexpr uint16_t Protected           = (1<<0);
+  static constexpr uint16_t IgnoringProtection  = (1<<1);
+  static constexpr uint16_t IgnoringWrite       = (1<<2);
+  static constexpr uint16_t TopReversed         = (1<<3);
+  static constexpr uint16_t BottomReversed      = (1<<4);
+  static constexpr uint16_t SideReversed        = (1<<5);
+  static constexpr uint16_t Triggered           = (1<<6);
+  static constexpr uint16_t Default             = (1<<7);
+  static constexpr uint16_t HasShape            = (1<<8);
+  static constexpr uint16_t HasExtra            = (1<<9);
+
+  /** Bits that are copied along with the cell content. */
+  static constexpr uint16_t ContentBits         = Protected | IgnoringProtection | IgnoringWrite |
+                                                  TopReversed | BottomReversed | SideReversed | Triggered;
+
+  /** Feature id value for cells that are not part of a feature. */
+  static constexpr uint16_t InvalidFeature      = 0xFFFF;
+
+                            CellStore           (size_t count = 0);
+
+  size_t                    GetCount            ()                                        const { return this->types.size(); }
+  size_t                    GetMemoryUsage      ()                                        const;
+
+  void                      Resize              (size_t count);
+  void                      Reset               (size_t i, const Symbol &type = "default");
+  void                      CopyCell            (size_t i, const CellStore &from, size_t j);
+
+  void                      CopyRegion          (const CellStore &from, const IVector3 &fromSize, 
+                                                 const IVector3 &origin, const IVector3 &size);
+  bool                      IsRegion            ()                                        const { return this->regionSize.x != 0; }
+  size_t                    GetRegionIndex      (const IVector3 &pos)                     const;
+
+  const CellShape *         FindShape           (size_t i)                                const;
+  CellShape &               GetShape            (size_t i);
+  void                      ClearShape          (size_t i);
+
+  const CellExtra *         FindExtra           (size_t i)                                const;
+  CellExtra &               GetExtra            (size_t i);
+  void                      ClearExtra          (size_t i);
+
+  CellCollision             GetCollision        (size_t i)                                const;
+  CellCollision             GetPickShape        (size_t i)                                const;
+
+  /** Index into the cell type table. */
+  std::vector<uint16_t>     types;
+
+  /** State bits. */
+  std::vector<uint16_t>     bits;
+
+  /** Feature the cell belongs to. */
+  std::vector<uint16_t>     features;
+
+  /** Amount of liquid in the cell. */
+  std::vector<uint8_t>      liquid;
+
+  /** Light level, one plane per color component. */
+  std::vector<uint8_t>      lightR;
+  std::vector<uint8_t>      lightG;
+  std::vector<uint8_t>      lightB;
+
+  /** Side visibility mask. */
+  std::vector<uint8_t>      visibility;
+
+  /** Randomly chosen texture variant. */
+  std::vector<uint8_t>      variants;
+
+  /** Current tick phase. */
+  std::vector<uint8_t>      tickPhases;
+
+  std::unordered_map<size_t, CellShape> shapes;
+  std::unordered_map<size_t, CellExtra> extras;
+
+  /** Part of the world copied by CopyRegion. */
+  IVector3                  regionOrigin;
+  IVector3                  regionSize;
+
+  /** Game time at which the region was copied. */
+  float                     regionTime          = 0.0f;
+};
+
+/** Get the index of a cell in a region copied by CopyRegion.
+  * @param pos World position of the cell.
+  * @return Index of the cell, or of the last cell which holds the default
+  *         cell for positions outside the region.
+  */
+inline size_t
+CellStore::GetRegionIndex(const IVector3 &pos) const {
+  // unsigned wraparound takes care of positions left of the origin
+  uint32_t x = pos.x - this->regionOrigin.x;
+  uint32_t y = pos.y - this->regionOrigin.y;
+  uint32_t z = pos.z - this->regionOrigin.z;
+
+  if (x >= this->regionSize.x || y >= this->regionSize.y || z >= this->regionSize.z) return this->GetCount() - 1;
+  return x + this->regionSize.x * (y + this->regionSize.y * z);
+}
+
+inline const CellShape *
+CellStore::FindShape(size_t i) const {
+  if (!(this->bits[i] & HasShape)) return nullptr;
+  return &this->shapes.at(i);
+}
+
+inline const CellExtra *
+CellStore::FindExtra(size_t i) const {
+  if (!(this->bits[i] & HasExtra)) return nullptr;
+  return &this->extras.at(i);
+}
+
+/** Get the collision shape of a cell. Like the rest of collision detection
+  * this ignores the scale of the cell.
+  * @param i Cell index.
+  * @return The collision shape in cell local coordinates.
+  */
+inline CellCollision
+CellStore::GetCollision(size_t i) const {
+  const CellShape *shape = this->FindShape(i);
+  if (!shape) return CellCollision();
+
+  return CellCollision(shape->top, shape->bottom, Vector3(1,1,1), this->bits[i] & TopReversed, this->bits[i] & BottomReversed);
+}
+
+/** Get the shape of a cell as it is rendered, for casting rays at it.
+  * @param i Cell index.
+  * @return The shape in cell local coordinates.
+  */
+inline CellCollision
+CellStore::GetPickShape(size_t i) const {
+  const CellShape *shape = this->FindShape(i);
+  if (!shape) return GetCellProperties(this->types[i]).pickShape;
+
+  return CellCollision(shape->top, shape->bottom, shape->scale, this->bits[i] & TopReversed, this->bits[i] & BottomReversed);
+}
+
+#endif
+
@@ -0,0 +1,161 @@
+#include "common.h"
+
+#include "game/world/cells/cell.h"
+#include "game/world/dynamicmesh.h"
+#include "game/world/world.h"
+#include "gfx/gfx.h"
+
+#include <cstring>
+
+constexpr size_t DynamicMesh::verticesPerUnit;
+
+/** C'tor. */
+DynamicMesh::DynamicMesh() :
+  layersNormal(),
+  layersEmissive(),
+  cells(),
+  stamp(0),
+  cellVerts(),
+  updateCount(0)
+{
+}
+
+/** Set the list of dynamic cells. Cells that are no longer in the list
+  * give up their vertex ranges, cells that stay keep them.
+  * @param cells Indices of the dynamic cells.
+  */
+void
+DynamicMesh::SetCells(const std::vector<size_t> &cells) {
+  this->stamp++;
+  for (size_t i : cells) {
+    this->cells[i].stamp = this->stamp;
+  }
+
+  for (auto iter = this->cells.begin(); iter != this->cells.end(); ) {
+    if (iter->second.stamp != this->stamp) {
+      this->Release(this->layersNormal,   iter->second.normal);
+      this->Release(this->layersEmissive, iter->second.emissive);
+      iter = this->cells.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+}
+
+/** Recreate the geometry of the dynamic cells and write the changed parts.
+  * @param world World of the cells.
+  * @param cells Indices of the dynamic cells, as passed to SetCells.
+  */
+void
+DynamicMesh::Update(const World &world, const std::vector<size_t> &cells) {
+  this->updateCount = 0;
+  for (size_t i : cells) {
+    this->UpdateCell(world.GetCell(i));
+  }
+}
+
+void
+DynamicMesh::DrawNormal(Gfx &gfx) {
+  this->Draw(gfx, this->layersNormal);
+}
+
+void
+DynamicMesh::DrawEmissive(Gfx &gfx) {
+  this->Draw(gfx, this->layersEmissive);
+}
+
+/** Recreate the geometry of a single cell.
+  * @param cell The cell, which must be in the list passed to SetCells.
+  */
+void
+DynamicMesh::UpdateCell(const Cell &cell) {
+  auto iter = this->cells.find(cell.GetIndex());
+  if (iter == this->cells.end()) return;
+
+  this->cellVerts.clear();
+  cell.GetVertices(this->cellVerts);
+
+  if (this->Place(this->layersNormal,   iter->second.normal,   cell.GetTexture()))         this->updateCount++;
+  if (this->Place(this->layersEmissive, iter->second.emissive, cell.GetEmissiveTexture())) this->updateCount++;
+}
+
+/** Write the current cell vertices to a range, moving the range if the
+  * texture or the number of vertices changed.
+  * @param layers Layers in which the range lives.
+  * @param range The range.
+  * @param texture Texture with which the vertices are drawn.
+  * @return true if the vertices were written.
+  */
+bool
+DynamicMesh::Place(Layers &layers, Range &range, const Texture *texture) {
+  size_t count = texture ? this->cellVerts.size() : 0;
+  size_t units = (count + verticesPerUnit - 1) / verticesPerUnit;
+
+  if (range.texture != texture || range.units != units) {
+    this->Release(layers, range);
+    if (units == 0) return false;
+
+    Layer &layer = layers[texture];
+    if (layer.freeRanges.size() <= units) layer.freeRanges.resize(units + 1);
+
+    std::vector<size_t> &freeRanges = layer.freeRanges[units];
+    if (freeRanges.empty()) {
+      range.first = layer.verts.GetCount();
+      layer.verts.Resize(range.first + units * verticesPerUnit);
+    } else {
+      range.first = freeRanges.back();
+      freeRanges.pop_back();
+    }
+
+    range.texture = texture;
+    range.units   = units;
+    range.count   = 0;
+    layer.usedUnits += units;
+  }
+
+  if (units == 0) return false;
+
+  Layer &layer = layers.at(texture);
+
+  // nothing to do if the vertices are unchanged
+  if (range.count == count && memcmp(layer.verts.GetData() + range.first, this->cellVerts.data(), sizeof(Vertex) * count) == 0) {
+    return false;
+  }
+
+  layer.verts.Update(range.first, this->cellVerts.data(), count);
+  if (range.count > count) layer.verts.Zero(range.first + count, range.count - count);
+  range.count = count;
+  return true;
+}
+
+/** Give up a range. Its vertices are zeroed so they are no longer drawn.
+  * @param layers Layers in which the range lives.
+  * @param range The range.
+  */
+void
+DynamicMesh::Release(Layers &layers, Range &range) {
+  if (range.units == 0) return;
+
+  Layer &layer = layers.at(range.texture);
+  layer.verts.Zero(range.first, range.units * verticesPerUnit);
+  layer.freeRanges[range.units].push_back(range.first);
+  layer.usedUnits -= range.units;
+
+  // start over when a layer is no longer used at all
+  if (layer.usedUnits == 0) {
+    layer.verts.Resize(0);
+    layer.freeRanges.clear();
+  }
+
+  range = Range();
+}
+
+void
+DynamicMesh::Draw(Gfx &gfx, Layers &layers) {
+  for (auto &iter : layers) {
+    if (!iter.second.usedUnits) continue;
+
+    gfx.SetTextureFrame(iter.first);
+    gfx.DrawTriangles(iter.second.verts);
+  }
+}
@@ -0,0 +1,76 @@
+#ifndef BARFOOS_DYNAMICMESH_H
+#define BARFOOS_DYNAMICMESH_H
+
+#include "gfx/vertex.h"
+#include "gfx/vertexbuffer.h"
+
+/** Persistent geometry of the dynamic cells of a world.
+  * Each cell owns a fixed range of vertices in one buffer per texture. The
+  * geometry of all cells is recreated every frame, but only ranges whose
+  * vertices actually changed are written and uploaded again.
+  */
+class DynamicMesh final {
+public:
+
+                            DynamicMesh         ();
+                            DynamicMesh         (const DynamicMesh &) = delete;
+
+  DynamicMesh &             operator=           (const DynamicMesh &) = delete;
+
+  void                      SetCells            (const std::vector<size_t> &cells);
+  void                      Update              (const World &world, const std::vector<size_t> &cells);
+
+  void                      DrawNormal          (Gfx &gfx);
+  void                      DrawEmissive        (Gfx &gfx);
+
+  size_t                    GetUpdateCount      ()                                        const { return this->updateCount; }
+
+private:
+
+  /** Ranges are allocated in multiples of one side of a cell. */
+  static constexpr size_t   verticesPerUnit = 6;
+
+  /** Vertex buffer for one texture. */
+  struct Layer {
+    VertexBuffer                      verts;
+
+    /** Free ranges by size in units. */
+    std::vector<std::vector<size_t>>  freeRanges;
+
+    /** Number of units in use. */
+    size_t                            usedUnits = 0;
+  };
+
+  typedef std::unordered_map<const Texture *, Layer> Layers;
+
+  /** A range of vertices in a layer. */
+  struct Range {
+    const Texture * texture = nullptr;
+    size_t          first   = 0;
+    size_t          units   = 0;
+    size_t          count   = 0;
+  };
+
+  struct CellRanges {
+    Range  normal;
+    Range  emissive;
+    size_t stamp = 0;
+  };
+
+  Layers                    layersNormal;
+  Layers                    layersEmissive;
+
+  std::unordered_map<size_t, CellRanges> cells;
+  size_t                    stamp;
+
+  std::vector<Vertex>       cellVerts;
+  size_t                    updateCount;
+
+  void                      UpdateCell          (const Cell &cell);
+  bool                      Place               (Layers &layers, Range &range, const Texture *texture);
+  void                      Release             (Layers &layers, Range &range);
+  void                      Draw                (Gfx &gfx, Layers &layers);
+};
+
+#endif
+
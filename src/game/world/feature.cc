@@ -9,6 +9,7 @@
 #include "math/random.h"
 #include "math/simplex.h"
 #include "util/weighted_map.h"
+#include "util/workerpool.h"
 
 #include <unordered_map>
 
@@ -39,6 +40,7 @@ Feature::Feature() :
   groups(),
   defaultMask(0),
   chars(0),
+  footprint(),
   size(0,0,0),
   minLevel(0),
   maxLevel(0),
@@ -57,6 +59,7 @@ Feature::Feature(FILE *f, const std::string &name) :
   groups(),
   defaultMask(0),
   chars(0),
+  footprint(),
   size(0,0,0),
   minLevel(0),
   maxLevel(-1),
@@ -195,6 +198,8 @@ Feature::Feature(FILE *f, const std::string &name) :
       Log("Ignoring unknown feature property: %s\n", tokens[0].c_str());
     }
   }
+
+  this->CompileFootprint();
 }
 
 Feature::~Feature() {
@@ -217,17 +222,32 @@ float Feature::GetProbability(const RunningState &state, const IVector3 &pos) co
 
 FeatureInstance Feature::BuildFeature(RunningState &state, World &world, const IVector3 &pos, int dir, int dist, ID id, const FeatureConnection *conn, ID prevId) const {
   if (this->useLastId) id = prevId;
+
+  // the noise only depends on the position, evaluate it for one slice of
+  // the feature per job before any cell is set
+  std::vector<CellShape> shapes;
+  if (this->UsesNoise()) {
+    shapes.resize(this->chars.size());
+    world.GetWorkerPool().Run(size.z, [&](size_t z) {
+      for (size_t y=0; y<size.y; y++) {
+        for (size_t x=0; x<size.x; x++) {
+          size_t index = x+size.x*(y+size.y*z);
+          shapes[index] = this->MakeShape(defs.at(chars[index]), pos+IVector3(x,y,z));
+        }
+      }
+    });
+  }
   
   for (size_t z=0; z<size.z; z++) {
     for (size_t y=0; y<size.y; y++) {
       for (size_t x=0; x<size.x; x++) { 
-        if (defaultMask[x+size.x*(y+size.y*z)] && world.IsChecking()) continue;
         if (defaultMask[x+size.x*(y+size.y*z)] && !world.IsDefault(pos+IVector3(x,y,z))) continue;
         
-        char ch = chars[x+size.x*(y+size.y*z)];
+        size_t index = x+size.x*(y+size.y*z);
+        char ch = chars[index];
         const FeatureCharDef &def = defs.at(ch);
 
-        Cell cell(this->MakeCell(def, IVector3(x,y,z) + pos));
+        Cell cell(shapes.empty() ? this->MakeCell(def, IVector3(x,y,z) + pos) : this->MakeCell(def, shapes[index]));
         world.SetCell(pos+IVector3(x,y,z), cell).SetFeatureID(id);
       }
     }
@@ -240,7 +260,7 @@ FeatureInstance Feature::BuildFeature(RunningState &state, World &world, const I
   // lock doors
   if (id > 1)
   size.For([&](const IVector3 &xyz) {
-    Cell &cell = world.GetCell(pos+xyz);
+    Cell cell = world.GetCell(pos+xyz);
     if (cell.GetInfo().lockedChance && state.GetRandom().Chance(cell.GetInfo().lockedChance)) {
       state.LockCell(cell);
     }
@@ -249,30 +269,58 @@ FeatureInstance Feature::BuildFeature(RunningState &state, World &world, const I
   return FeatureInstance(this, pos, dir, dist+1, id);
 }
 
-Cell Feature::MakeCell(const FeatureCharDef &def, const IVector3 &pos) const {
+void Feature::CompileFootprint() {
+  footprint.wordsPerRow = (size.x + 63) / 64;
+  footprint.rows.assign(footprint.wordsPerRow * size.y * size.z, 0);
+
+  for (size_t z=0; z<size.z; z++) {
+    for (size_t y=0; y<size.y; y++) {
+      for (size_t x=0; x<size.x; x++) {
+        if (defaultMask[x+size.x*(y+size.y*z)]) continue;
+        footprint.rows[(y+size.y*z)*footprint.wordsPerRow + x/64] |= uint64_t(1) << (x%64);
+      }
+    }
+  }
+}
+
+bool Feature::UsesNoise() const {
+  for (auto &def : defs) {
+    if (def.second.topNoise != 0.0f || def.second.topDisplace != 0.0f) return true;
+    if (def.second.bottomNoise != 0.0f || def.second.bottomDisplace != 0.0f) return true;
+  }
+  return false;
+}
+
+CellShape Feature::MakeShape(const FeatureCharDef &def, const IVector3 &pos) const {
+  static const Vector3 corners[4] = { Vector3(0,0,0), Vector3(0,0,1), Vector3(1,0,1), Vector3(1,0,0) };
+
   Vector3 vpos = Vector3(pos);
+  CellShape shape;
+
+  // most cells have no noise at all, don't evaluate what isn't used
+  float dispT = def.topDisplace    != 0.0f ? simplexNoise( vpos + 0.5 ) * def.topDisplace    : 0.0f;
+  float dispB = def.bottomDisplace != 0.0f ? simplexNoise( vpos + 0.5 ) * def.bottomDisplace : 0.0f;
+
+  for (size_t i=0; i<4; i++) {
+    float ofsT = def.topNoise    != 0.0f ? def.topNoise    * simplexNoise( (vpos + corners[i]) * def.topFreq    ) + dispT : dispT;
+    float ofsB = def.bottomNoise != 0.0f ? def.bottomNoise * simplexNoise( (vpos + corners[i]) * def.bottomFreq ) + dispB : dispB;
+
+    shape.top[i]    = def.top[i] + ofsT;
+    shape.bottom[i] = def.bot[i] + ofsB;
+  }
+
+  return shape;
+}
+
+Cell Feature::MakeCell(const FeatureCharDef &def, const IVector3 &pos) const {
+  return this->MakeCell(def, this->MakeShape(def, pos));
+}
+
+Cell Feature::MakeCell(const FeatureCharDef &def, const CellShape &shape) const {
   Cell cell(def.type);
-      
-  float dispT = simplexNoise( vpos + 0.5 ) * def.topDisplace;
-      
-  float ofsT[4] = {
-    def.topNoise * simplexNoise( (vpos                  ) * def.topFreq ) + dispT,
-    def.topNoise * simplexNoise( (vpos + Vector3(0,0,1) ) * def.topFreq ) + dispT,
-    def.topNoise * simplexNoise( (vpos + Vector3(1,0,1) ) * def.topFreq ) + dispT,
-    def.topNoise * simplexNoise( (vpos + Vector3(1,0,0) ) * def.topFreq ) + dispT
-  };
-      
-  float dispB = simplexNoise( vpos + 0.5 ) * def.bottomDisplace;
-      
-  float ofsB[4] = {
-    def.bottomNoise * simplexNoise( (vpos                  ) * def.bottomFreq ) + dispB,
-    def.bottomNoise * simplexNoise( (vpos + Vector3(0,0,1) ) * def.bottomFreq ) + dispB,
-    def.bottomNoise * simplexNoise( (vpos + Vector3(1,0,1) ) * def.bottomFreq ) + dispB,
-    def.bottomNoise * simplexNoise( (vpos + Vector3(1,0,0) ) * def.bottomFreq ) + dispB
-  };
-      
-  cell.SetTopHeights(def.top[0]+ofsT[0],def.top[1]+ofsT[1],def.top[2]+ofsT[2],def.top[3]+ofsT[3]);
-  cell.SetBottomHeights(def.bot[0]+ofsB[0],def.bot[1]+ofsB[1],def.bot[2]+ofsB[2],def.bot[3]+ofsB[3]);
+
+  cell.SetTopHeights(shape.top[0],shape.top[1],shape.top[2],shape.top[3]);
+  cell.SetBottomHeights(shape.bottom[0],shape.bottom[1],shape.bottom[2],shape.bottom[3]);
   cell.SetReversed(def.topRev, def.botRev);
   cell.SetProtected(def.lockCell);
   cell.SetIgnoringProtection(def.ignoreLock);
@@ -406,18 +454,29 @@ void FeatureConnection::Resolve() {
 const Feature *FeatureConnection::GetRandomFeature(RunningState &state, const IVector3 &pos) const {
   if (nextFeatures.empty()) return nullptr;
   
-  weighted_map<const Feature *> wm;
+  // go through the features in the order of their names, so the same seed
+  // selects the same feature no matter where the features are in memory
+  std::vector<std::pair<const Feature *, float>> totals;
+  float total = 0;
   
-  for (auto fname : nextFeatures) {
+  for (auto &fname : nextFeatures) {
     const Feature *f = getFeature(fname.first);
     if (!f) continue;
     float w = std::abs(f->GetProbability(state, pos+this->pos)*fname.second);
     if (w <= 0.0) continue;
     
-    wm[f] = w;
+    total += w;
+    totals.push_back(std::make_pair(f, total));
   }
   
-  const Feature *feature = wm.select(state.GetRandom().Float01());
+  float index = state.GetRandom().Float01() * total;
+  const Feature *feature = nullptr;
+  for (auto &t : totals) {
+    if (index < t.second) {
+      feature = t.first;
+      break;
+    }
+  }
   if (!feature) return nullptr;
   
   size_t variant = state.GetRandom().Integer(4);
@@ -509,6 +568,8 @@ Feature::Rotate() {
   for (auto &def:feature.defs) {
     def.second.Rotate();
   }
+
+  feature.CompileFootprint();
   return feature;
 }
 
@@ -103,6 +103,17 @@ struct FeatureCharDef {
   }
 };
 
+/** Cells a feature writes wherever it is built, that is all cells except
+  * those only written over default cells. One bit per cell, in rows along x
+  * ordered by y, then z.
+  */
+struct FeatureFootprint {
+  size_t wordsPerRow = 0;
+  std::vector<uint64_t> rows;
+
+  const uint64_t *GetRow(size_t y, size_t z, size_t sizeY) const { return &rows[(y + sizeY * z) * wordsPerRow]; }
+};
+
 class Feature final {
 public:
   Feature();
@@ -110,6 +121,7 @@ public:
   ~Feature();
   
   const IVector3 &GetSize() const { return size; }
+  const FeatureFootprint &GetFootprint() const { return footprint; }
 
   float GetProbability(const RunningState &state, const IVector3 &pos) const;
   FeatureInstance BuildFeature(RunningState &state, World &world, const IVector3 &pos, int dir, int dist, ID id, const FeatureConnection *conn, ID prevId) const;
@@ -144,6 +156,7 @@ protected:
 
   std::vector<bool> defaultMask;
   std::vector<char> chars;
+  FeatureFootprint footprint;
   IVector3 size; 
   
   int minLevel, maxLevel;
@@ -154,7 +167,11 @@ protected:
   bool useLastId;
   bool noRotate;
   
+  void CompileFootprint();
+  bool UsesNoise() const;
+  CellShape MakeShape(const FeatureCharDef &def, const IVector3 &pos) const;
   Cell MakeCell(const FeatureCharDef &def, const IVector3 &pos) const;
+  Cell MakeCell(const FeatureCharDef &def, const CellShape &shape) const;
   void ReplaceChars(const FeatureReplacement &r, std::vector<char> &chars) const;
   
   friend void LoadFeatures();
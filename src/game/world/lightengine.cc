@@ -0,0 +1,253 @@
+#include "common.h"
+
+#include "game/world/lightengine.h"
+#include "game/world/world.h"
+#include "util/workerpool.h"
+
+/** C'tor.
+  * @param world World whose light planes are updated.
+  */
+LightEngine::LightEngine(World &world) :
+  world(world),
+  addQueue(),
+  addHead(),
+  removeQueue(),
+  removeHead(),
+  touched(),
+  touchedCount(0),
+  lastTouchedCount(0)
+{
+}
+
+/** Notify the engine that the type or shape of a cell has changed.
+  * The light of the cell is removed and then refilled from the cell itself
+  * and its neighbours.
+  * @param i Index of the cell.
+  */
+void
+LightEngine::CellChanged(size_t i) {
+  for (size_t c=0; c<3; c++) {
+    std::vector<uint8_t> &plane = this->GetPlane(c);
+    uint8_t level = plane[i];
+
+    if (level) {
+      plane[i] = 0;
+      this->Touch(i);
+      this->Remove(c, i, level);
+    }
+
+    // let neighbours shine into the cell again
+    for (size_t s=0; s<6; s++) {
+      size_t n;
+      if (this->GetNeighbour(i, s, n) && plane[n]) this->Add(c, n);
+    }
+
+    uint8_t emission = this->GetEmission(i, c);
+    if (emission) {
+      plane[i] = emission;
+      this->Touch(i);
+      this->Add(c, i);
+    }
+  }
+}
+
+/** Propagate queued light changes. Without a limit the color channels
+  * don't depend on each other and are propagated in parallel.
+  * @param maxSteps Maximum number of cells to process, 0 for no limit.
+  * @return Number of cells processed.
+  */
+size_t
+LightEngine::Update(size_t maxSteps) {
+  PROFILE();
+
+  size_t steps = 0;
+
+  if (maxSteps) {
+    for (size_t c=0; c<3; c++) {
+      if (!this->UpdateChannel(c, maxSteps, steps)) break;
+    }
+  } else {
+    size_t channelSteps[3] = { 0, 0, 0 };
+    this->world.GetWorkerPool().Run(3, [&](size_t c) {
+      this->UpdateChannel(c, 0, channelSteps[c]);
+    });
+    steps = channelSteps[0] + channelSteps[1] + channelSteps[2];
+  }
+
+  // mark the chunks in the same order as if the channels were done one
+  // after the other
+  for (size_t c=0; c<3; c++) {
+    for (size_t i : this->touched[c]) {
+      this->Touch(i);
+    }
+    this->touched[c].clear();
+  }
+
+  if (this->touchedCount && this->IsSettled()) {
+    Log("light change touched %u cells\n", this->touchedCount);
+    this->lastTouchedCount = this->touchedCount;
+    this->touchedCount = 0;
+  }
+
+  return steps;
+}
+
+/** Propagate the queued light changes of one color channel. Only writes
+  * the light plane and queues of the channel.
+  * @param channel Color channel.
+  * @param maxSteps Maximum number of cells to process, 0 for no limit.
+  * @param[in,out] steps Number of cells processed so far.
+  * @return false if the limit was reached before the channel was done.
+  */
+bool
+LightEngine::UpdateChannel(size_t channel, size_t maxSteps, size_t &steps) {
+  size_t c = channel;
+  std::vector<uint8_t> &plane = this->GetPlane(c);
+
+  // clear removed light first, it hands its borders to the add queue
+  while(this->removeHead[c] < this->removeQueue[c].size()) {
+    if (maxSteps && steps >= maxSteps) return false;
+    steps++;
+
+    RemoveNode node = this->removeQueue[c][this->removeHead[c]++];
+
+    for (size_t s=0; s<6; s++) {
+      size_t n;
+      if (!this->GetNeighbour(node.index, s, n)) continue;
+
+      uint8_t level = plane[n];
+      if (!level) continue;
+
+      if (level <= this->PassThrough(n, node.level)) {
+        // light may have come from the removed cell
+        plane[n] = this->GetEmission(n, c);
+        this->touched[c].push_back(n);
+        this->Remove(c, n, level);
+        if (plane[n]) this->Add(c, n);
+      } else {
+        // lit from somewhere else, refill the cleared area from here
+        this->Add(c, n);
+      }
+    }
+  }
+  this->removeQueue[c].clear();
+  this->removeHead[c] = 0;
+
+  while(this->addHead[c] < this->addQueue[c].size()) {
+    if (maxSteps && steps >= maxSteps) return false;
+    steps++;
+
+    size_t i = this->addQueue[c][this->addHead[c]++];
+    uint8_t level = plane[i];
+    if (!level) continue;
+
+    for (size_t s=0; s<6; s++) {
+      size_t n;
+      if (!this->GetNeighbour(i, s, n)) continue;
+      if (!this->IsTransparent(n)) continue;
+
+      uint8_t passed = this->PassThrough(n, level);
+      if (passed > plane[n]) {
+        plane[n] = passed;
+        this->touched[c].push_back(n);
+        this->Add(c, n);
+      }
+    }
+  }
+  this->addQueue[c].clear();
+  this->addHead[c] = 0;
+
+  return true;
+}
+
+/** Check whether all light changes have been propagated.
+  * @return true if nothing is left to do.
+  */
+bool
+LightEngine::IsSettled() const {
+  for (size_t c=0; c<3; c++) {
+    if (this->addHead[c] < this->addQueue[c].size()) return false;
+    if (this->removeHead[c] < this->removeQueue[c].size()) return false;
+  }
+  return true;
+}
+
+std::vector<uint8_t> &
+LightEngine::GetPlane(size_t channel) {
+  switch(channel) {
+    case 0:  return this->world.cells.lightR;
+    case 1:  return this->world.cells.lightG;
+    default: return this->world.cells.lightB;
+  }
+}
+
+/** Get the light emitted by a cell.
+  * @param i Index of the cell.
+  * @param channel Color channel.
+  * @return Emitted light, only transparent cells emit light.
+  */
+uint8_t
+LightEngine::GetEmission(size_t i, size_t channel) const {
+  if (!this->IsTransparent(i)) return 0;
+
+  IColor light = GetCellProperties(this->world.cells.types[i]).light.Saturate();
+  switch(channel) {
+    case 0:  return light.r;
+    case 1:  return light.g;
+    default: return light.b;
+  }
+}
+
+/** Find the neighbour of a cell.
+  * @param i Index of the cell.
+  * @param side Side of the neighbour.
+  * @param[out] n Index of the neighbour.
+  * @return false if the neighbour is outside the world.
+  */
+bool
+LightEngine::GetNeighbour(size_t i, size_t side, size_t &n) const {
+  IVector3 pos = this->world.GetCellPos(i)[(Side)side];
+  if (!this->world.IsValidCellPosition(pos)) return false;
+
+  n = this->world.GetCellIndex(pos);
+  return true;
+}
+
+bool
+LightEngine::IsTransparent(size_t i) const {
+  return this->world.GetCell(i).IsTransparent();
+}
+
+/** Get the light left after passing into a cell.
+  * @param i Index of the cell.
+  * @param level Light level of the neighbour.
+  * @return Light level in the cell.
+  */
+uint8_t
+LightEngine::PassThrough(size_t i, uint8_t level) const {
+  const CellProperties &info = GetCellProperties(this->world.cells.types[i]);
+
+  int passed = (int16_t)(level * info.lightFactor);
+  passed = passed < info.lightFade ? 0 : passed - info.lightFade;
+  return passed > 255 ? 255 : passed;
+}
+
+void
+LightEngine::Add(size_t channel, size_t i) {
+  this->addQueue[channel].push_back(i);
+}
+
+void
+LightEngine::Remove(size_t channel, size_t i, uint8_t level) {
+  this->removeQueue[channel].push_back(RemoveNode{ i, level });
+}
+
+/** Remember that the light of a cell changed and its geometry needs to be
+  * rebuilt.
+  * @param i Index of the cell.
+  */
+void
+LightEngine::Touch(size_t i) {
+  this->touchedCount++;
+  this->world.MarkChunksDirty(this->world.GetCellPos(i));
+}
@@ -0,0 +1,58 @@
+#ifndef BARFOOS_LIGHTENGINE_H
+#define BARFOOS_LIGHTENGINE_H
+
+#include "common.h"
+
+/** Flood fill light propagation over the light planes of a world.
+  * Each color channel is propagated separately. Brighter light spreads
+  * through an add queue, removed light is cleared through a remove queue
+  * which hands the borders of the cleared area back to the add queue.
+  */
+class LightEngine final {
+public:
+
+                            LightEngine         (World &world);
+                            LightEngine         (const LightEngine &) = delete;
+
+  LightEngine &             operator=           (const LightEngine &) = delete;
+
+  void                      CellChanged         (size_t i);
+  size_t                    Update              (size_t maxSteps = 0);
+
+  bool                      IsSettled           ()                                        const;
+  size_t                    GetLastTouchedCount ()                                        const { return this->lastTouchedCount; }
+
+private:
+
+  struct RemoveNode {
+    size_t  index;
+    uint8_t level;
+  };
+
+  World &                   world;
+
+  std::vector<size_t>       addQueue[3];
+  size_t                    addHead[3];
+  std::vector<RemoveNode>   removeQueue[3];
+  size_t                    removeHead[3];
+
+  /** Cells whose light changed during an update, one list per channel so
+    * the channels can be propagated in parallel. */
+  std::vector<size_t>       touched[3];
+  size_t                    touchedCount;
+  size_t                    lastTouchedCount;
+
+  std::vector<uint8_t> &    GetPlane            (size_t channel);
+  uint8_t                   GetEmission         (size_t i, size_t channel)                const;
+  bool                      GetNeighbour        (size_t i, size_t side, size_t &n)        const;
+  bool                      IsTransparent       (size_t i)                                const;
+  uint8_t                   PassThrough         (size_t i, uint8_t level)                 const;
+
+  bool                      UpdateChannel       (size_t channel, size_t maxSteps, size_t &steps);
+  void                      Add                 (size_t channel, size_t i);
+  void                      Remove              (size_t channel, size_t i, uint8_t level);
+  void                      Touch               (size_t i);
+};
+
+#endif
+
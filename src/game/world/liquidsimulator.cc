@@ -0,0 +1,107 @@
+#include "common.h"
+
+#include "game/world/liquidsimulator.h"
+#include "game/world/world.h"
+
+constexpr uint8_t LiquidSimulator::sleepTicks;
+
+/** C'tor.
+  * @param world World whose liquids are simulated.
+  */
+LiquidSimulator::LiquidSimulator(World &world) :
+  world(world),
+  awake(),
+  active(),
+  ticking()
+{
+}
+
+/** Wake up a cell, so that it is ticked again.
+  * @param i Index of the cell.
+  */
+void
+LiquidSimulator::Wake(size_t i) {
+  if (!this->IsSimulated(i)) return;
+
+  if (!this->awake[i]) this->active.push_back(i);
+  this->awake[i] = sleepTicks;
+}
+
+/** Wake up a cell and its neighbours after it changed.
+  * @param i Index of the cell.
+  */
+void
+LiquidSimulator::WakeAround(size_t i) {
+  this->Wake(i);
+
+  IVector3 pos = this->world.GetCellPos(i);
+  for (size_t s=0; s<6; s++) {
+    IVector3 n = pos[(Side)s];
+    if (this->world.IsValidCellPosition(n)) this->Wake(this->world.GetCellIndex(n));
+  }
+}
+
+/** Wake up all cells, for example after the world was created or loaded. */
+void
+LiquidSimulator::WakeAll() {
+  this->awake.assign(this->world.GetCellCount(), 0);
+  this->active.clear();
+
+  // look up each cell type only once
+  std::vector<bool> simulated(GetCellTypeCount());
+  for (size_t t=0; t<simulated.size(); t++) {
+    simulated[t] = IsSimulated(GetCellProperties(t));
+  }
+
+  const std::vector<uint16_t> &types = this->world.cells.types;
+  for (size_t i=0; i<this->world.GetCellCount(); i++) {
+    if (!simulated[types[i]]) continue;
+
+    this->active.push_back(i);
+    this->awake[i] = sleepTicks;
+  }
+}
+
+/** Tick all awake cells.
+  * @param state Running state.
+  */
+void
+LiquidSimulator::Tick(RunningState &state) {
+  PROFILE();
+
+  // cells woken during this tick are ticked in the next one
+  std::swap(this->active, this->ticking);
+
+  for (size_t i : this->ticking) {
+    if (!this->IsSimulated(i)) {
+      // cell was turned into something else
+      this->awake[i] = 0;
+      continue;
+    }
+
+    if (this->world.GetCell(i).Tick(state)) {
+      this->awake[i] = sleepTicks;
+    } else {
+      this->awake[i]--;
+    }
+
+    if (this->awake[i]) this->active.push_back(i);
+  }
+
+  PROFILE_COUNT("LiquidSimulator::Tick / ticked cells", this->ticking.size());
+  this->ticking.clear();
+}
+
+/** Check whether a cell type needs to be ticked.
+  * @param i Index of the cell.
+  * @return true for liquids and cells that may replace themselves.
+  */
+bool
+LiquidSimulator::IsSimulated(size_t i) const {
+  return IsSimulated(GetCellProperties(this->world.cells.types[i]));
+}
+
+bool
+LiquidSimulator::IsSimulated(const CellProperties &info) {
+  return (info.flags & CellFlags::Liquid) || (info.detailBelowReplace && !info.replace.IsEmpty());
+}
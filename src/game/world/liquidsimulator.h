@@ -0,0 +1,46 @@
+#ifndef BARFOOS_LIQUIDSIMULATOR_H
+#define BARFOOS_LIQUIDSIMULATOR_H
+
+#include "common.h"
+
+/** Ticks the liquid cells of a world that are still moving.
+  * Cells that did not change for a while fall asleep and are no longer
+  * ticked until they or one of their neighbours change.
+  */
+class LiquidSimulator final {
+public:
+
+                            LiquidSimulator     (World &world);
+                            LiquidSimulator     (const LiquidSimulator &) = delete;
+
+  LiquidSimulator &         operator=           (const LiquidSimulator &) = delete;
+
+  void                      Wake                (size_t i);
+  void                      WakeAround          (size_t i);
+  void                      WakeAll             ();
+
+  void                      Tick                (RunningState &state);
+
+  size_t                    GetActiveCount      ()                                        const { return this->active.size(); }
+
+private:
+
+  /** Number of ticks without a change after which a cell falls asleep. Must
+    * be larger than the tick interval of viscous liquids. */
+  static constexpr uint8_t  sleepTicks = 64;
+
+  World &                   world;
+
+  /** Ticks left until a cell falls asleep, 0 if it is asleep. */
+  std::vector<uint8_t>      awake;
+
+  /** Awake cells, the current tick is swapped out before it runs. */
+  std::vector<size_t>       active;
+  std::vector<size_t>       ticking;
+
+  bool                      IsSimulated         (size_t i)                                const;
+  static bool               IsSimulated         (const CellProperties &info);
+};
+
+#endif
+
@@ -0,0 +1,199 @@
+#include "common.h"
+
+#include "game/world/cells/cell.h"
+#include "game/world/meshbuilder.h"
+
+/** C'tor.
+  * @param threadCount Number of worker threads, 0 to use one less than the
+  *                    number of cores (but at least one).
+  */
+MeshBuilder::MeshBuilder(size_t threadCount) :
+  threads(),
+  jobMutex(),
+  jobCondition(),
+  jobs(),
+  quit(false),
+  finished(nullptr),
+  pendingCount(0)
+{
+  if (threadCount == 0) {
+    size_t cores = std::thread::hardware_concurrency();
+    threadCount = cores > 1 ? cores - 1 : 1;
+  }
+
+  for (size_t i=0; i<threadCount; i++) {
+    this->threads.push_back(std::thread(&MeshBuilder::Run, this));
+  }
+}
+
+MeshBuilder::~MeshBuilder() {
+  {
+    std::lock_guard<std::mutex> lock(this->jobMutex);
+    this->quit = true;
+  }
+  this->jobCondition.notify_all();
+
+  for (auto &thread : this->threads) {
+    thread.join();
+  }
+
+  ChunkMesh *mesh = this->FetchFinished();
+  while(mesh) {
+    ChunkMesh *next = mesh->next;
+    delete mesh;
+    mesh = next;
+  }
+}
+
+/** Queue a chunk for building. The cells around the chunk are copied
+  * right away, so the world can be changed while the chunk is built.
+  * @param chunk Index of the chunk.
+  * @param generation Build number of the chunk.
+  * @param cells Cells of the world.
+  * @param worldSize Size of the world.
+  * @param origin Position of the first cell in the chunk.
+  * @param size Size of the chunk.
+  * @param time Game time for texture animation.
+  */
+void
+MeshBuilder::Build(
+  size_t chunk,
+  size_t generation,
+  const CellStore &cells,
+  const IVector3 &worldSize,
+  const IVector3 &origin,
+  const IVector3 &size,
+  float time
+) {
+  Job *job = new Job();
+  job->chunk      = chunk;
+  job->generation = generation;
+  job->origin     = origin;
+  job->size       = size;
+  job->worldSize  = worldSize;
+
+  // cell geometry depends on the direct neighbours, so copy one more
+  // cell on each side
+  IVector3 regionOrigin(origin.x - 1, origin.y - 1, origin.z - 1);
+  IVector3 regionSize(size.x + 2, size.y + 2, size.z + 2);
+  job->region.CopyRegion(cells, worldSize, regionOrigin, regionSize);
+  job->region.regionTime = time;
+
+  this->pendingCount++;
+  {
+    std::lock_guard<std::mutex> lock(this->jobMutex);
+    this->jobs.push_back(std::unique_ptr<Job>(job));
+  }
+  this->jobCondition.notify_one();
+}
+
+/** Take all finished meshes.
+  * @return A list of meshes linked by ChunkMesh::next, or nullptr. The
+  *         caller owns the meshes.
+  */
+ChunkMesh *
+MeshBuilder::FetchFinished() {
+  ChunkMesh *meshes = this->finished.exchange(nullptr);
+
+  for (ChunkMesh *mesh = meshes; mesh; mesh = mesh->next) {
+    this->pendingCount--;
+  }
+  return meshes;
+}
+
+/** Worker thread main loop. */
+void
+MeshBuilder::Run() {
+  while(true) {
+    std::unique_ptr<Job> job;
+    {
+      std::unique_lock<std::mutex> lock(this->jobMutex);
+      this->jobCondition.wait(lock, [this]{ return this->quit || !this->jobs.empty(); });
+      if (this->quit) return;
+
+      job = std::move(this->jobs.front());
+      this->jobs.pop_front();
+    }
+
+    ChunkMesh *mesh = new ChunkMesh();
+    mesh->chunk      = job->chunk;
+    mesh->generation = job->generation;
+    BuildMesh(job->region, job->origin, job->size, job->worldSize, *mesh);
+
+    // push onto finished list
+    mesh->next = this->finished.load();
+    while(!this->finished.compare_exchange_weak(mesh->next, mesh)) {}
+  }
+}
+
+/** Create the static geometry of a chunk and find its visible dynamic cells.
+  * @param region Copy of the cells around the chunk.
+  * @param origin Position of the first cell in the chunk.
+  * @param size Size of the chunk.
+  * @param worldSize Size of the world.
+  * @param[out] mesh The result.
+  */
+void
+MeshBuilder::BuildMesh(
+  const CellStore &region,
+  const IVector3 &origin,
+  const IVector3 &size,
+  const IVector3 &worldSize,
+  ChunkMesh &mesh
+) {
+  std::unordered_map<const Texture *, std::vector<Vertex>> verticesNormal;
+  std::unordered_map<const Texture *, std::vector<Vertex>> verticesEmissive;
+
+  std::vector<Vertex> cellVerts;
+  CellStore *cells = const_cast<CellStore *>(&region);
+
+  for (size_t z=origin.z; z<origin.z+size.z; z++) {
+    for (size_t y=origin.y; y<origin.y+size.y; y++) {
+      for (size_t x=origin.x; x<origin.x+size.x; x++) {
+        IVector3 pos(x,y,z);
+        size_t i = region.GetRegionIndex(pos);
+
+        // don't bother with invisible cells
+        if (!region.visibility[i]) continue;
+
+        Cell cell(cells, nullptr, i, pos);
+        const CellProperties &info = cell.GetInfo();
+        if (info.flags & CellFlags::DoNotRender) continue;
+
+        // don't add dynamic cells to static vertex buffer
+        if (cell.IsDynamic()) {
+          mesh.dynamicCells.push_back(x + worldSize.x * (y + worldSize.y * z));
+          continue;
+        }
+
+        cellVerts.clear();
+        cell.GetVertices(cellVerts);
+
+        // group vertex buffers by texture
+        const Texture *tex = cell.GetTexture();
+        if (tex) for (auto &v:cellVerts) verticesNormal[tex].push_back(v);
+
+        const Texture *etex = cell.GetEmissiveTexture();
+        if (etex) for (auto &v:cellVerts) verticesEmissive[etex].push_back(v);
+      }
+    }
+  }
+
+  size_t index = 0;
+
+  for (auto &iter : verticesNormal) {
+    mesh.vertexStartsNormal[iter.first] = index;
+    mesh.vertexCountsNormal[iter.first] = iter.second.size();
+    index += iter.second.size();
+
+    mesh.verts.insert(mesh.verts.end(), iter.second.begin(), iter.second.end());
+  }
+
+  for (auto &iter : verticesEmissive) {
+    mesh.vertexStartsEmissive[iter.first] = index;
+    mesh.vertexCountsEmissive[iter.first] = iter.second.size();
+    index += iter.second.size();
+
+    mesh.verts.insert(mesh.verts.end(), iter.second.begin(), iter.second.end());
+  }
+}
@@ -0,0 +1,82 @@
+#ifndef BARFOOS_MESHBUILDER_H
+#define BARFOOS_MESHBUILDER_H
+
+#include "game/world/cells/cellstore.h"
+#include "gfx/vertex.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+/** Static geometry of a chunk, built by a MeshBuilder. */
+struct ChunkMesh final {
+  /** Index of the chunk in the world. */
+  size_t chunk = 0;
+
+  /** Build number, results of older builds of the same chunk are dropped. */
+  size_t generation = 0;
+
+  std::vector<Vertex> verts;
+  std::unordered_map<const Texture *, size_t> vertexStartsNormal;
+  std::unordered_map<const Texture *, size_t> vertexCountsNormal;
+  std::unordered_map<const Texture *, size_t> vertexStartsEmissive;
+  std::unordered_map<const Texture *, size_t> vertexCountsEmissive;
+
+  /** Visible dynamic cells in the chunk. */
+  std::vector<size_t> dynamicCells;
+
+  /** Next mesh in the finished queue. */
+  ChunkMesh *next = nullptr;
+};
+
+/** Pool of worker threads that build chunk geometry from copies of the
+  * cells around a chunk. Finished meshes are handed back through a lock
+  * free queue, so the render thread only has to upload them.
+  */
+class MeshBuilder final {
+public:
+
+                            MeshBuilder         (size_t threadCount = 0);
+                            MeshBuilder         (const MeshBuilder &) = delete;
+                            ~MeshBuilder        ();
+
+  MeshBuilder &             operator=           (const MeshBuilder &) = delete;
+
+  void                      Build               (size_t chunk, size_t generation, const CellStore &cells,
+                                                 const IVector3 &worldSize, const IVector3 &origin,
+                                                 const IVector3 &size, float time);
+  ChunkMesh *               FetchFinished       ();
+  size_t                    GetPendingCount     ()                                        const { return this->pendingCount; }
+
+  static void               BuildMesh           (const CellStore &region, const IVector3 &origin,
+                                                 const IVector3 &size, const IVector3 &worldSize,
+                                                 ChunkMesh &mesh);
+
+private:
+
+  struct Job {
+    size_t    chunk;
+    size_t    generation;
+    IVector3  origin;
+    IVector3  size;
+    IVector3  worldSize;
+    CellStore region;
+  };
+
+  std::vector<std::thread>  threads;
+
+  std::mutex                jobMutex;
+  std::condition_variable   jobCondition;
+  std::deque<std::unique_ptr<Job>> jobs;
+  bool                      quit;
+
+  std::atomic<ChunkMesh *>  finished;
+  std::atomic<size_t>       pendingCount;
+
+  void                      Run                 ();
+};
+
+#endif
+
@@ -0,0 +1,352 @@
+#include "common.h"
+
+#include "game/world/navfield.h"
+#include "game/world/world.h"
+
+constexpr uint16_t NavField::Unreachable;
+constexpr uint8_t  NavField::ClearFlag;
+constexpr uint8_t  NavField::StandFlag;
+constexpr uint8_t  NavField::LadderFlag;
+constexpr uint8_t  NavField::NodeFlags;
+constexpr int      NavField::maxDrop;
+constexpr uint16_t NavField::maxDistance;
+
+/** Horizontal neighbours of a column. */
+static const int sideX[4] = { 1, -1, 0,  0 };
+static const int sideZ[4] = { 0,  0, 1, -1 };
+
+/** C'tor. Starts the worker thread.
+  * @param world World whose cells are navigated.
+  */
+NavField::NavField(const World &world) :
+  world(world),
+  size(),
+  flags(),
+  flagsValid(false),
+  dirty(true),
+  distances(),
+  sources(),
+  thread(),
+  mutex(),
+  condition(),
+  quit(false),
+  busy(false),
+  jobPending(false),
+  resultReady(false),
+  jobFlags(),
+  jobSources(),
+  jobDistances()
+{
+  this->thread = std::thread(&NavField::Run, this);
+}
+
+/** D'tor. Waits for the worker thread to finish. */
+NavField::~NavField() {
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->quit = true;
+  }
+  this->condition.notify_all();
+  this->thread.join();
+}
+
+/** Notify the field that a cell has changed. This updates the flags of the
+  * cell and the cells directly above and below it.
+  * @param pos Position of the cell.
+  */
+void
+NavField::CellChanged(const IVector3 &pos) {
+  if (!this->flagsValid) return;
+
+  for (int y=-1; y<=1; y++) {
+    IVector3 p(pos.x, pos.y + y, pos.z);
+    if (!this->IsValid(p)) continue;
+
+    uint8_t f = this->CalcFlags(p);
+    size_t i = this->GetIndex(p);
+    if (this->flags[i] != f) {
+      this->flags[i] = f;
+      this->dirty = true;
+    }
+  }
+}
+
+/** Recalculate the flags of all cells on the next update, for example
+  * after all cells have been replaced.
+  */
+void
+NavField::Invalidate() {
+  this->flagsValid = false;
+}
+
+/** Collect the result of the last search and start a new one if the sources
+  * or the cells have changed since.
+  * @param sources Positions of the cells to find the way to.
+  */
+void
+NavField::Update(const std::vector<IVector3> &sources) {
+  PROFILE();
+
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (this->resultReady) {
+      std::swap(this->distances, this->jobDistances);
+      this->resultReady = false;
+      this->busy = false;
+    }
+    if (this->busy) return;
+  }
+
+  // the worker reads the size while it searches, only touch it when idle
+  if (!this->flagsValid) {
+    PROFILE_NAMED("Build flags");
+
+    this->size = this->world.GetSize();
+    this->flags.resize(this->world.GetCellCount());
+
+    IVector3 p;
+    for (p.z=0; p.z<this->size.z; p.z++) {
+      for (p.y=0; p.y<this->size.y; p.y++) {
+        for (p.x=0; p.x<this->size.x; p.x++) {
+          this->flags[this->GetIndex(p)] = this->CalcFlags(p);
+        }
+      }
+    }
+
+    // the distances belong to the old cells
+    this->distances.clear();
+    this->flagsValid = true;
+    this->dirty = true;
+  }
+
+  if (!this->dirty && sources == this->sources) return;
+
+  this->sources    = sources;
+  this->jobSources = sources;
+  this->jobFlags   = this->flags;
+  this->dirty      = false;
+
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->busy       = true;
+    this->jobPending = true;
+  }
+  this->condition.notify_one();
+}
+
+/** Get the number of steps to the nearest source.
+  * @param feet Position of the feet of an entity.
+  * @return Number of steps or Unreachable.
+  */
+uint16_t
+NavField::GetDistance(const Vector3 &feet) const {
+  IVector3 node;
+  if (this->distances.empty() || !this->FindNode(this->flags, IVector3(feet), node)) return Unreachable;
+  return this->distances[this->GetIndex(node)];
+}
+
+/** Get the direction of the next step towards the nearest source.
+  * @param feet Position of the feet of an entity.
+  * @param[out] dir Offset from the feet to the center of the next node. A
+  *                 positive y component means the entity has to jump or
+  *                 climb.
+  * @return false if there is no way or the entity is already there.
+  */
+bool
+NavField::GetDirection(const Vector3 &feet, Vector3 &dir) const {
+  IVector3 from;
+  if (this->distances.empty() || !this->FindNode(this->flags, IVector3(feet), from)) return false;
+
+  uint16_t best = this->distances[this->GetIndex(from)];
+  if (best == Unreachable || best == 0) return false;
+
+  IVector3 bestNode = from;
+  auto consider = [&](const IVector3 &to) {
+    if (!this->IsValid(to)) return;
+
+    size_t i = this->GetIndex(to);
+    if (!(this->flags[i] & NodeFlags) || this->distances[i] >= best) return;
+    if (!this->IsEdge(this->flags, from, to)) return;
+
+    best     = this->distances[i];
+    bestNode = to;
+  };
+
+  consider(IVector3(from.x, from.y + 1, from.z));
+  consider(IVector3(from.x, from.y - 1, from.z));
+  for (size_t s=0; s<4; s++) {
+    for (int y=1; y>=-maxDrop; y--) {
+      consider(IVector3(from.x + sideX[s], from.y + y, from.z + sideZ[s]));
+    }
+  }
+
+  if (bestNode == from) return false;
+
+  dir = Vector3(
+    bestNode.x + 0.5f - feet.x,
+    float(bestNode.y) - float(from.y),
+    bestNode.z + 0.5f - feet.z
+  );
+  return true;
+}
+
+/** Get the flags of a cell from its own type and those of its neighbours
+  * above and below.
+  * @param pos Position of the cell.
+  * @return Flags of the cell.
+  */
+uint8_t
+NavField::CalcFlags(const IVector3 &pos) const {
+  auto cellFlags = [&](uint32_t y) -> uint32_t {
+    IVector3 p(pos.x, y, pos.z);
+    if (!this->world.IsValidCellPosition(p)) return CellFlags::Solid;
+    return GetCellProperties(this->world.cells.types[this->world.GetCellIndex(p)]).flags;
+  };
+
+  uint32_t here  = cellFlags(pos.y);
+  if (here & CellFlags::Solid) return 0;
+
+  uint32_t below = cellFlags(pos.y - 1);
+  uint32_t above = cellFlags(pos.y + 1);
+
+  // same as World::IsCellWalkable on the cell below
+  uint8_t f = ClearFlag;
+  if ((below & CellFlags::Solid) && !(here & CellFlags::Liquid) && !(above & (CellFlags::Solid | CellFlags::Liquid))) {
+    f |= StandFlag;
+  }
+  if (here & CellFlags::Ladder) f |= LadderFlag;
+  return f;
+}
+
+/** Find the node an entity is in. Entities on slopes or steps may have their
+  * feet a bit below or above the node.
+  * @param flags Cell flags.
+  * @param pos Position of the cell of the feet.
+  * @param[out] node Position of the node.
+  * @return false if there is no node near the position.
+  */
+bool
+NavField::FindNode(const std::vector<uint8_t> &flags, const IVector3 &pos, IVector3 &node) const {
+  for (int y : { 0, 1, -1 }) {
+    IVector3 p(pos.x, pos.y + y, pos.z);
+    if (this->IsValid(p) && (flags[this->GetIndex(p)] & NodeFlags)) {
+      node = p;
+      return true;
+    }
+  }
+  return false;
+}
+
+uint8_t
+NavField::GetFlags(const std::vector<uint8_t> &flags, int x, int y, int z) const {
+  IVector3 p(x, y, z);
+  if (!this->IsValid(p)) return 0;
+  return flags[this->GetIndex(p)];
+}
+
+/** Check whether an entity can get from one node to a neighbouring one.
+  * @param flags Cell flags.
+  * @param from Start node.
+  * @param to Target node.
+  * @return true if there is a way.
+  */
+bool
+NavField::IsEdge(const std::vector<uint8_t> &flags, const IVector3 &from, const IVector3 &to) const {
+  int dx = int(to.x) - int(from.x);
+  int dy = int(to.y) - int(from.y);
+  int dz = int(to.z) - int(from.z);
+
+  if (dx == 0 && dz == 0) {
+    // climb up or down a ladder, or jump onto one
+    if (dy ==  1) return (GetFlags(flags, from.x, from.y, from.z) | GetFlags(flags, to.x, to.y, to.z)) & LadderFlag;
+    if (dy == -1) return GetFlags(flags, from.x, from.y, from.z) & LadderFlag;
+    return false;
+  }
+
+  if (std::abs(dx) + std::abs(dz) != 1) return false;
+
+  // walk
+  if (dy == 0) return true;
+
+  // jump onto a step, needs room above the head
+  if (dy == 1) return GetFlags(flags, from.x, from.y + 2, from.z) & ClearFlag;
+
+  // drop down, needs the whole way down to be free
+  if (dy < 0 && dy >= -maxDrop) {
+    for (int y=to.y+1; y<=int(from.y)+1; y++) {
+      if (!(GetFlags(flags, to.x, y, to.z) & ClearFlag)) return false;
+    }
+    return true;
+  }
+
+  return false;
+}
+
+/** Worker thread main loop. */
+void
+NavField::Run() {
+  while(true) {
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->condition.wait(lock, [this]{ return this->quit || this->jobPending; });
+      if (this->quit) return;
+      this->jobPending = false;
+    }
+
+    this->Search();
+
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->resultReady = true;
+    }
+  }
+}
+
+/** Breadth first search from the job sources along reversed edges, so
+  * that each node ends up with the number of steps from it to the nearest
+  * source.
+  */
+void
+NavField::Search() {
+  const std::vector<uint8_t> &flags = this->jobFlags;
+  std::vector<uint16_t> &dist = this->jobDistances;
+
+  dist.assign(flags.size(), Unreachable);
+
+  std::vector<IVector3> queue;
+  for (const IVector3 &source : this->jobSources) {
+    IVector3 node;
+    if (!this->FindNode(flags, source, node)) continue;
+
+    size_t i = this->GetIndex(node);
+    if (dist[i] == 0) continue;
+
+    dist[i] = 0;
+    queue.push_back(node);
+  }
+
+  auto visit = [&](const IVector3 &from, const IVector3 &to, uint16_t d) {
+    if (!this->IsValid(from)) return;
+
+    size_t i = this->GetIndex(from);
+    if (dist[i] != Unreachable || !(flags[i] & NodeFlags)) return;
+    if (!this->IsEdge(flags, from, to)) return;
+
+    dist[i] = d;
+    queue.push_back(from);
+  };
+
+  for (size_t head=0; head<queue.size(); head++) {
+    IVector3 to = queue[head];
+    uint16_t d  = dist[this->GetIndex(to)] + 1;
+    if (d > maxDistance) continue;
+
+    visit(IVector3(to.x, to.y + 1, to.z), to, d);
+    visit(IVector3(to.x, to.y - 1, to.z), to, d);
+    for (size_t s=0; s<4; s++) {
+      for (int y=-1; y<=maxDrop; y++) {
+        visit(IVector3(to.x + sideX[s], to.y + y, to.z + sideZ[s]), to, d);
+      }
+    }
+  }
+}
@@ -0,0 +1,94 @@
+#ifndef BARFOOS_NAVFIELD_H
+#define BARFOOS_NAVFIELD_H
+
+#include "common.h"
+
+#include "math/ivector3.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/** Distance field over the walkable cells of a world, shared by all
+  * monsters that want to get to the player.
+  * A node is a cell that an entity can stand in: one above a walkable cell
+  * (see World::IsCellWalkable) or a ladder. Entities can walk between
+  * neighbouring nodes, jump up one cell, drop down a few cells and climb
+  * ladders. The walkability of each cell is kept up to date as cells
+  * change, the distances to the nearest source are computed by breadth
+  * first search on a worker thread and swapped in when done.
+  */
+class NavField final {
+public:
+
+  /** Distance of nodes that are not within reach of any source. */
+  static constexpr uint16_t Unreachable         = 0xFFFF;
+
+                            NavField            (const World &world);
+                            NavField            (const NavField &) = delete;
+                            ~NavField           ();
+
+  NavField &                operator=           (const NavField &) = delete;
+
+  void                      CellChanged         (const IVector3 &pos);
+  void                      Invalidate          ();
+  void                      Update              (const std::vector<IVector3> &sources);
+
+  uint16_t                  GetDistance         (const Vector3 &feet)                     const;
+  bool                      GetDirection        (const Vector3 &feet, Vector3 &dir)       const;
+
+private:
+
+  /** Per cell flags: not solid, something to stand on, a ladder to climb. */
+  static constexpr uint8_t  ClearFlag           = (1<<0);
+  static constexpr uint8_t  StandFlag           = (1<<1);
+  static constexpr uint8_t  LadderFlag          = (1<<2);
+  static constexpr uint8_t  NodeFlags           = StandFlag | LadderFlag;
+
+  /** Highest drop that is taken as a way down. */
+  static constexpr int      maxDrop             = 3;
+
+  /** Nodes further away from all sources are left unreachable. */
+  static constexpr uint16_t maxDistance         = 160;
+
+  const World &             world;
+
+  /** Size of the world, the worker reads it too while busy. */
+  IVector3                  size;
+
+  /** Flags of each cell, maintained on the main thread. */
+  std::vector<uint8_t>      flags;
+  bool                      flagsValid;
+  bool                      dirty;
+
+  /** Distances of the last finished search. */
+  std::vector<uint16_t>     distances;
+  std::vector<IVector3>     sources;
+
+  // worker
+  std::thread               thread;
+  std::mutex                mutex;
+  std::condition_variable   condition;
+  bool                      quit;
+  bool                      busy;
+  bool                      jobPending;
+  bool                      resultReady;
+
+  /** Input and output of the search in progress, owned by the worker
+    * while busy. */
+  std::vector<uint8_t>      jobFlags;
+  std::vector<IVector3>     jobSources;
+  std::vector<uint16_t>     jobDistances;
+
+  uint8_t                   CalcFlags           (const IVector3 &pos)                     const;
+  bool                      FindNode            (const std::vector<uint8_t> &flags, const IVector3 &pos, IVector3 &node) const;
+  bool                      IsValid             (const IVector3 &pos)                     const { return pos.x < this->size.x && pos.y < this->size.y && pos.z < this->size.z; }
+  size_t                    GetIndex            (const IVector3 &pos)                     const { return pos.x + this->size.x * (pos.y + this->size.y * pos.z); }
+  uint8_t                   GetFlags            (const std::vector<uint8_t> &flags, int x, int y, int z) const;
+  bool                      IsEdge              (const std::vector<uint8_t> &flags, const IVector3 &from, const IVector3 &to) const;
+
+  void                      Run                 ();
+  void                      Search              ();
+};
+
+#endif
@@ -0,0 +1,184 @@
+#include "common.h"
+
+#include "game/world/placementindex.h"
+#include "game/world/world.h"
+
+constexpr size_t PlacementIndex::blockSize;
+
+/** C'tor.
+  * @param world World in which features are placed.
+  */
+PlacementIndex::PlacementIndex(const World &world) :
+  world(world),
+  size(),
+  wordsPerRow(0),
+  rows(),
+  blockCount(),
+  blocks(),
+  connectors()
+{
+}
+
+/** Mirror the protected cells of the whole world and forget all
+  * connections, for example after the ground was filled again.
+  */
+void
+PlacementIndex::Reset() {
+  this->size        = this->world.GetSize();
+  this->wordsPerRow = (this->size.x + 63) / 64;
+  this->rows.assign(this->wordsPerRow * this->size.y * this->size.z, 0);
+
+  // bits past the end of a row are outside of the world
+  if (this->size.x % 64) {
+    uint64_t outside = ~uint64_t(0) << (this->size.x % 64);
+    for (size_t r=0; r<this->size.y * this->size.z; r++) {
+      this->rows[(r + 1) * this->wordsPerRow - 1] = outside;
+    }
+  }
+
+  this->blockCount = IVector3(
+    (this->size.x + blockSize - 1) / blockSize,
+    (this->size.y + blockSize - 1) / blockSize,
+    (this->size.z + blockSize - 1) / blockSize
+  );
+  this->blocks.assign(this->blockCount.x * this->blockCount.y * this->blockCount.z, 0);
+
+  this->Update(IVector3(0,0,0), this->size);
+  this->connectors.clear();
+}
+
+/** Mirror the protected cells of a part of the world after it was built.
+  * @param pos First cell of the part.
+  * @param size Size of the part.
+  */
+void
+PlacementIndex::Update(const IVector3 &pos, const IVector3 &size) {
+  const CellStore &cells = this->world.cells;
+
+  // the part may stick out of the world on any side
+  int64_t x0 = std::max<int64_t>(int32_t(pos.x), 0), x1 = std::min<int64_t>(int64_t(int32_t(pos.x)) + size.x, this->size.x);
+  int64_t y0 = std::max<int64_t>(int32_t(pos.y), 0), y1 = std::min<int64_t>(int64_t(int32_t(pos.y)) + size.y, this->size.y);
+  int64_t z0 = std::max<int64_t>(int32_t(pos.z), 0), z1 = std::min<int64_t>(int64_t(int32_t(pos.z)) + size.z, this->size.z);
+
+  for (int64_t z=z0; z<z1; z++) {
+    for (int64_t y=y0; y<y1; y++) {
+      uint64_t *row = &this->rows[(y + this->size.y * z) * this->wordsPerRow];
+
+      for (int64_t x=x0; x<x1; x++) {
+        bool isProtected  = cells.bits[this->world.GetCellIndex(IVector3(x,y,z))] & CellStore::Protected;
+        uint64_t bit      = uint64_t(1) << (x % 64);
+        bool wasProtected = row[x / 64] & bit;
+        if (isProtected == wasProtected) continue;
+
+        row[x / 64] ^= bit;
+
+        uint16_t &count = this->blocks[x / blockSize + this->blockCount.x * (y / blockSize + this->blockCount.y * (z / blockSize))];
+        if (isProtected) count++; else count--;
+      }
+    }
+  }
+}
+
+/** Check whether a feature can be built without overwriting any protected
+  * cells or leaving the world.
+  * @param feature The feature.
+  * @param pos Position of the first cell of the feature.
+  * @return true if the feature fits.
+  */
+bool
+PlacementIndex::CanPlace(const Feature &feature, const IVector3 &pos) const {
+  const IVector3 &featureSize = feature.GetSize();
+  if (this->IsUntouched(pos, featureSize)) return true;
+
+  // positions left of or below the world come in wrapped around
+  int64_t x0 = int32_t(pos.x);
+  int64_t y0 = int32_t(pos.y);
+  int64_t z0 = int32_t(pos.z);
+
+  const FeatureFootprint &footprint = feature.GetFootprint();
+  for (size_t z=0; z<featureSize.z; z++) {
+    for (size_t y=0; y<featureSize.y; y++) {
+      const uint64_t *row = footprint.GetRow(y, z, featureSize.y);
+
+      int64_t wy = y0 + y;
+      int64_t wz = z0 + z;
+      bool inside = wy >= 0 && wy < int64_t(this->size.y) && wz >= 0 && wz < int64_t(this->size.z);
+
+      for (size_t w=0; w<footprint.wordsPerRow; w++) {
+        if (!row[w]) continue;
+        if (!inside) return false;
+        if (this->GetRowBits(wy, wz, x0 + 64 * w) & row[w]) return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+/** Remember the connections of a placed feature.
+  * @param instance Index of the placed feature.
+  * @param placed The placed feature.
+  */
+void
+PlacementIndex::AddConnectors(size_t instance, const FeatureInstance &placed) {
+  for (const FeatureConnection &conn : placed.feature->GetConnections()) {
+    this->connectors[ConnectorKey { placed.pos + conn.pos, conn.dir }].push_back(Connector { instance, &conn });
+  }
+}
+
+/** Get the connections of placed features at a position.
+  * @param pos Position of the connection in the world.
+  * @param dir Direction of the connection.
+  * @return The connections in the order their features were placed.
+  */
+const std::vector<PlacementIndex::Connector> &
+PlacementIndex::GetConnectors(const IVector3 &pos, int dir) const {
+  static const std::vector<Connector> none;
+
+  auto iter = this->connectors.find(ConnectorKey { pos, dir });
+  return iter == this->connectors.end() ? none : iter->second;
+}
+
+/** Get 64 bits of a row of the protected cell mirror.
+  * @param y Row y position.
+  * @param z Row z position.
+  * @param x Position of the first cell, may be outside of the world.
+  * @return Bits of the cells from x on.
+  */
+uint64_t
+PlacementIndex::GetRowBits(size_t y, size_t z, int64_t x) const {
+  const uint64_t *row = &this->rows[(y + this->size.y * z) * this->wordsPerRow];
+
+  int64_t word  = x >= 0 ? x / 64 : (x - 63) / 64;
+  size_t  shift = x - word * 64;
+
+  uint64_t lo = word     >= 0 && word     < int64_t(this->wordsPerRow) ? row[word]     : ~uint64_t(0);
+  uint64_t hi = word + 1 >= 0 && word + 1 < int64_t(this->wordsPerRow) ? row[word + 1] : ~uint64_t(0);
+  return shift ? (lo >> shift) | (hi << (64 - shift)) : lo;
+}
+
+/** Check whether a box lies within the world and has no protected cells
+  * anywhere near it.
+  * @param pos First cell of the box.
+  * @param size Size of the box.
+  * @return true if every cell of the box can be overwritten.
+  */
+bool
+PlacementIndex::IsUntouched(const IVector3 &pos, const IVector3 &size) const {
+  if (pos.x >= this->size.x || size.x > this->size.x - pos.x) return false;
+  if (pos.y >= this->size.y || size.y > this->size.y - pos.y) return false;
+  if (pos.z >= this->size.z || size.z > this->size.z - pos.z) return false;
+  if (size.x == 0 || size.y == 0 || size.z == 0) return true;
+
+  IVector3 b0(pos.x / blockSize, pos.y / blockSize, pos.z / blockSize);
+  IVector3 b1((pos.x + size.x - 1) / blockSize, (pos.y + size.y - 1) / blockSize, (pos.z + size.z - 1) / blockSize);
+
+  for (size_t z=b0.z; z<=b1.z; z++) {
+    for (size_t y=b0.y; y<=b1.y; y++) {
+      for (size_t x=b0.x; x<=b1.x; x++) {
+        if (this->blocks[x + this->blockCount.x * (y + this->blockCount.y * z)]) return false;
+      }
+    }
+  }
+  return true;
+}
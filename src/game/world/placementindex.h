@@ -0,0 +1,75 @@
+#ifndef BARFOOS_PLACEMENTINDEX_H
+#define BARFOOS_PLACEMENTINDEX_H
+
+#include "common.h"
+
+#include "game/world/feature.h"
+
+#include <unordered_map>
+
+/** Tells where features can be placed while a world is built, without
+  * trying to build them there.
+  * The protected cells of the world are mirrored in bit rows along x, which
+  * are tested against the footprint of a feature one row at a time. A
+  * coarse grid counts the protected cells per block, placements in blocks
+  * without any skip the rows. The connections of placed features are
+  * hashed by position and direction to find features that happen to join.
+  */
+class PlacementIndex final {
+public:
+
+  /** Connection of a placed feature. */
+  struct Connector {
+    size_t                    instance;
+    const FeatureConnection * conn;
+  };
+
+                            PlacementIndex      (const World &world);
+                            PlacementIndex      (const PlacementIndex &) = delete;
+
+  PlacementIndex &          operator=           (const PlacementIndex &) = delete;
+
+  void                      Reset               ();
+  void                      Update              (const IVector3 &pos, const IVector3 &size);
+  bool                      CanPlace            (const Feature &feature, const IVector3 &pos) const;
+
+  void                      AddConnectors       (size_t instance, const FeatureInstance &placed);
+  const std::vector<Connector> &GetConnectors   (const IVector3 &pos, int dir)            const;
+
+private:
+
+  /** Edge length of a block of the coarse grid in cells. */
+  static constexpr size_t   blockSize           = 8;
+
+  struct ConnectorKey {
+    IVector3 pos;
+    int      dir;
+
+    bool operator==(const ConnectorKey &that) const { return this->pos == that.pos && this->dir == that.dir; }
+  };
+
+  struct ConnectorKeyHash {
+    size_t operator()(const ConnectorKey &key) const {
+      return ((key.pos.x * 73856093u) ^ (key.pos.y * 19349663u) ^ (key.pos.z * 83492791u)) + key.dir;
+    }
+  };
+
+  const World &             world;
+  IVector3                  size;
+
+  /** One bit per protected cell, cells outside of the world count as
+    * protected. */
+  size_t                    wordsPerRow;
+  std::vector<uint64_t>     rows;
+
+  /** Number of protected cells in each block. */
+  IVector3                  blockCount;
+  std::vector<uint16_t>     blocks;
+
+  std::unordered_map<ConnectorKey, std::vector<Connector>, ConnectorKeyHash> connectors;
+
+  uint64_t                  GetRowBits          (size_t y, size_t z, int64_t x)          const;
+  bool                      IsUntouched         (const IVector3 &pos, const IVector3 &size) const;
+};
+
+#endif
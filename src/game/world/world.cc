@@ -1,12 +1,18 @@
 #include "common.h"
 
 // #include "gfx/GLee.h"
+#include "game/game.h"
 #include "game/entities/entity.h"
 #include "game/gamestates/running/runningstate.h"
 #include "game/items/item.h"
 #include "game/items/itementity.h"
 #include "game/world/cells/cell.h"
+#include "game/world/dynamicmesh.h"
 #include "game/world/feature.h"
+#include "game/world/lightengine.h"
+#include "game/world/liquidsimulator.h"
+#include "game/world/meshbuilder.h"
+#include "game/world/navfield.h"
 #include "game/world/world.h"
 #include "game/world/worldedit.h"
 #include "gfx/gfx.h"
@@ -15,34 +21,60 @@
 #include "gfx/vertex.h"
 #include "math/aabb.h"
 #include "math/random.h"
+#include "io/protostream.h"
 #include "math/simplex.h"
 #include "util/image.h"
+#include "util/util.h"
+#include "util/workerpool.h"
+
+#include <cstring>
+#include <map>
 
 const IColor World::ambientLight = IColor(32,32,32);
+constexpr size_t World::chunkSize;
+constexpr size_t World::maxChunkRebuildsPerFrame;
+constexpr size_t World::maxLightStepsPerUpdate;
+constexpr size_t World::neighbourJobSize;
+
+/** Results of UpdateNeighbours for one cell of a round. */
+static const uint8_t neighbourLightChanged    = (1<<0);
+static const uint8_t neighbourGeometryChanged = (1<<1);
 
 World::World(RunningState &state, const IVector3 &size) :
   state(state),
   minimap(*this),
 
-  dirty(true),
   firstDirty(true),
-  cells(size.x * size.y * size.z, Cell("default")),
-  defaultMask(cells.size(), true),
-  defaultCell("default"),
+  cells(size.x * size.y * size.z + 1),
+  baseCells(),
   dynamicCells(0),
-  allVerts(),
-  vertexStartsNormal(),
-  vertexCountsNormal(),
-  vertexStartsEmissive(),
-  vertexCountsEmissive(),
-  checkOverwrite(false),
-  checkOverwriteOK(true)
+  dynamicCellsDirty(true),
+  neighbourUpdateMarks(),
+  neighbourUpdates(),
+  neighbourUpdateRound(),
+  neighbourUpdateResults(),
+  chunkCount(),
+  chunks(),
+  dirtyChunks(),
+  chunkRebuildCount(0),
+  cellGeneration(0),
+  meshBuilder(new MeshBuilder()),
+  dynamicMesh(new DynamicMesh()),
+  lightEngine(new LightEngine(*this)),
+  liquidSimulator(new LiquidSimulator(*this)),
+  navField(new NavField(*this)),
+  workerPool(new WorkerPool(state.GetGame().GetWorkerThreadCount()))
 {
   this->proto.set_size_x(size.x);
   this->proto.set_size_y(size.y);
   this->proto.set_size_z(size.z);
 
-  // TODO: load default mask
+  // tick from now on, a world built later in the game must not catch up
+  this->proto.set_next_tick_time(state.GetGame().GetTime());
+
+  this->neighbourUpdateMarks.resize(this->GetCellCount(), false);
+  this->liquidSimulator->WakeAll();
+  this->InitChunks();
 }
 
 World::World(RunningState &state, const World_Proto &proto) :
@@ -50,58 +82,57 @@ World::World(RunningState &state, const World_Proto &proto) :
   proto(proto),
   minimap(*this, proto.mini_map()),
 
-  dirty(true),
   firstDirty(true),
-  defaultCell("default"),
+  cells(),
+  baseCells(),
   dynamicCells(0),
-  allVerts(),
-  vertexStartsNormal(),
-  vertexCountsNormal(),
-  vertexStartsEmissive(),
-  vertexCountsEmissive(),
-  checkOverwrite(false),
-  checkOverwriteOK(true)
+  dynamicCellsDirty(true),
+  neighbourUpdateMarks(),
+  neighbourUpdates(),
+  neighbourUpdateRound(),
+  neighbourUpdateResults(),
+  chunkCount(),
+  chunks(),
+  dirtyChunks(),
+  chunkRebuildCount(0),
+  cellGeneration(0),
+  meshBuilder(new MeshBuilder()),
+  dynamicMesh(new DynamicMesh()),
+  lightEngine(new LightEngine(*this)),
+  liquidSimulator(new LiquidSimulator(*this)),
+  navField(new NavField(*this)),
+  workerPool(new WorkerPool(state.GetGame().GetWorkerThreadCount()))
 {
-  this->cells.clear();
-  this->defaultMask.clear();
+  this->LoadCells(proto);
+  this->neighbourUpdateMarks.resize(this->GetCellCount(), false);
+  this->liquidSimulator->WakeAll();
+  this->InitChunks();
 }
 
 World::~World() {
 }
 
-Cell &
-World::SetCell(const IVector3 &pos, const Cell &cell, bool ignoreLock) {
-  if (checkOverwrite) {
-    if (!this->IsValidCellPosition(pos)) 
-      checkOverwriteOK = false;
-    else if (!ignoreLock && this->cells[this->GetCellIndex(pos)].IsProtected())
-      checkOverwriteOK = false;
-    return this->defaultCell;
-  }
-
-  if (!this->IsValidCellPosition(pos)) return this->defaultCell;
+Cell
+World::SetCell(const IVector3 &pos, const Cell &cell) {
+  if (!this->IsValidCellPosition(pos)) return this->GetDefaultCell(pos);
 
   size_t i = this->GetCellIndex(pos);
-  if (this->cells[i].IsIgnoringWrite()) return this->defaultCell;
+  if (this->cells.bits[i] & CellStore::IgnoringWrite) return this->GetDefaultCell(pos);
 
-  defaultMask[i] = false;
+  this->cells.bits[i] &= ~CellStore::Default;
 
-  size_t featId = this->cells[i].GetFeatureID();
+  this->cells.CopyCell(i, *cell.store, cell.index);
+  this->cellGeneration++;
+  this->lightEngine->CellChanged(i);
+  this->liquidSimulator->WakeAround(i);
+  this->navField->CellChanged(pos);
 
-  CellProperties info = this->cells[i].GetInfo();
-  this->cells[i] = cell;
-  this->cells[i].SetWorld(this, GetCellPos(i));
-  this->cells[i].SetFeatureID(featId);
+  Cell newCell(&this->cells, this, i, pos);
+  newCell.Start();
   this->UpdateCell(i);
+  this->MarkChunksDirty(pos);
 
-  // ignore changes between invisible and dynamic cells, static mesh wont change
-  
-  this->dirty = !(((info.flags & CellFlags::DoNotRender) && (cell.GetInfo().flags & CellFlags::Dynamic)) ||
-                  ((info.flags & CellFlags::Dynamic) && (cell.GetInfo().flags & CellFlags::DoNotRender)) );
-                  
-
-  this->dirty = true;
-  return this->cells[i];
+  return newCell;
 }
 
 /**
@@ -111,8 +142,11 @@ World::SetCell(const IVector3 &pos, const Cell &cell, bool ignoreLock) {
 void
 World::UpdateCell(size_t i) {
   this->MarkForUpdateNeighbours(i);
+
+  Cell cell = this->GetCell(i);
   for (size_t n=0; n<6; n++) {
-    this->MarkForUpdateNeighbours(&(this->cells[i][(Side)n]));
+    Cell neighbour = cell[(Side)n];
+    this->MarkForUpdateNeighbours(&neighbour);
   }
 }
 
@@ -133,84 +167,59 @@ void
 World::Draw(Gfx &gfx) {
   PROFILE();
 
-  if (dirty) {
-    PROFILE_NAMED("Vertex Update");
-    // world has been changed, recreate vertex buffers
+  this->chunkRebuildCount = 0;
 
-    this->defaultCell = Cell("default");
+  if (!this->dirtyChunks.empty()) {
+    PROFILE_NAMED("Vertex Update");
+    // world has been changed, start rebuilding vertex buffers of changed chunks
 
-    this->dynamicCells.clear();
+    this->cells.Reset(this->GetCellCount());
 
     if (firstDirty) {
       // fill up liquids with liquids above, so it won't trickle
       for (size_t i=0; i<this->GetCellCount(); i++) {
-        if (this->cells[i].IsLiquid() && this->cells[i][Side::Up].GetInfo() == this->cells[i].GetInfo()) {
-          this->cells[i].SetLiquidAmount(16);
+        Cell cell = this->GetCell(i);
+        if (cell.IsLiquid() && cell[Side::Up].GetInfo() == cell.GetInfo()) {
+          cell.SetLiquidAmount(16);
         }
       }
-
-      firstDirty = false;
     }
 
-    std::unordered_map<const Texture *, std::vector<Vertex>> verticesNormal;
-    std::unordered_map<const Texture *, std::vector<Vertex>> verticesEmissive;
+    // build everything on the first frame, then spread rebuilds over frames
+    size_t rebuildCount = this->dirtyChunks.size();
+    if (!firstDirty && rebuildCount > maxChunkRebuildsPerFrame) rebuildCount = maxChunkRebuildsPerFrame;
 
-    size_t updateCount = 0;
+    float time = this->state.GetGame().GetTime();
+    for (size_t i=0; i<rebuildCount; i++) {
+      size_t c = this->dirtyChunks[i];
+      WorldChunk &chunk = *this->chunks[c];
 
-    {
-      PROFILE_NAMED("Gathering Cells");
-      for (size_t i=0; i<this->GetCellCount(); i++) {
-        Cell &cell = this->cells[i];
-        const CellProperties &info = cell.GetInfo();
-
-        // don't bother with invisible cells
-        if (info.flags & CellFlags::DoNotRender || !cell.GetVisibility()) continue;
-
-        // don't add dynamic cells to static vertex buffer
-        if (cell.IsDynamic()) {
-          dynamicCells.push_back(i);
-          continue;
-        }
-
-        if (cell.UpdateVertices()) {
-          updateCount ++;
-        }
-
-        // group vertex buffers by texture
-        const Texture *tex = cell.GetTexture();
-        if (tex) for (auto &v:cell.GetVertices()) verticesNormal[tex].push_back(v);
-
-        const Texture *etex = cell.GetEmissiveTexture();
-        if (etex) for (auto &v:cell.GetVertices()) verticesEmissive[etex].push_back(v);
-      }
+      chunk.dirty = false;
+      chunk.generation++;
+      this->meshBuilder->Build(c, chunk.generation, this->cells, this->GetSize(), chunk.origin, chunk.size, time);
     }
+    this->dirtyChunks.erase(this->dirtyChunks.begin(), this->dirtyChunks.begin() + rebuildCount);
+  }
 
-    if (updateCount) Log("%u cell vertex updates\n", updateCount);
-
-    size_t index = 0;
-    this->allVerts.Clear();
-
-    for (auto &iter : verticesNormal) {
-      this->vertexStartsNormal[iter.first] = index;
-      this->vertexCountsNormal[iter.first] = iter.second.size();
-      index += iter.second.size();
-
-      for (auto &v : iter.second) {
-        this->allVerts.Add(v);
-      }
+  if (firstDirty) {
+    // don't show a half built world
+    while(this->meshBuilder->GetPendingCount()) {
+      this->chunkRebuildCount += this->UploadFinishedMeshes();
+      std::this_thread::yield();
     }
+    firstDirty = false;
+  }
 
-    for (auto &iter : verticesEmissive) {
-      this->vertexStartsEmissive[iter.first] = index;
-      this->vertexCountsEmissive[iter.first] = iter.second.size();
-      index += iter.second.size();
+  this->chunkRebuildCount += this->UploadFinishedMeshes();
+  PROFILE_COUNT("World::Draw / chunk rebuilds", this->chunkRebuildCount);
 
-      for (auto &v : iter.second) {
-        this->allVerts.Add(v);
-      }
+  if (this->dynamicCellsDirty) {
+    this->dynamicCells.clear();
+    for (auto &chunk : this->chunks) {
+      this->dynamicCells.insert(this->dynamicCells.end(), chunk->dynamicCells.begin(), chunk->dynamicCells.end());
     }
-
-    dirty = false;
+    this->dynamicMesh->SetCells(this->dynamicCells);
+    this->dynamicCellsDirty = false;
   }
 
   gfx.SetShader("default");
@@ -221,66 +230,179 @@ World::Draw(Gfx &gfx) {
   {
     PROFILE_NAMED("Static Draw");
 
-    for (auto &s : this->vertexStartsNormal) {
-      gfx.SetTextureFrame(s.first);
-      gfx.DrawTriangles(this->allVerts, s.second, this->vertexCountsNormal[s.first]);
+    for (auto &chunk : this->chunks) {
+      for (auto &s : chunk->vertexStartsNormal) {
+        gfx.SetTextureFrame(s.first);
+        gfx.DrawTriangles(chunk->verts, s.second, chunk->vertexCountsNormal[s.first]);
+      }
     }
 
     gfx.SetBlendAdd();
-    for (auto &s : this->vertexStartsEmissive) {
-      gfx.SetTextureFrame(s.first);
-      gfx.DrawTriangles(this->allVerts, s.second, this->vertexCountsEmissive[s.first]);
+    for (auto &chunk : this->chunks) {
+      for (auto &s : chunk->vertexStartsEmissive) {
+        gfx.SetTextureFrame(s.first);
+        gfx.DrawTriangles(chunk->verts, s.second, chunk->vertexCountsEmissive[s.first]);
+      }
     }
   }
 
   {
     PROFILE_NAMED("Dynamic Draw");
 
-    // get vertices for dynamic cells
-    std::unordered_map<const Texture *, VertexBuffer> dynVerticesNormal;
-    std::unordered_map<const Texture *, VertexBuffer> dynVerticesEmissive;
-
-    for (size_t i : dynamicCells) {
-      Cell &cell = this->cells[i];
-      cell.UpdateVertices();
-
-      const Texture *tex = cell.GetTexture();
-      const Texture *etex = cell.GetEmissiveTexture();
-      for (auto &v:cell.GetVertices()) {
-        if (tex)  dynVerticesNormal[tex].Add(v);
-        if (etex) dynVerticesEmissive[etex].Add(v);
-      }
-    }
+    // only changed cells are written to the vertex buffers
+    this->dynamicMesh->Update(*this, this->dynamicCells);
 
     // render vertices for dynamic cells
     gfx.SetBlendNormal();
-    auto iter = dynVerticesNormal.begin();
-    for (size_t i=0; i<dynVerticesNormal.size(); i++, iter++) {
-      gfx.SetTextureFrame(iter->first);
-      gfx.DrawTriangles(iter->second);
-    }
+    this->dynamicMesh->DrawNormal(gfx);
 
     gfx.SetBlendAdd();
     gfx.SetLight(IColor(255,255,255));
-    iter = dynVerticesEmissive.begin();
-    for (size_t i=0; i<dynVerticesEmissive.size(); i++, iter++) {
-      gfx.SetTextureFrame(iter->first);
-      gfx.DrawTriangles(iter->second);
-    }
+    this->dynamicMesh->DrawEmissive(gfx);
 
     //lastDynVertexCount = dynVerticesNormal.size();
     //lastDynVertexEmissiveCount = dynVerticesEmissive.size();
   }
 }
 
+/**
+ * Split the world into chunks and mark all of them for rebuilding.
+ */
+void
+World::InitChunks() {
+  const IVector3 &size = this->GetSize();
+  this->chunkCount = IVector3(
+    (size.x + chunkSize - 1) / chunkSize,
+    (size.y + chunkSize - 1) / chunkSize,
+    (size.z + chunkSize - 1) / chunkSize
+  );
+
+  this->chunks.clear();
+  this->dirtyChunks.clear();
+
+  for (size_t z=0; z<this->chunkCount.z; z++) {
+    for (size_t y=0; y<this->chunkCount.y; y++) {
+      for (size_t x=0; x<this->chunkCount.x; x++) {
+        WorldChunk *chunk = new WorldChunk();
+        chunk->origin = IVector3(x*chunkSize, y*chunkSize, z*chunkSize);
+        chunk->size = IVector3(
+          std::min<size_t>(chunkSize, size.x - chunk->origin.x),
+          std::min<size_t>(chunkSize, size.y - chunk->origin.y),
+          std::min<size_t>(chunkSize, size.z - chunk->origin.z)
+        );
+
+        this->dirtyChunks.push_back(this->chunks.size());
+        this->chunks.push_back(std::unique_ptr<WorldChunk>(chunk));
+      }
+    }
+  }
+}
+
+/**
+ * Mark all chunks for rebuilding.
+ */
+void
+World::SetDirty() {
+  for (size_t i=0; i<this->chunks.size(); i++) {
+    if (this->chunks[i]->dirty) continue;
+    this->chunks[i]->dirty = true;
+    this->dirtyChunks.push_back(i);
+  }
+}
+
+/**
+ * Mark the chunks whose geometry depends on a cell for rebuilding. This is
+ * the chunk containing the cell and those containing any of its neighbours.
+ * @param pos Position of the changed cell.
+ */
+void
+World::MarkChunksDirty(const IVector3 &pos) {
+  if (!this->IsValidCellPosition(pos)) return;
+
+  size_t x0 = (pos.x > 0 ? pos.x - 1 : 0) / chunkSize, x1 = std::min<size_t>((pos.x + 1) / chunkSize, this->chunkCount.x - 1);
+  size_t y0 = (pos.y > 0 ? pos.y - 1 : 0) / chunkSize, y1 = std::min<size_t>((pos.y + 1) / chunkSize, this->chunkCount.y - 1);
+  size_t z0 = (pos.z > 0 ? pos.z - 1 : 0) / chunkSize, z1 = std::min<size_t>((pos.z + 1) / chunkSize, this->chunkCount.z - 1);
+
+  for (size_t z=z0; z<=z1; z++) {
+    for (size_t y=y0; y<=y1; y++) {
+      for (size_t x=x0; x<=x1; x++) {
+        size_t i = x + this->chunkCount.x * (y + this->chunkCount.y * z);
+        if (this->chunks[i]->dirty) continue;
+
+        this->chunks[i]->dirty = true;
+        this->dirtyChunks.push_back(i);
+      }
+    }
+  }
+}
+
+/**
+ * Move finished chunk meshes from the mesh builder into the chunk vertex 
+ * buffers.
+ * @return Number of chunks that were updated.
+ */
+size_t
+World::UploadFinishedMeshes() {
+  size_t count = 0;
+
+  ChunkMesh *mesh = this->meshBuilder->FetchFinished();
+  while(mesh) {
+    ChunkMesh *next = mesh->next;
+    WorldChunk &chunk = *this->chunks[mesh->chunk];
+
+    // meshes may arrive out of order, keep only the newest
+    if (mesh->generation > chunk.uploadedGeneration) {
+      chunk.verts.GetVerts().swap(mesh->verts);
+      chunk.vertexStartsNormal.swap(mesh->vertexStartsNormal);
+      chunk.vertexCountsNormal.swap(mesh->vertexCountsNormal);
+      chunk.vertexStartsEmissive.swap(mesh->vertexStartsEmissive);
+      chunk.vertexCountsEmissive.swap(mesh->vertexCountsEmissive);
+      chunk.dynamicCells.swap(mesh->dynamicCells);
+      chunk.uploadedGeneration = mesh->generation;
+      count++;
+    }
+
+    delete mesh;
+    mesh = next;
+  }
+
+  if (count) this->dynamicCellsDirty = true;
+  return count;
+}
+
 void
 World::MarkForUpdateNeighbours(const CellBase *cell) {
-  this->neighbourUpdates.insert(GetCellIndex(cell->GetPosition()));
+  // cells outside of the world have nothing to update
+  if (cell->GetWorld() != this) return;
+  this->MarkForUpdateNeighbours(cell->GetIndex());
+}
+
+/**
+ * Tell the light engine that a cell no longer has the right light level,
+ * for example because its shape changed.
+ * @param cell The cell.
+ */
+void
+World::MarkForUpdateLight(const CellBase *cell) {
+  if (cell->GetWorld() != this) return;
+  this->lightEngine->CellChanged(cell->GetIndex());
+}
+
+/**
+ * Wake up a liquid cell and its neighbours after its liquid amount changed.
+ * @param cell The cell.
+ */
+void
+World::MarkForUpdateLiquid(const CellBase *cell) {
+  if (cell->GetWorld() != this) return;
+  this->liquidSimulator->WakeAround(cell->GetIndex());
 }
 
 void
 World::MarkForUpdateNeighbours(size_t i) {
-  this->neighbourUpdates.insert(i);
+  if (this->neighbourUpdateMarks[i]) return;
+  this->neighbourUpdateMarks[i] = true;
+  this->neighbourUpdates.push_back(i);
 }
 
 void
@@ -295,43 +417,97 @@ World::Update(
     PROFILE_NAMED("Update Dynamic");
     //Log("updating %u dynamic cells\n", this->dynamicCells.size());
     for (size_t i : this->dynamicCells) {
-      this->cells[i].Update(state);
+      this->GetCell(i).Update(state);
     }
   }
 
-  if (this->neighbourUpdates.size())
-  {
-    PROFILE_NAMED("Update neighbours");
-    size_t neighbourCount = 0;
-    while(this->neighbourUpdates.size()) {
-      std::unordered_set<size_t> tmp = this->neighbourUpdates;
-      this->neighbourUpdates.clear();
-
-      for (auto &i:tmp) {
-        this->cells[i].UpdateNeighbours();
-        neighbourCount++;
-      }
-    }
+  this->UpdateNeighbourCells();
 
-    if (neighbourCount > 0) {
-      this->dirty = true;
-      Log("updated %u neighbours\n", neighbourCount);
-    }
+  if (!this->lightEngine->IsSettled())
+  {
+    PROFILE_NAMED("Update light");
+    // settle everything before the world is shown for the first time
+    this->lightEngine->Update(this->firstDirty ? 0 : maxLightStepsPerUpdate);
   }
 
   // tick world
-  if (this->dynamicCells.size() && tickInterval != 0.0 && state.GetGame().GetTime() > this->GetNextTickTime())
+  if (tickInterval != 0.0 && state.GetGame().GetTime() > this->GetNextTickTime())
   {
     PROFILE_NAMED("Tick");
     while (state.GetGame().GetTime() > this->GetNextTickTime()) {
-      for (size_t i : this->dynamicCells) {
-        this->cells[i].Tick(state);
-      }
+      this->liquidSimulator->Tick(state);
       this->SetNextTickTime(this->GetNextTickTime() + tickInterval);
     }
   }
 }
 
+/**
+ * Update the cells marked by MarkForUpdateNeighbours until no more cells
+ * are marked.
+ */
+void
+World::UpdateNeighbourCells() {
+  if (this->neighbourUpdates.empty()) return;
+
+  PROFILE_NAMED("Update neighbours");
+  size_t roundCount = 0;
+  while(this->neighbourUpdates.size()) {
+    // cells marked while processing this round go into the next one
+    std::swap(this->neighbourUpdates, this->neighbourUpdateRound);
+    for (size_t i : this->neighbourUpdateRound) {
+      this->neighbourUpdateMarks[i] = false;
+    }
+
+    // each cell only writes its own visibility, so blocks of the round can
+    // be updated in parallel, what has to be fixed up is collected and then
+    // done in order
+    size_t roundSize = this->neighbourUpdateRound.size();
+    this->neighbourUpdateResults.resize(roundSize);
+    this->workerPool->Run((roundSize + neighbourJobSize - 1) / neighbourJobSize, [&](size_t job) {
+      size_t end = std::min(roundSize, (job + 1) * neighbourJobSize);
+      for (size_t n=job * neighbourJobSize; n<end; n++) {
+        size_t i = this->neighbourUpdateRound[n];
+        Cell cell = this->GetCell(i);
+        bool visible = this->cells.visibility[i] != 0;
+
+        uint8_t result = 0;
+        if (cell.UpdateNeighbours()) result |= neighbourLightChanged;
+
+        // dynamic cells are not part of the static geometry, unless they
+        // become visible or invisible
+        if (!cell.IsDynamic() || visible != (this->cells.visibility[i] != 0)) {
+          result |= neighbourGeometryChanged;
+        }
+        this->neighbourUpdateResults[n] = result;
+      }
+    });
+
+    for (size_t n=0; n<roundSize; n++) {
+      size_t i = this->neighbourUpdateRound[n];
+      if (this->neighbourUpdateResults[n] & neighbourLightChanged)    this->lightEngine->CellChanged(i);
+      if (this->neighbourUpdateResults[n] & neighbourGeometryChanged) this->MarkChunksDirty(this->GetCellPos(i));
+    }
+
+    PROFILE_COUNT("World::Update / neighbour round", this->neighbourUpdateRound.size());
+    roundCount++;
+    this->neighbourUpdateRound.clear();
+  }
+
+  PROFILE_COUNT("World::Update / neighbour rounds", roundCount);
+}
+
+/**
+ * Bring the visibility and light of all cells up to date right away 
+ * instead of over the next updates, for example after building the world.
+ */
+void
+World::Settle() {
+  PROFILE();
+
+  this->UpdateNeighbourCells();
+  this->lightEngine->Update(0);
+}
+
 /**
  * Cast a ray from a given location along the x axis.
  * @param org Ray origin.
@@ -385,20 +561,16 @@ World::CastRayZ(const Vector3 &org, float dir, bool sneak) const {
  */
 float
 World::CastRayYUp(const Vector3 &org) const {
-  //Log("CastRayYUP: %f %f %f\n", org.x, org.y, org.z);
-
   if (org.y < 0) return 0;
 
   size_t x = org.x; // start cell x
   size_t y = org.y; // start cell y
   size_t z = org.z; // start cell z
 
-  //if (GetCell(IVector3(x,y,z)).IsSolid() && y > GetCell(IVector3(x,y,z)).GetHeightBottom(org.x, org.z)) return y;
-
+  CellCollision collision;
   while (y < this->proto.size_y()) {
-    const Cell &cell = this->GetCell(IVector3(x,y,z));
-    if (cell.IsSolid()) {
-      return y + cell.GetHeightBottom(org.x, org.z);
+    if (this->GetSolidCollision(IVector3(x,y,z), collision)) {
+      return y + collision.GetBottom(org.x - (int)org.x, org.z - (int)org.z);
     }
     y++;
   }
@@ -414,18 +586,19 @@ World::CastRayYUp(const Vector3 &org) const {
 float
 World::CastRayYDown(const Vector3 &org) const {
   size_t x = org.x; // start cell x
-  size_t y = org.y; // start cell y
+  int    y = org.y; // start cell y
   size_t z = org.z; // start cell z
 
-  if (y >= this->proto.size_y()) y = this->proto.size_y() - 1;
+  if (y >= (int)this->proto.size_y()) y = this->proto.size_y() - 1;
 
-  Cell *cell = &GetCell(IVector3(x,y,z));
-  while(!cell->IsSolid()) {
-    cell = &((*cell)[Side::Down]);
+  // below the world is the solid default cell
+  CellCollision collision;
+  while (y >= 0 && !this->GetSolidCollision(IVector3(x,y,z), collision)) {
     y--;
   }
+  if (y < 0) return 0;
 
-  return cell->GetHeight(org.x, org.z) + y;
+  return y + collision.GetTop(org.x - (int)org.x, org.z - (int)org.z);
 }
 
 /**
@@ -439,54 +612,34 @@ World::IsPointSolid(const Vector3 &org) const {
   size_t y = org.y; // start cell y
   size_t z = org.z; // start cell z
 
-  const Cell &cell = this->GetCell(IVector3(x,y,z));
-  if (!cell.IsSolid()) return false;
+  CellCollision collision;
+  if (!this->GetSolidCollision(IVector3(x,y,z), collision)) return false;
 
-  float cellY = org.y - y;
-  //Log("%f %f %f %s\n", cellY, cell.GetHeight(org.x, org.z), cell.GetHeightBottom(org.x, org.z), cell.GetType().c_str());
-  if (cellY > cell.GetHeight(org.x, org.z)) return false;
-  if (cellY < cell.GetHeightBottom(org.x, org.z)) return false;
-  return true;
+  return collision.IsPointInside(org - Vector3(x,y,z));
 }
 
 /**
- * Check if an AABB is intersection with solid geometry.
- * This checks each vertex position of the AABB, then check the
- * lines between the top and bottom vertices for solidity.
- * @note Experimental
+ * Check if an AABB is intersecting solid geometry. Tests the collision shape
+ * of every solid cell the AABB touches.
  * @param aabb AABB to check
  * @return true if AABB intersects solid geometry.
  */
 bool
 World::IsAABBSolid(const AABB &aabb) const {
-  std::vector<Vector3> verts;
-  verts.push_back(Vector3(-aabb.extents.x, -aabb.extents.y, -aabb.extents.z));
-  verts.push_back(Vector3( aabb.extents.x, -aabb.extents.y, -aabb.extents.z));
-  verts.push_back(Vector3(-aabb.extents.x, -aabb.extents.y,  aabb.extents.z));
-  verts.push_back(Vector3( aabb.extents.x, -aabb.extents.y,  aabb.extents.z));
-  verts.push_back(Vector3(-aabb.extents.x,  aabb.extents.y, -aabb.extents.z));
-  verts.push_back(Vector3( aabb.extents.x,  aabb.extents.y, -aabb.extents.z));
-  verts.push_back(Vector3(-aabb.extents.x,  aabb.extents.y,  aabb.extents.z));
-  verts.push_back(Vector3( aabb.extents.x,  aabb.extents.y,  aabb.extents.z));
-
-  for (auto &v : verts) {
-    if (IsPointSolid(aabb.center + v)) return true;
-  }
-
-  float top = aabb.center.y + aabb.extents.y + 0.01;
-  //Log("%f < %f? (from %f+%f)\n", CastRayYUp(verts[0]), top, verts[0].y, aabb.center.y);
-  if (CastRayYUp(verts[0]+aabb.center) < top) return true;
-  if (CastRayYUp(verts[1]+aabb.center) < top) return true;
-  if (CastRayYUp(verts[2]+aabb.center) < top) return true;
-  if (CastRayYUp(verts[3]+aabb.center) < top) return true;
-  //Log("meh..\n");
-
-  float bot = aabb.center.y - aabb.extents.y - 0.01;
-  if (CastRayYDown(verts[4]+aabb.center) > bot) return true;
-  if (CastRayYDown(verts[5]+aabb.center) > bot) return true;
-  if (CastRayYDown(verts[6]+aabb.center) > bot) return true;
-  if (CastRayYDown(verts[7]+aabb.center) > bot) return true;
-  //Log("muh..\n");
+  Vector3 min = aabb.Min();
+  Vector3 max = aabb.Max();
+
+  CellCollision collision;
+  for (int z = std::floor(min.z); z <= std::floor(max.z); z++) {
+    for (int y = std::floor(min.y); y <= std::floor(max.y); y++) {
+      for (int x = std::floor(min.x); x <= std::floor(max.x); x++) {
+        if (!this->GetSolidCollision(IVector3(x,y,z), collision)) continue;
+
+        Vector3 org(x,y,z);
+        if (collision.IsAABBOverlapping(min - org, max - org)) return true;
+      }
+    }
+  }
 
   return false;
 }
@@ -500,168 +653,309 @@ World::IsAABBSolid(const AABB &aabb) const {
  * @param[out] side Returns the side of the cell that collided.
  * @param sneak If true, assume sneaking mob and prevent falling from ledges.
  * @return The final center position of the AABB.
- * @note Might not work for too big AABBs.
  */
 Vector3 World::MoveAABB(
   const AABB &aabb,
   const Vector3 &targ,
   uint8_t &axis,
-  Cell **cell,
+  Cell *cell,
   Side *side,
   bool sneak
 ) {
-  // initialize axis to no collisions
-  axis = 0;
+  SweepResult result;
+  Vector3 center = this->SweepAABB(aabb, targ - aabb.center, result, 0.0f, sneak);
+
+  axis = result.axis;
+  if (cell && result.cell.IsValid()) {
+    *cell = result.cell;
+    if (side) *side = result.side;
+  }
+  return center;
+}
+
+/**
+ * Sweep a AABB through the world in a single pass. Horizontal movement
+ * stops in front of the first blocked cell side along each axis, vertical
+ * movement at the first solid cell above or below the AABB.
+ * @param aabb The AABB to move.
+ * @param delta Movement of the AABB.
+ * @param[out] result Contacts during the movement.
+ * @param stepHeight Obstacles up to this height are stepped onto instead of
+ *        blocking horizontal movement. When moving down, the AABB also
+ *        sticks to ground up to a quarter of this below it.
+ * @param sneak If true, assume sneaking mob and prevent falling from ledges.
+ * @return The final center position of the AABB.
+ */
+Vector3
+World::SweepAABB(
+  const AABB &aabb,
+  const Vector3 &delta,
+  SweepResult &result,
+  float stepHeight,
+  bool sneak
+) const {
+  result = SweepResult();
 
-  Vector3 center = aabb.center;
-  Vector3 dist = targ-aabb.center;
+  AABB box(aabb);
+  if (delta.GetSquareMag() == 0.0f) return box.center;
 
-  // are we moving at all?
-  if (dist.GetSquareMag() == 0.0f) return center;
+  box.center.x += this->SweepSide(box, &Vector3::x, &Vector3::z, delta.x, stepHeight, sneak, result);
+  box.center.z += this->SweepSide(box, &Vector3::z, &Vector3::x, delta.z, stepHeight, sneak, result);
 
-  bool movingUp      = dist.y > 0;
-  bool storeCell = cell != nullptr;
+  // try to stick to the ground when walking down slopes and steps
+  float snap = (delta.y <= 0.0f && stepHeight > 0.0f) ? stepHeight * 0.25f : 0.0f;
 
-  // create vertices that serve as origins for ray check. must be at most
-  // one cell size apart for correct collision detection.
-  std::vector<Vector3> verts;
-  aabb.GetVertices(verts);
+  IVector3 hitPos;
+  float d = delta.y - snap;
+  float dy = this->SweepVertical(box, d, &hitPos);
 
-  Vector3 target = targ;
-  while(true) {
-    // CastRayX/Z only check nearest neighbouring cell, limit movement to 1.0
-    // and reiterate if neccessary.
-    bool keepGoing = false;
-    Vector3 d = (target-center).Horiz();
+  if (dy != d) {
+    result.axis |= Axis::Y;
 
-    if (d.GetMag() > 1.0) {
-      d = d.Normalize();
-      keepGoing = true;
+    float time = d != 0.0f ? dy / d : 0.0f;
+    if (!result.cell.IsValid()) {
+      result.time   = std::max(0.0f, std::min(1.0f, time));
+      result.side   = d > 0.0f ? Side::Down : Side::Up;
+      result.normal = Vector3(-result.side);
+      result.cell   = this->GetCell(hitPos);
     }
+  } else {
+    // didn't touch the ground, don't snap
+    dy = delta.y;
+  }
+  box.center.y += dy;
 
-    // try to move along the x axis
-    Vector3 ddx(d.x + (d.x>0?0.01:-0.01), 0, 0);
+  return box.center;
+}
 
-    for (const Vector3 &v : verts) {
-      if (CastRayX(center + v, d.x, sneak)/* || IsPointSolid(center + v + ddx)*/) {
-        float newX = d.x;
-        if (d.x > 0) {
-          newX = ((int)center.x + 1) - aabb.extents.x - 0.01f;
-        } else if (d.x < 0) {
-          newX = ((int)center.x) + aabb.extents.x + 0.01f;
+/**
+ * Sweep a AABB along the x or z axis. Each cell side that the leading face
+ * of the AABB crosses is checked once. Obstacles low enough lift the AABB
+ * instead of blocking it, as long as there is room above.
+ * @param[in,out] aabb The AABB, lifted when stepping onto an obstacle.
+ * @param along Axis of the movement.
+ * @param across The other horizontal axis.
+ * @param d Movement along the axis.
+ * @param stepHeight Maximum total height to step up.
+ * @param sneak If true, prevent falling from ledges.
+ * @param[in,out] result Contacts during the movement.
+ * @return How far the AABB can move along the axis.
+ */
+float
+World::SweepSide(
+  AABB &aabb,
+  float Vector3::*along,
+  float Vector3::*across,
+  float d,
+  float stepHeight,
+  bool sneak,
+  SweepResult &result
+) const {
+  if (d == 0.0f) return 0.0f;
+
+  const float skin = 0.01f;
+
+  bool  positive = d > 0.0f;
+  int   dir      = positive ? 1 : -1;
+  Side  side     = along == &Vector3::x ? (positive ? Side::Right   : Side::Left)
+                                        : (positive ? Side::Forward : Side::Backward);
+  float lead     = aabb.center.*along + dir * aabb.extents.*along;
+
+  // cell boundaries crossed by the leading face
+  int first = positive ? (int)std::floor(lead - skin) + 1 : (int)std::floor(lead + skin);
+  int last  = positive ? (int)std::floor(lead + d + skin) : (int)std::ceil(lead + d - skin);
+
+  for (int b = first; positive ? b <= last : b >= last; b += dir) {
+    float top;
+    IVector3 hitPos;
+
+    while (this->IsSideBlocked(aabb, along, across, positive ? b - 1 : b, side, sneak, top, hitPos)) {
+      float rise = top - aabb.Min().y + 0.001f;
+
+      if (result.stepped + rise > stepHeight || this->SweepVertical(aabb, rise) < rise) {
+        // stop in front of the boundary
+        float allowed = dir * std::max(0.0f, dir * (b - lead) - skin);
+
+        if (!result.cell.IsValid()) {
+          result.time   = allowed / d;
+          result.side   = -side;
+          result.normal = Vector3(-side);
+          result.cell   = this->GetCell(hitPos);
         }
+        result.axis |= along == &Vector3::x ? Axis::X : Axis::Z;
+        return allowed;
+      }
 
-        if (std::abs(newX - center.x) < std::abs(d.x))
-          d.x = newX - center.x;
+      // step onto the obstacle
+      aabb.center.y  += rise;
+      result.stepped += rise;
+    }
+  }
 
-        axis |= Axis::X;
+  return d;
+}
 
-        if (storeCell) {
-          *cell = &GetCell(center+v+ddx);
-          if (side) *side = d.x > 0 ? Side::Left : Side::Right;
-          storeCell = false;
-        }
-        break;
-      }
+/**
+ * Check whether any of the cell sides in front of a AABB blocks it.
+ * @param aabb The AABB.
+ * @param along Axis of the movement.
+ * @param across The other horizontal axis.
+ * @param from Cell coordinate along the axis of the cells the AABB leaves.
+ * @param side Side of the cells the AABB leaves through.
+ * @param sneak If true, prevent falling from ledges.
+ * @param[out] top Highest top of a blocking cell, INFINITY if it can't be
+ *             stepped onto.
+ * @param[out] hitPos Position of a blocking cell.
+ * @return true if movement is blocked.
+ */
+bool
+World::IsSideBlocked(
+  const AABB &aabb,
+  float Vector3::*along,
+  float Vector3::*across,
+  int from,
+  Side side,
+  bool sneak,
+  float &top,
+  IVector3 &hitPos
+) const {
+  Vector3 min = aabb.Min();
+  Vector3 max = aabb.Max();
+
+  bool blocked = false;
+  top = -INFINITY;
+
+  int y0 = std::floor(min.y), y1 = std::floor(max.y);
+  int a0 = std::floor(min.*across), a1 = std::floor(max.*across);
+
+  for (int y = y0; y <= y1; y++) {
+    // only the part of the AABB in this row can hit the cell
+    float bottom = std::max(min.y, (float)y);
+
+    for (int a = a0; a <= a1; a++) {
+      IVector3 pos = along == &Vector3::x ? IVector3(from, y, a) : IVector3(a, y, from);
+
+      float cellTop;
+      if (!this->IsCellSideBlocked(pos, side, bottom, min.*across - a, max.*across - a, sneak && y == y0, cellTop)) continue;
+
+      if (!blocked || cellTop > top) hitPos = pos[side];
+      blocked = true;
+      top = std::max(top, cellTop);
     }
+  }
 
-    // update center to new position
-    center.x += d.x;
+  return blocked;
+}
 
-    // try to move along the z axis
-    Vector3 ddz(0, 0, d.z + (d.z>0?0.01:-0.01));
+/**
+ * Check solidity of a cells side, like Cell::CheckSideSolid, for a part of
+ * the side.
+ * @param pos Position of the cell that is left.
+ * @param side Side of the cell that is left through.
+ * @param bottom Lowest point of the part of the AABB in the cell row.
+ * @param from Start of the part of the side, in local coordinates.
+ * @param to End of the part of the side, in local coordinates.
+ * @param sneak If true, prevent going over ledges.
+ * @param[out] top Top of the adjacent cell, INFINITY if it can't be stepped
+ *             onto.
+ * @return true if movement out of the cell is clipped.
+ */
+bool
+World::IsCellSideBlocked(
+  const IVector3 &pos,
+  Side side,
+  float bottom,
+  float from,
+  float to,
+  bool sneak,
+  float &top
+) const {
+  top = INFINITY;
+
+  size_t index = this->GetCellIndexOrDefault(pos);
+  if (index == this->GetCellCount()) return true;
+
+  IVector3 next = pos[side];
+  size_t nextIndex = this->GetCellIndexOrDefault(next);
+
+  if (sneak) {
+    CellCollision below;
+    if (this->GetSolidCollision(pos[Side::Down], below) && !this->GetSolidCollision(next[Side::Down], below)) return true;
+  }
 
-    for (const Vector3 &v : verts) {
-      if (CastRayZ(center + v, d.z, sneak) || IsPointSolid(center + v + ddz)) {
-        float newZ = d.z;
-        if (d.z > 0) {
-          newZ = ((int)center.z + 1) - aabb.extents.z - 0.01f;
-        } else if (d.z < 0) {
-          newZ = ((int)center.z) + aabb.extents.z + 0.01f;
-        }
+  // check for clipping movement out the cell
+  if (GetCellProperties(this->cells.types[index]).clipSidesOut & (1 << side)) return true;
 
-        if (std::abs(newZ - center.z) < std::abs(d.z))
-          d.z = newZ - center.z;
+  // check for clipping movement into cell from opposite side
+  if (!(GetCellProperties(this->cells.types[nextIndex]).clipSidesIn & (1 << (-side)))) return false;
 
-        axis |= Axis::Z;
+  // only the part of the adjacent cell below its top blocks
+  CellCollision collision = this->cells.GetCollision(nextIndex);
+  float edge = (side == Side::Right || side == Side::Forward) ? 0.0f : 1.0f;
+  float highest, lowest;
 
-        if (storeCell) {
-          *cell = &GetCell(center+v+ddz);
-          if (side) *side = d.z > 0 ? Side::Backward : Side::Forward;
-          storeCell = false;
-        }
-        break;
-      }
-    }
+  if (side == Side::Right || side == Side::Left) {
+    collision.GetRange(edge, from, edge, to, highest, lowest);
+  } else {
+    collision.GetRange(from, edge, to, edge, highest, lowest);
+  }
 
-    // update center to new position
-    center.z += d.z;
+  top = pos.y + highest;
+  return bottom < top;
+}
 
-    if (axis & Axis::X) target.x = center.x;
-    if (axis & Axis::Z) target.z = center.z;
+/**
+ * Sweep a AABB along the y axis. Each column of cells below or above the
+ * AABB is scanned up to the first solid cell within reach.
+ * @param aabb The AABB.
+ * @param d Movement along the y axis.
+ * @param[out] hitPos Position of the cell that limits the movement.
+ * @return How far the AABB can move. Might be opposite to @a d when the
+ *         AABB is inside a cell, pushing it out.
+ */
+float
+World::SweepVertical(const AABB &aabb, float d, IVector3 *hitPos) const {
+  if (d == 0.0f) return 0.0f;
 
-    // check if nothing left to do for horizontal movement
-    if (axis & Axis::X && axis & Axis::Z) break;
+  Vector3 min = aabb.Min();
+  Vector3 max = aabb.Max();
 
-    // was this the final pass?
-    if (!keepGoing) break;
-  }
+  float allowed = d;
+  CellCollision collision;
 
-  // now try to move along y axis
-  if (movingUp) {
-    float endY = this->proto.size_y();
-    // get lowest collision point
-    for (const Vector3 &v : verts) {
-      if (v.y <= 0.0f) continue;
-      float vY = CastRayYUp(center+v);
-      if (vY < endY) {
-        endY = vY;
+  for (int z = std::floor(min.z); z <= std::floor(max.z); z++) {
+    for (int x = std::floor(min.x); x <= std::floor(max.x); x++) {
+      float highest, lowest;
 
-        if (storeCell && endY - aabb.extents.y < target.y) {
-          Vector3 end = center + v;
-          end.y = endY + 0.01;
-          *cell = &GetCell(end);
-          if (side) *side = Side::Down;
-          storeCell = false;
-        }
-      }
-    }
+      if (d < 0.0f) {
+        for (int y = std::floor(min.y); y >= std::floor(min.y + d); y--) {
+          if (!this->GetSolidCollision(IVector3(x,y,z), collision)) continue;
 
-    if (endY - aabb.extents.y < target.y) {
-      // we are too high, move top of aabb to collision height
-      axis |= Axis::Y;
-      target.y = endY - aabb.extents.y - 0.001f;
-    }
-  } else {
-    float endY = 0;
-    // get highest collision point
-    for (const Vector3 &v : verts) {
-      if (v.y >= 0.0f) continue;
-      float vY = CastRayYDown(center+v);
-      if (vY > endY) {
-        endY = vY;
-
-        if (storeCell && endY + aabb.extents.y > target.y) {
-          Vector3 end = center + v;
-          end.y = endY + 0.01;
-          *cell = &GetCell(end);
-          if (side) *side = Side::Up;
-          storeCell = false;
+          collision.GetRange(min.x - x, min.z - z, max.x - x, max.z - z, highest, lowest);
+          float dist = y + highest + 0.001f - min.y;
+          if (dist > allowed) {
+            allowed = dist;
+            if (hitPos) *hitPos = IVector3(x,y,z);
+          }
+          break;
+        }
+      } else {
+        for (int y = std::floor(max.y); y <= std::floor(max.y + d); y++) {
+          if (!this->GetSolidCollision(IVector3(x,y,z), collision)) continue;
+
+          collision.GetRange(min.x - x, min.z - z, max.x - x, max.z - z, highest, lowest);
+          float dist = y + lowest - 0.001f - max.y;
+          if (dist < allowed) {
+            allowed = dist;
+            if (hitPos) *hitPos = IVector3(x,y,z);
+          }
+          break;
         }
       }
     }
-    if (endY + aabb.extents.y > target.y) {
-      // we are too low, move top of aabb to collision height
-      axis |= Axis::Y;
-      target.y = endY + aabb.extents.y + 0.001f;
-    }
   }
 
-  // update y position
-  center.y = target.y;
-
-  // done
-  return center;
+  return allowed;
 }
 
 Vector3
@@ -746,7 +1040,7 @@ World::Dump() {
  * @note This will always return a cell. Outside the world or on the boundaries
  *       it will be the default cell, which has no world or position value.
  */
-Cell &
+Cell
 World::CastRayCell(const Vector3 &org, const Vector3 &dir, float &distance, Side &side, size_t flags) const {
   int dx = dir.x == 0 ? 0 : (dir.x > 0 ? 1 : -1);
   int dy = dir.y == 0 ? 0 : (dir.y > 0 ? 1 : -1);
@@ -757,17 +1051,26 @@ World::CastRayCell(const Vector3 &org, const Vector3 &dir, float &distance, Side
   size_t y = pos.y; // start cell y
   size_t z = pos.z; // start cell z
 
-  Cell *currentCell = nullptr;
+  bool visited = false;
+  IVector3 lastPos;
 
   while (IsValidCellPosition(IVector3(x,y,z))) {
-    currentCell = &this->GetCell(IVector3(x,y,z));
+    lastPos = IVector3(x,y,z);
+    visited = true;
+
+    // only cells with matching flags need the exact test against their
+    // triangles, everything else is skipped by looking at the type
+    size_t i = this->GetCellIndex(lastPos);
+    if (GetCellProperties(this->cells.types[i]).flags & flags) {
+      Cell currentCell = this->GetCell(lastPos);
 
-    float tt;
-    Vector3 p;
+      float tt;
+      Vector3 p;
 
-    if ((currentCell->GetInfo().flags & flags) && currentCell->Ray(org, dir, tt, p) && tt > 0) {
-      distance = tt;
-      return *currentCell;
+      if (currentCell.Ray(org, dir, tt, p) && tt > 0) {
+        distance = tt;
+        return currentCell;
+      }
     }
 
     float u = INFINITY;
@@ -798,8 +1101,8 @@ World::CastRayCell(const Vector3 &org, const Vector3 &dir, float &distance, Side
     }
   }
 
-  if (!currentCell) return defaultCell;
-  return *currentCell;
+  if (!visited) return this->GetDefaultCell(IVector3(x,y,z));
+  return this->GetCell(lastPos);
 }
 
 /**
@@ -811,33 +1114,59 @@ World::CastRayCell(const Vector3 &org, const Vector3 &dir, float &distance, Side
 bool
 World::IsDefault(const IVector3 &pos) const {
   if (!IsValidCellPosition(pos)) return true;
-  return defaultMask[GetCellIndex(pos)];
+  return this->cells.bits[GetCellIndex(pos)] & CellStore::Default;
 }
 
+/**
+ * Replace all cells of the world.
+ * @param cells Store with one cell for each position in the world.
+ */
 void
-World::ClearDefaults() {
-  this->defaultMask = std::vector<bool>(this->GetCellCount(), true);
-}
+World::CopyCellsFrom(const CellStore &cells) {
+  size_t count = this->GetCellCount();
 
-void
-World::CopyCellsFrom(const std::vector<Cell> &cells) {
   this->cells = cells;
-  for (size_t i=0; i<this->GetCellCount(); i++) {
-    this->cells[i].SetWorld(this, GetCellPos(i));
+  this->cells.Resize(count + 1);
+  this->cells.Reset(count);
+  this->cellGeneration++;
+
+  // pick the texture variants of one slice of the world per job, each
+  // with a random stream of its own
+  IVector3 size     = this->GetSize();
+  size_t sliceSize  = size.x * size.y;
+  uint32_t seed     = this->state.GetRandom().Integer();
+  this->workerPool->Run(size.z, [&](size_t z) {
+    Random random(seed, z);
+    for (size_t i=z*sliceSize; i<(z+1)*sliceSize; i++) {
+      const CellProperties &info = GetCellProperties(this->cells.types[i]);
+      this->cells.bits[i]    |= CellStore::Default;
+      this->cells.variants[i] = info.textures.empty() ? 0 : random.Integer(info.textures.size());
+    }
+  });
+
+  // all cells are new, so all of them need their neighbours checked
+  this->neighbourUpdates.resize(count);
+  for (size_t i=0; i<count; i++) {
+    this->neighbourUpdateMarks[i] = true;
+    this->neighbourUpdates[i] = i;
   }
-  this->ClearDefaults();
+  this->liquidSimulator->WakeAll();
+  this->navField->Invalidate();
+
+  Log("%u cells use %u bytes\n", count, this->cells.GetMemoryUsage());
 }
 
 void
 World::BreakBlock(const IVector3 &pos) {
   const CellProperties &info = this->GetCell(pos).GetInfo();
 
-  if (info.type == "air") return;
+  static const Symbol air("air");
+  if (info.type == air) return;
 
-  std::string particleType = info.breakParticle;
-  AABB aabb = this->SetCell(pos, Cell("air")).GetAABB();
+  Symbol particleType = info.breakParticle;
+  AABB aabb = this->SetCell(pos, Cell(air)).GetAABB();
 
-  if (particleType != "") {
+  if (!particleType.IsEmpty()) {
     Random &random = state.GetRandom();
     for (size_t i=0; i<4; i++) {
       state.SpawnInAABB(particleType, aabb, Vector3::Random(random));
@@ -852,9 +1181,9 @@ World::BreakBlock(const IVector3 &pos) {
 
 bool
 World::IsCellWalkable(const IVector3 &pos) const {
-  const Cell &cell = GetCell(pos);
-  const Cell &cell2 = cell[Side::Up];
-  const Cell &cell3 = cell2[Side::Up];
+  Cell cell = GetCell(pos);
+  Cell cell2 = cell[Side::Up];
+  Cell cell3 = cell2[Side::Up];
   return cell.IsSolid() && !cell2.IsSolid() && !cell2.IsLiquid() && !cell3.IsSolid() && !cell3.IsLiquid();
 }
 
@@ -864,7 +1193,7 @@ World::IsCellValidTeleportTarget(const IVector3 &pos, const Vector3 &extents) co
   aabb.center = Vector3(pos.x+0.5, pos.y + 1.01 + extents.y, pos.z + 0.5);
   aabb.extents = extents;
 
-  Cell &cell = GetCell(pos);
+  Cell cell = GetCell(pos);
 
   return
     !cell.IsTrigger() &&
@@ -880,9 +1209,9 @@ World::IsCellValidTeleportTarget(const IVector3 &pos, const Vector3 &extents) co
 
 bool
 World::IsCellValidCeiling(const IVector3 &pos) const {
-  const Cell &cell = GetCell(pos);
-  const Cell &cell2 = cell[Side::Down];
-  const Cell &cell3 = cell2[Side::Down];
+  Cell cell = GetCell(pos);
+  Cell cell2 = cell[Side::Down];
+  Cell cell3 = cell2[Side::Down];
   return cell.IsBottomFlat() && cell.IsSolid() && !cell2.IsSolid() && !cell2.IsLiquid() && !cell3.IsSolid() && !cell3.IsLiquid();
 }
 
@@ -929,24 +1258,638 @@ World::GetRandomCeiling(Random &random) const {
 }
 
 void World::TriggerOn(size_t id) {
-  for (size_t i=0; i<this->GetCellCount(); i++) {
-    if (this->cells[i].GetTriggerId() == id) this->cells[i].TriggerOn();
+  // only cells with extra data can have a trigger id
+  for (auto &extra : this->cells.extras) {
+    if (extra.first < this->GetCellCount() && extra.second.triggerId == id) this->GetCell(extra.first).TriggerOn();
   }
 }
 
 void World::TriggerOff(size_t id) {
-  for (size_t i=0; i<this->GetCellCount(); i++) {
-    if (this->cells[i].GetTriggerId() == id) this->cells[i].TriggerOff();
+  for (auto &extra : this->cells.extras) {
+    if (extra.first < this->GetCellCount() && extra.second.triggerId == id) this->GetCell(extra.first).TriggerOff();
   }
 }
 
-const World_Proto &
-World::GetProto() {
+/**
+ * Remember the current cells as the freshly built world, saves only store
+ * the cells that differ from it.
+ */
+void
+World::SetBaseline() {
+  this->baseCells = std::make_shared<const CellStore>(this->cells);
+}
+
+/**
+ * Get a checksum of the cells right after the world was built. Cell types
+ * go in by name, their indices may differ from one run to the next.
+ * @return The checksum.
+ */
+uint64_t
+World::GetBaselineChecksum() const {
+  const CellStore &cells = *this->baseCells;
+  size_t count = this->GetCellCount();
+
+  std::vector<uint64_t> typeChecksums;
+  for (size_t i=0; i<GetCellTypeCount(); i++) {
+    const std::string &name = GetCellProperties(i).type.GetString();
+    typeChecksums.push_back(Checksum(name.data(), name.size()));
+  }
+
+  uint64_t checksum = 14695981039346656037ull;
+  for (size_t i=0; i<count; i++) {
+    checksum = (checksum ^ typeChecksums[cells.types[i]]) * 1099511628211ull;
+  }
+
+  uint64_t planes[] = {
+    Checksum(cells.bits.data(),     count * sizeof(uint16_t)),
+    Checksum(cells.features.data(), count * sizeof(uint16_t)),
+    Checksum(cells.liquid.data(),   count),
+    Checksum(cells.variants.data(), count),
+  };
+  for (uint64_t plane : planes) {
+    checksum = (checksum ^ plane) * 1099511628211ull;
+  }
+  return checksum;
+}
+
+/**
+ * Take a snapshot of the world for saving. Only a plain copy of the cells
+ * is made here, comparing them to the baseline and packing the changes is
+ * left to the returned function, which may run on another thread.
+ * @param snapshot Receives the world proto without any cells.
+ * @return Function that adds the changed cells as deltas.
+ */
+std::function<void(std::vector<std::unique_ptr<CellDelta_Proto>> &)>
+World::GetSnapshot(World_Proto &snapshot) {
   *this->proto.mutable_mini_map() = this->minimap.GetProto();
+  snapshot = this->proto;
 
-  // TODO: save default mask
+  // cell type indices are only valid for this run, store them by name
+  for (size_t i=0; i<GetCellTypeCount(); i++) {
+    snapshot.add_cell_type_names(GetCellProperties(i).type.GetString());
+  }
 
-  return this->proto;
+  auto cells = std::make_shared<const CellStore>(this->cells);
+  auto base  = this->baseCells;
+
+  return [cells, base](std::vector<std::unique_ptr<CellDelta_Proto>> &deltas) {
+    SaveDelta(*cells, base.get(), deltas);
+  };
+}
+
+template<class T> static void
+PackPlane(const std::vector<T> &plane, size_t count, std::string *out) {
+  out->resize(count * sizeof(T));
+  for (size_t i=0; i<count; i++) {
+    for (size_t b=0; b<sizeof(T); b++) {
+      (*out)[i*sizeof(T)+b] = (char)(plane[i] >> (8*b));
+    }
+  }
+}
+
+template<class T> static bool
+UnpackPlane(const std::string &in, std::vector<T> &plane, size_t count) {
+  if (in.size() != count * sizeof(T)) return false;
+  if (plane.size() < count) plane.resize(count);
+
+  for (size_t i=0; i<count; i++) {
+    T v = 0;
+    for (size_t b=0; b<sizeof(T); b++) {
+      v |= (T)((uint8_t)in[i*sizeof(T)+b]) << (8*b);
+    }
+    plane[i] = v;
+  }
+  return true;
+}
+
+/**
+ * Get the sparse data of a cell.
+ * @param cells Cell store.
+ * @param i Cell index.
+ * @param[out] cellProto Receives the data.
+ * @return false if the cell has no sparse data.
+ */
+static bool
+GetSparseCell(const CellStore &cells, size_t i, SparseCell_Proto &cellProto) {
+  const CellShape *shape = cells.FindShape(i);
+  const CellExtra *extra = cells.FindExtra(i);
+  if (!shape && !extra) return false;
+
+  cellProto.Clear();
+  cellProto.set_index(i);
+
+  if (shape) {
+    auto top = cellProto.mutable_top_heights();
+    top->set_a(shape->top[0]);
+    top->set_b(shape->top[1]);
+    top->set_c(shape->top[2]);
+    top->set_d(shape->top[3]);
+
+    auto bottom = cellProto.mutable_bottom_heights();
+    bottom->set_a(shape->bottom[0]);
+    bottom->set_b(shape->bottom[1]);
+    bottom->set_c(shape->bottom[2]);
+    bottom->set_d(shape->bottom[3]);
+
+    cellProto.set_scale_x(shape->scale.x);
+    cellProto.set_scale_y(shape->scale.y);
+    cellProto.set_scale_z(shape->scale.z);
+  }
+
+  if (extra) {
+    if (extra->lockId != InvalidID)          cellProto.set_lock_id(extra->lockId);
+    if (extra->teleportTarget != InvalidID)  cellProto.set_teleport_target(extra->teleportTarget);
+    if (extra->triggerTargetId != InvalidID) cellProto.set_trigger_target_id(extra->triggerTargetId);
+    if (extra->triggerId != InvalidID) {
+      cellProto.set_trigger_id(extra->triggerId);
+      cellProto.set_is_trigger_toggle(extra->isTriggerToggle);
+    }
+
+    if (extra->spawnMobType != "") {
+      auto spawn = cellProto.mutable_spawn_on_active();
+      spawn->set_mob_type(extra->spawnMobType);
+      spawn->set_side((uint32_t)extra->spawnSide);
+      spawn->set_rate(extra->spawnRate);
+    }
+
+    cellProto.set_next_activation_time(extra->nextActivationTime);
+    cellProto.set_last_use_time(extra->lastUseTime);
+  }
+
+  return true;
+}
+
+/**
+ * Check whether a cell differs from the same cell in another store. Light
+ * follows from the cells and is ignored. Extra data holds game times that
+ * depend on when the world was built, so cells with extra data always 
+ * differ.
+ * @param cells Cell store.
+ * @param base Store to compare with, nullptr if all cells differ.
+ * @param i Cell index.
+ * @return true if the cell differs.
+ */
+static bool
+IsCellChanged(const CellStore &cells, const CellStore *base, size_t i) {
+  if (!base) return true;
+
+  static constexpr uint16_t savedBits  = CellStore::ContentBits | CellStore::Default | CellStore::HasShape;
+
+  if (cells.types[i]    != base->types[i]    ||
+      cells.features[i] != base->features[i] ||
+      cells.liquid[i]   != base->liquid[i]   ||
+      (cells.bits[i] & savedBits) != (base->bits[i] & savedBits)) return true;
+
+  if ((cells.bits[i] | base->bits[i]) & CellStore::HasExtra) return true;
+  if (!(cells.bits[i] & CellStore::HasShape)) return false;
+
+  SparseCell_Proto a, b;
+  GetSparseCell(cells, i, a);
+  GetSparseCell(*base, i, b);
+  return a.SerializeAsString() != b.SerializeAsString();
+}
+
+/**
+ * Write all cells that differ from a baseline as deltas of consecutive
+ * runs of cells. Only uses its arguments, so that it can run on another
+ * thread.
+ * @param cells Cells of the world, including the default cell at the end.
+ * @param base Cells of the freshly built world, nullptr to write all cells.
+ * @param deltas Receives the deltas.
+ */
+void
+World::SaveDelta(const CellStore &cells, const CellStore *base, std::vector<std::unique_ptr<CellDelta_Proto>> &deltas) {
+  size_t count = cells.GetCount() - 1;
+
+  std::unique_ptr<CellDelta_Proto> delta;
+  std::vector<uint16_t> types, bits, features;
+  std::vector<uint8_t>  liquid;
+  size_t next      = 0;
+  size_t runLength = 0;
+
+  auto flush = [&]() {
+    if (!delta) return;
+
+    size_t n = types.size();
+    PackPlane(types,    n, delta->mutable_cell_types());
+    PackPlane(bits,     n, delta->mutable_cell_bits());
+    PackPlane(features, n, delta->mutable_cell_features());
+    PackPlane(liquid,   n, delta->mutable_cell_liquid());
+    deltas.push_back(std::move(delta));
+
+    types.clear(); bits.clear(); features.clear(); liquid.clear();
+  };
+
+  SparseCell_Proto cellProto;
+  for (size_t i=0; i<count; i++) {
+    if (!IsCellChanged(cells, base, i)) {
+      if (runLength) {
+        delta->add_runs(runLength);
+        runLength = 0;
+        if (types.size() >= deltaCellsPerChunk) flush();
+      }
+      continue;
+    }
+
+    if (!delta) {
+      delta.reset(new CellDelta_Proto());
+      delta->set_base(i);
+      next = i;
+    }
+    if (!runLength) delta->add_runs(i - next);
+    runLength++;
+    next = i + 1;
+
+    types.push_back(cells.types[i]);
+    bits.push_back(cells.bits[i] & (CellStore::ContentBits | CellStore::Default));
+    features.push_back(cells.features[i]);
+    liquid.push_back(cells.liquid[i]);
+
+    if (GetSparseCell(cells, i, cellProto)) {
+      *delta->add_sparse_cells() = cellProto;
+    }
+  }
+
+  if (runLength) delta->add_runs(runLength);
+  flush();
+}
+
+/**
+ * Read all cells from a proto written by SaveCells.
+ * @param proto The world proto.
+ */
+void
+World::LoadCells(const World_Proto &proto) {
+  size_t count = proto.size_x() * proto.size_y() * proto.size_z();
+  this->cells.Resize(count + 1);
+
+  std::vector<uint16_t> typeMap;
+  for (auto &name : proto.cell_type_names()) {
+    typeMap.push_back(GetCellProperties(name).index);
+  }
+
+  std::vector<uint16_t> types(count, 0);
+  UnpackPlane(proto.cell_types(), types, count);
+  for (size_t i=0; i<count; i++) {
+    if (types[i] < typeMap.size()) this->cells.types[i] = typeMap[types[i]];
+  }
+
+  UnpackPlane(proto.cell_bits(),      this->cells.bits,     count);
+  UnpackPlane(proto.cell_features(),  this->cells.features, count);
+  UnpackPlane(proto.cell_liquid(),    this->cells.liquid,   count);
+  UnpackPlane(proto.cell_light_r(),   this->cells.lightR,   count);
+  UnpackPlane(proto.cell_light_g(),   this->cells.lightG,   count);
+  UnpackPlane(proto.cell_light_b(),   this->cells.lightB,   count);
+
+  for (size_t i=0; i<count; i++) {
+    this->cells.bits[i] &= CellStore::ContentBits | CellStore::Default;
+  }
+
+  for (auto &cellProto : proto.sparse_cells()) {
+    this->LoadSparseCell(cellProto);
+  }
+
+  for (size_t i=0; i<count; i++) {
+    this->GetCell(i).Start();
+  }
+}
+
+/**
+ * Set the sparse data of a cell.
+ * @param cellProto The sparse data.
+ */
+void
+World::LoadSparseCell(const SparseCell_Proto &cellProto) {
+  if (cellProto.index() >= this->GetCellCount()) return;
+
+  Cell cell(&this->cells, this, cellProto.index(), GetCellPos(cellProto.index()));
+
+  if (cellProto.has_top_heights()) {
+    auto &top = cellProto.top_heights();
+    cell.SetTopHeights(top.a(), top.b(), top.c(), top.d());
+  }
+  if (cellProto.has_bottom_heights()) {
+    auto &bottom = cellProto.bottom_heights();
+    cell.SetBottomHeights(bottom.a(), bottom.b(), bottom.c(), bottom.d());
+  }
+  if (cellProto.has_scale_x()) {
+    cell.SetScale(Vector3(cellProto.scale_x(), cellProto.scale_y(), cellProto.scale_z()));
+  }
+
+  if (cellProto.has_lock_id())            cell.SetLockID(cellProto.lock_id());
+  if (cellProto.has_teleport_target())    cell.SetTeleportTarget(cellProto.teleport_target());
+  if (cellProto.has_trigger_target_id())  cell.SetTriggerTarget(cellProto.trigger_target_id());
+  if (cellProto.has_trigger_id())         cell.SetTrigger(cellProto.trigger_id(), cellProto.is_trigger_toggle());
+  if (cellProto.has_spawn_on_active()) {
+    auto &spawn = cellProto.spawn_on_active();
+    cell.SetSpawnOnActive(spawn.mob_type(), (Side)spawn.side(), spawn.rate());
+  }
+  if (cellProto.has_next_activation_time()) cell.SetNextActivationTime(cellProto.next_activation_time());
+  if (cellProto.has_last_use_time())        cell.SetLastUseTime(cellProto.last_use_time());
+}
+
+/**
+ * Restore the state of the world apart from the cells from a snapshot 
+ * written by GetSnapshot.
+ * @param proto The world proto.
+ */
+void
+World::LoadSnapshot(const World_Proto &proto) {
+  this->proto.set_next_tick_time(proto.next_tick_time());
+
+  this->minimap.LoadProto(proto.mini_map());
+}
+
+/**
+ * Replace cells by those of a delta written by SaveDelta.
+ * @param proto The world proto of the snapshot, for the cell type names.
+ * @param delta The delta.
+ * @return false if the delta is broken.
+ */
+bool
+World::LoadDelta(const World_Proto &proto, const CellDelta_Proto &delta) {
+  size_t count = this->GetCellCount();
+
+  std::vector<uint16_t> typeMap;
+  for (auto &name : proto.cell_type_names()) {
+    typeMap.push_back(GetCellProperties(name).index);
+  }
+
+  if (delta.runs_size() % 2) return false;
+
+  size_t n = 0;
+  for (int r=1; r<delta.runs_size(); r+=2) {
+    n += delta.runs(r);
+  }
+
+  std::vector<uint16_t> types, bits, features;
+  std::vector<uint8_t>  liquid;
+  if (!UnpackPlane(delta.cell_types(),    types,    n) ||
+      !UnpackPlane(delta.cell_bits(),     bits,     n) ||
+      !UnpackPlane(delta.cell_features(), features, n) ||
+      !UnpackPlane(delta.cell_liquid(),   liquid,   n)) return false;
+
+  std::unordered_map<size_t, const SparseCell_Proto *> sparseCells;
+  for (auto &cellProto : delta.sparse_cells()) {
+    sparseCells[cellProto.index()] = &cellProto;
+  }
+
+  size_t i = delta.base();
+  size_t k = 0;
+  for (int r=0; r<delta.runs_size(); r+=2) {
+    i += delta.runs(r);
+
+    for (size_t j=0; j<delta.runs(r+1); j++, i++, k++) {
+      if (i >= count) return false;
+
+      if (types[k] < typeMap.size()) this->cells.types[i] = typeMap[types[k]];
+      this->cells.bits[i]     = (this->cells.bits[i] & ~(CellStore::ContentBits | CellStore::Default)) |
+                                (bits[k] & (CellStore::ContentBits | CellStore::Default));
+      this->cells.features[i] = features[k];
+      this->cells.liquid[i]   = liquid[k];
+
+      this->cells.ClearShape(i);
+      this->cells.ClearExtra(i);
+      auto iter = sparseCells.find(i);
+      if (iter != sparseCells.end()) this->LoadSparseCell(*iter->second);
+
+      // same as SetCell
+      IVector3 pos = this->GetCellPos(i);
+      this->cellGeneration++;
+      this->lightEngine->CellChanged(i);
+      this->liquidSimulator->WakeAround(i);
+      this->navField->CellChanged(pos);
+
+      this->GetCell(i).Start();
+      this->UpdateCell(i);
+      this->MarkChunksDirty(pos);
+    }
+  }
+
+  return k == n;
+}
+
+/**
+ * Header of a cell snapshot file written by GetCellSnapshot. 
+ * The header is followed by these sections, each starting at a multiple
+ * of eight bytes:
+ *  - the cell type names, each terminated by a zero byte,
+ *  - the cell planes one after another: types (indices into the type
+ *    names), bits, features, liquid, light red, green and blue, 
+ *    visibility and texture variants,
+ *  - the cells with shapes or extras as size prefixed SparseCell_Proto
+ *    messages.
+ * Numbers are stored as they are in memory. A file written on a machine
+ * with a different byte order is rejected because of its magic number.
+ */
+struct CellSnapshotHeader final {
+  static constexpr uint32_t Magic   = 0x53434642; // "BFCS"
+  static constexpr uint32_t Version = 1;
+
+  uint32_t magic;
+  uint32_t version;
+
+  /** Identifies the level the cells belong to. */
+  uint64_t key;
+
+  uint32_t sizeX, sizeY, sizeZ;
+  uint32_t typeCount;
+
+  uint64_t typeNamesOffset;
+  uint64_t planesOffset;
+  uint64_t sparseOffset;
+  uint64_t sparseSize;
+
+  /** Checksum of everything after the header. */
+  uint64_t checksum;
+};
+
+static size_t
+AlignSnapshotSection(size_t size) {
+  return (size + 7) & ~size_t(7);
+}
+
+template<class T> static void
+AppendSnapshotPlane(std::string &data, const std::vector<T> &plane, size_t count) {
+  size_t offset = data.size();
+  data.resize(AlignSnapshotSection(offset + count * sizeof(T)));
+  memcpy(&data[offset], plane.data(), count * sizeof(T));
+}
+
+template<class T> static const char *
+ReadSnapshotPlane(const char *p, std::vector<T> &plane, size_t count) {
+  memcpy(plane.data(), p, count * sizeof(T));
+  return p + AlignSnapshotSection(count * sizeof(T));
+}
+
+static size_t
+GetSnapshotPlanesSize(size_t count) {
+  return 3 * AlignSnapshotSection(count * sizeof(uint16_t)) + 6 * AlignSnapshotSection(count);
+}
+
+/**
+ * Take a snapshot of the cells right after the world was built (see
+ * SetBaseline) in a form that LoadCellSnapshot can load without building
+ * the world again. Only the baseline is copied here, the returned function
+ * writes the file and may run on another thread.
+ * @param key Identifies the level, LoadCellSnapshot rejects snapshots of
+ *            other levels.
+ * @return Function that appends the contents of the file.
+ */
+std::function<void(std::string &)>
+World::GetCellSnapshot(uint64_t key) const {
+  std::vector<std::string> typeNames;
+  for (size_t i=0; i<GetCellTypeCount(); i++) {
+    typeNames.push_back(GetCellProperties(i).type.GetString());
+  }
+
+  auto cells = this->baseCells;
+  IVector3 size = this->GetSize();
+
+  return [cells, size, typeNames, key](std::string &data) {
+    WriteCellSnapshot(*cells, size, typeNames, key, data);
+  };
+}
+
+void
+World::WriteCellSnapshot(const CellStore &cells, const IVector3 &size, const std::vector<std::string> &typeNames, uint64_t key, std::string &data) {
+  size_t count = size.x * size.y * size.z;
+  size_t start = data.size();
+
+  CellSnapshotHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic     = CellSnapshotHeader::Magic;
+  header.version   = CellSnapshotHeader::Version;
+  header.key       = key;
+  header.sizeX     = size.x;
+  header.sizeY     = size.y;
+  header.sizeZ     = size.z;
+  header.typeCount = typeNames.size();
+
+  data.resize(start + AlignSnapshotSection(sizeof(header)));
+
+  header.typeNamesOffset = data.size() - start;
+  for (const std::string &name : typeNames) {
+    data.append(name.c_str(), name.size() + 1);
+  }
+  data.resize(start + AlignSnapshotSection(data.size() - start));
+
+  header.planesOffset = data.size() - start;
+  AppendSnapshotPlane(data, cells.types,      count);
+  AppendSnapshotPlane(data, cells.bits,       count);
+  AppendSnapshotPlane(data, cells.features,   count);
+  AppendSnapshotPlane(data, cells.liquid,     count);
+  AppendSnapshotPlane(data, cells.lightR,     count);
+  AppendSnapshotPlane(data, cells.lightG,     count);
+  AppendSnapshotPlane(data, cells.lightB,     count);
+  AppendSnapshotPlane(data, cells.visibility, count);
+  AppendSnapshotPlane(data, cells.variants,   count);
+
+  header.sparseOffset = data.size() - start;
+  SparseCell_Proto cellProto;
+  for (size_t i=0; i<count; i++) {
+    if (GetSparseCell(cells, i, cellProto)) {
+      appendDelimited(cellProto, data);
+    }
+  }
+  header.sparseSize = data.size() - start - header.sparseOffset;
+
+  size_t headerSize = AlignSnapshotSection(sizeof(header));
+  header.checksum = Checksum(data.data() + start + headerSize, data.size() - start - headerSize);
+  memcpy(&data[start], &header, sizeof(header));
+}
+
+/**
+ * Replace all cells by those of a snapshot written by GetCellSnapshot.
+ * The world is left untouched if the snapshot does not fit.
+ * @param data Contents of the snapshot file.
+ * @param size Size of the snapshot file.
+ * @param key Identifies the level that is expected.
+ * @return false if the snapshot is broken, outdated or of another level.
+ */
+bool
+World::LoadCellSnapshot(const char *data, size_t size, uint64_t key) {
+  PROFILE();
+
+  CellSnapshotHeader header;
+  size_t headerSize = AlignSnapshotSection(sizeof(header));
+  if (size < headerSize) return false;
+  memcpy(&header, data, sizeof(header));
+
+  if (header.magic != CellSnapshotHeader::Magic || header.version != CellSnapshotHeader::Version) {
+    Log("cell snapshot has an unknown format\n");
+    return false;
+  }
+  if (header.key != key || IVector3(header.sizeX, header.sizeY, header.sizeZ) != this->GetSize()) {
+    Log("cell snapshot is of a different level\n");
+    return false;
+  }
+
+  size_t count = this->GetCellCount();
+  if (header.typeNamesOffset < headerSize ||
+      header.planesOffset < header.typeNamesOffset ||
+      header.planesOffset + GetSnapshotPlanesSize(count) > header.sparseOffset ||
+      header.sparseOffset + header.sparseSize != size) {
+    Log("cell snapshot is truncated\n");
+    return false;
+  }
+  if (Checksum(data + headerSize, size - headerSize) != header.checksum) {
+    Log("cell snapshot is broken\n");
+    return false;
+  }
+
+  // cell type indices are only valid for this run, map them by name
+  std::vector<uint16_t> typeMap;
+  const char *name = data + header.typeNamesOffset;
+  const char *namesEnd = data + header.planesOffset;
+  for (size_t t=0; t<header.typeCount; t++) {
+    const char *nameEnd = static_cast<const char *>(memchr(name, 0, namesEnd - name));
+    if (!nameEnd) return false;
+    typeMap.push_back(GetCellProperties(std::string(name, nameEnd)).index);
+    name = nameEnd + 1;
+  }
+
+  const char *p = data + header.planesOffset;
+  p = ReadSnapshotPlane(p, this->cells.types,      count);
+  p = ReadSnapshotPlane(p, this->cells.bits,       count);
+  p = ReadSnapshotPlane(p, this->cells.features,   count);
+  p = ReadSnapshotPlane(p, this->cells.liquid,     count);
+  p = ReadSnapshotPlane(p, this->cells.lightR,     count);
+  p = ReadSnapshotPlane(p, this->cells.lightG,     count);
+  p = ReadSnapshotPlane(p, this->cells.lightB,     count);
+  p = ReadSnapshotPlane(p, this->cells.visibility, count);
+  p = ReadSnapshotPlane(p, this->cells.variants,   count);
+
+  bool sameTypes = true;
+  for (size_t t=0; t<typeMap.size(); t++) {
+    sameTypes &= typeMap[t] == t;
+  }
+  if (!sameTypes) {
+    for (size_t i=0; i<count; i++) {
+      uint16_t type = this->cells.types[i];
+      this->cells.types[i] = type < typeMap.size() ? typeMap[type] : 0;
+    }
+  }
+
+  for (size_t i=0; i<count; i++) {
+    this->cells.bits[i] &= CellStore::ContentBits | CellStore::Default;
+  }
+
+  this->cells.shapes.clear();
+  this->cells.extras.clear();
+
+  ProtoReader reader(data + header.sparseOffset, header.sparseSize);
+  SparseCell_Proto cellProto;
+  while(reader.Read(cellProto)) {
+    this->LoadSparseCell(cellProto);
+  }
+
+  this->cellGeneration++;
+  this->dynamicCellsDirty = true;
+  this->liquidSimulator->WakeAll();
+  this->navField->Invalidate();
+  this->SetDirty();
+  return true;
 }
 
 /*
@@ -982,10 +1925,10 @@ MiniMap::MiniMap(const World &world) :
 MiniMap::MiniMap(const World &world, const MiniMap_Proto &proto) :
   world(world),
   proto(proto),
+  seenFeatures(proto.seen_features().begin(), proto.seen_features().end()),
   mapTexture(nullptr),
   viewY(0)
 {
-  // TODO: load seen features
 }
 
 void
@@ -1059,7 +2002,7 @@ MiniMap::RepaintMap() {
 
       for (size_t yy=viewY; yy>0; yy--) {
         IVector3 pos(x,yy,z);
-        Cell &cell = this->world.GetCell(pos);
+        Cell cell = this->world.GetCell(pos);
         if (!cell.IsSeen(2)) continue;
 
         bool solid = !cell.IsTransparent() && !cell[Side::Up].IsTransparent() && !cell[Side::Down].IsTransparent();
@@ -1086,6 +2029,20 @@ MiniMap::RepaintMap() {
 
 const MiniMap_Proto &
 MiniMap::GetProto() {
-  // TODO: save seen features
+  this->proto.clear_seen_features();
+  for (bool seen : this->seenFeatures) {
+    this->proto.add_seen_features(seen);
+  }
   return this->proto;
 }
+
+/**
+ * Restore the seen features saved by GetProto.
+ * @param proto The mini map proto.
+ */
+void
+MiniMap::LoadProto(const MiniMap_Proto &proto) {
+  this->proto = proto;
+  this->seenFeatures.assign(proto.seen_features().begin(), proto.seen_features().end());
+  this->RepaintMap();
+}
@@ -5,11 +5,64 @@
 #include "util/icolor.h"
 #include "gfx/vertexbuffer.h"
 
+#include <functional>
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
 
 #include "world.pb.h"
 
+class DynamicMesh;
+class LightEngine;
+class LiquidSimulator;
+class MeshBuilder;
+class NavField;
+
+/** A block of cells whose static geometry is built and drawn as a unit. */
+struct WorldChunk final {
+  /** Position of the first cell in the chunk. */
+  IVector3 origin;
+
+  /** Size of the chunk in cells, smaller at the far borders of the world. */
+  IVector3 size;
+
+  /** Static geometry needs to be rebuilt. */
+  bool dirty = true;
+
+  /** Number of the last build that was started and that was uploaded. */
+  size_t generation = 0;
+  size_t uploadedGeneration = 0;
+
+  VertexBuffer verts;
+  std::unordered_map<const Texture *, size_t> vertexStartsNormal;
+  std::unordered_map<const Texture *, size_t> vertexCountsNormal;
+  std::unordered_map<const Texture *, size_t> vertexStartsEmissive;
+  std::unordered_map<const Texture *, size_t> vertexCountsEmissive;
+
+  /** Visible dynamic cells in this chunk. */
+  std::vector<size_t> dynamicCells;
+};
+
+/** Result of sweeping a box through the world. */
+struct SweepResult final {
+  /** Axes along which movement was blocked. */
+  uint8_t axis = 0;
+
+  /** Fraction of the movement along the first blocked axis that was done
+    * before the contact, 1 if nothing was hit. */
+  float time = 1.0f;
+
+  /** Normal of the first contact. */
+  Vector3 normal;
+
+  /** First cell that was hit and the side of it that was hit. */
+  Cell cell;
+  Side side = Side::InvalidSide;
+
+  /** How far the box was lifted to step onto obstacles. */
+  float stepped = 0.0f;
+};
+
 class MiniMap final {
 public:
 
@@ -22,6 +75,7 @@ public:
   bool IsFeatureSeen(ID id) const;
 
   const MiniMap_Proto &GetProto();
+  void LoadProto(const MiniMap_Proto &proto);
 
 private:
 
@@ -47,18 +101,21 @@ public:
   World &operator=(const World &) = delete;
 
   RunningState &  GetState()  const { return state; }
+  static const IColor &GetAmbientLight() { return ambientLight; }
   MiniMap &       GetMap()          { return minimap; }
+  NavField &      GetNavField() const { return *navField; }
+  WorkerPool &    GetWorkerPool() const { return *workerPool; }
 
   IVector3  GetSize()   const { return IVector3(this->proto.size_x(), this->proto.size_y(), this->proto.size_z()); }
-  size_t    GetCellCount() const { return this->cells.size(); }
+  size_t    GetCellCount() const { return this->cells.GetCount() - 1; }
 
   void Draw(Gfx &gfx);
   void Update(RunningState &runningState);
+  void Settle();
 
-  Cell &GetCell(const IVector3 &pos) const;
-  Cell &GetCell(size_t i) const;
-  Cell &SetCell(const IVector3 &pos, const Cell &cell, bool ignoreLock = false);
-  std::vector<const Cell *> GetCellNeighbours(const IVector3 &pos) const;
+  Cell GetCell(const IVector3 &pos) const;
+  Cell GetCell(size_t i) const;
+  Cell SetCell(const IVector3 &pos, const Cell &cell);
   IColor GetLight(const IVector3 &pos) const;
   IColor GetLight(const Vector3 &pos) const;
 
@@ -67,26 +124,26 @@ public:
   float CastRayYUp(const Vector3 &org) const;
   float CastRayYDown(const Vector3 &org) const;
 
-  Cell &CastRayCell(const Vector3 &org, const Vector3 &dir, float &distance, Side &side, size_t flags = CellFlags::Pickable) const;
+  Cell CastRayCell(const Vector3 &org, const Vector3 &dir, float &distance, Side &side, size_t flags = CellFlags::Pickable) const;
   bool IsPointSolid(const Vector3 &org) const;
   bool IsAABBSolid(const AABB &aabb) const;
 
   Vector3 MoveAABB(const AABB &aabb, const Vector3 &target, bool sneak = false);
-  Vector3 MoveAABB(const AABB &aabb, const Vector3 &target, uint8_t &axis, Cell **cell = nullptr, Side *side = nullptr, bool sneak = false);
-
-  void BeginCheckOverwrite() { checkOverwrite = true; checkOverwriteOK = true; }
-  bool FinishCheckOverwrite() { checkOverwrite = false; return checkOverwriteOK;}
-  bool IsChecking() const { return checkOverwrite; }
+  Vector3 MoveAABB(const AABB &aabb, const Vector3 &target, uint8_t &axis, Cell *cell = nullptr, Side *side = nullptr, bool sneak = false);
+  Vector3 SweepAABB(const AABB &aabb, const Vector3 &delta, SweepResult &result, float stepHeight = 0.0f, bool sneak = false) const;
 
   void Dump();
 
   bool IsDefault(const IVector3 &pos) const;
-  void ClearDefaults();
-  void CopyCellsFrom(const std::vector<Cell> &cells);
+  void CopyCellsFrom(const CellStore &cells);
 
   void BreakBlock(const IVector3 &pos);
 
-  void SetDirty() { this->dirty = true; }
+  void SetDirty();
+  size_t GetChunkRebuildCount() const { return this->chunkRebuildCount; }
+
+  /** Incremented whenever a cell is replaced. */
+  size_t GetCellGeneration() const { return this->cellGeneration; }
 
   bool IsCellWalkable(const IVector3 &pos) const;
   bool IsCellValidTeleportTarget(const IVector3 &pos, const Vector3 &extents = Vector3(0,0,0)	) const;
@@ -100,19 +157,47 @@ public:
   void                  TriggerOff              (size_t id);
 
   void                  MarkForUpdateNeighbours (const CellBase *cell);
+  void                  MarkForUpdateLight      (const CellBase *cell);
+  void                  MarkForUpdateLiquid     (const CellBase *cell);
   void                  UpdateCell              (const IVector3 &pos);
 
   size_t                GetCellIndex            (const IVector3 &pos) const { return pos.x+proto.size_x()*(pos.y+proto.size_y()*pos.z); }
   IVector3              GetCellPos              (size_t i)            const { return IVector3( i%proto.size_x(), (i/proto.size_x())%proto.size_y(), (i/(proto.size_x()*proto.size_y()))%proto.size_z()); }
   bool                  IsValidCellPosition     (const IVector3 &pos) const { return pos.x < proto.size_x() && pos.y < proto.size_y() && pos.z < proto.size_z();  }
 
-  const World_Proto &   GetProto();
+  void                  SetBaseline             ();
+  uint64_t              GetBaselineChecksum     () const;
+  std::function<void(std::vector<std::unique_ptr<CellDelta_Proto>> &)>
+                        GetSnapshot             (World_Proto &snapshot);
+  void                  LoadSnapshot            (const World_Proto &proto);
+  bool                  LoadDelta               (const World_Proto &proto, const CellDelta_Proto &delta);
+  std::function<void(std::string &)>
+                        GetCellSnapshot         (uint64_t key) const;
+  bool                  LoadCellSnapshot        (const char *data, size_t size, uint64_t key);
 
 private:
 
   static constexpr float tickInterval = 0.1f;
+  static constexpr size_t deltaCellsPerChunk = 4096;
   static const IColor ambientLight;
 
+  /** Edge length of a chunk in cells. */
+  static constexpr size_t chunkSize = 16;
+
+  /** Maximum number of chunk rebuilds to start per frame after the first. */
+  static constexpr size_t maxChunkRebuildsPerFrame = 8;
+
+  /** Maximum number of cells the light engine processes per update. */
+  static constexpr size_t maxLightStepsPerUpdate = 16384;
+
+  /** Number of cells of a neighbour update round per worker job. */
+  static constexpr size_t neighbourJobSize = 4096;
+
+  friend class LightEngine;
+  friend class LiquidSimulator;
+  friend class NavField;
+  friend class PlacementIndex;
+
   float                 GetNextTickTime         ()                    const { return this->proto.next_tick_time(); }
   void                  SetNextTickTime         (float t)                   { this->proto.set_next_tick_time(t); }
 
@@ -120,41 +205,100 @@ private:
   World_Proto proto;
   MiniMap minimap;
 
-  bool dirty, firstDirty;
+  bool firstDirty;
 
-  std::vector<Cell> cells;
-  std::vector<bool> defaultMask;
+  /** All cells of the world, followed by one scratch cell that is handed
+    * out for positions outside of the world. */
+  CellStore cells;
 
-  mutable Cell defaultCell;
+  /** Cells right after the world was built, see SetBaseline. */
+  std::shared_ptr<const CellStore> baseCells;
 
   std::vector<size_t> dynamicCells;
-
-  std::unordered_set<size_t> neighbourUpdates;
-
-  VertexBuffer allVerts;
-  std::unordered_map<const Texture *, size_t> vertexStartsNormal;
-  std::unordered_map<const Texture *, size_t> vertexCountsNormal;
-  std::unordered_map<const Texture *, size_t> vertexStartsEmissive;
-  std::unordered_map<const Texture *, size_t> vertexCountsEmissive;
-
-  bool checkOverwrite;
-  bool checkOverwriteOK;
+  bool dynamicCellsDirty;
+
+  /** Cells waiting for UpdateNeighbours, each cell is queued only once per
+    * round. The current round is swapped out before it is processed. */
+  std::vector<bool>   neighbourUpdateMarks;
+  std::vector<size_t> neighbourUpdates;
+  std::vector<size_t> neighbourUpdateRound;
+
+  /** What UpdateNeighbours found for each cell of the current round. */
+  std::vector<uint8_t> neighbourUpdateResults;
+
+  IVector3 chunkCount;
+  std::vector<std::unique_ptr<WorldChunk>> chunks;
+  std::vector<size_t> dirtyChunks;
+  size_t chunkRebuildCount;
+  size_t cellGeneration;
+  std::unique_ptr<MeshBuilder> meshBuilder;
+  std::unique_ptr<DynamicMesh> dynamicMesh;
+  std::unique_ptr<LightEngine> lightEngine;
+  std::unique_ptr<LiquidSimulator> liquidSimulator;
+  std::unique_ptr<NavField> navField;
+  std::unique_ptr<WorkerPool> workerPool;
 
   void UpdateCell(size_t i);
   void MarkForUpdateNeighbours(size_t i);
-
+  void UpdateNeighbourCells();
+
+  void InitChunks();
+  void MarkChunksDirty(const IVector3 &pos);
+  size_t UploadFinishedMeshes();
+
+  Cell GetDefaultCell(const IVector3 &pos) const;
+  size_t GetCellIndexOrDefault(const IVector3 &pos) const;
+  bool GetSolidCollision(const IVector3 &pos, CellCollision &collision) const;
+
+  float SweepSide(AABB &aabb, float Vector3::*along, float Vector3::*across, float d, float stepHeight, bool sneak, SweepResult &result) const;
+  float SweepVertical(const AABB &aabb, float d, IVector3 *hitPos = nullptr) const;
+  bool IsSideBlocked(const AABB &aabb, float Vector3::*along, float Vector3::*across, int from, Side side, bool sneak, float &top, IVector3 &hitPos) const;
+  bool IsCellSideBlocked(const IVector3 &pos, Side side, float bottom, float from, float to, bool sneak, float &top) const;
+  void LoadCells(const World_Proto &proto);
+  void LoadSparseCell(const SparseCell_Proto &cellProto);
+  static void SaveDelta(const CellStore &cells, const CellStore *base, std::vector<std::unique_ptr<CellDelta_Proto>> &deltas);
+  static void WriteCellSnapshot(const CellStore &cells, const IVector3 &size, const std::vector<std::string> &typeNames, uint64_t key, std::string &data);
 };
 
-inline Cell &
+inline Cell
+World::GetDefaultCell(const IVector3 &pos) const {
+  return Cell(const_cast<CellStore *>(&this->cells), nullptr, this->GetCellCount(), pos);
+}
+
+inline Cell
 World::GetCell(const IVector3 &pos) const {
-  if (checkOverwrite) return const_cast<Cell &>(this->defaultCell);
-  if (!this->IsValidCellPosition(pos)) return const_cast<Cell &>(this->defaultCell);
-  return const_cast<Cell &>(this->cells[this->GetCellIndex(pos)]);
+  if (!this->IsValidCellPosition(pos)) return this->GetDefaultCell(pos);
+  return Cell(const_cast<CellStore *>(&this->cells), const_cast<World *>(this), this->GetCellIndex(pos), pos);
+}
+
+/** Get the index of a cell in the store without creating a cell object.
+  * Positions outside the world use the default cell, like GetCell.
+  * @param pos Cell position.
+  * @return Index of the cell, GetCellCount() for the default cell.
+  */
+inline size_t
+World::GetCellIndexOrDefault(const IVector3 &pos) const {
+  if (!this->IsValidCellPosition(pos)) return this->GetCellCount();
+  return this->GetCellIndex(pos);
+}
+
+/** Get the collision shape of a solid cell without creating a cell object.
+  * @param pos Cell position.
+  * @param[out] collision The collision shape if the cell is solid.
+  * @return true if the cell is solid.
+  */
+inline bool
+World::GetSolidCollision(const IVector3 &pos, CellCollision &collision) const {
+  size_t i = this->GetCellIndexOrDefault(pos);
+  if (!(GetCellProperties(this->cells.types[i]).flags & CellFlags::Solid)) return false;
+
+  collision = this->cells.GetCollision(i);
+  return true;
 }
 
-inline Cell &
+inline Cell
 World::GetCell(size_t i) const {
-  return const_cast<Cell &>(this->cells[i]);
+  return Cell(const_cast<CellStore *>(&this->cells), const_cast<World *>(this), i, this->GetCellPos(i));
 }
 
 #endif
@@ -10,11 +10,53 @@
 #include "game/world/worldedit.h"
 #include "math/random.h"
 #include "math/simplex.h"
+#include "util/workerpool.h"
 
 #include <algorithm>
 
+Theme::Theme(const Theme_Proto &proto) :
+  featureCount      (proto.feature_count()),
+  minFeatures       (proto.min_features()),
+  useLastChance     (proto.use_last_chance()),
+  useLastDirChance  (proto.use_last_dir_chance()),
+  caveLengthMin     (proto.cave_length_min()),
+  caveLengthMax     (proto.cave_length_max()),
+  caveRepeat        (proto.cave_repeat()),
+  teleportCount     (proto.teleport_count()),
+  trapCount         (proto.trap_count()),
+  decoCount         (proto.deco_count()),
+  itemCount         (proto.item_count()),
+  monsterCount      (proto.monster_count()),
+  firstFeature      (proto.first_feature()),
+  firstFeaturePos   (proto.first_feature_x(), proto.first_feature_y(), proto.first_feature_z())
+{
+}
+
+Theme_Proto
+Theme::GetProto() const {
+  Theme_Proto proto;
+  proto.set_feature_count(this->featureCount);
+  proto.set_min_features(this->minFeatures);
+  proto.set_use_last_chance(this->useLastChance);
+  proto.set_use_last_dir_chance(this->useLastDirChance);
+  proto.set_cave_length_min(this->caveLengthMin);
+  proto.set_cave_length_max(this->caveLengthMax);
+  proto.set_cave_repeat(this->caveRepeat);
+  proto.set_teleport_count(this->teleportCount);
+  proto.set_trap_count(this->trapCount);
+  proto.set_deco_count(this->decoCount);
+  proto.set_item_count(this->itemCount);
+  proto.set_monster_count(this->monsterCount);
+  proto.set_first_feature(this->firstFeature);
+  proto.set_first_feature_x(this->firstFeaturePos.x);
+  proto.set_first_feature_y(this->firstFeaturePos.y);
+  proto.set_first_feature_z(this->firstFeaturePos.z);
+  return proto;
+}
+
 WorldBuilder::WorldBuilder(World &world) :
   world(world),
+  placement(world),
   minY(0), maxY(0),
   lastDir(0),
   loop(0)
@@ -41,6 +83,9 @@ WorldBuilder::Build(RunningState &state, const Theme &theme) {
     this->instances.push_back(getFeature(theme.firstFeature)->BuildFeature(state, this->world, theme.firstFeaturePos, 0, 0, 0, nullptr, 0));
     this->instances.back().prevID = InvalidID;
 
+    this->placement.Reset();
+    this->placement.AddConnectors(0, this->instances.back());
+
     Log("Building features...\n");
     this->lastDir = 0;
     this->minY = this->world.GetSize().y;
@@ -92,7 +137,7 @@ WorldBuilder::Build(RunningState &state, const Theme &theme) {
     } else {
       a = this->world.GetRandomCeiling(random)[Side::Down];
     }
-    Cell &cell = this->world.GetCell(a);
+    Cell cell = this->world.GetCell(a);
     ID decoID = cell.GetFeatureID();
     if (decoID == InvalidID) continue;
 
@@ -107,7 +152,7 @@ WorldBuilder::Build(RunningState &state, const Theme &theme) {
     Entity *entity = Entity::Create(decoName);
     if (!entity) continue;
 
-    state.AddEntity(entity);
+    if (state.AddEntity(entity) == InvalidID) continue;
 
     Vector3 pos(Vector3(a.x + 0.5, a.y, a.z + 0.5));
     if (top) {
@@ -131,36 +176,56 @@ WorldBuilder::Build(RunningState &state, const Theme &theme) {
 
     IVector3 a = this->world.GetRandomTeleportTarget(random, entity->GetAABB().extents);
 
-    state.AddEntity(entity);
+    if (state.AddEntity(entity) == InvalidID) continue;
     entity->SetPosition(Vector3(a.x + 0.5, a.y + entity->GetAABB().extents.y+1.01, a.z + 0.5));
   }
 
-  // remove spilt liquids
+  // remove spilt liquids, look for them in one slice of the world per job,
+  // then remove them in order along with the liquids they held in place
   Log("Wiping the floor...\n");
-  bool foundLiquid = true;
-  while(foundLiquid) {
-    foundLiquid = false;
-    for (size_t i=0; i<this->world.GetCellCount(); i++) {
-      Cell &cell = this->world.GetCell(this->world.GetCellPos(i));
-      if (!cell.IsLiquid()) continue;
-
-      if (cell[Side::Down].GetType()     == "air" ||
-          cell[Side::Right].GetType()    == "air" ||
-          cell[Side::Left].GetType()     == "air" ||
-          cell[Side::Forward].GetType()  == "air" ||
-          cell[Side::Backward].GetType() == "air") {
-        foundLiquid = true;
-        this->world.SetCell(this->world.GetCellPos(i), Cell("air"));
-      }
+  static const Symbol air("air");
+  auto isSpilt = [&](const Cell &cell) {
+    if (!cell.IsLiquid()) return false;
+    return cell[Side::Down].GetType()     == air ||
+           cell[Side::Right].GetType()    == air ||
+           cell[Side::Left].GetType()     == air ||
+           cell[Side::Forward].GetType()  == air ||
+           cell[Side::Backward].GetType() == air;
+  };
+
+  const IVector3 &size = this->world.GetSize();
+  size_t sliceSize = size.x * size.y;
+  std::vector<std::vector<size_t>> spilt(size.z);
+  this->world.GetWorkerPool().Run(size.z, [&](size_t z) {
+    for (size_t i=z*sliceSize; i<(z+1)*sliceSize; i++) {
+      if (isSpilt(this->world.GetCell(i))) spilt[z].push_back(i);
     }
+  });
+
+  std::vector<size_t> queue;
+  for (auto &cells : spilt) {
+    queue.insert(queue.end(), cells.begin(), cells.end());
   }
 
-  // update all cells
-  Log("Updating all cells...\n");
-  for (size_t i=0; i<this->world.GetCellCount(); i++) {
-    this->world.UpdateCell(this->world.GetCellPos(i));
+  static const Side holding[] = { Side::Up, Side::Right, Side::Left, Side::Forward, Side::Backward };
+  for (size_t head=0; head<queue.size(); head++) {
+    IVector3 pos = this->world.GetCellPos(queue[head]);
+    if (!isSpilt(this->world.GetCell(pos))) continue;
+
+    this->world.SetCell(pos, Cell(air));
+    if (this->world.GetCell(pos).IsLiquid()) continue;
+
+    for (Side side : holding) {
+      IVector3 p = pos[side];
+      if (this->world.IsValidCellPosition(p) && isSpilt(this->world.GetCell(p))) {
+        queue.push_back(this->world.GetCellIndex(p));
+      }
+    }
   }
 
+  // all cells are still marked for a neighbour update since the ground was
+  // filled, so this updates all of them
+  Log("Updating all cells...\n");
   this->world.Update(state);
   this->world.Update(state);
 
@@ -174,37 +239,43 @@ WorldBuilder::MakeGround(Random &random) {
   IVector3 r(random.Integer(), random.Integer(), random.Integer());
 
   size_t cellCount = this->world.GetCellCount();
-  defaultCells.clear();
+  defaultCells = CellStore(cellCount);
 
+  uint16_t bedrock = GetCellProperties("bedrock").index;
+  uint16_t dirt    = GetCellProperties("dirt").index;
+
+  // the store is new, only type and bits differ from the defaults, one
+  // slice of the world per job
   const IVector3 &size = this->world.GetSize();
-  for (size_t i=0; i<cellCount; i++) {
-    IVector3 pos = this->world.GetCellPos(i);
-    if (pos.x < 2 || pos.y < 2 || pos.z < 2 || pos.x >= size.x-2 || pos.y >= size.y-2 || pos.z >= size.z-2) {
-      Cell cell("bedrock");
-      cell.SetProtected(true);
-      cell.SetIgnoringWrite(true);
-
-      defaultCells.push_back(cell);
-    } else {
-      defaultCells.push_back(Cell("dirt"));
-      /*
-      defaultCells[i] = Cell("rock");
-
-      IVector3 ppp(pos+r);
-      ppp.x %= 256;
-      ppp.y %= 256;
-      ppp.z %= 256;
-      Vector3 vpos(ppp);
-      float f = (simplexNoise(vpos*0.07) * simplexNoise(vpos*(-0.06)) * simplexNoise(vpos*(-0.13)));
-      if (f > 0.75) {
-        defaultCells[i] = Cell("brick");
-      } else if (f > 0.5) {
-        defaultCells[i] = Cell("rock");
+  size_t sliceSize = size.x * size.y;
+  this->world.GetWorkerPool().Run(size.z, [&](size_t z) {
+    for (size_t i=z*sliceSize; i<(z+1)*sliceSize; i++) {
+      IVector3 pos = this->world.GetCellPos(i);
+      if (pos.x < 2 || pos.y < 2 || pos.z < 2 || pos.x >= size.x-2 || pos.y >= size.y-2 || pos.z >= size.z-2) {
+        defaultCells.types[i] = bedrock;
+        defaultCells.bits[i]  = CellStore::Protected | CellStore::IgnoringWrite;
       } else {
-        defaultCells[i] = Cell("dirt");
-      }*/
+        defaultCells.types[i] = dirt;
+        defaultCells.bits[i]  = 0;
+        /*
+        defaultCells[i] = Cell("rock");
+
+        IVector3 ppp(pos+r);
+        ppp.x %= 256;
+        ppp.y %= 256;
+        ppp.z %= 256;
+        Vector3 vpos(ppp);
+        float f = (simplexNoise(vpos*0.07) * simplexNoise(vpos*(-0.06)) * simplexNoise(vpos*(-0.13)));
+        if (f > 0.75) {
+          defaultCells[i] = Cell("brick");
+        } else if (f > 0.5) {
+          defaultCells[i] = Cell("rock");
+        } else {
+          defaultCells[i] = Cell("dirt");
+        }*/
+      }
     }
-  }
+  });
 }
 
 void
@@ -238,9 +309,7 @@ WorldBuilder::BuildFeature(RunningState &state, Random &random, const Theme &the
   IVector3                  pos         = instance.pos + conn->pos - revConn->pos + IVector3(SideFromDir(conn->dir));
 
   // check if feature can be built
-  this->world.BeginCheckOverwrite();
-  nextFeature->BuildFeature(state, this->world, pos, conn->dir, instance.dist, instances.size(), nullptr, featNum);
-  if (!this->world.FinishCheckOverwrite()) return;
+  if (!this->placement.CanPlace(*nextFeature, pos)) return;
 
   // build it
   FeatureInstance           nextInstance = nextFeature->BuildFeature(state, this->world, pos, conn->dir, instance.dist, instances.size(), revConn, featNum);
@@ -257,25 +326,23 @@ WorldBuilder::BuildFeature(RunningState &state, Random &random, const Theme &the
   for (auto &nextConn : nextInstance.feature->GetConnections()) {
     IVector3 nextConnPos = nextInstance.pos + nextConn.pos;
 
-    for (auto &inst : instances) {
-      for (const FeatureConnection &c : inst.feature->GetConnections()) {
-        // match direction
-        if (c.dir != -nextConn.dir) continue;
+    for (const PlacementIndex::Connector &c : this->placement.GetConnectors(nextConnPos, -nextConn.dir)) {
+      const FeatureInstance &inst = instances[c.instance];
 
-        // match position
-        IVector3 connPos = inst.pos + c.pos;
-        if (connPos != nextConnPos) continue;
-
-        // replace some cells after connection if wanted
-        inst.feature->ReplaceChars(this->world, inst.pos, c.id, inst.featureID);
-        nextInstance.feature->ReplaceChars(this->world, nextInstance.pos, nextConn.id, nextInstance.featureID);
-      }
+      // replace some cells after connection if wanted
+      inst.feature->ReplaceChars(this->world, inst.pos, c.conn->id, inst.featureID);
+      nextInstance.feature->ReplaceChars(this->world, nextInstance.pos, nextConn.id, nextInstance.featureID);
+      this->placement.Update(inst.pos, inst.feature->GetSize());
     }
   }
 
+  this->placement.Update(instance.pos, feature->GetSize());
+  this->placement.Update(nextInstance.pos, nextFeature->GetSize());
+
   // done :)
   instances.push_back(nextInstance);
   instances.back().prevID = featNum;
+  this->placement.AddConnectors(instances.size()-1, instances.back());
 }
 
 void
@@ -331,20 +398,20 @@ WorldBuilder::PlaceTraps(RunningState &state, Random &random, const Theme &theme
 
     size_t a = world.GetCellIndex(world.GetRandomTeleportTarget(random));
 
-    Cell *aboveCell = &world.GetCell(a)[Side::Up][Side::Up];
+    Cell aboveCell = world.GetCell(a)[Side::Up][Side::Up];
     Side side = (Side)random.Integer(6);
     while (side == Side::Down) side = (Side)random.Integer(6);
 
     size_t distance = 0;
-    while(!aboveCell->IsSolid()) {
-      aboveCell = &((*aboveCell)[side]);
+    while(!aboveCell.IsSolid()) {
+      aboveCell = aboveCell[side];
       distance ++;
     }
 
     if (distance > 5) { i--; continue; }
 
-    Cell &trigger = world.GetCell(a);
-    Cell &spawner = world.SetCell(aboveCell->GetPosition(), Cell("shooter"));
+    Cell trigger = world.GetCell(a);
+    Cell spawner = world.SetCell(aboveCell.GetPosition(), Cell("shooter"));
 
     const std::vector<std::string> &traps = GetEntitiesInGroup("trap");
     if (traps.empty()) {
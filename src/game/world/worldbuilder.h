@@ -3,8 +3,11 @@
 
 #include <vector>
 
+#include "game/world/placementindex.h"
 #include "math/ivector3.h"
 
+#include "world.pb.h"
+
 struct Theme {
   size_t featureCount       = 200;
   size_t minFeatures        = 100;
@@ -23,6 +26,11 @@ struct Theme {
 
   std::string firstFeature  = "start";
   IVector3 firstFeaturePos  = IVector3(32-4, 32-8,32-4);
+
+  Theme() = default;
+  Theme(const Theme_Proto &proto);
+
+  Theme_Proto GetProto() const;
 };
 
 class WorldBuilder final {
@@ -37,7 +45,8 @@ private:
 
   World &world;
   std::vector<FeatureInstance> instances;
-  std::vector<Cell> defaultCells;
+  PlacementIndex placement;
+  CellStore defaultCells;
   uint32_t minY, maxY;
   int lastDir;
   size_t loop;
@@ -1,6 +1,8 @@
 #include "common.h"
 
+#if HAVE_GFX
 #include <GL/glew.h>
+#endif
 
 #include "game/entities/player.h"
 #include "game/game.h"
@@ -15,13 +17,17 @@
 #include "math/matrix4.h"
 #include "math/vector2.h"
 
+#if HAVE_GFX
 #include <GLFW/glfw3.h>
+#else
+#include <chrono>
+#endif
 
 Gfx::Gfx(const Point &pos, const Point &size, bool fullscreen) :
   screen(*this, pos, size, fullscreen),
   useFixedFunction(false),
   isInit(false),
-  startTime(glfwGetTime()),
+  startTime(GetTime()),
   player(nullptr),
 
   vb(nullptr),
@@ -59,6 +65,7 @@ Gfx::Init(Game &game) {
 
   if (!this->screen.Init(game)) return false;
 
+#if HAVE_GFX
   // We'd like extensions with that
   glewInit();
 
@@ -105,6 +112,10 @@ Gfx::Init(Game &game) {
   glEnableClientState(GL_VERTEX_ARRAY);
   glEnableClientState(GL_COLOR_ARRAY);
   glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+#else
+  // without a context there is nothing to compile shaders for
+  this->useFixedFunction = true;
+#endif
 
   this->vb = new VertexBuffer();
 
@@ -158,19 +169,32 @@ Gfx::Deinit() {
 
 float
 Gfx::GetTime() const {
+#if HAVE_GFX
   return glfwGetTime();
+#else
+  static const auto start = std::chrono::steady_clock::now();
+  return std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+#endif
 }
 
 void
 Gfx::ClearColor(const IColor &color) const {
+#if HAVE_GFX
   glClearColor(color.r/255.0, color.g/255.0, color.b/255.0, 1.0);
   glClear(GL_COLOR_BUFFER_BIT);
+#else
+  (void)color;
+#endif
 }
 
 void
 Gfx::ClearDepth(float depth) const {
+#if HAVE_GFX
   glClearDepth(depth);
   glClear(GL_DEPTH_BUFFER_BIT);
+#else
+  (void)depth;
+#endif
 }
 
 void
@@ -179,18 +203,22 @@ Gfx::Update(Game &game) {
 
   Texture::UpdateTextures();
 
+#if HAVE_GFX
   if (game.GetInput().IsKeyActive(InputKey::DebugWireframe)) {
     glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
   } else {
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
   }
+#endif
 }
 
 void Gfx::SetShader(const std::string &name) {
   if (this->useFixedFunction) return;
 
   if (name == "") {
+#if HAVE_GFX
     glUseProgram(0);
+#endif
     this->activeShader = nullptr;
     return;
   }
@@ -198,16 +226,22 @@ void Gfx::SetShader(const std::string &name) {
   if (!shaders[name]) shaders[name] = std::shared_ptr<Shader>(new Shader(name));
   this->activeShader = shaders[name];
 
+#if HAVE_GFX
   glUseProgram(shaders[name]->GetProgram());
+#endif
   this->SetUniforms();
 }
 
 void Gfx::SetBlendNormal() {
+#if HAVE_GFX
   glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+#endif
 }
 
 void Gfx::SetBlendAdd() {
+#if HAVE_GFX
   glBlendFunc(GL_ONE, GL_ONE);
+#endif
 }
 
 void
@@ -225,11 +259,14 @@ Gfx::SetLights(const std::vector<Vector3> &positions, const std::vector<IColor>
 void
 Gfx::SetTextureFrame(const Texture *texture, size_t stage, size_t currentFrame, size_t frameCount) {
   if (stage != this->activeTextureStage) {
+#if HAVE_GFX
     glActiveTexture(GL_TEXTURE0 + stage);
+#endif
     this->activeTextureStage = stage;
   }
 
   if (this->activeTextures[stage] != texture) {
+#if HAVE_GFX
     if (texture) {
       glBindTexture(GL_TEXTURE_2D, texture->handle);
       glEnable(GL_TEXTURE_2D);
@@ -237,6 +274,7 @@ Gfx::SetTextureFrame(const Texture *texture, size_t stage, size_t currentFrame,
       glBindTexture(GL_TEXTURE_2D, 0);
       glDisable(GL_TEXTURE_2D);
     }
+#endif
     this->activeTextures[stage] = texture;
   }
 
@@ -274,11 +312,15 @@ Gfx::SetLight(const IColor &color) {
 
 void
 Gfx::SetBackfaceCulling(bool cull) {
+#if HAVE_GFX
   if (cull) {
     glEnable(GL_CULL_FACE);
   } else {
     glDisable(GL_CULL_FACE);
   }
+#else
+  (void)cull;
+#endif
 }
 
 void
@@ -298,7 +340,13 @@ Gfx::SetUniforms() const {
 
   if (!this->activeShader) return;
 
-  if (this->activeShader->HasUniform("u_lightPos") && this->activeShader->HasUniform("u_lightColor")) {
+  // uniform names are interned once, this runs for every draw call
+  static const Symbol uLightPos("u_lightPos"),  uLightColor("u_lightColor");
+  static const Symbol uFogLin("u_fogLin"),      uFogColor("u_fogColor");
+  static const Symbol uTime("u_time"),          uColor("u_color"),          uLight("u_light");
+  static const Symbol uTexture("u_texture"),    uTexture2("u_texture2");
+
+  if (this->activeShader->HasUniform(uLightPos) && this->activeShader->HasUniform(uLightColor)) {
     std::vector<Vector3> lightPos;
     std::vector<IColor>  lightCol;
 
@@ -311,21 +359,21 @@ Gfx::SetUniforms() const {
     lightCol.resize(MaxLights, IColor(0,0,0));
     lightPos.resize(MaxLights);
     
-    this->activeShader->Uniform("u_lightPos",   lightPos);
-    this->activeShader->Uniform("u_lightColor", lightCol);
+    this->activeShader->Uniform(uLightPos,   lightPos);
+    this->activeShader->Uniform(uLightColor, lightCol);
   }
 
 
   this->view->SetUniforms(this->activeShader);
 
-  this->activeShader->Uniform("u_fogLin",   this->fogLin);
-  this->activeShader->Uniform("u_fogColor", this->fogColor);
-  this->activeShader->Uniform("u_time",     this->GetTime());
-  this->activeShader->Uniform("u_color",    this->color, this->alpha);
-  this->activeShader->Uniform("u_light",    this->light, 1.0);
+  this->activeShader->Uniform(uFogLin,   this->fogLin);
+  this->activeShader->Uniform(uFogColor, this->fogColor);
+  this->activeShader->Uniform(uTime,     this->GetTime());
+  this->activeShader->Uniform(uColor,    this->color, this->alpha);
+  this->activeShader->Uniform(uLight,    this->light, 1.0);
 
-  this->activeShader->Uniform("u_texture", 0);
-  this->activeShader->Uniform("u_texture2", 1);
+  this->activeShader->Uniform(uTexture,  0);
+  this->activeShader->Uniform(uTexture2, 1);
 
   if (this->player) this->player->SetUniforms(this->activeShader);
 }
@@ -371,6 +419,7 @@ void Gfx::DrawSprite(const Sprite &sprite, const Vector3 &pos, bool flip, bool b
 
   SetBackfaceCulling(false);
   if (sprite.texture) {
+#if HAVE_GFX
     if (this->useFixedFunction) {
       glEnable(GL_LIGHTING);
       float e[] = {
@@ -378,11 +427,14 @@ void Gfx::DrawSprite(const Sprite &sprite, const Vector3 &pos, bool flip, bool b
       };
       glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, e);
     }
+#endif
     this->SetTextureFrame(sprite.texture, 0, sprite.currentFrame, sprite.totalFrames);
     this->DrawUnitQuad();
+#if HAVE_GFX
     if (this->useFixedFunction) {
       glDisable(GL_LIGHTING);
     }
+#endif
   }
   if (sprite.emissiveTexture) {
     this->SetTextureFrame(sprite.emissiveTexture, 0, sprite.currentFrame, sprite.totalFrames);
@@ -407,6 +459,7 @@ void Gfx::DrawSprite(const Sprite &sprite, const Vector3 &pos, const Vector3 &ax
 
   SetBackfaceCulling(false);
   if (sprite.texture) {
+#if HAVE_GFX
     if (this->useFixedFunction) {
       glEnable(GL_LIGHTING);
       float e[] = {
@@ -414,11 +467,14 @@ void Gfx::DrawSprite(const Sprite &sprite, const Vector3 &pos, const Vector3 &ax
       };
       glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, e);
     }
+#endif
     this->SetTextureFrame(sprite.texture, 0, sprite.currentFrame, sprite.totalFrames);
     this->DrawUnitQuad();
+#if HAVE_GFX
     if (this->useFixedFunction) {
       glDisable(GL_LIGHTING);
     }
+#endif
   }
   if (sprite.emissiveTexture) {
     this->SetTextureFrame(sprite.emissiveTexture, 0, sprite.currentFrame, sprite.totalFrames);
@@ -5,6 +5,7 @@
 #include "io/input.h"
 #include "util/image.h"
 
+#if HAVE_GFX
 #include "GLee.h"
 #include <GLFW/glfw3.h>
 
@@ -57,9 +58,11 @@ static InputKey MapKey(int k) {
   }
   return key;
 }
+#endif
 
 GfxScreen::GfxScreen(Gfx &gfx, const Point &pos, const Point &size, bool fullscreen) :
   gfx(gfx),
+  window(nullptr),
   screenPos(pos),
   screenSize(size),
   isFullscreen(fullscreen),
@@ -74,6 +77,7 @@ GfxScreen::GfxScreen(Gfx &gfx, const Point &pos, const Point &size, bool fullscr
 
 bool
 GfxScreen::Init(Game &game) {
+#if HAVE_GFX
   // Create window
   this->window = glfwCreateWindow(
     this->screenSize.x,
@@ -134,6 +138,9 @@ GfxScreen::Init(Game &game) {
     Gfx  &gfx  = game.GetGfx();
     gfx.GetScreen().Key(game, k, e);
   } );
+#else
+  (void)game;
+#endif
 
   this->Viewport(Rect());
   return true;
@@ -141,18 +148,22 @@ GfxScreen::Init(Game &game) {
 
 void
 GfxScreen::Deinit() {
+#if HAVE_GFX
   glfwSetWindowSizeCallback( this->window, nullptr);
   glfwSetCursorPosCallback(  this->window, nullptr);
   glfwSetMouseButtonCallback(this->window, nullptr);
   glfwSetKeyCallback(        this->window, nullptr);
 
   glfwDestroyWindow(this->window);
+#endif
   this->window = nullptr;
 }
 
 void
 GfxScreen::Update(Game &game) {
+#if HAVE_GFX
   glfwPollEvents();
+#endif
 
   if (this->mouseGrab && !this->guiActiveCount) {
     // send relative coordinates
@@ -206,6 +217,7 @@ GfxScreen::MouseMove(Game &game, double x, double y) {
 
 void
 GfxScreen::MouseButton(Game &game, int b, int e) {
+#if HAVE_GFX
   bool down = (e != GLFW_RELEASE);
   InputKey key = MapMouseButton(b);
 
@@ -223,10 +235,16 @@ GfxScreen::MouseButton(Game &game, int b, int e) {
     // if already grabbed
     game.GetInput().HandleEvent(InputEvent(InputEventType::Key, this->mousePos, key, down));
   }
+#else
+  (void)game;
+  (void)b;
+  (void)e;
+#endif
 }
 
 void
 GfxScreen::Key(Game &game, int k, int e) {
+#if HAVE_GFX
   bool down = e != GLFW_RELEASE;
   InputKey key = MapKey(k);
 
@@ -237,6 +255,11 @@ GfxScreen::Key(Game &game, int k, int e) {
   } else {
     game.GetInput().HandleEvent(InputEvent(InputEventType::Key, this->mousePos, key, down));
   }
+#else
+  (void)game;
+  (void)k;
+  (void)e;
+#endif
 }
 
 void
@@ -250,12 +273,16 @@ GfxScreen::Viewport(const Rect &view) {
   }
 
   if (view.size.x == 0 || view.size.y == 0) {
+#if HAVE_GFX
     glScissor(0,0, this->screenSize.x, this->screenSize.y);
     glViewport(0,0, this->screenSize.x, this->screenSize.y);
+#endif
     this->viewportSize = this->screenSize;
   } else {
+#if HAVE_GFX
     glScissor(view.pos.x, view.pos.y + this->screenSize.y - view.size.y, view.size.x, view.size.y);
     glViewport(view.pos.x, view.pos.y + this->screenSize.y - view.size.y, view.size.x, view.size.y);
+#endif
     this->viewportSize = view.size;
   }
 }
@@ -263,23 +290,33 @@ GfxScreen::Viewport(const Rect &view) {
 
 bool
 GfxScreen::Swap() {
+#if HAVE_GFX
   glfwSwapBuffers(this->window);
   glViewport(0, 0, this->screenSize.x, this->screenSize.y);
   return !glfwWindowShouldClose(this->window);
+#else
+  return true;
+#endif
 }
 
 void
 GfxScreen::Save(const std::string &name) {
+#if HAVE_GFX
   uint8_t *data = new uint8_t[screenSize.x*screenSize.y*3];
   glReadPixels(0,0,screenSize.x, screenSize.y, GL_RGB, GL_UNSIGNED_BYTE, data);
   Image(screenSize, data, false).Save(name);
   Log("%s saved\n", name.c_str());
+#else
+  (void)name;
+#endif
 }
 
 void
 GfxScreen::IncGuiCount() {
   guiActiveCount ++;
+#if HAVE_GFX
   glfwSetInputMode(this->window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+#endif
 }
 
 void
@@ -289,9 +326,13 @@ GfxScreen::DecGuiCount() {
   guiActiveCount--;
 
   if (!guiActiveCount && this->mouseGrab) {
+#if HAVE_GFX
     glfwSetCursorPos(this->window, screenSize.x/2, screenSize.y/2);
+#endif
     mousePos = lastMousePos = Point(screenSize.x/2, screenSize.y/2);
+#if HAVE_GFX
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+#endif
   }
 }
 
@@ -1,6 +1,8 @@
 #include "common.h"
 
+#if HAVE_GFX
 #include <GL/glew.h>
+#endif
 
 #include "gfx/gfx.h"
 #include "gfx/gfxview.h"
@@ -31,7 +33,9 @@ void GfxView::Look(const Vector3 &pos, const Vector3 &forward, float fovY, const
   }
 
   this->viewMatrix = Matrix4::LookFrom(pos, forward, up);
+#if HAVE_GFX
   glEnable(GL_DEPTH_TEST);
+#endif
 }
 
 void GfxView::GUI() {
@@ -43,7 +47,9 @@ void GfxView::GUI() {
     Matrix4::Translate(Vector3( -0.5*ssize.x, -0.5*ssize.y, 0));
 
   this->modelMatrixStack.back() = Matrix4();
+#if HAVE_GFX
   glDisable(GL_DEPTH_TEST);
+#endif
 }
 
 void GfxView::Push() {
@@ -123,19 +129,25 @@ GfxView::AlignY(const Vector3 &axis) {
 void GfxView::SetUniforms(const std::shared_ptr<Shader> &shader) const {
   Matrix4 matModelView = this->viewMatrix * this->modelMatrixStack.back();
   if (gfx.UseFixedFunction()) {
+#if HAVE_GFX
     glMatrixMode(GL_PROJECTION);
     glLoadMatrixf(this->projectionMatrix.m);
     glMatrixMode(GL_MODELVIEW);
     glLoadMatrixf(matModelView.m);
     glMatrixMode(GL_TEXTURE);
     glLoadMatrixf(this->textureMatrix.m);
+#endif
   } else {
-    shader->Uniform("u_matProjection",    this->projectionMatrix);
-    shader->Uniform("u_matModelView",     matModelView);
-    shader->Uniform("u_matView",          this->viewMatrix);
-    shader->Uniform("u_matInvModelView",  matModelView.Inverse());
-    shader->Uniform("u_matTexture",       this->textureMatrix);
-    shader->Uniform("u_matNormal",        matModelView.Mat3().Inverse().Transpose());
+    static const Symbol uMatProjection("u_matProjection"),     uMatModelView("u_matModelView");
+    static const Symbol uMatView("u_matView"),                 uMatInvModelView("u_matInvModelView");
+    static const Symbol uMatTexture("u_matTexture"),           uMatNormal("u_matNormal");
+
+    shader->Uniform(uMatProjection,    this->projectionMatrix);
+    shader->Uniform(uMatModelView,     matModelView);
+    shader->Uniform(uMatView,          this->viewMatrix);
+    shader->Uniform(uMatInvModelView,  matModelView.Inverse());
+    shader->Uniform(uMatTexture,       this->textureMatrix);
+    shader->Uniform(uMatNormal,        matModelView.Mat3().Inverse().Transpose());
   }
 }
 
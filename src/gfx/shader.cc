@@ -7,8 +7,11 @@
 #include "math/matrix4.h"
 
 Shader::Shader(const std::string &name) :
-  program(glCreateProgramObjectARB())
+  program(0)
 {
+#if HAVE_GFX
+  this->program = glCreateProgramObjectARB();
+
   const char *txt;
   char tmp[1024];
   GLsizei l;
@@ -46,40 +49,62 @@ Shader::Shader(const std::string &name) :
 
   glDeleteObjectARB(vshad);
   glDeleteObjectARB(fshad);
+#else
+  (void)name;
+#endif
 }
 
 Shader::~Shader() {
+#if HAVE_GFX
   glDeleteObjectARB(program);
+#endif
 }
 
 bool
-Shader::HasUniform(const std::string &name) const {
+Shader::HasUniform(const Symbol &name) const {
   int loc = GetUniformLocation(name);
   return loc != -1;
 }
 
 
 void
-Shader::Uniform(const std::string &name, int value) const {
+Shader::Uniform(const Symbol &name, int value) const {
+#if HAVE_GFX
   int loc = GetUniformLocation(name);
   glUniform1iARB(loc, value);
+#else
+  (void)name;
+  (void)value;
+#endif
 }
 
 void
-Shader::Uniform(const std::string &name, float value) const {
+Shader::Uniform(const Symbol &name, float value) const {
+#if HAVE_GFX
   int loc = GetUniformLocation(name);
   glUniform1fARB(loc, value);
+#else
+  (void)name;
+  (void)value;
+#endif
 }
 
 void 
-Shader::Uniform(const std::string &name, const IColor &value, float alpha) const {
+Shader::Uniform(const Symbol &name, const IColor &value, float alpha) const {
+#if HAVE_GFX
   float rgb[4] = { value.r / 255.0f, value.g / 255.0f, value.b / 255.0f, alpha };
   int loc = GetUniformLocation(name);
   glUniform4fv(loc, 1, rgb);
+#else
+  (void)name;
+  (void)value;
+  (void)alpha;
+#endif
 }
 
 void 
-Shader::Uniform(const std::string &name, const std::vector<IColor> &value) const {
+Shader::Uniform(const Symbol &name, const std::vector<IColor> &value) const {
+#if HAVE_GFX
   float rgb[4*value.size()];
   for (size_t i=0; i<value.size(); i++) {
     rgb[i*4+0] = value[i].r / 255.0;
@@ -91,19 +116,29 @@ Shader::Uniform(const std::string &name, const std::vector<IColor> &value) const
   int loc = GetUniformLocation(name);
   glUniform4fv(loc, value.size(), rgb);
 
-  loc = GetUniformLocation((name+"_length").c_str());
+  loc = GetUniformLocation(name.GetString()+"_length");
   glUniform1i(loc, value.size());
+#else
+  (void)name;
+  (void)value;
+#endif
 }
 
 void 
-Shader::Uniform(const std::string &name, const Vector3 &value) const {
+Shader::Uniform(const Symbol &name, const Vector3 &value) const {
+#if HAVE_GFX
   int loc = GetUniformLocation(name);
   float xyz[3] = { value.x, value.y, value.z };
   glUniform3fv(loc, 1, xyz);
+#else
+  (void)name;
+  (void)value;
+#endif
 }
 
 void 
-Shader::Uniform(const std::string &name, const std::vector<Vector3> &value) const {
+Shader::Uniform(const Symbol &name, const std::vector<Vector3> &value) const {
+#if HAVE_GFX
   float xyz[3 * value.size()];
   for (size_t i=0; i<value.size(); i++) {
     xyz[i*3+0] = value[i].x;
@@ -114,21 +149,35 @@ Shader::Uniform(const std::string &name, const std::vector<Vector3> &value) cons
   int loc = GetUniformLocation(name);
   glUniform3fv(loc, value.size(), xyz);
   
-  loc = GetUniformLocation((name+"_length").c_str());
+  loc = GetUniformLocation(name.GetString()+"_length");
   glUniform1i(loc, value.size());
+#else
+  (void)name;
+  (void)value;
+#endif
 }
   
 void 
-Shader::Uniform(const std::string &name, const Matrix4 &value) const {
+Shader::Uniform(const Symbol &name, const Matrix4 &value) const {
+#if HAVE_GFX
   int loc = GetUniformLocation(name);
   glUniformMatrix4fv(loc, 1, false, value.m);
+#else
+  (void)name;
+  (void)value;
+#endif
 }
 
 int 
-Shader::GetUniformLocation(const std::string &name) const {
+Shader::GetUniformLocation(const Symbol &name) const {
+#if HAVE_GFX
   auto iter = locations.find(name);
   if (iter == locations.end()) {
     locations[name] = glGetUniformLocationARB(program, name.c_str());
   }
   return locations[name];
+#else
+  (void)name;
+  return -1;
+#endif
 }
@@ -1,7 +1,14 @@
 #ifndef BARFOOS_SHADER_H
 #define BARFOOS_SHADER_H
 
+#include "common.h"
+
+#if HAVE_GFX
 #include <GL/glew.h>
+#else
+typedef unsigned int GLhandleARB;
+#endif
+
 #include <unordered_map>
 #include <vector>
 
@@ -14,16 +21,16 @@ public:
   
   Shader &operator=(const Shader &) = delete;
 
-  void Uniform(const std::string &name, int value) const;
-  void Uniform(const std::string &name, float value) const;
-  void Uniform(const std::string &name, const IColor &value, float alpha = 1.0) const;
-  void Uniform(const std::string &name, const std::vector<IColor> &value) const;
+  void Uniform(const Symbol &name, int value) const;
+  void Uniform(const Symbol &name, float value) const;
+  void Uniform(const Symbol &name, const IColor &value, float alpha = 1.0) const;
+  void Uniform(const Symbol &name, const std::vector<IColor> &value) const;
 
-  void Uniform(const std::string &name, const Vector3 &value) const;
-  void Uniform(const std::string &name, const std::vector<Vector3> &value) const;
-  void Uniform(const std::string &name, const Matrix4 &value) const;
+  void Uniform(const Symbol &name, const Vector3 &value) const;
+  void Uniform(const Symbol &name, const std::vector<Vector3> &value) const;
+  void Uniform(const Symbol &name, const Matrix4 &value) const;
 
-  bool HasUniform(const std::string &name) const;
+  bool HasUniform(const Symbol &name) const;
   
   GLhandleARB GetProgram() const { return program; }
 
@@ -31,8 +38,8 @@ private:
 
   GLhandleARB program;
 
-  int GetUniformLocation(const std::string &name) const;
-  mutable std::unordered_map<std::string, int> locations;
+  int GetUniformLocation(const Symbol &name) const;
+  mutable std::unordered_map<Symbol, int> locations;
 };
 
 
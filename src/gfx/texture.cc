@@ -1,6 +1,8 @@
 #include "common.h"
 
+#if HAVE_GFX
 #include <GL/glew.h>
+#endif
 
 #include "gfx/texture.h"
 #include "io/fileio.h"
@@ -10,7 +12,7 @@
 #include <sys/time.h>
 #include <unordered_map>
 
-static std::unordered_map<std::string, std::unique_ptr<Texture>> textures;
+static std::unordered_map<Symbol, std::unique_ptr<Texture>> textures;
 // static time_t lastUpdate = 0;
 
 Texture::Texture() :
@@ -27,7 +29,9 @@ Texture::Texture(const std::string &name) :
 }
 
 Texture::~Texture() {
+#if HAVE_GFX
   if (handle) glDeleteTextures(1, &handle);
+#endif
 }
 
 Texture::Texture(Texture &&rhs) :
@@ -43,28 +47,31 @@ void Texture::Reload() {
   this->SetImage(Image::Load(this->name));
 }
 
-const Texture *Texture::Get(const std::string &name) {
-  if (name == "") return nullptr;
-  if (!textures[name])
-    textures[name] = std::unique_ptr<Texture>(new Texture(name));
-  return textures[name].get();
+const Texture *Texture::Get(const Symbol &name) {
+  if (name.IsEmpty()) return nullptr;
+  std::unique_ptr<Texture> &texture = textures[name];
+  if (!texture)
+    texture = std::unique_ptr<Texture>(new Texture(name.GetString()));
+  return texture.get();
 }
 
-const Texture *Texture::Create(const std::string &name, const Image &image) {
-  if (name == "") return nullptr;
-  if (!textures[name])
-    textures[name] = std::unique_ptr<Texture>(new Texture());
-  textures[name]->SetImage(image);
-  return textures[name].get();
+const Texture *Texture::Create(const Symbol &name, const Image &image) {
+  if (name.IsEmpty()) return nullptr;
+  std::unique_ptr<Texture> &texture = textures[name];
+  if (!texture)
+    texture = std::unique_ptr<Texture>(new Texture());
+  texture->SetImage(image);
+  return texture.get();
 }
 
 void Texture::SetImage(const Image &image) {
+  this->size = image.GetSize();
+
+#if HAVE_GFX
   if (!this->handle) {
     glGenTextures(1, &this->handle);
   }
 
-  this->size = image.GetSize();
-
   glBindTexture(GL_TEXTURE_2D, this->handle);
   glTexImage2D(GL_TEXTURE_2D, 0,
     image.HasAlpha() ? GL_RGBA : GL_RGB,
@@ -76,6 +83,7 @@ void Texture::SetImage(const Image &image) {
 
   glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
   glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+#endif
 }
 
 void Texture::UpdateTextures() {
@@ -27,8 +27,8 @@ struct Texture {
   void GetFrameUV(size_t frame, size_t totalFrames, Vector2 &uv1, Vector2 &uv2) const;
 
   static void UpdateTextures();
-  static const Texture *Get(const std::string &name);
-  static const Texture *Create(const std::string &name, const Image &image);
+  static const Texture *Get(const Symbol &name);
+  static const Texture *Create(const Symbol &name, const Image &image);
 };
 
 #endif
@@ -1,7 +1,11 @@
 #include "common.h"
 
+#if HAVE_GFX
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#endif
+
+#include <cstring>
 
 #include "gfx/vertex.h"
 #include "gfx/vertexbuffer.h"
@@ -11,19 +15,23 @@
 VertexBuffer::VertexBuffer() :
   dirty(true),
   vbo(0),
-  verts()
+  verts(),
+  dirtyFirst(0),
+  dirtyEnd(0)
 {
 }
 
 VertexBuffer::VertexBuffer(const std::vector<Vertex> &verts) :
   dirty(true),
   vbo(0),
-  verts(verts)
+  verts(verts),
+  dirtyFirst(0),
+  dirtyEnd(0)
 {
 }
 
 VertexBuffer::~VertexBuffer() {
-#if USE_VBO
+#if HAVE_GFX && USE_VBO
   if (this->vbo) {
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glDeleteBuffers(1, &this->vbo);
@@ -50,12 +58,60 @@ VertexBuffer::Add(const std::vector<Vertex> &verts) {
   return this->verts.size()-1;
 }
 
+/** Change the number of vertices. New vertices are zeroed.
+  * @param count New number of vertices.
+  */
 void
-VertexBuffer::DrawTriangles(size_t first, size_t count) {
-  if (count == 0) count = this->verts.size() - first;
+VertexBuffer::Resize(size_t count) {
+  size_t oldCount = this->verts.size();
+  this->verts.resize(count);
+  if (count > oldCount) this->Zero(oldCount, count - oldCount);
+  this->dirty = true;
+}
+
+/** Overwrite a range of vertices. Only the changed range is uploaded on the
+  * next draw unless the whole buffer is dirty anyway.
+  * @param first Index of the first vertex to overwrite.
+  * @param verts New vertices.
+  * @param count Number of vertices.
+  */
+void
+VertexBuffer::Update(size_t first, const Vertex *verts, size_t count) {
+  if (count == 0) return;
+
+  std::copy(verts, verts + count, this->verts.begin() + first);
+  this->MarkDirty(first, count);
+}
+
+/** Set a range of vertices to zero, so they form degenerate triangles.
+  * @param first Index of the first vertex.
+  * @param count Number of vertices.
+  */
+void
+VertexBuffer::Zero(size_t first, size_t count) {
   if (count == 0) return;
 
-#if USE_VBO
+  memset(static_cast<void *>(&this->verts[first]), 0, sizeof(Vertex) * count);
+  this->MarkDirty(first, count);
+}
+
+void
+VertexBuffer::MarkDirty(size_t first, size_t count) {
+  if (this->dirtyFirst == this->dirtyEnd) {
+    this->dirtyFirst = first;
+    this->dirtyEnd   = first + count;
+  } else {
+    this->dirtyFirst = std::min(this->dirtyFirst, first);
+    this->dirtyEnd   = std::max(this->dirtyEnd,   first + count);
+  }
+}
+
+/** Upload changed vertices and bind the buffer. */
+void
+VertexBuffer::Upload() {
+#if !HAVE_GFX
+  // nothing to upload to
+#elif USE_VBO
   if (this->dirty) {
     if (!this->vbo) glGenBuffers(1, &this->vbo);
     if (!this->vbo) Log("%04x\n", glGetError());
@@ -63,35 +119,42 @@ VertexBuffer::DrawTriangles(size_t first, size_t count) {
     glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex)*(this->verts.size()), &this->verts[0], GL_STATIC_DRAW);
   } else {
     glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
+    if (this->dirtyFirst != this->dirtyEnd) {
+      glBufferSubData(
+        GL_ARRAY_BUFFER,
+        sizeof(Vertex)*this->dirtyFirst,
+        sizeof(Vertex)*(this->dirtyEnd - this->dirtyFirst),
+        &this->verts[this->dirtyFirst]
+      );
+    }
   }
   glInterleavedArrays(GL_T2F_C4F_N3F_V3F,  sizeof(Vertex), nullptr);
 #else
   glInterleavedArrays(GL_T2F_C4F_N3F_V3F,  sizeof(Vertex), &this->verts[0]);
 #endif
 
-  glDrawArrays(GL_TRIANGLES, first, count);
   this->dirty = false;
+  this->dirtyFirst = this->dirtyEnd = 0;
 }
 
 void
-VertexBuffer::DrawQuads(size_t first, size_t count) {
+VertexBuffer::DrawTriangles(size_t first, size_t count) {
   if (count == 0) count = this->verts.size() - first;
   if (count == 0) return;
 
-#if USE_VBO
-  if (this->dirty) {
-    if (!this->vbo) glGenBuffers(1, &this->vbo);
-    if (!this->vbo) Log("%04x\n", glGetError());
-    glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex)*(this->verts.size()), &this->verts[0], GL_STATIC_DRAW);
-  } else {
-    glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
-  }
-  glInterleavedArrays(GL_T2F_C4F_N3F_V3F,  sizeof(Vertex), nullptr);
-#else
-  glInterleavedArrays(GL_T2F_C4F_N3F_V3F,  sizeof(Vertex), &this->verts[0]);
+  this->Upload();
+#if HAVE_GFX
+  glDrawArrays(GL_TRIANGLES, first, count);
 #endif
+}
 
+void
+VertexBuffer::DrawQuads(size_t first, size_t count) {
+  if (count == 0) count = this->verts.size() - first;
+  if (count == 0) return;
+
+  this->Upload();
+#if HAVE_GFX
   glDrawArrays(GL_QUADS, first, count);
-  this->dirty = false;
+#endif
 }
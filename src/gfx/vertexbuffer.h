@@ -15,7 +15,13 @@ public:
   size_t Add(const Vertex &vert);
   size_t Add(const std::vector<Vertex> &verts);
 
+  void Resize(size_t count);
+  void Update(size_t first, const Vertex *verts, size_t count);
+  void Zero(size_t first, size_t count);
+
   inline std::vector<Vertex> &GetVerts() { this->dirty = true; return verts; }
+  inline const Vertex *GetData() const { return verts.data(); }
+  inline size_t GetCount() const { return verts.size(); }
 
 private:
 
@@ -23,6 +29,12 @@ private:
   unsigned int vbo;
   std::vector<Vertex> verts;
 
+  /** Range of vertices changed since the last upload, if not all dirty. */
+  size_t dirtyFirst;
+  size_t dirtyEnd;
+
+  void MarkDirty(size_t first, size_t count);
+  void Upload();
   void DrawTriangles(size_t first, size_t count);
   void DrawQuads(size_t first, size_t count);
 
@@ -149,6 +149,47 @@ createUserStream(const std::string &name, std::fstream &out) {
   return out.is_open();
 }
 
+bool 
+openUserStream(const std::string &name, std::fstream &in) {
+  std::string path = getUserPath(name);
+  in.open(path, std::ios::binary | std::ios::in);
+  return in.is_open();
+}
+
+// write to a temporary file that then replaces the old one, so that the
+// file is never left half written
+bool 
+writeUserFileAtomic(const std::string &name, const std::string &data) {
+  std::string path = getUserPath(name);
+  std::string tmpPath = path + ".tmp";
+  makePath(path);
+
+  FILE *file = fopen(tmpPath.c_str(), "wb");
+  if (!file) {
+    perror(tmpPath.c_str());
+    return false;
+  }
+
+  bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+  ok = (fclose(file) == 0) && ok;
+  if (!ok) {
+    perror(tmpPath.c_str());
+    remove(tmpPath.c_str());
+    return false;
+  }
+
+#ifdef _WIN32
+  // rename does not replace existing files here
+  remove(path.c_str());
+#endif
+  if (rename(tmpPath.c_str(), path.c_str())) {
+    perror(path.c_str());
+    remove(tmpPath.c_str());
+    return false;
+  }
+  return true;
+}
+
 FILE *openUserFile(const std::string &name) {
   std::string path = getUserPath(name);
   FILE *file = fopen(path.c_str(), "rb");
@@ -16,6 +16,8 @@ std::string getUserPath(const std::string &name);
 void makePath(const std::string &path);
 
 bool createUserStream(const std::string &name, std::fstream &out);
+bool openUserStream(const std::string &name, std::fstream &in);
+bool writeUserFileAtomic(const std::string &name, const std::string &data);
 
 FILE *openUserFile(const std::string &name);
 time_t getFileChangeTime(const std::string &name);
@@ -0,0 +1,108 @@
+#include "common.h"
+
+#include "io/fileio.h"
+#include "io/mappedfile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/** C'tor. */
+MappedFile::MappedFile() :
+  data(nullptr),
+  size(0)
+#ifdef _WIN32
+  ,
+  file(INVALID_HANDLE_VALUE),
+  mapping(nullptr)
+#endif
+{
+}
+
+/** D'tor. Unmaps the file. */
+MappedFile::~MappedFile() {
+  this->Close();
+}
+
+/** Map a user file into memory.
+  * @param name Name of the file relative to the user directory.
+  * @return false if the file does not exist, is empty or could not be
+  *         mapped.
+  */
+bool
+MappedFile::Open(const std::string &name) {
+  this->Close();
+
+  std::string path = getUserPath(name);
+
+#ifdef _WIN32
+  this->file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (this->file == INVALID_HANDLE_VALUE) return false;
+
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(this->file, &fileSize) || fileSize.QuadPart == 0) {
+    this->Close();
+    return false;
+  }
+
+  this->mapping = CreateFileMappingA(this->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!this->mapping) {
+    this->Close();
+    return false;
+  }
+
+  void *view = MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!view) {
+    this->Close();
+    return false;
+  }
+
+  this->data = static_cast<const char *>(view);
+  this->size = size_t(fileSize.QuadPart);
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+
+  struct stat st;
+  if (fstat(fd, &st) || st.st_size == 0) {
+    close(fd);
+    return false;
+  }
+
+  // the mapping stays valid after the descriptor is closed
+  void *view = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (view == MAP_FAILED) {
+    perror(path.c_str());
+    return false;
+  }
+
+  this->data = static_cast<const char *>(view);
+  this->size = size_t(st.st_size);
+#endif
+
+  return true;
+}
+
+/** Unmap the file. */
+void
+MappedFile::Close() {
+#ifdef _WIN32
+  if (this->data)                         UnmapViewOfFile(this->data);
+  if (this->mapping)                      CloseHandle(this->mapping);
+  if (this->file != INVALID_HANDLE_VALUE) CloseHandle(this->file);
+  this->mapping = nullptr;
+  this->file    = INVALID_HANDLE_VALUE;
+#else
+  if (this->data) munmap(const_cast<char *>(this->data), this->size);
+#endif
+
+  this->data = nullptr;
+  this->size = 0;
+}
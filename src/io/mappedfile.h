@@ -0,0 +1,36 @@
+#ifndef BARFOOS_MAPPEDFILE_H
+#define BARFOOS_MAPPEDFILE_H
+
+#include "common.h"
+
+/** A user file mapped into memory for reading. The operating system pages
+  * the contents in as they are accessed, so nothing is copied or parsed
+  * when the file is opened.
+  */
+class MappedFile final {
+public:
+
+                            MappedFile          ();
+                            MappedFile          (const MappedFile &) = delete;
+                            ~MappedFile         ();
+
+  MappedFile &              operator=           (const MappedFile &) = delete;
+
+  bool                      Open                (const std::string &name);
+  void                      Close               ();
+
+  const char *              GetData             ()                                        const { return this->data; }
+  size_t                    GetSize             ()                                        const { return this->size; }
+
+private:
+
+  const char *              data;
+  size_t                    size;
+
+#ifdef _WIN32
+  void *                    file;
+  void *                    mapping;
+#endif
+};
+
+#endif
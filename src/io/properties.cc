@@ -125,6 +125,13 @@ Properties::Parse(std::string &str) {
   tokens.erase(tokens.begin());
 }
 
+void
+Properties::Parse(Symbol &symbol) {
+  std::string str;
+  Parse(str);
+  symbol = Symbol(str);
+}
+
 void
 Properties::Parse(std::vector<std::string> &str) {
   if (tokens.empty()) {
@@ -0,0 +1,52 @@
+#include "common.h"
+
+#include "io/protostream.h"
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/message.h>
+
+void
+appendDelimited(const google::protobuf::Message &message, std::string &out) {
+  google::protobuf::io::StringOutputStream stream(&out);
+  google::protobuf::io::CodedOutputStream coded(&stream);
+
+  coded.WriteVarint32(uint32_t(message.ByteSizeLong()));
+  message.SerializeWithCachedSizes(&coded);
+}
+
+/** C'tor.
+  * @param in Stream to read from.
+  */
+ProtoReader::ProtoReader(std::istream &in) :
+  input(new google::protobuf::io::IstreamInputStream(&in))
+{
+}
+
+/** C'tor.
+  * @param data Memory to read from, must stay valid while reading.
+  * @param size Size of the memory in bytes.
+  */
+ProtoReader::ProtoReader(const void *data, size_t size) :
+  input(new google::protobuf::io::ArrayInputStream(data, int(size)))
+{
+}
+
+/** Read the next message.
+  * @param[out] message Receives the message.
+  * @return false at the end of the stream or if the message is broken.
+  */
+bool
+ProtoReader::Read(google::protobuf::Message &message) {
+  // a coded stream per message keeps its byte limit from being hit
+  google::protobuf::io::CodedInputStream coded(this->input.get());
+
+  uint32_t size;
+  if (!coded.ReadVarint32(&size)) return false;
+
+  google::protobuf::io::CodedInputStream::Limit limit = coded.PushLimit(size);
+  message.Clear();
+  bool ok = message.MergeFromCodedStream(&coded) && coded.ConsumedEntireMessage();
+  coded.PopLimit(limit);
+  return ok;
+}
@@ -0,0 +1,35 @@
+#ifndef BARFOOS_PROTOSTREAM_H
+#define BARFOOS_PROTOSTREAM_H
+
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+
+#include <istream>
+#include <memory>
+#include <string>
+
+namespace google { namespace protobuf { class Message; } }
+
+// messages prefixed with their size, so that several can go into one file
+void appendDelimited(const google::protobuf::Message &message, std::string &out);
+
+/** Reads messages written by appendDelimited from a stream or a block of
+  * memory one at a time, so that large files can be processed while they
+  * are read.
+  */
+class ProtoReader final {
+public:
+
+                            ProtoReader         (std::istream &in);
+                            ProtoReader         (const void *data, size_t size);
+                            ProtoReader         (const ProtoReader &) = delete;
+
+  ProtoReader &             operator=           (const ProtoReader &) = delete;
+
+  bool                      Read                (google::protobuf::Message &message);
+
+private:
+
+  std::unique_ptr<google::protobuf::io::ZeroCopyInputStream> input;
+};
+
+#endif
@@ -0,0 +1,134 @@
+#include "common.h"
+
+#include "io/fileio.h"
+#include "io/protostream.h"
+#include "io/savewriter.h"
+
+#include <google/protobuf/message.h>
+
+#include <algorithm>
+#include <chrono>
+
+/** C'tor. Starts the worker thread. */
+SaveWriter::SaveWriter() :
+  thread(),
+  mutex(),
+  condition(),
+  quit(false),
+  busy(false),
+  jobPending(false),
+  pending(),
+  writing(),
+  writeTime(0.0)
+{
+  this->thread = std::thread(&SaveWriter::Run, this);
+}
+
+/** D'tor. Writes what has been posted and waits for the worker thread to
+  * finish.
+  */
+SaveWriter::~SaveWriter() {
+  this->Flush();
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->quit = true;
+  }
+  this->condition.notify_all();
+  this->thread.join();
+}
+
+/** Hand a snapshot over to the worker thread.
+  * @param snapshot Files to write, taken over by the writer.
+  */
+void
+SaveWriter::Post(Snapshot &&snapshot) {
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    // keep files of the waiting snapshot that are not written again
+    for (File &file : this->pending) {
+      auto sameName = [&](const File &other) { return other.name == file.name; };
+      if (std::none_of(snapshot.begin(), snapshot.end(), sameName)) {
+        snapshot.push_back(std::move(file));
+      }
+    }
+
+    this->pending    = std::move(snapshot);
+    this->jobPending = true;
+  }
+  this->condition.notify_all();
+}
+
+/** Wait until all posted snapshots have been written. */
+void
+SaveWriter::Flush() {
+  std::unique_lock<std::mutex> lock(this->mutex);
+  this->condition.wait(lock, [this]{ return !this->busy && !this->jobPending; });
+}
+
+/** Check whether a snapshot is being written or waiting to be written.
+  * @return true if the writer is busy.
+  */
+bool
+SaveWriter::IsBusy() {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->busy || this->jobPending;
+}
+
+/** Get the time it took to write the last snapshot.
+  * @return Time in seconds.
+  */
+float
+SaveWriter::GetWriteTime() {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->writeTime;
+}
+
+/** Worker thread main loop. */
+void
+SaveWriter::Run() {
+  while(true) {
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->condition.wait(lock, [this]{ return this->quit || this->jobPending; });
+      if (this->quit && !this->jobPending) return;
+
+      std::swap(this->writing, this->pending);
+      this->jobPending = false;
+      this->busy       = true;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    this->Write();
+    float time = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+
+    Log("Saved in %.1f ms\n", time * 1000.0f);
+
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->writing.clear();
+      this->writeTime = time;
+      this->busy      = false;
+    }
+    this->condition.notify_all();
+  }
+}
+
+/** Prepare, serialize and write all files of the current snapshot. */
+void
+SaveWriter::Write() {
+  std::string data;
+  for (File &file : this->writing) {
+    if (file.prepare) file.prepare(file.messages);
+
+    data.clear();
+    for (auto &message : file.messages) {
+      appendDelimited(*message, data);
+    }
+    if (file.write) file.write(data);
+
+    if (!writeUserFileAtomic(file.name, data)) {
+      Log("could not write %s\n", file.name.c_str());
+    }
+  }
+}
@@ -0,0 +1,78 @@
+#ifndef BARFOOS_SAVEWRITER_H
+#define BARFOOS_SAVEWRITER_H
+
+#include "common.h"
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace google { namespace protobuf { class Message; } }
+
+/** Writes save files on a worker thread.
+  * The main thread takes a snapshot of the game by copying its protobuf
+  * messages into a SaveWriter::Snapshot, which the worker then serializes
+  * and writes, each message prefixed with its size (see ProtoReader). Each
+  * file is written next to its final name first and
+  * renamed when complete, so a crash never leaves a half written save.
+  * There are two snapshot buffers: the one being written and the next one.
+  * A snapshot posted while the worker is busy replaces the files of a
+  * waiting one that has not been started yet, files that are only in the
+  * waiting one are still written.
+  */
+class SaveWriter final {
+public:
+
+  typedef std::vector<std::unique_ptr<google::protobuf::Message>> MessageList;
+
+  /** A file consists of messages that are written one after another.
+    * Expensive messages can be filled in or added on the worker thread by
+    * the prepare function from data copied into it. Files that are not
+    * made of messages are written by the write function instead, which
+    * appends the raw data.
+    */
+  struct File {
+    std::string                               name;
+    MessageList                               messages;
+    std::function<void(MessageList &)>        prepare;
+    std::function<void(std::string &)>        write;
+  };
+
+  typedef std::vector<File> Snapshot;
+
+                            SaveWriter          ();
+                            SaveWriter          (const SaveWriter &) = delete;
+                            ~SaveWriter         ();
+
+  SaveWriter &              operator=           (const SaveWriter &) = delete;
+
+  void                      Post                (Snapshot &&snapshot);
+  void                      Flush               ();
+
+  bool                      IsBusy              ();
+  float                     GetWriteTime        ();
+
+private:
+
+  std::thread               thread;
+  std::mutex                mutex;
+  std::condition_variable   condition;
+  bool                      quit;
+  bool                      busy;
+  bool                      jobPending;
+
+  /** Next snapshot to write and the one being written. */
+  Snapshot                  pending;
+  Snapshot                  writing;
+
+  /** Time it took to write the last snapshot. */
+  float                     writeTime;
+
+  void                      Run                 ();
+  void                      Write               ();
+};
+
+#endif
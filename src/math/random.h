@@ -13,6 +13,18 @@ public:
   {
     Seed(s,n);
   }
+
+  /** Make one of many independent generators, for example one per region
+    * of the world, which can be used in any order or in parallel.
+    * @param seed Seed shared by all streams.
+    * @param stream Number of the stream.
+    */
+  Random(uint32_t seed, uint32_t stream) :
+    gen()
+  {
+    std::seed_seq seq { seed, stream };
+    gen = std::mt19937(seq);
+  }
   
   void Seed(const std::string &s, size_t n = 0) {
     std::seed_seq seq(s.begin(), s.end());
@@ -0,0 +1,150 @@
+#include "common.h"
+
+#include "util/pool.h"
+
+#include <cstdio>
+
+/** C'tor.
+  * @param name Name of the pool for statistics.
+  * @param perLevel Whether the pool is released when a level is left.
+  * @param blocksPerChunk Number of blocks to allocate at once.
+  */
+Pool::Pool(const char *name, bool perLevel, size_t blocksPerChunk) :
+  name(name),
+  perLevel(perLevel),
+  blocksPerChunk(blocksPerChunk),
+  blockSize(0),
+  chunks(),
+  freeList(nullptr),
+  live(0),
+  peak(0)
+{
+  GetPools().push_back(this);
+}
+
+/** D'tor. */
+Pool::~Pool() {
+  std::vector<Pool*> &pools = GetPools();
+  pools.erase(std::remove(pools.begin(), pools.end(), this), pools.end());
+
+  // objects still alive at exit are leaked anyway
+  if (!this->live) this->Release();
+}
+
+/** Allocate a block.
+  * @param size Size of the object, the first call fixes the block size.
+  * @return Pointer to the block.
+  */
+void *
+Pool::Allocate(size_t size) {
+  if (!this->blockSize) this->blockSize = GetBlockSize(size);
+
+  if (!this->Fits(size)) return ::operator new(size);
+
+  if (!this->freeList) this->AddChunk();
+
+  FreeBlock *block = this->freeList;
+  this->freeList = block->next;
+
+  this->live++;
+  this->peak = std::max(this->peak, this->live);
+  return block;
+}
+
+/** Return a block to the pool.
+  * @param ptr Pointer to the block.
+  * @param size Size that was passed to Allocate().
+  */
+void
+Pool::Free(void *ptr, size_t size) {
+  if (!ptr) return;
+
+  if (!this->Fits(size)) {
+    ::operator delete(ptr);
+    return;
+  }
+
+  FreeBlock *block = static_cast<FreeBlock*>(ptr);
+  block->next = this->freeList;
+  this->freeList = block;
+  this->live--;
+}
+
+/** Give all chunks back to the heap at once. This only happens if no block
+  * is in use.
+  * @return true if the pool was released.
+  */
+bool
+Pool::Release() {
+  if (this->live) return false;
+
+  for (char *chunk : this->chunks) {
+    ::operator delete(chunk);
+  }
+  this->chunks.clear();
+  this->freeList = nullptr;
+  return true;
+}
+
+/** Release all pools of level objects. Called when leaving a level after
+  * all of its entities have been deleted.
+  */
+void
+Pool::ReleaseLevel() {
+  for (Pool *pool : GetPools()) {
+    if (!pool->perLevel) continue;
+    if (!pool->Release()) {
+      Log("Pool %s still has %u live objects\n", pool->name, (unsigned int)pool->live);
+    }
+  }
+}
+
+/** Get statistics of all pools.
+  * @return Table of block size, live and peak counts and chunks per pool.
+  */
+std::string
+Pool::GetDump() {
+  std::string dump;
+  char line[256];
+
+  snprintf(line, sizeof(line), "%-16s %8s %8s %8s %8s\n", "pool", "size", "live", "peak", "chunks");
+  dump += line;
+
+  for (const Pool *pool : GetPools()) {
+    snprintf(line, sizeof(line), "%-16s %8u %8u %8u %8u\n",
+      pool->name,
+      (unsigned int)pool->blockSize,
+      (unsigned int)pool->live,
+      (unsigned int)pool->peak,
+      (unsigned int)pool->chunks.size()
+    );
+    dump += line;
+  }
+  return dump;
+}
+
+void
+Pool::AddChunk() {
+  char *chunk = static_cast<char*>(::operator new(this->blockSize * this->blocksPerChunk));
+  this->chunks.push_back(chunk);
+
+  for (size_t i=this->blocksPerChunk; i>0; i--) {
+    FreeBlock *block = reinterpret_cast<FreeBlock*>(chunk + (i-1) * this->blockSize);
+    block->next = this->freeList;
+    this->freeList = block;
+  }
+}
+
+size_t
+Pool::GetBlockSize(size_t size) {
+  // keep every block aligned like memory from the heap
+  size_t align = alignof(std::max_align_t);
+  size = std::max(size, sizeof(FreeBlock));
+  return (size + align - 1) / align * align;
+}
+
+std::vector<Pool*> &
+Pool::GetPools() {
+  static std::vector<Pool*> pools;
+  return pools;
+}
@@ -0,0 +1,99 @@
+#ifndef BARFOOS_POOL_H
+#define BARFOOS_POOL_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/** Fixed size block allocator for objects of one class.
+  * Blocks are carved out of chunks that are never returned to the heap
+  * one by one, freed blocks go to a free list and are reused first. The
+  * block size is taken from the first allocation, requests of a different
+  * size (e.g. from a derived class without a pool of its own) go to the
+  * heap. Pools of objects that belong to a level can be released in one
+  * go when the level is left. Pools are not thread safe.
+  */
+class Pool final {
+public:
+
+                            Pool                (const char *name, bool perLevel = false, size_t blocksPerChunk = 64);
+                            Pool                (const Pool &) = delete;
+                            ~Pool               ();
+
+  Pool &                    operator=           (const Pool &) = delete;
+
+  void *                    Allocate            (size_t size);
+  void                      Free                (void *ptr, size_t size);
+  bool                      Release             ();
+
+  const char *              GetName             ()                                        const { return this->name; }
+  size_t                    GetLive             ()                                        const { return this->live; }
+  size_t                    GetPeak             ()                                        const { return this->peak; }
+
+  static void               ReleaseLevel        ();
+  static std::string        GetDump             ();
+
+private:
+
+  struct FreeBlock {
+    FreeBlock *next;
+  };
+
+  const char *              name;
+  bool                      perLevel;
+  size_t                    blocksPerChunk;
+  size_t                    blockSize;
+
+  std::vector<char *>       chunks;
+  FreeBlock *               freeList;
+
+  size_t                    live;
+  size_t                    peak;
+
+  bool                      Fits                (size_t size)                             const { return GetBlockSize(size) == this->blockSize; }
+  void                      AddChunk            ();
+
+  static size_t             GetBlockSize        (size_t size);
+
+  static std::vector<Pool*> &GetPools();
+};
+
+/** Standard allocator that takes its memory from a pool, for use with
+  * std::allocate_shared. The pool is shared by all rebound copies, so it
+  * ends up holding the combined control block and object.
+  */
+template<class T>
+class PoolAllocator final {
+public:
+
+  typedef T value_type;
+
+                            PoolAllocator       (Pool &pool) : pool(&pool) {}
+  template<class U>         PoolAllocator       (const PoolAllocator<U> &that) : pool(that.pool) {}
+
+  T *                       allocate            (size_t n);
+  void                      deallocate          (T *ptr, size_t n);
+
+  template<class U> bool    operator==          (const PoolAllocator<U> &that)            const { return this->pool == that.pool; }
+  template<class U> bool    operator!=          (const PoolAllocator<U> &that)            const { return this->pool != that.pool; }
+
+private:
+
+  Pool *                    pool;
+
+  template<class U> friend class PoolAllocator;
+};
+
+template<class T> T *
+PoolAllocator<T>::allocate(size_t n) {
+  if (n != 1) return static_cast<T*>(::operator new(n * sizeof(T)));
+  return static_cast<T*>(this->pool->Allocate(sizeof(T)));
+}
+
+template<class T> void
+PoolAllocator<T>::deallocate(T *ptr, size_t n) {
+  if (n != 1) ::operator delete(ptr);
+  else        this->pool->Free(ptr, sizeof(T));
+}
+
+#endif
@@ -27,7 +27,15 @@ struct ProfileFunc {
   uint64_t ticksPerCall = 0;
 };
 
+struct ProfileCounter {
+  std::string name = "";
+  uint64_t samples = 0;
+  uint64_t total = 0;
+  uint64_t max = 0;
+};
+
 static std::unordered_map<std::string, ProfileFunc> funcs;
+static std::unordered_map<std::string, ProfileCounter> counters;
 static std::vector<std::string> funcStack;
 
 static inline uint64_t measure() {
@@ -70,6 +78,20 @@ Profile::~Profile() {
   funcStack.pop_back();
 }
 
+/** Record a sample of a named counter, e.g. the amount of work done in one
+  * round of an iterative algorithm.
+  * @param name Name of the counter.
+  * @param count Value of the sample.
+  */
+void
+Profile::Count(const char *name, uint64_t count) {
+  ProfileCounter &counter = counters[name];
+  counter.name = name;
+  counter.samples ++;
+  counter.total += count;
+  if (count > counter.max) counter.max = count;
+}
+
 #endif
 
 std::string 
@@ -91,6 +113,12 @@ Profile::GetDump() {
     snprintf(tmp, sizeof(tmp), "%s %10" PRIu64 " c, %10" PRIu64 " t, %10" PRIu64 " t/c", f.name.c_str(), f.calls, f.totalTicks, f.ticksPerCall);
     str << tmp << std::endl << std::endl;
   }
+
+  for (auto c : counters) {
+    char tmp[512];
+    snprintf(tmp, sizeof(tmp), "%-87s %10" PRIu64 " s, %10" PRIu64 " n, %10" PRIu64 " max", c.second.name.c_str(), c.second.samples, c.second.total, c.second.max);
+    str << tmp << std::endl << std::endl;
+  }
   
   return str.str();
 #endif
@@ -5,7 +5,10 @@
 #define NO_PROFILE 1
 #endif
 
+// only enabled on request, e.g. for the benchmark
+#ifndef WITH_PROFILE
 #define NO_PROFILE 1
+#endif
 
 #ifdef NO_PROFILE
 
@@ -13,6 +16,7 @@
 
 #define PROFILE()
 #define PROFILE_NAMED(n)
+#define PROFILE_COUNT(n, c)
 
 class Profile {
 public:
@@ -32,6 +36,8 @@ public:
   static void Dump();
   static std::string GetDump();
 
+  static void Count(const char *name, uint64_t count);
+
 private:
 
   std::string name;
@@ -40,6 +46,7 @@ private:
 
 #define PROFILE() Profile __profile(__PRETTY_FUNCTION__, __FILE__, __LINE__)
 #define PROFILE_NAMED(n) Profile __profile(n, __FILE__, __LINE__)
+#define PROFILE_COUNT(n, c) Profile::Count(n, c)
 
 #endif
 
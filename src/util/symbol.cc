@@ -0,0 +1,47 @@
+#include "common.h"
+
+#include <mutex>
+
+/** Get the table of all interned strings. Elements of an unordered_set keep
+  * their address when the set grows.
+  */
+static std::unordered_set<std::string> &
+GetSymbolTable() {
+  static std::unordered_set<std::string> table;
+  return table;
+}
+
+static std::mutex &
+GetSymbolMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+/** C'tor.
+  * @param str String to intern.
+  */
+Symbol::Symbol(const std::string &str) :
+  name(nullptr)
+{
+  if (str.empty()) return;
+
+  std::lock_guard<std::mutex> lock(GetSymbolMutex());
+  this->name = &*GetSymbolTable().insert(str).first;
+}
+
+/** C'tor.
+  * @param str String to intern.
+  */
+Symbol::Symbol(const char *str) :
+  Symbol(std::string(str ? str : ""))
+{
+}
+
+/** Get the interned string.
+  * @return The string, empty for a default constructed symbol.
+  */
+const std::string &
+Symbol::GetString() const {
+  static const std::string empty;
+  return this->name ? *this->name : empty;
+}
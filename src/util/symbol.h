@@ -0,0 +1,39 @@
+#ifndef BARFOOS_SYMBOL_H
+#define BARFOOS_SYMBOL_H
+
+#include <functional>
+#include <string>
+
+/** An interned string. Each distinct string is stored once in a global table
+  * and a symbol only holds a pointer to it, so copying, comparing and hashing
+  * symbols does not touch the characters. Creating a symbol from a string
+  * does a table lookup, so symbols used on hot paths should be created once
+  * and kept around.
+  */
+class Symbol final {
+public:
+
+                            Symbol              () : name(nullptr) {}
+                            Symbol              (const std::string &str);
+                            Symbol              (const char *str);
+
+  const std::string &       GetString           ()                                        const;
+  const char *              c_str               ()                                        const { return this->GetString().c_str(); }
+  bool                      IsEmpty             ()                                        const { return this->name == nullptr; }
+
+  bool                      operator==          (const Symbol &that)                      const { return this->name == that.name; }
+  bool                      operator!=          (const Symbol &that)                      const { return this->name != that.name; }
+
+private:
+
+  /** Interned string, nullptr for the empty string. */
+  const std::string *       name;
+
+  friend struct std::hash<Symbol>;
+};
+
+namespace std { template<> struct hash<Symbol> {
+  size_t operator()(const Symbol &symbol) const { return std::hash<const std::string *>()(symbol.name); }
+}; }
+
+#endif
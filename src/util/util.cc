@@ -105,3 +105,25 @@ std::vector<std::string> Tokenize(const char *l) {
   } while(q && *p);
   return tokens;
 }
+
+/** Calculate a checksum to detect broken files. This is FNV-1a taking
+  * eight bytes at a time, which is fast enough for large blocks of data
+  * but is no protection against deliberate changes.
+  * @param data Data to check.
+  * @param size Size of the data in bytes.
+  * @return The checksum.
+  */
+uint64_t Checksum(const void *data, size_t size) {
+  const uint8_t *p = static_cast<const uint8_t *>(data);
+  uint64_t hash = 14695981039346656037ull;
+
+  for (; size >= 8; size -= 8, p += 8) {
+    uint64_t word;
+    memcpy(&word, p, 8);
+    hash = (hash ^ word) * 1099511628211ull;
+  }
+  for (; size > 0; size--, p++) {
+    hash = (hash ^ *p) * 1099511628211ull;
+  }
+  return hash;
+}
@@ -10,6 +10,7 @@ float Wave(float x, float z, float t, float a = 0.2);
 
 std::vector<std::string> Tokenize(const char *line);
 uint32_t ParseSidesMask(const std::string &str);
+uint64_t Checksum(const void *data, size_t size);
 
 // TODO: separate file: regular.h ----------------------------------------------------
 
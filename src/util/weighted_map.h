@@ -1,12 +1,17 @@
 #ifndef BARFOOS_WEIGHTED_MAP_H
 #define BARFOOS_WEIGHTED_MAP_H
 
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 
 template<class T>
 class weighted_map : public std::unordered_map<T, float> {
 
+  // the order of the entries decides what is selected, pointers would make
+  // it depend on where things are in memory
+  static_assert(!std::is_pointer<T>::value, "weighted_map must not be keyed by pointers");
+
 public:
 
   T select(float index) const {
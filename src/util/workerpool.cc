@@ -0,0 +1,107 @@
+#include "common.h"
+
+#include "util/workerpool.h"
+
+/** C'tor. Starts the worker threads.
+  * @param threadCount Number of threads working on a job including the
+  *                    calling thread, 0 to use one per core.
+  */
+WorkerPool::WorkerPool(size_t threadCount) :
+  threads(),
+  mutex(),
+  jobCondition(),
+  doneCondition(),
+  quit(false),
+  job(nullptr),
+  jobCount(0),
+  jobNumber(0),
+  nextPart(0),
+  busyCount(0)
+{
+  if (threadCount == 0) {
+    threadCount = std::thread::hardware_concurrency();
+  }
+
+  for (size_t i=1; i<threadCount; i++) {
+    this->threads.push_back(std::thread(&WorkerPool::Work, this));
+  }
+}
+
+/** D'tor. Waits for the worker threads to finish. */
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->quit = true;
+  }
+  this->jobCondition.notify_all();
+
+  for (auto &thread : this->threads) {
+    thread.join();
+  }
+}
+
+/** Run a job on all threads and wait until it is done. Not to be called
+  * from within a job.
+  * @param count Number of parts of the job.
+  * @param job Function that does one part of the job, gets the number of
+  *            the part.
+  */
+void
+WorkerPool::Run(size_t count, const std::function<void(size_t)> &job) {
+  if (count == 0) return;
+
+  // not worth waking anyone up
+  if (count == 1 || this->threads.empty()) {
+    for (size_t i=0; i<count; i++) job(i);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->job       = &job;
+    this->jobCount  = count;
+    this->nextPart  = 0;
+    this->busyCount = this->threads.size();
+    this->jobNumber++;
+  }
+  this->jobCondition.notify_all();
+
+  this->RunParts();
+
+  // every worker has to check in, so none of them can miss a job
+  std::unique_lock<std::mutex> lock(this->mutex);
+  this->doneCondition.wait(lock, [this]{ return this->busyCount == 0; });
+  this->job = nullptr;
+}
+
+/** Do parts of the current job until there are none left. */
+void
+WorkerPool::RunParts() {
+  while(true) {
+    size_t part = this->nextPart++;
+    if (part >= this->jobCount) return;
+    (*this->job)(part);
+  }
+}
+
+/** Worker thread main loop. */
+void
+WorkerPool::Work() {
+  size_t lastJob = 0;
+
+  while(true) {
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->jobCondition.wait(lock, [&]{ return this->quit || this->jobNumber != lastJob; });
+      if (this->quit) return;
+      lastJob = this->jobNumber;
+    }
+
+    this->RunParts();
+
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      if (--this->busyCount == 0) this->doneCondition.notify_one();
+    }
+  }
+}
@@ -0,0 +1,52 @@
+#ifndef BARFOOS_WORKERPOOL_H
+#define BARFOOS_WORKERPOOL_H
+
+#include "common.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/** A few worker threads that share the work of one loop with the calling
+  * thread. The loop is split into a fixed number of parts by the caller,
+  * which parts end up on which thread is left to chance. To get the same
+  * result regardless of the number of threads, each part may only write
+  * what belongs to it and the caller combines the parts in order
+  * afterwards.
+  */
+class WorkerPool final {
+public:
+
+                            WorkerPool          (size_t threadCount = 0);
+                            WorkerPool          (const WorkerPool &) = delete;
+                            ~WorkerPool         ();
+
+  WorkerPool &              operator=           (const WorkerPool &) = delete;
+
+  void                      Run                 (size_t count, const std::function<void(size_t)> &job);
+
+  size_t                    GetThreadCount      ()                                        const { return this->threads.size() + 1; }
+
+private:
+
+  std::vector<std::thread>  threads;
+  std::mutex                mutex;
+  std::condition_variable   jobCondition;
+  std::condition_variable   doneCondition;
+  bool                      quit;
+
+  /** Job in progress, its next part and the number of threads still
+    * working on it. */
+  const std::function<void(size_t)> *job;
+  size_t                    jobCount;
+  size_t                    jobNumber;
+  std::atomic<size_t>       nextPart;
+  size_t                    busyCount;
+
+  void                      RunParts            ();
+  void                      Work                ();
+};
+
+#endif